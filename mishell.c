@@ -1,6 +1,8 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 #include <sys/wait.h>
 #include <sys/types.h>
@@ -10,7 +12,37 @@
 #include <readline/readline.h>
 #include <readline/history.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <poll.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include <dirent.h>
+#include <time.h>
 #include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <sys/statvfs.h>
+#include <limits.h>
+#include <pwd.h>
+#include <fnmatch.h>
+#include <regex.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 #define MAX_CMD_LEN 1024
 #define MAX_ARGS 100
@@ -18,14 +50,175 @@
 #define MAX_API_KEY_LEN 100
 #define MAX_RESPONSE_SIZE 65536
 #define API_KEY_FILE ".mishell_api_key"
+#define AI_CONFIG_FILE ".mishell_ai.conf"
+#define AI_MOCK_DEFAULT_PORT 8089
+#define AI_INDEX_FILE ".mishell_ai_index"
+#define AI_INDEX_VERSION 1
+#define AI_INDEX_HASHES 64           // Jumlah fungsi hash MinHash per prompt
+#define AI_INDEX_MIN_SIMILARITY 0.5  // Kemiripan minimum untuk menawarkan saran lokal
+#define AI_LATENCY_HISTORY 64        // Jumlah sampel latensi untuk menghitung p95
+#define AI_HEDGE_DEFAULT_MS 1500     // Jeda hedge sebelum ada cukup sampel latensi
+#define AI_BACKOFF_BASE_MS 250       // Jeda awal retry, berlipat dua setiap percobaan
+#define AI_BREAKER_THRESHOLD 5       // Jumlah kegagalan beruntun sebelum circuit breaker terbuka
+#define AI_BREAKER_COOLDOWN_MS 15000 // Lama circuit breaker terbuka sebelum mencoba lagi
+#define MAX_CPUS 1024                // Jumlah core maksimum yang dibaca dari /proc/stat
+#define CPU_SAMPLE_DEFAULT_MS 250     // Interval sampel bawaan "cek cpu"
+#define MAX_DISKS 64                  // Jumlah perangkat blok maksimum per sampel
+#define MAX_MOUNTS 256                // Jumlah mount maksimum yang ditampilkan "cek disk"
+#define DISK_STATVFS_TIMEOUT_MS 2000  // Batas waktu statvfs per mount (mis. NFS macet)
+#define DISK_SAMPLE_DEFAULT_MS 500    // Interval sampel I/O bawaan "cek disk"
+#define PROC_READ_BUF 4096            // Buffer baca per thread untuk file /proc/[pid]
+#define PROC_SCAN_MAX_THREADS 8       // Ukuran maksimum thread pool pemindai /proc
+#define PROC_SCAN_PER_THREAD 256      // Jumlah proses per thread tambahan
+#define RAM_TOP_DEFAULT 10            // Jumlah proses bawaan "cek ram --top"
+#define PROC_SORT_RSS 0               // Kolom urutan "cek ram --top --sort"
+#define PROC_SORT_PSS 1
+#define PROC_SORT_SWAP 2
+#define PROC_SORT_CPU 3               // Kolom urutan tambahan "cek proc -s"
+#define PROC_SORT_THREADS 4
+#define PROC_SORT_STATE 5
+#define PROC_SORT_USER 6
+#define PROC_SORT_NAME 7
+#define PROC_LIST_DEFAULT 20          // Jumlah baris bawaan "cek proc"
+#define PROC_SAMPLE_DEFAULT_MS 500    // Interval sampel CPU% bawaan "cek proc"
+#define PROC_BENCH_MAX_SPAWN 20000    // Batas proses anak "cek proc bench --spawn"
+#define METRICS_DEFAULT_PORT 9464      // Port bawaan "cek serve"
+#define METRICS_REFRESH_DEFAULT_MS 5000 // Interval penyegaran snapshot metrik
+#define METRICS_MAX_CLIENTS 64          // Jumlah koneksi scrape bersamaan
+#define METRICS_CLIENT_TIMEOUT_MS 5000  // Batas waktu membaca header permintaan scrape
+#define METRICS_FORMAT_OPENMETRICS 0
+#define METRICS_FORMAT_JSON 1
+#define HISTORY_FILE ".mishell_metrics.ring"
+#define HISTORY_VERSION 1
+#define HISTORY_BLOCK_SIZE 4096         // Ukuran satu blok ring (dan header)
+#define HISTORY_DEFAULT_SIZE_MB 1       // Ukuran bawaan file ring
+#define HISTORY_DEFAULT_INTERVAL_S 10   // Interval sampel bawaan "cek record start"
+#define HISTORY_DEFAULT_SINCE_S 3600    // Rentang bawaan "cek history"
+#define HISTORY_MAX_WIDTH 120           // Lebar maksimum sparkline
+#define CGROUP_SAMPLE_DEFAULT_MS 1000  // Interval sampel bawaan "cek pressure" dan "cek cgroup"
+#define SPEED_DEFAULT_PORT 9465         // Port bawaan "test speed serve"
+#define SPEED_DEFAULT_PORT_STR "9465"
+#define SPEED_DEFAULT_STREAMS 4         // Jumlah aliran paralel bawaan "test speed"
+#define SPEED_MAX_STREAMS 32
+#define SPEED_DEFAULT_SECONDS 5         // Lama pengukuran per arah
+#define SPEED_DEFAULT_PINGS 10          // Jumlah sampel RTT
+#define SPEED_WARMUP_PERCENT 20         // Bagian awal pengukuran yang diabaikan (slow start TCP)
+#define SPEED_TRANSFER_BYTES 100000000  // Ukuran satu transfer sebelum diulang
+#define SPEED_MAX_DOWN_BYTES 10000000000ULL // Batas /down?bytes= server bawaan
+#define SPEED_CHUNK 131072              // Ukuran buffer kirim/terima server
+#define SPEED_HEADER_MAX 8192           // Batas ukuran header permintaan server
+#define SPEED_IDLE_TIMEOUT_S 30         // Koneksi server yang diam ditutup setelah ini
+#define SPEED_DEFAULT_DOWN_URL "https://speed.cloudflare.com/__down?bytes=100000000"
+#define SPEED_DEFAULT_UP_URL "https://speed.cloudflare.com/__up"
+#define SPEED_DEFAULT_PING_URL "https://speed.cloudflare.com/__down?bytes=0"
+#define MAX_NET_IFACES 128              // Jumlah interface maksimum per sampel "cek net"
+#define NET_SAMPLE_DEFAULT_MS 1000      // Interval sampel bawaan "cek net"
+#define DNS_DEFAULT_DIR "/etc/bind"      // Direktori konfigurasi BIND untuk "setup dns"
+#define DNS_DEFAULT_TTL 604800
+#define DIFF_MAX_CELLS (1 << 22)        // Batas tabel LCS diff dry run (baris lama x baris baru)
+#define DNS_CONF_BEGIN "// BEGIN mishell setup dns (dikelola otomatis, jangan diedit)"
+#define DNS_CONF_END "// END mishell setup dns"
+#define DNS_PORT 53
+#define DNS_SERVE_DEFAULT_PORT 5353     // Port bawaan "dns serve"
+#define DNS_MAX_MESSAGE 4096            // Ukuran pesan DNS maksimum yang diproses
+#define DNS_UDP_MAX 512                 // Batas jawaban UDP tanpa EDNS
+#define DNS_TYPE_A 1
+#define DNS_TYPE_PTR 12
+#define DNS_TYPE_ANY 255
+#define DNS_RCODE_NOERROR 0
+#define DNS_RCODE_SERVFAIL 2
+#define DNS_RCODE_NXDOMAIN 3
+#define DNS_RCODE_REFUSED 5
+#define DNS_DB_BUCKETS 4096             // Bucket hash database responder bawaan
+#define DNS_MAX_TCP_CLIENTS 64          // Koneksi TCP serentak responder bawaan
+#define DNS_TCP_IDLE_MS 10000           // Koneksi TCP responder yang diam ditutup setelah ini
+#define DNS_BENCH_DEFAULT_QPS 1000
+#define DNS_BENCH_MAX_QPS 200000
+#define DNS_BENCH_DEFAULT_SECONDS 5
+#define DNS_BENCH_DEFAULT_TIMEOUT_MS 2000
+#define DNS_BENCH_DEFAULT_TCP_CONNS 4
+#define DNS_BENCH_MAX_CONNS 64
+#define DNS_BENCH_MAX_SERVERS 8
+#define DNS_BENCH_SYNTH_HOSTS 256       // Jumlah host zona sintetis bench.test
+#define DNS_HISTOGRAM_WIDTH 40
+#define GLOB_MAX_SEGMENTS 64            // Batas komponen path dalam satu pola glob
+#define WORK_POOL_MAX_WORKERS 16        // Batas worker pool work stealing (glob "**", cari)
+#define GLOB_MAX_OPEN_FDS 256           // dirfd anak yang boleh terbuka bersamaan
+#define GLOB_CACHE_DIRS 1024            // Slot cache listing direktori
+#define GLOB_MAX_BRACE 4096             // Batas kata hasil ekspansi {a,b}
+#define GLOB_MAX_ARGV 131072            // Batas argumen hasil glob untuk perintah eksternal
+#define GLOB_NULL 1                     // Flag glob_stream: pola tanpa hasil tidak menghasilkan apa pun
+#define CARI_MAX_NAMES 16               // Batas opsi -n per pemanggilan "cari"
+#define CARI_MAX_ROOTS 64
+#define CARI_MAX_OPEN_FDS 512           // dirfd subdirektori yang boleh terbuka bersamaan
+#define CARI_MAX_IGNORE_FILE (1 << 20)  // .gitignore lebih besar dari ini dilewati
+#define CARI_OUT_BATCH 65536            // Ukuran batch keluaran per thread
+#define SARING_CHUNK (1 << 20)          // Ukuran baca per chunk untuk stdin/pipe
+#define SARING_MAX_LITERAL 256          // Batas panjang literal prefilter
+#define HITUNG_CHUNK (1 << 20)          // Ukuran baca per chunk untuk stdin/pipe
+#define HITUNG_MIN_PART (8 << 20)       // Potongan file minimum per thread
+#define URUT_DEFAULT_BUDGET (256 << 20) // Anggaran memori bawaan satu run "urut" (-S)
+#define URUT_MIN_BUDGET (64 << 10)
+#define URUT_MIN_PART 16384             // Baris minimum per thread pengurut
+#define URUT_MAX_MERGE 64               // Run file yang digabung sekaligus
+#define URUT_MIN_READ_BUF (64 << 10)    // Buffer baca minimum per run saat merge
+#define URUT_WRITE_BATCH 65536
+#define SCRIPT_CACHE_SIZE 32            // Program skrip (bytecode) yang disimpan, per path+mtime
+#define SCRIPT_MAX_DEPTH 64             // Batas loop bersarang dalam skrip
+#define TOP_DEFAULT_RATE_HZ 2         // Laju refresh bawaan "cek top"
+#define TOP_MAX_RATE_HZ 10
+#define AI_CONTEXT_BUDGET 2048      // Batas byte daftar file dalam prompt (~500 token)
+#define AI_CONTEXT_MAX_ENTRIES 1024 // Batas entri direktori yang dikumpulkan
 
 // Prototype/deklarasi fungsi-fungsi
 char* remove_surrounding_quotes(char* str);
 char* escape_path(const char* path);
 void replace_html_escapes(char* str);
-void check_cpu();
+void check_cpu(int interval_ms);
+int parse_interval_arg(char** args, int default_ms);
 void check_ram();
-void check_disk();
+void check_ram_top(int top_n, int sort_key);
+void check_proc(char** args);
+void proc_benchmark(char** args);
+void export_metrics(char** args);
+void start_metrics_server(char** args);
+void record_metric_history(char** args);
+void show_metric_history(char** args);
+void check_disk(int interval_ms);
+void check_cgroup(int interval_ms, int show_cgroup);
+void check_net(char** args);
+void setup_dns(char** args);
+void dns_bench(char** args);
+void start_dns_server(char** args);
+int open_tcp_listener(const char* host, int port);
+void test_speed(char** args);
+void start_speed_server(char** args);
+void live_top(int rate_hz);
+void run_command_line(char* line);
+void run_parsed_command(char** args);
+void run_input_line(char* line);
+void script_run_file(const char* path);
+void jalankan_command(char** args);
+typedef int (*pipeline_stage_source)(void* ctx, int index, char** args);
+void run_pipeline(int num_commands, pipeline_stage_source source, void* ctx);
+void shell_env_sync(void);
+const char* shell_var_get(const char* name);
+void export_command(char** args);
+void unset_command(char** args);
+char** expand_glob_args(char** args);
+void free_glob_args(char** argv, char** original);
+int is_glob_stream_builtin(const char* name);
+void pola_command(char** args);
+void cari_command(char** args);
+int saring_run(char** args, int in_fd, int out_fd);
+int hitung_run(char** args, int in_fd, int out_fd);
+int urut_run(char** args, int in_fd, int out_fd);
+void execute_command(char** args);
+int needs_bash_fallback(const char* command);
+void run_with_bash(const char* command);
+
+// Status keluar perintah terakhir (seperti $? di bash)
+int last_exit_status = 0;
 
 // Menyimpan sejarah perintah yang dijalankan
 char history[MAX_HISTORY][MAX_CMD_LEN];
@@ -43,7 +236,7 @@ struct MemoryStruct {
 
 // Fungsi untuk mendapatkan path file API key
 void get_api_key_path(char *path, size_t size) {
-    char *home_dir = getenv("HOME");
+    const char *home_dir = shell_var_get("HOME");
     if (home_dir != NULL) {
         snprintf(path, size, "%s/%s", home_dir, API_KEY_FILE);
     } else {
@@ -118,6 +311,162 @@ void logout_api_key() {
     }
 }
 
+// Konfigurasi backend AI (dapat diubah lewat "ai config" atau variabel lingkungan MISHELL_AI_*)
+struct ai_config {
+    char backend[32];       // "gemini" atau "openai" (OpenAI-compatible / llama.cpp)
+    char base_url[256];     // Kosong = pakai URL bawaan backend
+    char model[128];        // Kosong = pakai model bawaan backend
+    long timeout_ms;        // Batas waktu satu permintaan
+    char auth_header[64];   // Nama header untuk API key, kosong = tanpa autentikasi
+    long deadline_ms;       // Batas waktu total termasuk retry dan hedge
+    long hedge_ms;          // Jeda sebelum permintaan duplikat: 0 = otomatis (p95), -1 = mati
+    int retries;            // Jumlah retry untuk HTTP 429/5xx dan kegagalan koneksi
+};
+
+struct ai_config ai_cfg = { "gemini", "", "", 30000, "x-goog-api-key", 30000, 0, 3 };
+
+// PID dan URL mock server AI yang dijalankan dengan "ai mock" (0 = tidak berjalan)
+pid_t ai_mock_pid = 0;
+pid_t ai_mock_owner = 0;           // Proses shell yang menjalankan mock
+char ai_mock_url[64] = "";
+
+// Fungsi untuk mendapatkan path file konfigurasi AI
+void get_ai_config_path(char *path, size_t size) {
+    const char *home_dir = shell_var_get("HOME");
+    if (home_dir != NULL) {
+        snprintf(path, size, "%s/%s", home_dir, AI_CONFIG_FILE);
+    } else {
+        snprintf(path, size, "./%s", AI_CONFIG_FILE);
+    }
+}
+
+// Fungsi untuk mengubah satu nilai konfigurasi AI, mengembalikan 0 jika kunci dikenal
+int set_ai_config_value(const char* key, const char* value) {
+    if (strcmp(key, "backend") == 0) {
+        if (strcmp(value, "gemini") != 0 && strcmp(value, "openai") != 0) {
+            fprintf(stderr, "Backend tidak dikenal: %s (gunakan gemini atau openai)\n", value);
+            return -1;
+        }
+        // Ganti header autentikasi bawaan mengikuti backend
+        if (strcmp(ai_cfg.auth_header, "x-goog-api-key") == 0 || strcmp(ai_cfg.auth_header, "Authorization") == 0) {
+            strcpy(ai_cfg.auth_header, strcmp(value, "gemini") == 0 ? "x-goog-api-key" : "Authorization");
+        }
+        snprintf(ai_cfg.backend, sizeof(ai_cfg.backend), "%s", value);
+    } else if (strcmp(key, "url") == 0) {
+        snprintf(ai_cfg.base_url, sizeof(ai_cfg.base_url), "%s", value);
+        // Hapus garis miring di akhir URL
+        size_t len = strlen(ai_cfg.base_url);
+        while (len > 0 && ai_cfg.base_url[len - 1] == '/') ai_cfg.base_url[--len] = '\0';
+    } else if (strcmp(key, "model") == 0) {
+        snprintf(ai_cfg.model, sizeof(ai_cfg.model), "%s", value);
+    } else if (strcmp(key, "timeout") == 0) {
+        long ms = strtol(value, NULL, 10);
+        if (ms <= 0) {
+            fprintf(stderr, "Timeout harus berupa angka milidetik > 0\n");
+            return -1;
+        }
+        ai_cfg.timeout_ms = ms;
+    } else if (strcmp(key, "deadline") == 0) {
+        long ms = strtol(value, NULL, 10);
+        if (ms <= 0) {
+            fprintf(stderr, "Deadline harus berupa angka milidetik > 0\n");
+            return -1;
+        }
+        ai_cfg.deadline_ms = ms;
+    } else if (strcmp(key, "hedge") == 0) {
+        // "auto" = jeda mengikuti p95 latensi, "off" = tanpa hedge, angka = jeda tetap (ms)
+        if (strcmp(value, "auto") == 0) {
+            ai_cfg.hedge_ms = 0;
+        } else if (strcmp(value, "off") == 0) {
+            ai_cfg.hedge_ms = -1;
+        } else if (strtol(value, NULL, 10) > 0) {
+            ai_cfg.hedge_ms = strtol(value, NULL, 10);
+        } else {
+            fprintf(stderr, "Hedge harus auto, off, atau angka milidetik > 0\n");
+            return -1;
+        }
+    } else if (strcmp(key, "retries") == 0) {
+        int n = atoi(value);
+        if (n < 0 || n > 10) {
+            fprintf(stderr, "Retries harus antara 0 dan 10\n");
+            return -1;
+        }
+        ai_cfg.retries = n;
+    } else if (strcmp(key, "auth_header") == 0) {
+        // "none" atau "-" berarti tanpa autentikasi (mis. server inferensi lokal)
+        if (strcmp(value, "none") == 0 || strcmp(value, "-") == 0) value = "";
+        snprintf(ai_cfg.auth_header, sizeof(ai_cfg.auth_header), "%s", value);
+    } else {
+        fprintf(stderr, "Kunci konfigurasi tidak dikenal: %s\n", key);
+        return -1;
+    }
+    return 0;
+}
+
+// Fungsi untuk memuat konfigurasi AI dari file, lalu menimpanya dengan variabel lingkungan
+void load_ai_config() {
+    char config_path[MAX_CMD_LEN];
+    get_ai_config_path(config_path, sizeof(config_path));
+
+    FILE *file = fopen(config_path, "r");
+    if (file != NULL) {
+        char line[512];
+        while (fgets(line, sizeof(line), file) != NULL) {
+            line[strcspn(line, "\n")] = 0;
+            if (line[0] == '#' || line[0] == '\0') continue;
+
+            char* eq = strchr(line, '=');
+            if (eq == NULL) continue;
+            *eq = '\0';
+            set_ai_config_value(line, eq + 1);
+        }
+        fclose(file);
+    }
+
+    const struct { const char* env; const char* key; } overrides[] = {
+        {"MISHELL_AI_BACKEND", "backend"},
+        {"MISHELL_AI_URL", "url"},
+        {"MISHELL_AI_MODEL", "model"},
+        {"MISHELL_AI_TIMEOUT", "timeout"},
+        {"MISHELL_AI_AUTH_HEADER", "auth_header"},
+        {"MISHELL_AI_DEADLINE", "deadline"},
+        {"MISHELL_AI_HEDGE", "hedge"},
+        {"MISHELL_AI_RETRIES", "retries"},
+    };
+    for (size_t i = 0; i < sizeof(overrides) / sizeof(overrides[0]); i++) {
+        const char* value = shell_var_get(overrides[i].env);
+        if (value != NULL) set_ai_config_value(overrides[i].key, value);
+    }
+}
+
+// Fungsi untuk menyimpan konfigurasi AI ke file
+void save_ai_config() {
+    char config_path[MAX_CMD_LEN];
+    get_ai_config_path(config_path, sizeof(config_path));
+
+    FILE *file = fopen(config_path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Tidak dapat menyimpan konfigurasi AI: %s\n", strerror(errno));
+        return;
+    }
+
+    fprintf(file, "backend=%s\n", ai_cfg.backend);
+    fprintf(file, "url=%s\n", ai_cfg.base_url);
+    fprintf(file, "model=%s\n", ai_cfg.model);
+    fprintf(file, "timeout=%ld\n", ai_cfg.timeout_ms);
+    fprintf(file, "auth_header=%s\n", ai_cfg.auth_header[0] ? ai_cfg.auth_header : "none");
+    fprintf(file, "deadline=%ld\n", ai_cfg.deadline_ms);
+    if (ai_cfg.hedge_ms == 0) {
+        fprintf(file, "hedge=auto\n");
+    } else if (ai_cfg.hedge_ms < 0) {
+        fprintf(file, "hedge=off\n");
+    } else {
+        fprintf(file, "hedge=%ld\n", ai_cfg.hedge_ms);
+    }
+    fprintf(file, "retries=%d\n", ai_cfg.retries);
+    fclose(file);
+}
+
 // Callback function untuk cURL untuk menangani respons dari API
 static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp) {
     size_t realsize = size * nmemb;
@@ -157,8 +506,8 @@ void setup_ai_api() {
     }
 }
 
-// Fungsi untuk mengurai respons JSON untuk mendapatkan teks hasil
-char* extract_text_from_json(const char* json) {
+// Fungsi untuk mengurai respons JSON: mengambil string setelah marker pertama yang ditemukan
+char* extract_json_text(const char* json, const char* markers[], int num_markers) {
     static char result[MAX_RESPONSE_SIZE] = {0};
     
     // Reset result
@@ -167,21 +516,10 @@ char* extract_text_from_json(const char* json) {
     // Debug: Print the received JSON response
     // printf("DEBUG - Received JSON: %s\n", json);
     
-    // Try different markers that might exist in the response
-    const char* markers[] = {
-        "\"text\": \"",
-        "\"text\":\"",
-        "\"content\": \"",
-        "\"content\":\"",
-        "\"contents\":[{\"parts\":[{\"text\":\"",
-        "\"parts\":[{\"text\":\"",
-        "\"text\":\""
-    };
-    
     const char* text_start = NULL;
     
     // Try each marker
-    for (int m = 0; m < sizeof(markers)/sizeof(markers[0]); m++) {
+    for (int m = 0; m < num_markers; m++) {
         text_start = strstr(json, markers[m]);
         if (text_start) {
             text_start += strlen(markers[m]);
@@ -242,6 +580,22 @@ char* extract_text_from_json(const char* json) {
     return result;
 }
 
+// Fungsi untuk mengurai respons JSON untuk mendapatkan teks hasil
+char* extract_text_from_json(const char* json) {
+    // Try different markers that might exist in the response
+    const char* markers[] = {
+        "\"text\": \"",
+        "\"text\":\"",
+        "\"content\": \"",
+        "\"content\":\"",
+        "\"contents\":[{\"parts\":[{\"text\":\"",
+        "\"parts\":[{\"text\":\"",
+        "\"text\":\""
+    };
+    
+    return extract_json_text(json, markers, sizeof(markers)/sizeof(markers[0]));
+}
+
 // Fungsi untuk membersihkan respon dari Gemini sebelum menjalankannya
 char* clean_command(const char* response) {
     static char cleaned[MAX_CMD_LEN];
@@ -338,1262 +692,13116 @@ char* clean_command(const char* response) {
     return start;
 }
 
-// Fungsi untuk mengirim perintah ke Gemini API dan mendapatkan respons
-void ask_ai_terminal(const char* prompt) {
-    if (!is_api_key_set) {
-        printf("API key belum diatur. Silakan gunakan perintah 'ai setup' terlebih dahulu.\n");
-        return;
+// Fungsi untuk meng-escape string agar aman dimasukkan ke dalam string JSON (hasil harus di-free)
+char* json_escape(const char* str) {
+    size_t len = strlen(str);
+    char* out = malloc(len * 6 + 1);
+    if (out == NULL) return NULL;
+
+    size_t j = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)str[i];
+        switch (c) {
+            case '"':  out[j++] = '\\'; out[j++] = '"'; break;
+            case '\\': out[j++] = '\\'; out[j++] = '\\'; break;
+            case '\n': out[j++] = '\\'; out[j++] = 'n'; break;
+            case '\r': out[j++] = '\\'; out[j++] = 'r'; break;
+            case '\t': out[j++] = '\\'; out[j++] = 't'; break;
+            default:
+                if (c < 0x20) {
+                    j += sprintf(out + j, "\\u%04x", c);
+                } else {
+                    out[j++] = c;
+                }
+        }
     }
-    
+    out[j] = '\0';
+    return out;
+}
+
+// Adapter request/response untuk satu jenis API AI
+struct ai_backend {
+    const char* name;           // Nama di konfigurasi ("gemini", "openai")
+    const char* label;          // Nama yang ditampilkan ke pengguna
+    const char* default_url;
+    const char* default_model;
+    void (*build_url)(const char* base_url, const char* model, char* url, size_t size);
+    char* (*build_request)(const char* escaped_prompt, const char* model);  // Hasil harus di-free
+    char* (*parse_response)(const char* json);
+};
+
+// Fungsi-fungsi adapter Google Gemini (generateContent)
+static void gemini_build_url(const char* base_url, const char* model, char* url, size_t size) {
+    snprintf(url, size, "%s/v1beta/models/%s:generateContent", base_url, model);
+}
+
+static char* gemini_build_request(const char* escaped_prompt, const char* model) {
+    (void)model;
+    size_t size = strlen(escaped_prompt) + 64;
+    char* body = malloc(size);
+    if (body != NULL) {
+        snprintf(body, size, "{\"contents\": [{\"parts\": [{\"text\": \"%s\"}]}]}", escaped_prompt);
+    }
+    return body;
+}
+
+static char* gemini_parse_response(const char* json) {
+    return extract_text_from_json(json);
+}
+
+// Fungsi-fungsi adapter API chat OpenAI-compatible (OpenAI, llama.cpp server, vLLM, dll)
+static void openai_build_url(const char* base_url, const char* model, char* url, size_t size) {
+    (void)model;
+    snprintf(url, size, "%s/v1/chat/completions", base_url);
+}
+
+static char* openai_build_request(const char* escaped_prompt, const char* model) {
+    // Nama model berasal dari konfigurasi, jadi di-escape seperti prompt
+    char* escaped_model = json_escape(model);
+    if (escaped_model == NULL) return NULL;
+    size_t size = strlen(escaped_prompt) + strlen(escaped_model) + 128;
+    char* body = malloc(size);
+    if (body != NULL) {
+        snprintf(body, size,
+                 "{\"model\": \"%s\", \"temperature\": 0, "
+                 "\"messages\": [{\"role\": \"user\", \"content\": \"%s\"}]}",
+                 escaped_model, escaped_prompt);
+    }
+    free(escaped_model);
+    return body;
+}
+
+static char* openai_parse_response(const char* json) {
+    const char* markers[] = { "\"content\": \"", "\"content\":\"" };
+    return extract_json_text(json, markers, 2);
+}
+
+static const struct ai_backend ai_backends[] = {
+    { "gemini", "Gemini", "https://generativelanguage.googleapis.com", "gemini-2.0-flash",
+      gemini_build_url, gemini_build_request, gemini_parse_response },
+    { "openai", "OpenAI-compatible", "http://127.0.0.1:8080", "default",
+      openai_build_url, openai_build_request, openai_parse_response },
+};
+
+// Fungsi untuk mendapatkan adapter backend AI yang sedang aktif
+const struct ai_backend* get_ai_backend() {
+    for (size_t i = 0; i < sizeof(ai_backends) / sizeof(ai_backends[0]); i++) {
+        if (strcmp(ai_backends[i].name, ai_cfg.backend) == 0) {
+            return &ai_backends[i];
+        }
+    }
+    return &ai_backends[0];
+}
+
+// Fungsi untuk mendapatkan base URL yang dipakai (mock server sesi ini > konfigurasi > bawaan)
+const char* ai_base_url(const struct ai_backend* backend) {
+    if (ai_mock_url[0] != '\0') return ai_mock_url;
+    return ai_cfg.base_url[0] ? ai_cfg.base_url : backend->default_url;
+}
+
+// Fungsi untuk memeriksa apakah backend aktif membutuhkan API key
+int ai_requires_api_key() {
+    if (ai_mock_url[0] != '\0') return 0;
+    return strcmp(ai_cfg.backend, "gemini") == 0 && ai_cfg.auth_header[0] != '\0';
+}
+
+// Fungsi pembanding untuk qsort nilai double
+static int compare_doubles(const void* a, const void* b) {
+    double da = *(const double*)a, db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+// Fungsi untuk mendapatkan waktu monotonic dalam milidetik
+double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Hasil satu putaran permintaan AI
+#define AI_RESULT_OK 0        // Jawaban sukses diterima
+#define AI_RESULT_FATAL 1     // Gagal dan tidak perlu diulang (mis. HTTP 400/401)
+#define AI_RESULT_RETRY 2     // Gagal dengan 429/5xx/koneksi, boleh diulang
+#define AI_RESULT_DEADLINE 3  // Deadline total terlampaui
+#define AI_RESULT_CANCELLED 4 // Dibatalkan karena pengguna memilih saran lokal
+
+// Diisi thread utama untuk membatalkan permintaan yang berjalan di latar belakang
+static int ai_request_cancelled = 0;
+#define AI_CANCEL_POLL_MS 100
+
+// Diisi thread utama selama prompt saran lokal ditampilkan: pesan status permintaan latar belakang
+// (retry, HTTP, circuit breaker) tidak dicetak agar tidak menimpa prompt y/n
+static int ai_request_quiet = 0;
+
+// Melindungi statistik, riwayat latensi, dan circuit breaker yang juga diubah thread latar belakang
+static pthread_mutex_t ai_state_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Fungsi untuk mencetak pesan status permintaan AI, kecuali selagi prompt saran lokal ditampilkan
+static void ai_notice(FILE* stream, const char* format, ...) {
+    if (__atomic_load_n(&ai_request_quiet, __ATOMIC_ACQUIRE)) return;
+    va_list ap;
+    va_start(ap, format);
+    vfprintf(stream, format, ap);
+    va_end(ap);
+}
+
+// Satu permintaan HTTP ke backend AI (permintaan utama atau duplikat hedge)
+struct ai_attempt {
     CURL *curl;
-    CURLcode res;
     struct MemoryStruct chunk;
-    
-    chunk.memory = malloc(1);
-    chunk.size = 0;
-    
-    // Get current working directory for context
-    char cwd[MAX_CMD_LEN];
-    if (getcwd(cwd, sizeof(cwd)) == NULL) {
-        strcpy(cwd, "unknown");
+    double start_ms;
+    long http_code;
+    CURLcode result;
+    int done;
+};
+
+// Riwayat latensi permintaan sukses untuk menghitung jeda hedge berbasis p95
+double ai_latency_history[AI_LATENCY_HISTORY];
+int ai_latency_count = 0;
+int ai_latency_next = 0;
+
+// Status circuit breaker backend AI
+int ai_breaker_failures = 0;
+double ai_breaker_open_until = 0;
+
+// Statistik sesi untuk "ai bench"
+struct {
+    int hedged;
+    int hedge_wins;
+    int retries;
+} ai_stats;
+
+// Fungsi untuk mencatat latensi permintaan sukses
+void record_ai_latency(double ms) {
+    pthread_mutex_lock(&ai_state_lock);
+    ai_latency_history[ai_latency_next] = ms;
+    ai_latency_next = (ai_latency_next + 1) % AI_LATENCY_HISTORY;
+    if (ai_latency_count < AI_LATENCY_HISTORY) ai_latency_count++;
+    pthread_mutex_unlock(&ai_state_lock);
+}
+
+// Fungsi untuk menambah satu counter statistik "ai bench"
+static void ai_stats_add(int* counter) {
+    pthread_mutex_lock(&ai_state_lock);
+    (*counter)++;
+    pthread_mutex_unlock(&ai_state_lock);
+}
+
+// Fungsi untuk menghitung jeda sebelum mengirim permintaan hedge
+double ai_hedge_delay_ms() {
+    if (ai_cfg.hedge_ms > 0) return ai_cfg.hedge_ms;
+
+    double sorted[AI_LATENCY_HISTORY];
+    pthread_mutex_lock(&ai_state_lock);
+    int count = ai_latency_count;
+    memcpy(sorted, ai_latency_history, sizeof(double) * count);
+    pthread_mutex_unlock(&ai_state_lock);
+    if (count < 8) return AI_HEDGE_DEFAULT_MS;
+
+    qsort(sorted, count, sizeof(double), compare_doubles);
+    return sorted[(count * 95) / 100];
+}
+
+// Fungsi untuk memulai satu permintaan HTTP di dalam curl multi handle
+static int ai_start_attempt(struct ai_attempt* a, CURLM* multi, const char* url,
+                            struct curl_slist* headers, const char* post_data, double deadline) {
+    memset(a, 0, sizeof(*a));
+    a->curl = curl_easy_init();
+    if (a->curl == NULL) return -1;
+
+    a->chunk.memory = malloc(1);
+    a->chunk.size = 0;
+    a->start_ms = now_ms();
+
+    // Batas waktu per permintaan tidak boleh melewati deadline total
+    long timeout = ai_cfg.timeout_ms;
+    if (deadline - a->start_ms < timeout) timeout = (long)(deadline - a->start_ms) + 1;
+
+    curl_easy_setopt(a->curl, CURLOPT_URL, url);
+    curl_easy_setopt(a->curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(a->curl, CURLOPT_POSTFIELDS, post_data);
+    curl_easy_setopt(a->curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
+    curl_easy_setopt(a->curl, CURLOPT_WRITEDATA, (void *)&a->chunk);
+    curl_easy_setopt(a->curl, CURLOPT_TIMEOUT_MS, timeout);
+    curl_easy_setopt(a->curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(a->curl, CURLOPT_PRIVATE, a);
+
+    curl_multi_add_handle(multi, a->curl);
+    return 0;
+}
+
+// Fungsi untuk membersihkan satu permintaan HTTP
+static void ai_cleanup_attempt(struct ai_attempt* a, CURLM* multi) {
+    if (a->curl == NULL) return;
+    curl_multi_remove_handle(multi, a->curl);
+    curl_easy_cleanup(a->curl);
+    free(a->chunk.memory);
+    a->curl = NULL;
+}
+
+// Fungsi untuk memeriksa apakah kegagalan suatu permintaan layak di-retry
+static int ai_attempt_retryable(const struct ai_attempt* a) {
+    return a->result != CURLE_OK || a->http_code == 429 || a->http_code >= 500;
+}
+
+// Fungsi untuk menjalankan satu putaran permintaan: permintaan utama, lalu duplikat hedge
+// jika belum ada jawaban setelah jeda p95. Jawaban yang datang lebih dulu yang dipakai.
+static int ai_run_round(CURLM* multi, const struct ai_backend* backend, const char* url,
+                        struct curl_slist* headers, const char* post_data, double deadline,
+                        char** response_text) {
+    struct ai_attempt attempts[2];
+    int started = 0;
+    int outcome = -1;
+    double hedge_at = ai_cfg.hedge_ms < 0 ? -1 : now_ms() + ai_hedge_delay_ms();
+
+    if (ai_start_attempt(&attempts[0], multi, url, headers, post_data, deadline) != 0) {
+        return AI_RESULT_FATAL;
     }
-    
-    // Format prompt with more context including current directory
-    char formatted_prompt[MAX_CMD_LEN * 6]; // Ukuran jauh lebih besar untuk menampung semua data
-    
-    // Jika permintaan terkait dengan file (hapus/delete/rm/touch/cat), jalankan ls terlebih dahulu
-    if (strstr(prompt, "hapus") || strstr(prompt, "delete") || strstr(prompt, "rm") || 
-        strstr(prompt, "touch") || strstr(prompt, "cat") || strstr(prompt, "edit") ||
-        strstr(prompt, "file")) {
-        
-        // Dapatkan daftar file di direktori saat ini
-        printf("Memeriksa daftar file di direktori saat ini...\n");
-        
-        FILE *fp;
-        char file_list[MAX_CMD_LEN * 2] = ""; // Ukuran yang lebih besar
-        char line[256];
-        int line_count = 0;
-        
-        // Gunakan perintah ls yang lebih terfokus (tanpa hidden files)
-        fp = popen("ls -l | head -20", "r");
-        if (fp != NULL) {
-            while (fgets(line, sizeof(line), fp) != NULL && line_count < 20) {
-                strcat(file_list, line);
-                line_count++;
+    started = 1;
+
+    while (outcome < 0) {
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        CURLMsg* msg;
+        int queued;
+        while (outcome < 0 && (msg = curl_multi_info_read(multi, &queued)) != NULL) {
+            if (msg->msg != CURLMSG_DONE) continue;
+
+            struct ai_attempt* a = NULL;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&a);
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &a->http_code);
+            a->result = msg->data.result;
+            a->done = 1;
+
+            if (a->result == CURLE_OK && a->http_code < 400) {
+                record_ai_latency(now_ms() - a->start_ms);
+                if (a == &attempts[1]) ai_stats_add(&ai_stats.hedge_wins);
+                *response_text = backend->parse_response(a->chunk.memory);
+                outcome = AI_RESULT_OK;
+            } else if (!ai_attempt_retryable(a)) {
+                ai_notice(stderr, "Backend AI mengembalikan HTTP %ld\n", a->http_code);
+                *response_text = backend->parse_response(a->chunk.memory);
+                outcome = AI_RESULT_FATAL;
+            } else if (a->result != CURLE_OK) {
+                ai_notice(stderr, "curl gagal: %s\n", curl_easy_strerror(a->result));
+            } else {
+                ai_notice(stderr, "Backend AI mengembalikan HTTP %ld\n", a->http_code);
             }
-            pclose(fp);
         }
-        
-        // Sertakan informasi ini dalam prompt
-        snprintf(formatted_prompt, sizeof(formatted_prompt), 
-                 "Kamu adalah asisten terminal Linux yang membantu dengan perintah bash. "
-                 "Tugas kamu adalah memberikan perintah bash yang tepat untuk: \"%s\". "
-                 "PENTING: Direktori kerja saat ini adalah: %s. "
-                 "Daftar file di direktori saat ini:\n%s\n"
-                 "Ikuti aturan ini dengan cermat: "
-                 "1. PERHATIKAN NAMA FILE DENGAN TEPAT sebelum membuat perintah. Pastikan nama file persis sesuai dengan yang ada di direktori. "
-                 "2. Untuk file di direktori saat ini, SELALU gunakan awalan ./ (contoh: ./nama-file) "
-                 "3. Untuk path dengan spasi, SELALU gunakan tanda kutip TUNGGAL, bukan ganda (contoh: './nama file') "
-                 "4. Periksa apakah nama file misalnya 'test.txt' bukan 'tes.txt', perhatikan ejaan yang tepat "
-                 "5. Berikan HANYA perintah bash yang valid, tanpa komentar, backtick, markdown, atau penjelasan "
-                 "Jawaban kamu HANYA berisi perintah siap eksekusi, tidak ada teks tambahan.", 
-                 prompt, cwd, file_list);
-    } else {
-        // Format prompt biasa tanpa daftar file
-        snprintf(formatted_prompt, sizeof(formatted_prompt), 
-                 "Kamu adalah asisten terminal Linux yang membantu dengan perintah bash. "
-                 "Tugas kamu adalah memberikan perintah bash yang tepat untuk: \"%s\". "
-                 "PENTING: Direktori kerja saat ini adalah: %s. "
-                 "Ikuti aturan ini dengan cermat: "
-                 "1. PERHATIKAN NAMA FILE DENGAN TEPAT sebelum membuat perintah. Pastikan nama file persis sesuai dengan yang ada di direktori. "
-                 "2. Untuk file di direktori saat ini, SELALU gunakan awalan ./ (contoh: ./nama-file) "
-                 "3. Untuk path dengan spasi, SELALU gunakan tanda kutip TUNGGAL, bukan ganda (contoh: './nama file') "
-                 "4. Periksa apakah nama file misalnya 'test.txt' bukan 'tes.txt', perhatikan ejaan yang tepat "
-                 "5. Berikan HANYA perintah bash yang valid, tanpa komentar, backtick, markdown, atau penjelasan "
-                 "Jawaban kamu HANYA berisi perintah siap eksekusi, tidak ada teks tambahan.", 
-                 prompt, cwd);
-    }
-    
-    // Escape karakter khusus dalam prompt untuk JSON
-    for (int i = 0; i < strlen(formatted_prompt); i++) {
-        if (formatted_prompt[i] == '"') {
-            memmove(&formatted_prompt[i+1], &formatted_prompt[i], strlen(&formatted_prompt[i]) + 1);
-            formatted_prompt[i] = '\\';
-            i++;
+        if (outcome >= 0) break;
+
+        // Semua permintaan yang sudah dikirim gagal dan boleh diulang
+        if (attempts[0].done && (started == 1 || attempts[1].done)) {
+            // Permintaan utama gagal sebelum jeda hedge: langsung ke retry dengan backoff
+            outcome = AI_RESULT_RETRY;
+            break;
         }
-        else if (formatted_prompt[i] == '\\') {
-            memmove(&formatted_prompt[i+1], &formatted_prompt[i], strlen(&formatted_prompt[i]) + 1);
-            i++;
+
+        if (__atomic_load_n(&ai_request_cancelled, __ATOMIC_ACQUIRE)) {
+            outcome = AI_RESULT_CANCELLED;
+            break;
         }
-    }
-    
-    // Membangun JSON request - gunakan format yang benar untuk model Gemini
-    char post_data[MAX_CMD_LEN * 8]; // Ukuran yang jauh lebih besar untuk menghindari truncation
-    snprintf(post_data, sizeof(post_data), 
-             "{"
-             "\"contents\": [{"
-             "\"parts\": [{\"text\": \"%s\"}]"
-             "}]"
-             "}", formatted_prompt);
-    
-    // Membuat URL dengan API key
-    char url[256];
-    snprintf(url, sizeof(url), 
-             "https://generativelanguage.googleapis.com/v1beta/models/gemini-2.0-flash:generateContent?key=%s", 
-             gemini_api_key);
-    
-    // Inisialisasi cURL
-    curl = curl_easy_init();
-    if (curl) {
-        struct curl_slist *headers = NULL;
-        headers = curl_slist_append(headers, "Content-Type: application/json");
-        
-        curl_easy_setopt(curl, CURLOPT_URL, url);
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_data);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
-        
-        // Untuk debugging
-        // curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
-        
-        printf("Mengirim permintaan ke Gemini AI...\n");
-        
-        // Melakukan request
-        res = curl_easy_perform(curl);
-        
-        if (res != CURLE_OK) {
-            fprintf(stderr, "curl_easy_perform() gagal: %s\n", curl_easy_strerror(res));
-        } else {
-            // Debug: Tampilkan response mentah
-            // printf("Response raw: %s\n", chunk.memory);
-            
-            // Mengurai respons dan menampilkan hasilnya
-            char* response_text = extract_text_from_json(chunk.memory);
-            
-            printf("\n==== Respons dari Gemini AI ====\n");
-            printf("%s\n", response_text);
-            printf("================================\n\n");
-            
-            // Bersihkan perintah dari markdown dan backticks
-            char* cleaned_command = clean_command(response_text);
-            
-            // Ganti karakter escape HTML dengan karakter aslinya
-            replace_html_escapes(cleaned_command);
-            
-            // Periksa apakah perintah kosong setelah dibersihkan atau mengandung string error
-            if (cleaned_command[0] == '\0' || 
-                strstr(cleaned_command, "Tidak dapat") != NULL || 
-                strstr(cleaned_command, "tidak dapat") != NULL ||
-                strstr(cleaned_command, "Error") != NULL) {
-                printf("Maaf, tidak dapat mengekstrak perintah yang valid dari respons AI.\n");
-            } else {
-                // Tanyakan apakah ingin menjalankan perintah tersebut
-                printf("Perintah yang akan dijalankan: %s\n", cleaned_command);
-                printf("Apakah Anda ingin menjalankan perintah ini? (y/n): ");
-                char answer[10];
-                fgets(answer, sizeof(answer), stdin);
-                
-                if (answer[0] == 'y' || answer[0] == 'Y') {
-                    printf("Menjalankan perintah...\n");
-                    
-                    // Periksa apakah ini perintah cd
-                    if (strncmp(cleaned_command, "cd ", 3) == 0) {
-                        // Ekstrak direktori tujuan
-                        char* target_dir = cleaned_command + 3;
-                        
-                        // Hilangkan spasi di awal jika ada
-                        while (*target_dir == ' ') target_dir++;
-                        
-                        // Hapus tanda kutip yang mungkin mengelilingi path
-                        char* clean_dir = remove_surrounding_quotes(target_dir);
-                        
-                        // Jalankan chdir langsung di proses utama
-                        if (chdir(clean_dir) != 0) {
-                            perror("cd");
-                        }
-                    } else if (strncmp(cleaned_command, "rm ", 3) == 0 || 
-                               strncmp(cleaned_command, "touch ", 6) == 0 ||
-                               strncmp(cleaned_command, "mkdir ", 6) == 0 ||
-                               strncmp(cleaned_command, "rmdir ", 6) == 0 ||
-                               strncmp(cleaned_command, "cp ", 3) == 0 ||
-                               strncmp(cleaned_command, "mv ", 3) == 0 ||
-                               strncmp(cleaned_command, "cat ", 4) == 0 ||
-                               strncmp(cleaned_command, "echo ", 5) == 0) {
-                        // Untuk perintah yang bekerja dengan file, tangani path dengan spasi
-                        char bash_command[MAX_CMD_LEN * 2];
-                        
-                        // Membersihkan command dari tanda kutip ganda jika ada
-                        char cleaned_path[MAX_CMD_LEN];
-                        strncpy(cleaned_path, cleaned_command, MAX_CMD_LEN - 1);
-                        cleaned_path[MAX_CMD_LEN - 1] = '\0';
-                        
-                        // Ganti semua tanda kutip ganda menjadi kutip tunggal jika ada
-                        char* ptr = cleaned_path;
-                        while ((ptr = strchr(ptr, '"')) != NULL) {
-                            *ptr = '\'';
-                            ptr++; // Pindahkan pointer ke karakter berikutnya untuk menghindari infinite loop
-                        }
-                        
-                        // Pastikan perintah dengan spasi dalam filename ditangani dengan benar
-                        snprintf(bash_command, sizeof(bash_command), "bash -c \"%s\"", cleaned_path);
-                        
-                        printf("Menjalankan: %s\n", cleaned_path);
-                        // printf("Perintah bash: %s\n", bash_command); // Uncomment untuk debugging
-                        
-                        // Jalankan perintah
-                        int result = system(bash_command);
-                        
-                        if (result != 0) {
-                            printf("Perintah selesai dengan kode keluar: %d\n", WEXITSTATUS(result));
-                        }
-                    } else {
-                        // Untuk perintah lain, gunakan system() seperti biasa
-                        char bash_command[MAX_CMD_LEN + 20];
-                        snprintf(bash_command, sizeof(bash_command), "bash -c \"%s\"", cleaned_command);
-                        int result = system(bash_command);
-                        
-                        if (result != 0) {
-                            printf("Perintah selesai dengan kode keluar: %d\n", WEXITSTATUS(result));
-                        }
-                    }
-                } else {
-                    printf("Perintah tidak dijalankan.\n");
-                }
+
+        double now = now_ms();
+        if (now >= deadline) {
+            ai_notice(stderr, "Deadline %ld ms terlampaui, permintaan AI dibatalkan.\n", ai_cfg.deadline_ms);
+            outcome = AI_RESULT_DEADLINE;
+            break;
+        }
+
+        // Kirim duplikat hedge jika permintaan utama belum menjawab setelah jeda p95
+        if (started == 1 && hedge_at > 0 && now >= hedge_at) {
+            if (ai_start_attempt(&attempts[1], multi, url, headers, post_data, deadline) == 0) {
+                started = 2;
+                ai_stats_add(&ai_stats.hedged);
             }
+            hedge_at = -1;
         }
-        
-        // Membersihkan
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
+
+        double wait = deadline - now;
+        if (started == 1 && hedge_at > 0 && hedge_at - now < wait) wait = hedge_at - now;
+        if (wait > AI_CANCEL_POLL_MS) wait = AI_CANCEL_POLL_MS;     // Agar pembatalan cepat terlihat
+        curl_multi_poll(multi, NULL, 0, (int)wait + 1, NULL);
     }
-    
-    free(chunk.memory);
-}
 
-// Deklarasi fungsi wifi_add
-void wifi_add() {
-    printf("Fungsi wifi_add belum diimplementasikan\n");
+    for (int i = 0; i < started; i++) {
+        ai_cleanup_attempt(&attempts[i], multi);
+    }
+    return outcome;
 }
 
-void setup_dns() {
-    char ip[50], domain[100];
-    char command[512];  // Ukuran buffer yang lebih besar untuk menghindari truncation
-    char ip_parts[4][4]; // Array untuk memisahkan IP ke dalam bagian-bagian (oktets)
+// Fungsi untuk mengirim prompt ke backend AI aktif dan mengembalikan teks jawabannya
+// Menerapkan deadline total, hedge, retry dengan exponential backoff, dan circuit breaker.
+// Mengembalikan NULL jika permintaan gagal. Teks jawaban berada di buffer statis.
+char* ai_send_request(const char* full_prompt) {
+    // Circuit breaker: gagal cepat selama backend dianggap mati
+    int half_open = 0;
+    pthread_mutex_lock(&ai_state_lock);
+    if (ai_breaker_failures >= AI_BREAKER_THRESHOLD) {
+        double wait = ai_breaker_open_until - now_ms();
+        if (wait > 0) {
+            pthread_mutex_unlock(&ai_state_lock);
+            ai_notice(stdout, "Backend AI sedang tidak tersedia, coba lagi dalam %.0f detik.\n", wait / 1000.0 + 0.5);
+            return NULL;
+        }
+        // Setelah masa tunggu, kirim satu permintaan uji tanpa retry
+        half_open = 1;
+    }
+    pthread_mutex_unlock(&ai_state_lock);
 
-    // Meminta input dari user
-    printf("Masukkan IP untuk DNS server (contoh 192.168.100.86): ");
+    const struct ai_backend* backend = get_ai_backend();
+    const char* base_url = ai_base_url(backend);
+    const char* model = ai_cfg.model[0] ? ai_cfg.model : backend->default_model;
 
-    fgets(ip, sizeof(ip), stdin);
-    ip[strcspn(ip, "\n")] = 0;  // Menghapus newline di akhir input
+    char url[512];
+    backend->build_url(base_url, model, url, sizeof(url));
 
-    // Memecah IP menjadi bagian-bagian (oktets)
-    sscanf(ip, "%3s.%3s.%3s.%3s", ip_parts[0], ip_parts[1], ip_parts[2], ip_parts[3]);
+    char* escaped = json_escape(full_prompt);
+    if (escaped == NULL) return NULL;
+    char* post_data = backend->build_request(escaped, model);
+    free(escaped);
+    if (post_data == NULL) return NULL;
 
-    printf("Masukkan domain untuk DNS (contoh: sugax1-server.com): ");
-    fgets(domain, sizeof(domain), stdin);
-    domain[strcspn(domain, "\n")] = 0;  // Menghapus newline di akhir input
+    CURLM *multi = curl_multi_init();
+    if (multi == NULL) {
+        free(post_data);
+        return NULL;
+    }
 
-    // Mengecek apakah bind9 sudah terinstal
-    printf("Memeriksa apakah bind9 sudah terinstal...\n");
-    FILE *fp = popen("which bind9", "r");
-    if (fp == NULL || feof(fp)) {
-        // Jika bind9 belum terinstal, instal bind9
-        printf("bind9 belum terinstal. Menginstal bind9...\n");
-        system("sudo apt-get update");
-        system("sudo apt-get install bind9 -y");
-    } else {
-        printf("bind9 sudah terinstal.\n");
-    }
-
-    // Menyalin file db.127 menjadi db.<ip_user>
-    printf("Menyalin db.127 menjadi db.%s...\n", ip);
-    snprintf(command, sizeof(command), "sudo cp /etc/bind/db.127 /etc/bind/db.%s", ip);
-    system(command);
-
-    // Mengedit file db.<ip_user>
-    printf("Mengedit file db.%s...\n", ip);
-    snprintf(command, sizeof(command), "sudo sed -i 's/localhost/%s/g' /etc/bind/db.%s", domain, ip);
-    system(command);
-    snprintf(command, sizeof(command), "sudo sed -i 's/127.0.0.1/%s/g' /etc/bind/db.%s", ip, ip);
-    system(command);
-
-    // Menyalin file db.local menjadi db.<domain_user>
-    printf("Menyalin db.local menjadi db.%s...\n", domain);
-    snprintf(command, sizeof(command), "sudo cp /etc/bind/db.local /etc/bind/db.%s", domain);
-    system(command);
-
-    // Mengedit file db.<domain_user>
-    printf("Mengedit file db.%s...\n", domain);
-    snprintf(command, sizeof(command), "sudo sed -i 's/localhost/%s/g' /etc/bind/db.%s", domain, domain);
-    system(command);
-    snprintf(command, sizeof(command), "sudo sed -i 's/127.0.0.1/%s/g' /etc/bind/db.%s", ip, domain);
-    system(command);
-
-    // Menambahkan konfigurasi di named.conf.local untuk zona domain
-    printf("Menambahkan konfigurasi zona untuk domain di named.conf.local...\n");
-    snprintf(command, sizeof(command), 
-             "echo 'zone \"%s\" { type master; file \"/etc/bind/db.%s\"; allow-update { none; }; };' | sudo tee -a /etc/bind/named.conf.local", 
-             domain, domain);
-    system(command);
-
-    // Menambahkan konfigurasi untuk zona reverse di named.conf.local
-    // Membalikkan IP dan menggunakan tiga oktet pertama (misalnya, 192.168.100.86 menjadi 100.168.192)
-    char reversed_ip[50];
-    snprintf(reversed_ip, sizeof(reversed_ip), "%s.%s.%s", ip_parts[2], ip_parts[1], ip_parts[0]);
-    
-    printf("Menambahkan konfigurasi zona reverse di named.conf.local...\n");
-    snprintf(command, sizeof(command), 
-             "echo 'zone \"%s.in-addr.arpa\" { type master; file \"/etc/bind/db.%s\"; };' | sudo tee -a /etc/bind/named.conf.local", 
-             reversed_ip, ip);
-    system(command);
+    struct curl_slist *headers = NULL;
+    headers = curl_slist_append(headers, "Content-Type: application/json");
 
-    // Mengedit /etc/resolv.conf untuk menambahkan IP DNS server
-    printf("Menambahkan IP DNS ke /etc/resolv.conf...\n");
-    snprintf(command, sizeof(command), "echo 'nameserver %s' | sudo tee -a /etc/resolv.conf", ip);
-    system(command);
+    // API key dikirim lewat header, bukan query string
+    if (ai_cfg.auth_header[0] != '\0' && is_api_key_set) {
+        char auth[MAX_API_KEY_LEN + 96];
+        if (strcasecmp(ai_cfg.auth_header, "Authorization") == 0) {
+            snprintf(auth, sizeof(auth), "Authorization: Bearer %s", gemini_api_key);
+        } else {
+            snprintf(auth, sizeof(auth), "%s: %s", ai_cfg.auth_header, gemini_api_key);
+        }
+        headers = curl_slist_append(headers, auth);
+    }
 
-    // Mengganti 1.0.0 dengan oktet terakhir IP di file db.<ip_user>
-    printf("Mengganti 1.0.0 dengan oktet terakhir IP di db.%s...\n", ip);
-    snprintf(command, sizeof(command), "sudo sed -i 's/1.0.0/%s/g' /etc/bind/db.%s", ip_parts[3], ip);
-    system(command);
+    char* response_text = NULL;
+    double deadline = now_ms() + ai_cfg.deadline_ms;
+    int max_rounds = half_open ? 1 : ai_cfg.retries + 1;
+    int outcome = AI_RESULT_RETRY;
+    unsigned int seed = (unsigned int)getpid() ^ (unsigned int)(long long)(now_ms() * 1000);  // rand_r: aman dari thread
 
-    // Restart bind9 untuk menerapkan konfigurasi
-    printf("Restarting bind9...\n");
-    system("sudo systemctl restart bind9");
+    for (int round = 0; round < max_rounds; round++) {
+        if (round > 0) {
+            // Exponential backoff dengan jitter, tidak boleh melewati deadline
+            long backoff = AI_BACKOFF_BASE_MS << (round - 1);
+            backoff += rand_r(&seed) % (backoff / 2 + 1);
+            if (now_ms() + backoff >= deadline) {
+                ai_notice(stderr, "Deadline %ld ms terlampaui, permintaan AI tidak diulang.\n", ai_cfg.deadline_ms);
+                outcome = AI_RESULT_DEADLINE;
+                break;
+            }
 
-    // Menampilkan pesan sukses
-    printf("\nKonfigurasi DNS selesai! DNS telah disiapkan dengan IP %s dan domain %s.\n", ip, domain);
-}
+            ai_notice(stdout, "Mencoba ulang dalam %ld ms (percobaan %d/%d)...\n", backoff, round + 1, max_rounds);
+            // Tidur dalam potongan pendek agar pembatalan tidak menunggu backoff selesai
+            double wake = now_ms() + backoff;
+            double left;
+            while (!__atomic_load_n(&ai_request_cancelled, __ATOMIC_ACQUIRE) && (left = wake - now_ms()) > 0) {
+                usleep((useconds_t)((left < AI_CANCEL_POLL_MS ? left : AI_CANCEL_POLL_MS) * 1000));
+            }
+            if (__atomic_load_n(&ai_request_cancelled, __ATOMIC_ACQUIRE)) {
+                outcome = AI_RESULT_CANCELLED;
+                break;
+            }
+            ai_stats_add(&ai_stats.retries);
+        }
 
-// Fungsi untuk menampilkan prompt dengan direktori saat ini
-char* show_prompt() {
-    static char prompt[MAX_CMD_LEN];
-    char cwd[MAX_CMD_LEN];
-    
-    if (getcwd(cwd, sizeof(cwd)) != NULL) {
-        // Menghindari pemeriksaan truncation dengan menjamin ukuran yang cukup
-        char prefix[] = "mishell-EDU [";
-        char suffix[] = "]> ";
-        size_t prefix_len = strlen(prefix);
-        size_t suffix_len = strlen(suffix);
-        size_t cwd_len = strlen(cwd);
-        
-        // Pastikan ukuran total tidak melebihi MAX_CMD_LEN - 1 (untuk null terminator)
-        size_t max_total = MAX_CMD_LEN - 1;
-        
-        if (prefix_len + cwd_len + suffix_len > max_total) {
-            // Jika terlalu panjang, potong path di tengah
-            size_t max_cwd_len = max_total - prefix_len - suffix_len;
-            size_t ellipsis_len = 3; // untuk "..."
-            
-            if (max_cwd_len > ellipsis_len + 10) { // Pastikan masih ada ruang yang cukup setelah pemotongan
-                // Tampilkan bagian awal dan akhir dari path dengan "..." di tengah
-                size_t first_part = (max_cwd_len - ellipsis_len) / 2;
-                size_t second_part = max_cwd_len - ellipsis_len - first_part;
-                
-                // Copy prefix
-                strncpy(prompt, prefix, prefix_len);
-                
-                // Copy bagian awal path
-                strncpy(prompt + prefix_len, cwd, first_part);
-                
-                // Tambahkan "..."
-                strcpy(prompt + prefix_len + first_part, "...");
-                
-                // Copy bagian akhir path
-                strncpy(prompt + prefix_len + first_part + ellipsis_len, 
-                       cwd + (cwd_len - second_part), second_part);
-                
-                // Tambahkan suffix
-                strcpy(prompt + prefix_len + first_part + ellipsis_len + second_part, suffix);
-            } else {
-                // Jika terlalu pendek, gunakan fallback
-                strcpy(prompt, "mishell-EDU> ");
-            }
-        } else {
-            // Jika cukup ruang, gabungkan secara normal
-            strcpy(prompt, prefix);
-            strcat(prompt, cwd);
-            strcat(prompt, suffix);
-        }
+        outcome = ai_run_round(multi, backend, url, headers, post_data, deadline, &response_text);
+        if (outcome != AI_RESULT_RETRY || __atomic_load_n(&ai_request_cancelled, __ATOMIC_ACQUIRE)) break;
+    }
+
+    // Perbarui circuit breaker: jawaban apa pun (termasuk HTTP 4xx) berarti backend hidup
+    if (outcome == AI_RESULT_CANCELLED || __atomic_load_n(&ai_request_cancelled, __ATOMIC_ACQUIRE)) {
+        // Pembatalan bukan tanda backend bermasalah
+    } else if (outcome == AI_RESULT_OK || outcome == AI_RESULT_FATAL) {
+        pthread_mutex_lock(&ai_state_lock);
+        ai_breaker_failures = 0;
+        pthread_mutex_unlock(&ai_state_lock);
     } else {
-        perror("getcwd");
-        strcpy(prompt, "mishell-EDU> ");
+        pthread_mutex_lock(&ai_state_lock);
+        ai_breaker_failures++;
+        int opened = half_open || ai_breaker_failures >= AI_BREAKER_THRESHOLD;
+        if (opened) {
+            ai_breaker_failures = AI_BREAKER_THRESHOLD;
+            ai_breaker_open_until = now_ms() + AI_BREAKER_COOLDOWN_MS;
+        }
+        pthread_mutex_unlock(&ai_state_lock);
+        if (opened) {
+            ai_notice(stdout, "Backend AI gagal berulang kali; permintaan berikutnya ditahan selama %d detik.\n",
+                      AI_BREAKER_COOLDOWN_MS / 1000);
+        }
     }
-    
-    return prompt;
-}
 
-// Fungsi untuk menampilkan daftar perintah yang tersedia
-void list_commands() {
-    printf("\nDaftar perintah yang tersedia:\n");
-    printf("1. cd <direktori>      : Pindah direktori\n");
-    printf("2. echo <pesan>        : Tampilkan pesan\n");
-    printf("3. touch <file>        : Membuat file baru\n");
-    printf("4. edit <file>         : Mengedit file\n");
-    printf("5. q                   : Keluar dari shell\n");
-    printf("6. history             : Menampilkan riwayat perintah\n");
-    printf("7. pwd                 : Menampilkan direktori saat ini\n");
-    printf("8. ls                  : Menampilkan daftar file\n");
-    printf("9. cat <file>          : Menampilkan isi file\n");
-    printf("10. rm <file>          : Menghapus file\n");
-    printf("11. rmdir <dir>        : Menghapus direktori kosong\n");
-    printf("12. mkdir <dir>        : Membuat direktori baru\n");
-    printf("13. clear / cl         : Menghapus layar terminal\n");
-    printf("14. cp <source> <dest> : Menyalin file\n");
-    printf("15. mv <source> <dest> : Memindahkan file\n");
-    printf("16. whoami             : Menampilkan nama pengguna\n");
-    printf("17. date               : Menampilkan tanggal dan waktu\n");
-    printf("18. man <command>      : Menampilkan manual perintah\n");
-    printf("19. head <file>        : Menampilkan beberapa baris pertama file\n");
-    printf("20. tail <file>        : Menampilkan beberapa baris terakhir file\n");
-    printf("21. setup dns          : Meng-Setup DNS dengan cepat\n");
-    printf("22. list perintah      : Menampilkan daftar perintah yang tersedia\n");
-    printf("23. cek battery        : Memeriksa kapasitas baterai\n");
-    printf("24. test speed         : Menguji kecepatan internet\n");
-    printf("25. cek cpu            : Menampilkan informasi penggunaan CPU\n");
-    printf("26. cek ram            : Menampilkan informasi penggunaan RAM\n");
-    printf("27. cek disk           : Menampilkan informasi penggunaan disk\n");
-    printf("28. ai setup           : Menyiapkan Google Gemini API\n");
-    printf("29. ai <pertanyaan>    : Bertanya ke AI tentang perintah terminal\n");
-    printf("30. ai logout          : Menghapus API key Gemini yang tersimpan\n");
-    printf("\nSilakan masukkan perintah!\n");
+    curl_slist_free_all(headers);
+    curl_multi_cleanup(multi);
+    free(post_data);
+
+    return response_text;
 }
 
+// Fungsi untuk membaca satu permintaan HTTP lengkap (header + body) dari socket mock server
+static int read_http_request(int fd, char* buf, size_t size) {
+    size_t len = 0;
+    long content_length = -1;
+    char* body = NULL;
 
-// Fungsi untuk menambahkan perintah ke history
-void add_to_history(char* input) {
-    if (input == NULL || input[0] == '\0')
-        return;
-        
-    if (history_count < MAX_HISTORY) {
-        strcpy(history[history_count], input);
-        history_count++;
-    } else {
-        for (int i = 1; i < MAX_HISTORY; i++) {
-            strcpy(history[i-1], history[i]);
+    while (len < size - 1) {
+        ssize_t n = read(fd, buf + len, size - 1 - len);
+        if (n <= 0) break;
+        len += n;
+        buf[len] = '\0';
+
+        if (body == NULL && (body = strstr(buf, "\r\n\r\n")) != NULL) {
+            body += 4;
+            char* cl = strcasestr(buf, "Content-Length:");
+            content_length = (cl != NULL && cl < body) ? strtol(cl + 15, NULL, 10) : 0;
         }
-        strcpy(history[MAX_HISTORY-1], input);
+        if (body != NULL && (long)(buf + len - body) >= content_length) break;
     }
-    
-    // Juga tambahkan ke readline history
-    add_history(input);
+
+    buf[len] = '\0';
+    return (int)len;
 }
 
-// Fungsi untuk menampilkan history
-void show_history() {
-    for (int i = 0; i < history_count; i++) {
-        printf("%d: %s", i + 1, history[i]);
+// Parameter injeksi gangguan mock server AI (untuk menguji deadline, hedge, retry, dan circuit breaker)
+struct ai_mock_faults {
+    int delay_ms;       // Jeda dasar setiap respons
+    int tail_pct;       // Persentase respons yang sangat lambat (ekor latensi)
+    int tail_ms;        // Jeda tambahan untuk respons lambat
+    int error_pct;      // Persentase respons HTTP 503
+    int ratelimit_pct;  // Persentase respons HTTP 429
+    char reply[256];    // Perintah yang dijawab mock (bawaan "ls -la")
+};
+
+struct ai_mock_faults ai_mock_faults;
+
+// Fungsi untuk mengurai argumen mock server: [port] [--delay ms] [--tail pct ms] [--error pct] [--429 pct] [--reply cmd]
+int parse_ai_mock_args(char** args, int* port) {
+    memset(&ai_mock_faults, 0, sizeof(ai_mock_faults));
+    *port = AI_MOCK_DEFAULT_PORT;
+
+    for (int i = 0; args[i] != NULL; i++) {
+        if (strcmp(args[i], "--delay") == 0 && args[i + 1] != NULL) {
+            ai_mock_faults.delay_ms = atoi(args[++i]);
+        } else if (strcmp(args[i], "--tail") == 0 && args[i + 1] != NULL && args[i + 2] != NULL) {
+            ai_mock_faults.tail_pct = atoi(args[++i]);
+            ai_mock_faults.tail_ms = atoi(args[++i]);
+        } else if (strcmp(args[i], "--error") == 0 && args[i + 1] != NULL) {
+            ai_mock_faults.error_pct = atoi(args[++i]);
+        } else if (strcmp(args[i], "--429") == 0 && args[i + 1] != NULL) {
+            ai_mock_faults.ratelimit_pct = atoi(args[++i]);
+        } else if (strcmp(args[i], "--reply") == 0 && args[i + 1] != NULL) {
+            snprintf(ai_mock_faults.reply, sizeof(ai_mock_faults.reply), "%s", args[++i]);
+        } else if (isdigit((unsigned char)args[i][0])) {
+            *port = atoi(args[i]);
+        } else {
+            fprintf(stderr, "Argumen mock tidak dikenal: %s\n", args[i]);
+            fprintf(stderr, "Gunakan: ai mock [port] [--delay ms] [--tail pct ms] [--error pct] [--429 pct] [--reply perintah]\n");
+            return -1;
+        }
     }
+    return 0;
 }
 
-// Fungsi untuk mem-parsing input perintah
-void parse_input(char* input, char** args) {
-    char* token = strtok(input, " \n");
-    int i = 0;
+// Fungsi untuk melayani satu koneksi mock server AI dengan jawaban tetap
+static void serve_ai_mock_request(int fd) {
+    char request[65536];
+    if (read_http_request(fd, request, sizeof(request)) <= 0) return;
 
-    while (token != NULL) {
-        args[i++] = token;
-        token = strtok(NULL, " \n");
+    // Injeksi gangguan: jeda, ekor latensi, dan kegagalan acak
+    srand(getpid() ^ (unsigned)(now_ms() * 1000));
+    int delay = ai_mock_faults.delay_ms;
+    if (rand() % 100 < ai_mock_faults.tail_pct) delay += ai_mock_faults.tail_ms;
+    if (delay > 0) usleep(delay * 1000);
+
+    int roll = rand() % 100;
+    int status = 0;
+    if (roll < ai_mock_faults.error_pct) {
+        status = 503;
+    } else if (roll < ai_mock_faults.error_pct + ai_mock_faults.ratelimit_pct) {
+        status = 429;
+    }
+    if (status != 0) {
+        char response[256];
+        const char* body = "{\"error\":{\"message\":\"mock fault\"}}";
+        int len = snprintf(response, sizeof(response),
+                           "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\n"
+                           "Content-Length: %zu\r\nConnection: close\r\n\r\n%s",
+                           status, status == 503 ? "Service Unavailable" : "Too Many Requests",
+                           strlen(body), body);
+        if (write(fd, response, len) < 0) {
+            perror("mock write");
+        }
+        return;
+    }
+
+    // Format jawaban mengikuti endpoint yang dipanggil
+    char* mock_command = json_escape(ai_mock_faults.reply[0] ? ai_mock_faults.reply : "ls -la");
+    if (mock_command == NULL) return;
+    char body[2048];
+    if (strstr(request, "/chat/completions") != NULL) {
+        snprintf(body, sizeof(body),
+                 "{\"id\":\"mock\",\"object\":\"chat.completion\",\"choices\":[{\"index\":0,"
+                 "\"message\":{\"role\":\"assistant\",\"content\":\"%s\"},\"finish_reason\":\"stop\"}]}",
+                 mock_command);
+    } else {
+        snprintf(body, sizeof(body),
+                 "{\"candidates\":[{\"content\":{\"parts\":[{\"text\":\"%s\"}],\"role\":\"model\"}}]}",
+                 mock_command);
+    }
+    free(mock_command);
+
+    char response[4096];
+    int len = snprintf(response, sizeof(response),
+                       "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                       "Content-Length: %zu\r\nConnection: close\r\n\r\n%s",
+                       strlen(body), body);
+    if (write(fd, response, len) < 0) {
+        perror("mock write");
     }
-    args[i] = NULL;
 }
 
-// Fungsi untuk menangani input/output redirection
-void handle_redirection(char** args) {
-    int i = 0;
-    int input_redirect = -1, output_redirect = -1;
-    char* input_file = NULL, *output_file = NULL;
+// Fungsi untuk membuka socket TCP yang mendengarkan di alamat IPv4 host:port
+int open_tcp_listener(const char* host, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
 
-    // Menentukan posisi input/output redirection
-    while (args[i] != NULL) {
-        if (strcmp(args[i], "<") == 0) {
-            input_redirect = i;
-            input_file = args[i + 1];
-        } else if (strcmp(args[i], ">") == 0) {
-            output_redirect = i;
-            output_file = args[i + 1];
-        }
-        i++;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        printf("Alamat tidak valid: %s\n", host);
+        close(fd);
+        return -1;
     }
 
-    if (input_redirect != -1) {
-        // Input redirection
-        int fd = open(input_file, O_RDONLY);
-        if (fd == -1) {
-            perror("Error opening input file");
-            return;
-        }
-        dup2(fd, STDIN_FILENO);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 128) != 0) {
+        perror("bind/listen");
         close(fd);
-        args[input_redirect] = NULL;  // Hapus "<" dan file name
+        return -1;
     }
+    return fd;
+}
 
-    if (output_redirect != -1) {
-        // Output redirection
-        int fd = open(output_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-        if (fd == -1) {
-            perror("Error opening output file");
-            return;
+// Fungsi untuk membuka socket TCP yang mendengarkan di 127.0.0.1:port
+int open_loopback_listener(int port) {
+    return open_tcp_listener("127.0.0.1", port);
+}
+
+// Fungsi untuk menjalankan loop mock server AI (satu proses anak per koneksi)
+void run_ai_mock_server(int listen_fd) {
+    signal(SIGCHLD, SIG_IGN);
+
+    while (1) {
+        int client = accept(listen_fd, NULL, NULL);
+        if (client < 0) {
+            if (errno == EINTR) continue;
+            perror("accept");
+            break;
         }
-        dup2(fd, STDOUT_FILENO);
-        close(fd);
-        args[output_redirect] = NULL;  // Hapus ">" dan file name
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(listen_fd);
+            serve_ai_mock_request(client);
+            close(client);
+            _exit(0);
+        }
+        close(client);
     }
 }
 
-// Fungsi untuk mengeksekusi perintah dengan atau tanpa pipe
-void execute_pipeline(char* input) {
-    char* commands[MAX_ARGS];
-    int num_commands = 0;
+// Fungsi untuk menghentikan mock server AI yang berjalan di latar belakang (hanya dari proses pemiliknya)
+void stop_ai_mock() {
+    if (ai_mock_pid > 0 && getpid() == ai_mock_owner) {
+        kill(ai_mock_pid, SIGTERM);
+        waitpid(ai_mock_pid, NULL, 0);
+        ai_mock_pid = 0;
+        ai_mock_url[0] = '\0';
+    }
+}
 
-    // Memecah perintah berdasarkan pipe "|"
-    char* cmd = strtok(input, "|");
-    while (cmd != NULL) {
-        commands[num_commands++] = cmd;
-        cmd = strtok(NULL, "|");
+// Fungsi untuk menjalankan mock server AI di latar belakang dan mengarahkan backend ke sana
+void start_ai_mock(char** args) {
+    if (ai_mock_pid > 0) {
+        printf("Mock server AI sudah berjalan (pid %d). Gunakan 'ai mock stop' terlebih dahulu.\n", ai_mock_pid);
+        return;
     }
 
-    int pipefd[2 * (num_commands - 1)][2];
-    pid_t pid;
+    int port;
+    if (parse_ai_mock_args(args, &port) != 0) return;
 
-    for (int i = 0; i < num_commands; i++) {
-        pipe(pipefd[i]);
+    int listen_fd = open_loopback_listener(port);
+    if (listen_fd < 0) return;
 
-        pid = fork();
-        if (pid == 0) {
-            // Child process
-            if (i > 0) {
-                dup2(pipefd[i - 1][0], STDIN_FILENO);  // Dapatkan input dari pipe sebelumnya
-            }
-            if (i < num_commands - 1) {
-                dup2(pipefd[i][1], STDOUT_FILENO);  // Kirim output ke pipe berikutnya
-            }
+    pid_t pid = fork();
+    if (pid == 0) {
+        run_ai_mock_server(listen_fd);
+        _exit(0);
+    } else if (pid < 0) {
+        perror("fork");
+        close(listen_fd);
+        return;
+    }
 
-            char* args[MAX_ARGS];
-            parse_input(commands[i], args);
-            handle_redirection(args);
-            execvp(args[0], args);
-            perror("execvp");  // Menambahkan error handling di sini
-            exit(1);
-        } else if (pid < 0) {
-            perror("fork");
+    close(listen_fd);
+    ai_mock_pid = pid;
+    ai_mock_owner = getpid();
+    static int stop_registered = 0;
+    if (!stop_registered) {
+        atexit(stop_ai_mock);
+        stop_registered = 1;
+    }
+
+    // Arahkan backend aktif ke mock (hanya untuk sesi ini, tidak disimpan)
+    snprintf(ai_mock_url, sizeof(ai_mock_url), "http://127.0.0.1:%d", port);
+    printf("Mock server AI berjalan di %s (pid %d)\n", ai_mock_url, pid);
+}
+
+// Fungsi untuk mengukur latensi jalur AI sebanyak n permintaan
+void ai_benchmark(int n) {
+    if (n <= 0) n = 10;
+
+    double* latencies = malloc(sizeof(double) * n);
+    if (latencies == NULL) return;
+
+    int ok = 0;
+    double total = 0;
+    memset(&ai_stats, 0, sizeof(ai_stats));
+    printf("Mengirim %d permintaan ke %s...\n", n, get_ai_backend()->label);
+
+    for (int i = 0; i < n; i++) {
+        double start = now_ms();
+        char* text = ai_send_request("Berikan perintah bash untuk menampilkan daftar file.");
+        double elapsed = now_ms() - start;
+        if (text != NULL) {
+            latencies[ok++] = elapsed;
+            total += elapsed;
         }
     }
 
-    // Menutup semua pipe dan menunggu semua child process
-    for (int i = 0; i < num_commands - 1; i++) {
-        close(pipefd[i][0]);
-        close(pipefd[i][1]);
+    if (ok == 0) {
+        printf("Semua permintaan gagal.\n");
+    } else {
+        qsort(latencies, ok, sizeof(double), compare_doubles);
+        printf("Berhasil : %d/%d\n", ok, n);
+        printf("Min      : %.2f ms\n", latencies[0]);
+        printf("Rata-rata: %.2f ms\n", total / ok);
+        printf("p50      : %.2f ms\n", latencies[ok / 2]);
+        printf("p95      : %.2f ms\n", latencies[(int)(ok * 0.95) < ok ? (int)(ok * 0.95) : ok - 1]);
+        printf("Max      : %.2f ms\n", latencies[ok - 1]);
     }
-    for (int i = 0; i < num_commands; i++) {
-        wait(NULL);
+    printf("Hedge    : %d dikirim, %d menang\n", ai_stats.hedged, ai_stats.hedge_wins);
+    printf("Retry    : %d\n", ai_stats.retries);
+
+    free(latencies);
+}
+
+// Fungsi untuk menampilkan konfigurasi backend AI yang aktif
+void show_ai_config() {
+    const struct ai_backend* backend = get_ai_backend();
+    printf("Backend     : %s\n", backend->name);
+    printf("URL         : %s%s\n", ai_base_url(backend), ai_mock_url[0] ? " (mock)" : "");
+    printf("Model       : %s\n", ai_cfg.model[0] ? ai_cfg.model : backend->default_model);
+    printf("Timeout     : %ld ms\n", ai_cfg.timeout_ms);
+    printf("Auth header : %s\n", ai_cfg.auth_header[0] ? ai_cfg.auth_header : "(tanpa autentikasi)");
+    printf("Deadline    : %ld ms\n", ai_cfg.deadline_ms);
+    if (ai_cfg.hedge_ms == 0) {
+        printf("Hedge       : otomatis (p95 = %.0f ms)\n", ai_hedge_delay_ms());
+    } else if (ai_cfg.hedge_ms < 0) {
+        printf("Hedge       : mati\n");
+    } else {
+        printf("Hedge       : %ld ms\n", ai_cfg.hedge_ms);
     }
+    printf("Retries     : %d\n", ai_cfg.retries);
+    printf("API key     : %s\n", is_api_key_set ? "diatur" : "belum diatur");
 }
 
-// Fungsi untuk mengeksekusi perintah dengan atau tanpa pipe
-void execute_command(char** args) {
-    if (args[0] == NULL) return;  // Tidak ada perintah untuk dijalankan
+// Struktur mentah hasil syscall getdents64
+struct linux_dirent64 {
+    unsigned long long d_ino;
+    long long d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
 
-    // Perintah internal "cd"
-    if (strcmp(args[0], "cd") == 0) {
-        if (args[1] == NULL) {
-            fprintf(stderr, "cd: expected argument\n");
-        } else if (chdir(args[1]) != 0) {
-            perror("cd");
-        }
+// Informasi satu entri direktori untuk konteks AI
+struct dir_entry_info {
+    char name[256];
+    mode_t mode;
+    off_t size;
+    time_t mtime;
+    int score;
+};
+
+// Cache entri direktori, berlaku selama device/inode/mtime direktori tidak berubah
+struct dir_context_cache {
+    int valid;
+    dev_t dev;
+    ino_t ino;
+    struct timespec mtime;
+    int count;
+    int total;                  // Jumlah semua entri, termasuk yang melewati batas entries
+    struct dir_entry_info entries[AI_CONTEXT_MAX_ENTRIES];
+};
+
+static struct dir_context_cache dir_cache;
+
+// Kata kunci yang menandakan permintaan berhubungan dengan file (dicocokkan per kata utuh)
+static const char* file_keywords[] = {
+    "hapus", "delete", "rm", "touch", "cat", "edit", "file", "files", "berkas",
+    "folder", "direktori", "salin", "copy", "cp", "pindah", "move", "mv",
+    "rename", "ganti", "buka", "baca", "tampilkan", "isi", NULL
+};
+
+// Fungsi untuk mengumpulkan entri direktori dengan getdents64 + fstatat (tanpa proses tambahan)
+int collect_dir_entries(const char* path) {
+    int dirfd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirfd < 0) {
+        return -1;
     }
-    // Perintah internal "exit"
-    else if (strcmp(args[0], "q") == 0) {
-        exit(0);
+
+    // mtime dibaca sebelum listing, sehingga perubahan selama listing membatalkan cache berikutnya
+    struct stat dir_st;
+    if (fstat(dirfd, &dir_st) != 0) {
+        close(dirfd);
+        return -1;
     }
-    // Perintah internal "setup dns"
-    else if (strcmp(args[0], "setup") == 0 && strcmp(args[1], "dns") == 0) {
-        setup_dns();  // Memanggil fungsi setup_dns
+
+    if (dir_cache.valid && dir_cache.dev == dir_st.st_dev && dir_cache.ino == dir_st.st_ino &&
+        dir_cache.mtime.tv_sec == dir_st.st_mtim.tv_sec &&
+        dir_cache.mtime.tv_nsec == dir_st.st_mtim.tv_nsec) {
+        close(dirfd);
+        return dir_cache.count;
     }
-    // Perintah AI setup
-    else if (strcmp(args[0], "ai") == 0 && args[1] != NULL && strcmp(args[1], "setup") == 0) {
-        setup_ai_api();
+
+    dir_cache.valid = 0;
+    dir_cache.count = 0;
+    dir_cache.total = 0;
+
+    char buf[32768];
+    long nread;
+    while ((nread = syscall(SYS_getdents64, dirfd, buf, sizeof(buf))) > 0) {
+        for (long off = 0; off < nread; ) {
+            struct linux_dirent64* d = (struct linux_dirent64*)(buf + off);
+            off += d->d_reclen;
+
+            // Lewati ".", ".." dan file tersembunyi
+            if (d->d_name[0] == '.') continue;
+
+            // Setelah batas entries hanya dihitung (tanpa fstatat) agar jumlah sisanya tetap tepat
+            dir_cache.total++;
+            if (dir_cache.count == AI_CONTEXT_MAX_ENTRIES) continue;
+
+            struct stat st;
+            if (fstatat(dirfd, d->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+
+            struct dir_entry_info* e = &dir_cache.entries[dir_cache.count++];
+            strncpy(e->name, d->d_name, sizeof(e->name) - 1);
+            e->name[sizeof(e->name) - 1] = '\0';
+            e->mode = st.st_mode;
+            e->size = st.st_size;
+            e->mtime = st.st_mtime;
+            e->score = 0;
+        }
     }
-    // Perintah AI logout
-    else if (strcmp(args[0], "ai") == 0 && args[1] != NULL && 
-             (strcmp(args[1], "logout") == 0 || strcmp(args[1], "keluar") == 0)) {
-        logout_api_key();
+    close(dirfd);
+
+    if (nread < 0) {
+        return -1;
     }
-    // Perintah AI ask
-    else if (strcmp(args[0], "ai") == 0 && args[1] != NULL) {
-        // Menggabungkan semua argumen setelah "ai" menjadi satu prompt
-        char prompt[MAX_CMD_LEN] = "";
-        for (int i = 1; args[i] != NULL; i++) {
-            strcat(prompt, args[i]);
-            strcat(prompt, " ");
+
+    dir_cache.dev = dir_st.st_dev;
+    dir_cache.ino = dir_st.st_ino;
+    dir_cache.mtime = dir_st.st_mtim;
+    dir_cache.valid = 1;
+    return dir_cache.count;
+}
+
+// Fungsi untuk menghitung skor kecocokan fuzzy antara satu kata prompt dan nama file
+// Kata dan nama harus sudah dalam huruf kecil. Mengembalikan 0 jika tidak cocok.
+int fuzzy_score(const char* word, const char* name) {
+    size_t wlen = strlen(word);
+    size_t nlen = strlen(name);
+
+    if (wlen == 0 || nlen == 0) return 0;
+    if (strcmp(word, name) == 0) return 100;
+
+    // Kata muncul utuh di dalam nama (mis. "log" dalam "server.log")
+    const char* found = strstr(name, word);
+    if (found != NULL) {
+        int score = 50 + (int)(30 * wlen / nlen);
+        // Bonus jika cocok di awal nama atau setelah pemisah
+        if (found == name || strchr("._- ", found[-1]) != NULL) score += 10;
+        return score;
+    }
+
+    // Cocok sebagai subsequence (mis. "tglama" dalam "tugas lama.txt"), hanya untuk kata >= 3 huruf
+    if (wlen < 3) return 0;
+    size_t wi = 0, first = 0, last = 0;
+    for (size_t ni = 0; ni < nlen && wi < wlen; ni++) {
+        if (name[ni] == word[wi]) {
+            if (wi == 0) first = ni;
+            last = ni;
+            wi++;
         }
-        
-        ask_ai_terminal(prompt);
     }
-    // Perintah internal "wifi add"
-    else if (strcmp(args[0], "wifi") == 0 && strcmp(args[1], "add") == 0) {
+    if (wi < wlen) return 0;
+
+    // Semakin rapat huruf-huruf yang cocok, semakin tinggi skornya
+    return 10 + (int)(30 * wlen / (last - first + 1));
+}
+
+// Fungsi untuk memecah prompt menjadi kata-kata huruf kecil
+int split_prompt_words(const char* prompt, char words[][64], int max_words) {
+    int count = 0;
+    const char* p = prompt;
+
+    while (*p && count < max_words) {
+        while (*p && !(isalnum((unsigned char)*p) || *p == '.' || *p == '_' || *p == '-')) p++;
+        if (!*p) break;
+
+        // Abaikan awalan "./"
+        if (p[0] == '.' && p[1] == '/') {
+            p += 2;
+            continue;
+        }
+
+        int len = 0;
+        while (*p && (isalnum((unsigned char)*p) || *p == '.' || *p == '_' || *p == '-')) {
+            if (len < 63) words[count][len++] = tolower((unsigned char)*p);
+            p++;
+        }
+        words[count][len] = '\0';
+        if (len >= 2) count++;
+    }
+
+    return count;
+}
+
+// Fungsi pembanding untuk mengurutkan entri berdasarkan skor lalu waktu modifikasi terbaru
+static int compare_dir_entries(const void* a, const void* b) {
+    const struct dir_entry_info* ea = a;
+    const struct dir_entry_info* eb = b;
+
+    if (ea->score != eb->score) return eb->score - ea->score;
+    if (ea->mtime != eb->mtime) return (eb->mtime > ea->mtime) ? 1 : -1;
+    return strcmp(ea->name, eb->name);
+}
+
+// Fungsi untuk menyusun konteks daftar file yang relevan dengan prompt, dibatasi AI_CONTEXT_BUDGET byte
+// Mengembalikan 1 jika konteks perlu disertakan dalam prompt, 0 jika tidak
+int build_dir_context(const char* prompt, char* out, size_t out_size) {
+    char words[32][64];
+    int num_words = split_prompt_words(prompt, words, 32);
+
+    out[0] = '\0';
+
+    int is_file_request = 0;
+    for (int w = 0; w < num_words && !is_file_request; w++) {
+        for (int k = 0; file_keywords[k] != NULL; k++) {
+            if (strcmp(words[w], file_keywords[k]) == 0) {
+                is_file_request = 1;
+                break;
+            }
+        }
+    }
+
+    int count = collect_dir_entries(".");
+    if (count <= 0) return 0;
+
+    // Beri skor setiap entri terhadap kata-kata dalam prompt
+    int best_score = 0;
+    for (int i = 0; i < count; i++) {
+        struct dir_entry_info* e = &dir_cache.entries[i];
+        char lower_name[256];
+        size_t j;
+        for (j = 0; e->name[j] && j < sizeof(lower_name) - 1; j++) {
+            lower_name[j] = tolower((unsigned char)e->name[j]);
+        }
+        lower_name[j] = '\0';
+
+        e->score = 0;
+        for (int w = 0; w < num_words; w++) {
+            int s = fuzzy_score(words[w], lower_name);
+            if (s > e->score) e->score = s;
+        }
+        if (e->score > best_score) best_score = e->score;
+    }
+
+    // Sertakan konteks hanya jika permintaan terkait file atau ada nama file yang disebut
+    if (!is_file_request && best_score < 50) return 0;
+
+    qsort(dir_cache.entries, count, sizeof(struct dir_entry_info), compare_dir_entries);
+
+    size_t budget = out_size < AI_CONTEXT_BUDGET ? out_size : AI_CONTEXT_BUDGET;
+    size_t used = 0;
+    int shown = 0;
+
+    for (int i = 0; i < count; i++) {
+        struct dir_entry_info* e = &dir_cache.entries[i];
+        char line[384];
+        char date[32];
+        char type = S_ISDIR(e->mode) ? 'd' : S_ISLNK(e->mode) ? 'l' : '-';
+
+        strftime(date, sizeof(date), "%Y-%m-%d %H:%M", localtime(&e->mtime));
+        int len = snprintf(line, sizeof(line), "%c %10lld %s %s%s\n", type, (long long)e->size,
+                           date, e->name, S_ISDIR(e->mode) ? "/" : "");
+
+        // Sisakan ruang untuk baris ringkasan di akhir
+        if (len < 0 || used + len + 48 > budget) break;
+        memcpy(out + used, line, len + 1);
+        used += len;
+        shown++;
+    }
+
+    if (shown < dir_cache.total) {
+        snprintf(out + used, out_size - used, "... (%d entri lain tidak ditampilkan)\n", dir_cache.total - shown);
+    }
+
+    return 1;
+}
+
+// Header file indeks saran AI lokal
+struct ai_index_header {
+    char magic[4];          // "MSAI"
+    uint32_t version;
+    uint32_t count;         // Jumlah record
+    uint32_t reserved;
+};
+
+// Satu record indeks: diikuti teks prompt dan perintah (tanpa null terminator), rata 4 byte
+struct ai_index_record {
+    uint32_t size;                          // Ukuran total record termasuk teks dan padding
+    uint16_t prompt_len;
+    uint16_t command_len;
+    uint16_t signature[AI_INDEX_HASHES];    // Tanda tangan MinHash dari trigram prompt
+};
+
+// Indeks yang sedang di-mmap (dimuat saat pertama kali dibutuhkan)
+struct {
+    void* map;
+    size_t size;
+} ai_index;
+
+// Fungsi untuk mendapatkan path file indeks saran AI
+void get_ai_index_path(char *path, size_t size) {
+    const char *home_dir = shell_var_get("HOME");
+    if (home_dir != NULL) {
+        snprintf(path, size, "%s/%s", home_dir, AI_INDEX_FILE);
+    } else {
+        snprintf(path, size, "./%s", AI_INDEX_FILE);
+    }
+}
+
+// Fungsi untuk menormalkan prompt: huruf kecil, satu spasi antar kata
+static void normalize_prompt(const char* prompt, char* out, size_t size) {
+    size_t j = 0;
+    int pending_space = 0;
+
+    for (const char* p = prompt; *p != '\0' && j < size - 2; p++) {
+        if (isalnum((unsigned char)*p) || *p == '.' || *p == '_' || *p == '-' || *p == '/') {
+            if (pending_space && j > 0) out[j++] = ' ';
+            out[j++] = tolower((unsigned char)*p);
+            pending_space = 0;
+        } else {
+            pending_space = 1;
+        }
+    }
+    out[j] = '\0';
+}
+
+// Fungsi hash 64-bit untuk mengacak nilai (splitmix64)
+static uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Fungsi untuk menghitung tanda tangan MinHash dari trigram karakter prompt
+void compute_minhash(const char* prompt, uint16_t* signature) {
+    char norm[MAX_CMD_LEN + 2];
+    char padded[MAX_CMD_LEN + 4];
+
+    normalize_prompt(prompt, norm, sizeof(norm));
+    snprintf(padded, sizeof(padded), " %s ", norm);
+    size_t len = strlen(padded);
+
+    for (int i = 0; i < AI_INDEX_HASHES; i++) signature[i] = 0xFFFF;
+
+    for (size_t k = 0; k + 3 <= len; k++) {
+        // FNV-1a untuk satu trigram
+        uint64_t h = 1469598103934665603ULL;
+        for (int c = 0; c < 3; c++) {
+            h ^= (unsigned char)padded[k + c];
+            h *= 1099511628211ULL;
+        }
+
+        for (int i = 0; i < AI_INDEX_HASHES; i++) {
+            uint16_t v = (uint16_t)(mix64(h ^ ((uint64_t)i * 0x9E3779B97F4A7C15ULL)) >> 48);
+            if (v < signature[i]) signature[i] = v;
+        }
+    }
+}
+
+// Fungsi untuk memetakan (mmap) file indeks jika belum dimuat atau ukurannya berubah
+static int ai_index_map() {
+    char path[MAX_CMD_LEN];
+    get_ai_index_path(path, sizeof(path));
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct ai_index_header)) {
+        close(fd);
+        return -1;
+    }
+
+    if (ai_index.map != NULL && ai_index.size == (size_t)st.st_size) {
+        close(fd);
+        return 0;
+    }
+
+    if (ai_index.map != NULL) {
+        munmap(ai_index.map, ai_index.size);
+        ai_index.map = NULL;
+    }
+
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    const struct ai_index_header* header = map;
+    if (memcmp(header->magic, "MSAI", 4) != 0 || header->version != AI_INDEX_VERSION) {
+        munmap(map, st.st_size);
+        return -1;
+    }
+
+    ai_index.map = map;
+    ai_index.size = st.st_size;
+    return 0;
+}
+
+// Fungsi untuk mencari perintah dengan prompt paling mirip di indeks lokal
+// Mengembalikan kemiripan (0.0 - 1.0) dan mengisi command, atau -1 jika indeks kosong
+double ai_index_lookup(const char* prompt, char* command, size_t size) {
+    if (ai_index_map() != 0) return -1;
+
+    uint16_t signature[AI_INDEX_HASHES];
+    compute_minhash(prompt, signature);
+
+    const char* base = ai_index.map;
+    size_t offset = sizeof(struct ai_index_header);
+    const struct ai_index_record* best = NULL;
+    int best_matches = -1;
+
+    while (offset + sizeof(struct ai_index_record) <= ai_index.size) {
+        const struct ai_index_record* rec = (const struct ai_index_record*)(base + offset);
+        if (rec->size < sizeof(struct ai_index_record) || offset + rec->size > ai_index.size) break;
+
+        int matches = 0;
+        for (int i = 0; i < AI_INDEX_HASHES; i++) {
+            matches += rec->signature[i] == signature[i];
+        }
+        // Record yang lebih baru menang jika kemiripannya sama
+        if (matches >= best_matches) {
+            best_matches = matches;
+            best = rec;
+        }
+        offset += rec->size;
+    }
+
+    if (best == NULL) return -1;
+
+    const char* text = (const char*)(best + 1);
+    size_t len = best->command_len < size - 1 ? best->command_len : size - 1;
+    memcpy(command, text + best->prompt_len, len);
+    command[len] = '\0';
+
+    return (double)best_matches / AI_INDEX_HASHES;
+}
+
+// Fungsi untuk menambahkan pasangan (prompt, perintah yang diterima) ke indeks lokal
+void ai_index_add(const char* prompt, const char* command) {
+    // Lewati jika pasangan yang sama persis sudah ada
+    char existing[MAX_CMD_LEN];
+    if (ai_index_lookup(prompt, existing, sizeof(existing)) >= 1.0 && strcmp(existing, command) == 0) {
+        return;
+    }
+
+    char path[MAX_CMD_LEN];
+    get_ai_index_path(path, sizeof(path));
+
+    // Header dibaca-ubah-tulis di bawah flock agar jumlah record tetap benar saat beberapa shell menulis
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd < 0) return;
+    if (flock(fd, LOCK_EX) != 0) {
+        close(fd);
+        return;
+    }
+
+    struct ai_index_header header;
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header) || memcmp(header.magic, "MSAI", 4) != 0 ||
+        header.version != AI_INDEX_VERSION) {
+        // File baru atau format lama: mulai ulang indeks
+        memcpy(header.magic, "MSAI", 4);
+        header.version = AI_INDEX_VERSION;
+        header.count = 0;
+        header.reserved = 0;
+        if (ftruncate(fd, 0) != 0 || pwrite(fd, &header, sizeof(header), 0) != sizeof(header)) {
+            close(fd);
+            return;
+        }
+    }
+
+    size_t prompt_len = strlen(prompt);
+    size_t command_len = strlen(command);
+    if (prompt_len > 0xFFFF) prompt_len = 0xFFFF;
+    if (command_len > 0xFFFF) command_len = 0xFFFF;
+
+    size_t size = (sizeof(struct ai_index_record) + prompt_len + command_len + 3) & ~(size_t)3;
+    char* buf = calloc(1, size);
+    if (buf == NULL) {
+        close(fd);
+        return;
+    }
+
+    struct ai_index_record* rec = (struct ai_index_record*)buf;
+    rec->size = size;
+    rec->prompt_len = prompt_len;
+    rec->command_len = command_len;
+    compute_minhash(prompt, rec->signature);
+    memcpy(buf + sizeof(*rec), prompt, prompt_len);
+    memcpy(buf + sizeof(*rec) + prompt_len, command, command_len);
+
+    // Record ditulis lewat descriptor O_APPEND (pwrite pada O_APPEND mengabaikan offset di Linux,
+    // jadi header tetap diperbarui lewat descriptor pertama)
+    int append_fd = open(path, O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (append_fd >= 0 && write(append_fd, buf, size) == (ssize_t)size) {
+        header.count++;
+        pwrite(fd, &header, sizeof(header), 0);
+    }
+    if (append_fd >= 0) close(append_fd);
+
+    free(buf);
+    close(fd);
+}
+
+// Fungsi untuk menampilkan atau menghapus indeks saran lokal
+void ai_index_command(const char* action) {
+    char path[MAX_CMD_LEN];
+    get_ai_index_path(path, sizeof(path));
+
+    if (action != NULL && strcmp(action, "clear") == 0) {
+        if (ai_index.map != NULL) {
+            munmap(ai_index.map, ai_index.size);
+            ai_index.map = NULL;
+        }
+        if (remove(path) == 0 || errno == ENOENT) {
+            printf("Indeks saran lokal telah dihapus.\n");
+        } else {
+            fprintf(stderr, "Error menghapus indeks: %s\n", strerror(errno));
+        }
+        return;
+    }
+
+    if (ai_index_map() != 0) {
+        printf("Indeks saran lokal masih kosong.\n");
+        return;
+    }
+
+    const struct ai_index_header* header = ai_index.map;
+    printf("Indeks saran lokal: %u entri, %zu byte (%s)\n", header->count, ai_index.size, path);
+}
+
+// Fungsi untuk menjalankan perintah saran AI yang sudah disetujui pengguna
+void execute_ai_command(const char* command) {
+    printf("Menjalankan perintah...\n");
+    
+    // Jalankan lewat parser dan executor mishell sendiri, sehingga builtin seperti cd
+    // berlaku di proses shell ini. Bash hanya dipakai untuk sintaks yang belum didukung.
+    char command_line[MAX_CMD_LEN];
+    snprintf(command_line, sizeof(command_line), "%s", command);
+    
+    if (needs_bash_fallback(command_line)) {
+        run_with_bash(command_line);
+    } else {
+        run_input_line(command_line);
+    }
+    
+    if (last_exit_status != 0) {
+        printf("Perintah selesai dengan kode keluar: %d\n", last_exit_status);
+    }
+}
+
+// Permintaan AI yang berjalan di thread selagi saran lokal ditawarkan
+struct ai_background_request {
+    pthread_t thread;
+    const char* prompt;
+    char* response;
+};
+
+static void* ai_background_request_run(void* arg) {
+    struct ai_background_request* r = arg;
+    r->response = ai_send_request(r->prompt);
+    return NULL;
+}
+
+// Fungsi untuk menampilkan saran dari indeks lokal; mengembalikan 1 jika pengguna memilihnya
+static int offer_local_suggestion(const char* command, double similarity, const char* other) {
+    printf("\n==== Saran dari riwayat lokal (kemiripan %.0f%%) ====\n", similarity * 100);
+    printf("%s\n", command);
+    printf("=================================================\n\n");
+    printf("Jalankan saran ini? (y = jalankan, n = %s): ", other);
+    fflush(stdout);
+    char answer[10];
+    return fgets(answer, sizeof(answer), stdin) != NULL && (answer[0] == 'y' || answer[0] == 'Y');
+}
+
+// Fungsi untuk mengirim perintah ke Gemini API dan mendapatkan respons
+void ask_ai_terminal(const char* prompt) {
+    // Cari lebih dulu di indeks lokal perintah yang pernah diterima, tanpa jaringan
+    char local_command[MAX_CMD_LEN];
+    double similarity = ai_index_lookup(prompt, local_command, sizeof(local_command));
+    int has_local = similarity >= AI_INDEX_MIN_SIMILARITY;
+    
+    if (ai_requires_api_key() && !is_api_key_set) {
+        // Tanpa API key hanya saran lokal yang bisa ditawarkan
+        if (has_local && offer_local_suggestion(local_command, similarity, "batal")) {
+            execute_ai_command(local_command);
+            return;
+        }
+        printf("API key belum diatur. Silakan gunakan perintah 'ai setup' terlebih dahulu.\n");
+        return;
+    }
+    
+    // Get current working directory for context
+    char cwd[MAX_CMD_LEN];
+    if (getcwd(cwd, sizeof(cwd)) == NULL) {
+        strcpy(cwd, "unknown");
+    }
+    
+    // Format prompt with more context including current directory
+    char formatted_prompt[MAX_CMD_LEN * 6]; // Ukuran jauh lebih besar untuk menampung semua data
+    
+    // Kumpulkan daftar file yang relevan dengan prompt (tanpa menjalankan ls)
+    char file_list[AI_CONTEXT_BUDGET + 64];
+    if (build_dir_context(prompt, file_list, sizeof(file_list))) {
+        printf("Memeriksa daftar file di direktori saat ini...\n");
+        
+        // Sertakan informasi ini dalam prompt
+        snprintf(formatted_prompt, sizeof(formatted_prompt), 
+                 "Kamu adalah asisten terminal Linux yang membantu dengan perintah bash. "
+                 "Tugas kamu adalah memberikan perintah bash yang tepat untuk: \"%s\". "
+                 "PENTING: Direktori kerja saat ini adalah: %s. "
+                 "Daftar file di direktori saat ini (diurutkan menurut relevansi):\n%s\n"
+                 "Ikuti aturan ini dengan cermat: "
+                 "1. PERHATIKAN NAMA FILE DENGAN TEPAT sebelum membuat perintah. Pastikan nama file persis sesuai dengan yang ada di direktori. "
+                 "2. Untuk file di direktori saat ini, SELALU gunakan awalan ./ (contoh: ./nama-file) "
+                 "3. Untuk path dengan spasi, SELALU gunakan tanda kutip TUNGGAL, bukan ganda (contoh: './nama file') "
+                 "4. Periksa apakah nama file misalnya 'test.txt' bukan 'tes.txt', perhatikan ejaan yang tepat "
+                 "5. Berikan HANYA perintah bash yang valid, tanpa komentar, backtick, markdown, atau penjelasan "
+                 "Jawaban kamu HANYA berisi perintah siap eksekusi, tidak ada teks tambahan.", 
+                 prompt, cwd, file_list);
+    } else {
+        // Format prompt biasa tanpa daftar file
+        snprintf(formatted_prompt, sizeof(formatted_prompt), 
+                 "Kamu adalah asisten terminal Linux yang membantu dengan perintah bash. "
+                 "Tugas kamu adalah memberikan perintah bash yang tepat untuk: \"%s\". "
+                 "PENTING: Direktori kerja saat ini adalah: %s. "
+                 "Ikuti aturan ini dengan cermat: "
+                 "1. PERHATIKAN NAMA FILE DENGAN TEPAT sebelum membuat perintah. Pastikan nama file persis sesuai dengan yang ada di direktori. "
+                 "2. Untuk file di direktori saat ini, SELALU gunakan awalan ./ (contoh: ./nama-file) "
+                 "3. Untuk path dengan spasi, SELALU gunakan tanda kutip TUNGGAL, bukan ganda (contoh: './nama file') "
+                 "4. Periksa apakah nama file misalnya 'test.txt' bukan 'tes.txt', perhatikan ejaan yang tepat "
+                 "5. Berikan HANYA perintah bash yang valid, tanpa komentar, backtick, markdown, atau penjelasan "
+                 "Jawaban kamu HANYA berisi perintah siap eksekusi, tidak ada teks tambahan.", 
+                 prompt, cwd);
+    }
+    
+    const struct ai_backend* backend = get_ai_backend();
+    printf("Mengirim permintaan ke %s AI...\n", backend->label);
+    
+    // Jika ada saran lokal, permintaan jaringan tetap berjalan di thread selagi saran ditawarkan.
+    // Memilih saran lokal membatalkan permintaan; menolaknya menunggu jawaban AI.
+    char* response_text;
+    struct ai_background_request request = { .prompt = formatted_prompt, .response = NULL };
+    int background = 0;
+    if (has_local) {
+        __atomic_store_n(&ai_request_quiet, 1, __ATOMIC_RELEASE);
+        background = pthread_create(&request.thread, NULL, ai_background_request_run, &request) == 0;
+        if (!background) __atomic_store_n(&ai_request_quiet, 0, __ATOMIC_RELEASE);
+    }
+    if (background) {
+        int use_local = offer_local_suggestion(local_command, similarity, "tunggu jawaban AI");
+        if (use_local) __atomic_store_n(&ai_request_cancelled, 1, __ATOMIC_RELEASE);
+        __atomic_store_n(&ai_request_quiet, 0, __ATOMIC_RELEASE);
+        pthread_join(request.thread, NULL);
+        __atomic_store_n(&ai_request_cancelled, 0, __ATOMIC_RELEASE);
+        if (use_local) {
+            execute_ai_command(local_command);
+            return;
+        }
+        response_text = request.response;
+        // Pesan kegagalan yang muncul selagi prompt ditampilkan tidak dicetak
+        if (response_text == NULL) printf("Jawaban AI tidak tersedia.\n");
+    } else if (has_local && offer_local_suggestion(local_command, similarity, "tanya AI")) {
+        execute_ai_command(local_command);
+        return;
+    } else {
+        response_text = ai_send_request(formatted_prompt);
+    }
+    
+    // Mengurai respons dan menampilkan hasilnya
+    if (response_text == NULL) {
+        return;
+    }
+    
+    printf("\n==== Respons dari %s AI ====\n", backend->label);
+    printf("%s\n", response_text);
+    printf("================================\n\n");
+    
+    // Bersihkan perintah dari markdown dan backticks
+    char* cleaned_command = clean_command(response_text);
+    
+    // Ganti karakter escape HTML dengan karakter aslinya
+    replace_html_escapes(cleaned_command);
+    
+    // Periksa apakah perintah kosong setelah dibersihkan atau mengandung string error
+    if (cleaned_command[0] == '\0' || 
+        strstr(cleaned_command, "Tidak dapat") != NULL || 
+        strstr(cleaned_command, "tidak dapat") != NULL ||
+        strstr(cleaned_command, "Error") != NULL) {
+        printf("Maaf, tidak dapat mengekstrak perintah yang valid dari respons AI.\n");
+    } else {
+        // Tanyakan apakah ingin menjalankan perintah tersebut
+        printf("Perintah yang akan dijalankan: %s\n", cleaned_command);
+        printf("Apakah Anda ingin menjalankan perintah ini? (y/n): ");
+        char answer[10];
+        fgets(answer, sizeof(answer), stdin);
+        
+        if (answer[0] == 'y' || answer[0] == 'Y') {
+            // Simpan pasangan prompt dan perintah untuk saran lokal berikutnya
+            ai_index_add(prompt, cleaned_command);
+            execute_ai_command(cleaned_command);
+        } else {
+            printf("Perintah tidak dijalankan.\n");
+        }
+    }
+}
+
+// Deklarasi fungsi wifi_add
+void wifi_add() {
+    printf("Fungsi wifi_add belum diimplementasikan\n");
+}
+
+// Fungsi untuk menampilkan prompt dengan direktori saat ini
+char* show_prompt() {
+    static char prompt[MAX_CMD_LEN];
+    char cwd[MAX_CMD_LEN];
+    
+    if (getcwd(cwd, sizeof(cwd)) != NULL) {
+        // Menghindari pemeriksaan truncation dengan menjamin ukuran yang cukup
+        char prefix[] = "mishell-EDU [";
+        char suffix[] = "]> ";
+        size_t prefix_len = strlen(prefix);
+        size_t suffix_len = strlen(suffix);
+        size_t cwd_len = strlen(cwd);
+        
+        // Pastikan ukuran total tidak melebihi MAX_CMD_LEN - 1 (untuk null terminator)
+        size_t max_total = MAX_CMD_LEN - 1;
+        
+        if (prefix_len + cwd_len + suffix_len > max_total) {
+            // Jika terlalu panjang, potong path di tengah
+            size_t max_cwd_len = max_total - prefix_len - suffix_len;
+            size_t ellipsis_len = 3; // untuk "..."
+            
+            if (max_cwd_len > ellipsis_len + 10) { // Pastikan masih ada ruang yang cukup setelah pemotongan
+                // Tampilkan bagian awal dan akhir dari path dengan "..." di tengah
+                size_t first_part = (max_cwd_len - ellipsis_len) / 2;
+                size_t second_part = max_cwd_len - ellipsis_len - first_part;
+                
+                // Copy prefix
+                strncpy(prompt, prefix, prefix_len);
+                
+                // Copy bagian awal path
+                strncpy(prompt + prefix_len, cwd, first_part);
+                
+                // Tambahkan "..."
+                strcpy(prompt + prefix_len + first_part, "...");
+                
+                // Copy bagian akhir path
+                strncpy(prompt + prefix_len + first_part + ellipsis_len, 
+                       cwd + (cwd_len - second_part), second_part);
+                
+                // Tambahkan suffix
+                strcpy(prompt + prefix_len + first_part + ellipsis_len + second_part, suffix);
+            } else {
+                // Jika terlalu pendek, gunakan fallback
+                strcpy(prompt, "mishell-EDU> ");
+            }
+        } else {
+            // Jika cukup ruang, gabungkan secara normal
+            strcpy(prompt, prefix);
+            strcat(prompt, cwd);
+            strcat(prompt, suffix);
+        }
+    } else {
+        perror("getcwd");
+        strcpy(prompt, "mishell-EDU> ");
+    }
+    
+    return prompt;
+}
+
+// Fungsi untuk menampilkan daftar perintah yang tersedia
+void list_commands() {
+    printf("\nDaftar perintah yang tersedia:\n");
+    printf("1. cd <direktori>      : Pindah direktori\n");
+    printf("2. echo <pesan>        : Tampilkan pesan\n");
+    printf("3. touch <file>        : Membuat file baru\n");
+    printf("4. edit <file>         : Mengedit file\n");
+    printf("5. q                   : Keluar dari shell\n");
+    printf("6. history             : Menampilkan riwayat perintah\n");
+    printf("7. pwd                 : Menampilkan direktori saat ini\n");
+    printf("8. ls                  : Menampilkan daftar file\n");
+    printf("9. cat <file>          : Menampilkan isi file\n");
+    printf("10. rm <file>          : Menghapus file\n");
+    printf("11. rmdir <dir>        : Menghapus direktori kosong\n");
+    printf("12. mkdir <dir>        : Membuat direktori baru\n");
+    printf("13. clear / cl         : Menghapus layar terminal\n");
+    printf("14. cp <source> <dest> : Menyalin file\n");
+    printf("15. mv <source> <dest> : Memindahkan file\n");
+    printf("16. whoami             : Menampilkan nama pengguna\n");
+    printf("17. date               : Menampilkan tanggal dan waktu\n");
+    printf("18. man <command>      : Menampilkan manual perintah\n");
+    printf("19. head <file>        : Menampilkan beberapa baris pertama file\n");
+    printf("20. tail <file>        : Menampilkan beberapa baris terakhir file\n");
+    printf("21. setup dns [ip dom] : Meng-Setup DNS BIND (transaksional, --dir)\n");
+    printf("22. list perintah      : Menampilkan daftar perintah yang tersedia\n");
+    printf("23. cek battery        : Memeriksa kapasitas baterai\n");
+    printf("24. test speed [local] : Uji throughput & latensi (curl multi, -n aliran)\n");
+    printf("25. cek cpu [-i ms]    : Menampilkan penggunaan CPU per core\n");
+    printf("26. cek ram [--top N]   : Menampilkan penggunaan RAM dan proses terbesar\n");
+    printf("27. cek disk [-i ms]   : Menampilkan penggunaan disk dan laju I/O\n");
+    printf("28. ai setup           : Menyiapkan Google Gemini API\n");
+    printf("29. ai <pertanyaan>    : Bertanya ke AI tentang perintah terminal\n");
+    printf("30. ai logout          : Menghapus API key Gemini yang tersimpan\n");
+    printf("31. ai config [k v]    : Mengatur backend AI (gemini/openai, url, model, timeout)\n");
+    printf("32. ai mock [port|stop]: Menjalankan mock server AI lokal\n");
+    printf("33. ai bench [n]       : Mengukur latensi backend AI\n");
+    printf("34. ai index [clear]   : Status/hapus indeks saran AI lokal\n");
+    printf("35. cek top [-r hz]    : Dashboard live CPU, RAM, disk, dan load\n");
+    printf("36. cek proc [opsi]    : Daftar proses (urut/filter CPU%%, RSS, user, dll.)\n");
+    printf("37. cek export         : Cetak metrik (--format=openmetrics|json)\n");
+    printf("38. cek serve [stop]   : Server metrik OpenMetrics/JSON di latar belakang\n");
+    printf("39. cek record [start|stop] : Perekam riwayat metrik di latar belakang\n");
+    printf("40. cek history cpu|ram|disk : Sparkline riwayat (--since 1h)\n");
+    printf("41. cek pressure / cek cgroup: PSI dan batas cgroup (-i ms)\n");
+    printf("42. cek net [--live]   : Trafik interface & state socket TCP (-i ms, -a)\n");
+    printf("43. setup dns --from f : Provisioning massal dari CSV/YAML (--dry-run)\n");
+    printf("44. dns bench [local]  : Latensi resolver p50/p99, timeout & SERVFAIL (dns serve)\n");
+    printf("45. pola [-c] <pola>   : Ekspansi glob * ? [..] {a,b} ** yang dialirkan ke stdout\n");
+    printf("46. cari [dir] [-n pola]: Cari file paralel (-t, -s, -m, -d; patuhi .gitignore)\n");
+    printf("47. saring [-i -c -n -l] <pola> [file]: Cari teks (regex ERE) di file/pipe, seperti grep\n");
+    printf("48. hitung [-l -w -c] [file...]: Hitung baris/kata/byte (seperti wc), paralel dengan SIMD\n");
+    printf("49. urut [-n -r -u] [-k N] [file]: Urutkan baris (seperti sort), muat file > RAM\n");
+    printf("50. jalankan <file>    : Jalankan skrip mishell (; && || if for while), bytecode di-cache\n");
+    printf("51. export NAMA=nilai  : Variabel environment ($NAMA, $(...), <(...)); unset NAMA\n");
+    printf("\nSilakan masukkan perintah!\n");
+}
+
+
+// Fungsi untuk menambahkan perintah ke history
+void add_to_history(char* input) {
+    if (input == NULL || input[0] == '\0')
+        return;
+        
+    if (history_count < MAX_HISTORY) {
+        strcpy(history[history_count], input);
+        history_count++;
+    } else {
+        for (int i = 1; i < MAX_HISTORY; i++) {
+            strcpy(history[i-1], history[i]);
+        }
+        strcpy(history[MAX_HISTORY-1], input);
+    }
+    
+    // Juga tambahkan ke readline history
+    add_history(input);
+}
+
+// Fungsi untuk menampilkan history
+void show_history() {
+    for (int i = 0; i < history_count; i++) {
+        printf("%d: %s", i + 1, history[i]);
+    }
+}
+
+// ==================== Pool worker dengan work stealing ====================
+
+// Deque per thread: pemilik mengambil dari bawah (LIFO, lokalitas cache), thread lain mencuri dari atas
+struct work_deque {
+    pthread_mutex_t lock;
+    void** items;
+    int head, tail, capacity;
+};
+
+struct work_pool;
+
+struct work_pool_arg {
+    struct work_pool* pool;
+    int index;
+};
+
+// Pool thread untuk penelusuran paralel; deque terakhir milik thread pemanggil. Pekerjaan dianggap
+// selesai ketika semua item yang didorong sudah dikerjakan (outstanding kembali 0).
+struct work_pool {
+    int workers;
+    struct work_deque deques[WORK_POOL_MAX_WORKERS + 1];
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;
+    int queued;                 // Item di deque yang belum diambil
+    int outstanding;            // Item yang sudah didorong tetapi belum selesai dikerjakan
+    int idle;
+    int finished;
+    void (*run)(void* ctx, void* item, int self);
+    void* ctx;
+    int started;                // Thread yang berhasil dibuat
+    pthread_t threads[WORK_POOL_MAX_WORKERS];
+    struct work_pool_arg args[WORK_POOL_MAX_WORKERS];
+};
+
+// Fungsi untuk menentukan jumlah worker bawaan: satu per CPU selain thread pemanggil
+int work_pool_default_workers() {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus <= 1) return 0;
+    return cpus - 1 < WORK_POOL_MAX_WORKERS ? (int)cpus - 1 : WORK_POOL_MAX_WORKERS;
+}
+
+// Fungsi untuk mendorong item ke deque milik owner; -1 jika memori habis (kerjakan langsung)
+int work_pool_push(struct work_pool* p, int owner, void* item) {
+    struct work_deque* d = &p->deques[owner];
+    pthread_mutex_lock(&d->lock);
+    if (d->tail == d->capacity) {
+        if (d->head > 0) {
+            memmove(d->items, d->items + d->head, (d->tail - d->head) * sizeof(*d->items));
+            d->tail -= d->head;
+            d->head = 0;
+        } else {
+            int capacity = d->capacity ? d->capacity * 2 : 64;
+            void** items = realloc(d->items, capacity * sizeof(*items));
+            if (items == NULL) {
+                pthread_mutex_unlock(&d->lock);
+                return -1;
+            }
+            d->items = items;
+            d->capacity = capacity;
+        }
+    }
+    d->items[d->tail++] = item;
+    pthread_mutex_unlock(&d->lock);
+
+    pthread_mutex_lock(&p->lock);
+    p->queued++;
+    p->outstanding++;
+    if (p->idle > 0) pthread_cond_signal(&p->work_cond);
+    pthread_mutex_unlock(&p->lock);
+    return 0;
+}
+
+// Fungsi untuk mengambil item: dari bawah deque sendiri, atau mencuri dari atas deque lain
+static void* work_pool_take(struct work_pool* p, int self) {
+    for (int k = 0; k <= p->workers; k++) {
+        struct work_deque* d = &p->deques[(self + k) % (p->workers + 1)];
+        void* item = NULL;
+        pthread_mutex_lock(&d->lock);
+        if (d->tail > d->head) item = k == 0 ? d->items[--d->tail] : d->items[d->head++];
+        pthread_mutex_unlock(&d->lock);
+        if (item != NULL) {
+            pthread_mutex_lock(&p->lock);
+            p->queued--;
+            pthread_mutex_unlock(&p->lock);
+            return item;
+        }
+    }
+    return NULL;
+}
+
+// Fungsi loop satu thread pool: kerjakan item sampai semua pekerjaan selesai
+static void work_pool_loop(struct work_pool* p, int self) {
+    for (;;) {
+        void* item = work_pool_take(p, self);
+        if (item != NULL) {
+            p->run(p->ctx, item, self);
+            pthread_mutex_lock(&p->lock);
+            if (--p->outstanding == 0) {
+                p->finished = 1;
+                pthread_cond_broadcast(&p->work_cond);
+            }
+            pthread_mutex_unlock(&p->lock);
+            continue;
+        }
+        pthread_mutex_lock(&p->lock);
+        while (p->queued == 0 && !p->finished) {
+            p->idle++;
+            pthread_cond_wait(&p->work_cond, &p->lock);
+            p->idle--;
+        }
+        int finished = p->finished;
+        pthread_mutex_unlock(&p->lock);
+        if (finished) break;
+    }
+}
+
+static void* work_pool_thread(void* arg) {
+    struct work_pool_arg* a = arg;
+    work_pool_loop(a->pool, a->index);
+    return NULL;
+}
+
+// Fungsi untuk menyiapkan pool dengan sejumlah worker (boleh 0: semua dikerjakan pemanggil).
+// Item boleh didorong ke deque pemanggil (indeks workers) sebelum work_pool_launch.
+void work_pool_init(struct work_pool* p, int workers, void (*run)(void* ctx, void* item, int self), void* ctx) {
+    memset(p, 0, sizeof(*p));
+    p->workers = workers;
+    p->run = run;
+    p->ctx = ctx;
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->work_cond, NULL);
+    for (int i = 0; i <= WORK_POOL_MAX_WORKERS; i++) pthread_mutex_init(&p->deques[i].lock, NULL);
+}
+
+// Fungsi untuk menjalankan thread worker. Jika pembuatan thread gagal, deque-nya tetap dikosongkan
+// oleh thread lain lewat pencurian.
+void work_pool_launch(struct work_pool* p) {
+    for (int i = 0; i < p->workers; i++) {
+        p->args[i].pool = p;
+        p->args[i].index = i;
+        if (pthread_create(&p->threads[i], NULL, work_pool_thread, &p->args[i]) != 0) break;
+        p->started++;
+    }
+}
+
+// Fungsi agar thread pemanggil ikut mengerjakan item sampai pool kosong
+void work_pool_run(struct work_pool* p) {
+    pthread_mutex_lock(&p->lock);
+    int empty = p->outstanding == 0;
+    pthread_mutex_unlock(&p->lock);
+    if (!empty) work_pool_loop(p, p->workers);
+}
+
+// Fungsi untuk menghentikan worker dan membebaskan pool
+void work_pool_stop(struct work_pool* p) {
+    pthread_mutex_lock(&p->lock);
+    p->finished = 1;
+    pthread_cond_broadcast(&p->work_cond);
+    pthread_mutex_unlock(&p->lock);
+    for (int i = 0; i < p->started; i++) pthread_join(p->threads[i], NULL);
+    for (int i = 0; i <= WORK_POOL_MAX_WORKERS; i++) {
+        free(p->deques[i].items);
+        pthread_mutex_destroy(&p->deques[i].lock);
+    }
+    pthread_mutex_destroy(&p->lock);
+    pthread_cond_destroy(&p->work_cond);
+}
+
+// ==================== Glob: * ? [...] {a,b} dan ** ====================
+
+typedef int (*glob_callback)(const char* path, void* ctx);
+
+// Jenis satu segmen pola (bagian di antara '/')
+enum { GLOB_SEG_LITERAL, GLOB_SEG_MATCH, GLOB_SEG_STAR2 };
+
+// Pola glob yang sudah dipecah per segmen
+struct glob_pattern {
+    int count;
+    int absolute;               // Pola diawali '/'
+    int dir_only;               // Pola diakhiri '/': hanya direktori yang cocok
+    int recursive;              // Ada segmen "**"
+    unsigned char kind[GLOB_MAX_SEGMENTS];
+    char* seg[GLOB_MAX_SEGMENTS];       // Pola segmen (dengan escape, untuk fnmatch)
+    char* literal[GLOB_MAX_SEGMENTS];   // Segmen literal tanpa escape
+    char storage[];
+};
+
+// Listing satu direktori dari getdents64, terurut; dibagi bersama lewat cache
+struct glob_listing {
+    dev_t dev;
+    ino_t ino;
+    struct timespec mtime, ctime;
+    int refs;
+    int count;
+    char** names;               // Terurut; tipe d_type ada di names[i][-1]
+};
+
+// Cache listing direktori (direct-mapped per inode), berlaku selama mtime/ctime tidak berubah
+static struct glob_listing* glob_cache[GLOB_CACHE_DIRS];
+static pthread_mutex_t glob_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Satu hasil dalam direktori: path yang cocok dan/atau subdirektori yang perlu ditelusuri
+struct glob_item {
+    char* path;                 // NULL jika nama ini sendiri tidak cocok
+    struct glob_node* child;
+};
+
+// Satu direktori yang ditelusuri dengan himpunan segmen pola yang aktif di sana
+struct glob_node {
+    int dirfd;                  // Dibuka relatif ke direktori induk; -1 = buka lewat path
+    char* prefix;               // Path direktori dengan '/' di akhir ("" untuk direktori kerja)
+    uint64_t states;            // Bit segmen yang aktif
+    int done;                   // Sudah dikerjakan (dilindungi pool.lock)
+    int count;
+    struct glob_item* items;
+};
+
+// Status satu penelusuran glob
+struct glob_walk {
+    struct glob_pattern* pat;
+    int base_fd;
+    struct work_pool pool;
+    pthread_cond_t done_cond;   // Node selesai dikerjakan (bersama pool.lock)
+    int stop;                   // Callback meminta berhenti
+    int open_fds;               // dirfd anak yang sedang terbuka
+};
+
+// Fungsi untuk memeriksa apakah string berisi karakter glob yang tidak di-escape
+static int glob_has_meta(const char* s) {
+    for (; *s != '\0'; s++) {
+        if (*s == '\\' && s[1] != '\0') s++;
+        else if (*s == '*' || *s == '?' || *s == '[') return 1;
+    }
+    return 0;
+}
+
+// Fungsi untuk menghapus escape backslash (hasil ditulis ke out)
+static void glob_unescape(const char* s, char* out) {
+    for (; *s != '\0'; s++) {
+        if (*s == '\\' && s[1] != '\0') s++;
+        *out++ = *s;
+    }
+    *out = '\0';
+}
+
+// Fungsi untuk memecah pola menjadi segmen; mengembalikan NULL jika terlalu banyak segmen
+static struct glob_pattern* glob_compile(const char* pattern) {
+    size_t len = strlen(pattern);
+    struct glob_pattern* p = calloc(1, sizeof(*p) + 2 * (len + 1));
+    if (p == NULL) return NULL;
+    char* copy = p->storage;
+    char* lit = p->storage + len + 1;
+    memcpy(copy, pattern, len + 1);
+
+    p->absolute = copy[0] == '/';
+    p->dir_only = len > 1 && copy[len - 1] == '/';
+    for (char* s = copy; *s != '\0'; ) {
+        while (*s == '/') *s++ = '\0';
+        if (*s == '\0') break;
+        if (p->count == GLOB_MAX_SEGMENTS) {
+            free(p);
+            return NULL;
+        }
+        char* seg = s;
+        while (*s != '\0' && *s != '/') {
+            if (*s == '\\' && s[1] != '\0') s++;
+            s++;
+        }
+        if (*s == '/') *s++ = '\0';
+
+        // "**" berturut-turut sama dengan satu "**"
+        if (strcmp(seg, "**") == 0) {
+            if (p->count > 0 && p->kind[p->count - 1] == GLOB_SEG_STAR2) continue;
+            p->kind[p->count] = GLOB_SEG_STAR2;
+            p->recursive = 1;
+        } else if (glob_has_meta(seg)) {
+            p->kind[p->count] = GLOB_SEG_MATCH;
+        } else {
+            p->kind[p->count] = GLOB_SEG_LITERAL;
+            glob_unescape(seg, lit);
+            p->literal[p->count] = lit;
+            lit += strlen(lit) + 1;
+        }
+        p->seg[p->count++] = seg;
+    }
+    return p;
+}
+
+static int compare_glob_names(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static void glob_listing_put(struct glob_listing* l) {
+    if (l == NULL) return;
+    pthread_mutex_lock(&glob_cache_lock);
+    int last = --l->refs == 0;
+    pthread_mutex_unlock(&glob_cache_lock);
+    if (last) free(l);
+}
+
+// Fungsi untuk membaca listing direktori dengan getdents64 (lewat cache jika isinya belum berubah)
+static struct glob_listing* glob_listing_get(int dirfd) {
+    struct stat st;
+    if (fstat(dirfd, &st) != 0) return NULL;
+
+    unsigned int slot = (unsigned int)(st.st_ino ^ st.st_dev) % GLOB_CACHE_DIRS;
+    pthread_mutex_lock(&glob_cache_lock);
+    struct glob_listing* hit = glob_cache[slot];
+    if (hit != NULL && hit->dev == st.st_dev && hit->ino == st.st_ino &&
+        hit->mtime.tv_sec == st.st_mtim.tv_sec && hit->mtime.tv_nsec == st.st_mtim.tv_nsec &&
+        hit->ctime.tv_sec == st.st_ctim.tv_sec && hit->ctime.tv_nsec == st.st_ctim.tv_nsec) {
+        hit->refs++;
+        pthread_mutex_unlock(&glob_cache_lock);
+        return hit;
+    }
+    pthread_mutex_unlock(&glob_cache_lock);
+
+    // Setiap entri disimpan sebagai [tipe][nama\0] berurutan dalam satu buffer, sehingga setelah
+    // pointer nama diurutkan, tipe tetap terbaca di names[i][-1]
+    size_t text_len = 0, text_cap = 16384;
+    int count = 0;
+    char* text = malloc(text_cap);
+    char buf[32768];
+    long nread = 0;
+    while (text != NULL && (nread = syscall(SYS_getdents64, dirfd, buf, sizeof(buf))) > 0) {
+        for (long off = 0; off < nread; ) {
+            struct linux_dirent64* d = (struct linux_dirent64*)(buf + off);
+            off += d->d_reclen;
+            if (d->d_name[0] == '.' && (d->d_name[1] == '\0' || (d->d_name[1] == '.' && d->d_name[2] == '\0'))) {
+                continue;
+            }
+            size_t n = strlen(d->d_name) + 1;
+            if (text_len + n + 1 > text_cap) {
+                char* grown = realloc(text, text_cap *= 2);
+                if (grown == NULL) {
+                    free(text);
+                    return NULL;
+                }
+                text = grown;
+            }
+            text[text_len] = d->d_type;
+            memcpy(text + text_len + 1, d->d_name, n);
+            text_len += n + 1;
+            count++;
+        }
+    }
+
+    struct glob_listing* l = text != NULL ? malloc(sizeof(*l) + count * sizeof(char*) + text_len) : NULL;
+    if (l != NULL) {
+        l->dev = st.st_dev;
+        l->ino = st.st_ino;
+        l->mtime = st.st_mtim;
+        l->ctime = st.st_ctim;
+        l->refs = 1;
+        l->count = count;
+        l->names = (char**)(l + 1);
+        char* block = (char*)(l->names + count);
+        memcpy(block, text, text_len);
+        for (int i = 0; i < count; i++) {
+            l->names[i] = block + 1;
+            block += strlen(block + 1) + 2;
+        }
+        qsort(l->names, count, sizeof(char*), compare_glob_names);
+
+        // Direktori yang baru saja berubah tidak di-cache: granularitas timestamp bisa menyembunyikan
+        // perubahan berikutnya dalam detik yang sama
+        if (nread == 0 && time(NULL) - st.st_mtim.tv_sec > 1 && time(NULL) - st.st_ctim.tv_sec > 1) {
+            pthread_mutex_lock(&glob_cache_lock);
+            struct glob_listing* old = glob_cache[slot];
+            glob_cache[slot] = l;
+            l->refs++;
+            int free_old = old != NULL && --old->refs == 0;
+            pthread_mutex_unlock(&glob_cache_lock);
+            if (free_old) free(old);
+        }
+    }
+    free(text);
+    return l;
+}
+
+// Fungsi untuk menambahkan segmen yang aktif lewat "**" (nol direktori) ke himpunan state
+static uint64_t glob_closure(const struct glob_pattern* p, uint64_t states) {
+    for (int s = 0; s < p->count - 1; s++) {
+        if ((states >> s & 1) && p->kind[s] == GLOB_SEG_STAR2) states |= 1ULL << (s + 1);
+    }
+    return states;
+}
+
+// Fungsi untuk membaca tipe entri jika getdents tidak menyediakannya (DT_UNKNOWN)
+static unsigned char glob_entry_type(int dirfd, const char* name, unsigned char type) {
+    if (type != DT_UNKNOWN) return type;
+    struct stat st;
+    if (fstatat(dirfd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) return DT_UNKNOWN;
+    if (S_ISDIR(st.st_mode)) return DT_DIR;
+    if (S_ISLNK(st.st_mode)) return DT_LNK;
+    return DT_REG;
+}
+
+// Fungsi untuk memeriksa apakah entri adalah direktori, mengikuti symlink
+static int glob_is_dir(int dirfd, const char* name, unsigned char type) {
+    if (type == DT_DIR) return 1;
+    if (type != DT_LNK && type != DT_UNKNOWN) return 0;
+    struct stat st;
+    return fstatat(dirfd, name, &st, 0) == 0 && S_ISDIR(st.st_mode);
+}
+
+// Fungsi untuk menambahkan item hasil ke node
+static struct glob_item* glob_add_item(struct glob_node* node, int* capacity) {
+    if (node->count == *capacity) {
+        int grown = *capacity ? *capacity * 2 : 16;
+        struct glob_item* items = realloc(node->items, grown * sizeof(*items));
+        if (items == NULL) return NULL;
+        node->items = items;
+        *capacity = grown;
+    }
+    struct glob_item* item = &node->items[node->count++];
+    item->path = NULL;
+    item->child = NULL;
+    return item;
+}
+
+static void glob_run_node(struct glob_walk* w, struct glob_node* node, int owner);
+
+// Fungsi untuk mencocokkan satu entri terhadap state aktif: apakah cocok penuh, dan state untuk isinya
+static int glob_match_entry(const struct glob_pattern* p, uint64_t states, int dirfd, const char* name,
+                            unsigned char* type, uint64_t* child_states) {
+    int last = p->count - 1, emit = 0, hidden = name[0] == '.';
+    *child_states = 0;
+    for (int s = 0; s <= last; s++) {
+        if (!(states >> s & 1)) continue;
+        if (p->kind[s] == GLOB_SEG_STAR2) {
+            // "**" tidak masuk ke file tersembunyi dan tidak mengikuti symlink direktori
+            if (hidden) continue;
+            *type = glob_entry_type(dirfd, name, *type);
+            if (s == last) emit = 1;
+            if (*type == DT_DIR) *child_states |= 1ULL << s;
+            continue;
+        }
+        int matched = p->kind[s] == GLOB_SEG_LITERAL ? strcmp(p->literal[s], name) == 0
+                                                     : fnmatch(p->seg[s], name, FNM_PERIOD) == 0;
+        if (!matched) continue;
+        if (s == last) emit = 1;
+        else *child_states |= 1ULL << (s + 1);
+    }
+    if (emit && p->dir_only && !glob_is_dir(dirfd, name, *type)) emit = 0;
+    return emit;
+}
+
+// Fungsi untuk mengerjakan satu node: baca listing (atau cek langsung segmen literal) lalu
+// catat hasil terurut dan buat node anak untuk subdirektori yang masih perlu ditelusuri
+static void glob_visit(struct glob_walk* w, struct glob_node* node, int owner) {
+    const struct glob_pattern* p = w->pat;
+    int capacity = 0;
+    int fd = node->dirfd;
+    if (fd < 0 && !w->stop) {
+        fd = openat(w->base_fd, node->prefix[0] != '\0' ? node->prefix : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    } else if (fd >= 0) {
+        __atomic_fetch_sub(&w->open_fds, 1, __ATOMIC_RELAXED);
+    }
+    if (fd < 0 || w->stop) {
+        if (fd >= 0) close(fd);
+        return;
+    }
+
+    uint64_t states = glob_closure(p, node->states);
+    int all_literal = 1;
+    for (int s = 0; s < p->count; s++) {
+        if ((states >> s & 1) && p->kind[s] != GLOB_SEG_LITERAL) all_literal = 0;
+    }
+
+    // Semua segmen aktif literal: cukup fstatat per nama, tanpa membaca isi direktori
+    struct glob_listing* listing = NULL;
+    char* literal_names[GLOB_MAX_SEGMENTS];
+    char** names = literal_names;
+    int count = 0;
+    if (all_literal) {
+        for (int s = 0; s < p->count; s++) {
+            if (states >> s & 1) literal_names[count++] = p->literal[s];
+        }
+        qsort(literal_names, count, sizeof(char*), compare_glob_names);
+    } else {
+        listing = glob_listing_get(fd);
+        if (listing != NULL) {
+            names = listing->names;
+            count = listing->count;
+        } else {
+            count = 0;
+        }
+    }
+
+    size_t prefix_len = strlen(node->prefix);
+    for (int i = 0; i < count && !w->stop; i++) {
+        const char* name = names[i];
+        if (all_literal && i > 0 && strcmp(name, names[i - 1]) == 0) continue;
+        unsigned char type = DT_UNKNOWN;
+        if (all_literal) {
+            struct stat st;
+            if (fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+            type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISLNK(st.st_mode) ? DT_LNK : DT_REG;
+        } else {
+            type = (unsigned char)name[-1];
+        }
+
+        uint64_t child_states;
+        int emit = glob_match_entry(p, states, fd, name, &type, &child_states);
+        if (child_states != 0 && !glob_is_dir(fd, name, type)) child_states = 0;
+        if (!emit && child_states == 0) continue;
+
+        struct glob_item* item = glob_add_item(node, &capacity);
+        if (item == NULL) break;
+        size_t name_len = strlen(name);
+        if (emit) {
+            item->path = malloc(prefix_len + name_len + 2);
+            if (item->path != NULL) {
+                memcpy(item->path, node->prefix, prefix_len);
+                memcpy(item->path + prefix_len, name, name_len + 1);
+                if (p->dir_only) strcpy(item->path + prefix_len + name_len, "/");
+            }
+        }
+        if (child_states != 0) {
+            struct glob_node* child = calloc(1, sizeof(*child));
+            char* prefix = malloc(prefix_len + name_len + 2);
+            if (child == NULL || prefix == NULL) {
+                free(child);
+                free(prefix);
+                continue;
+            }
+            memcpy(prefix, node->prefix, prefix_len);
+            memcpy(prefix + prefix_len, name, name_len);
+            strcpy(prefix + prefix_len + name_len, "/");
+            child->prefix = prefix;
+            child->states = child_states;
+            // Buka relatif ke dirfd induk selama anggaran fd masih ada; sisanya dibuka lewat path nanti
+            child->dirfd = -1;
+            if (__atomic_add_fetch(&w->open_fds, 1, __ATOMIC_RELAXED) <= GLOB_MAX_OPEN_FDS) {
+                child->dirfd = openat(fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            }
+            if (child->dirfd < 0) __atomic_fetch_sub(&w->open_fds, 1, __ATOMIC_RELAXED);
+            item->child = child;
+        }
+    }
+    glob_listing_put(listing);
+    close(fd);
+
+    // Anak didorong terbalik agar pemilik deque mengerjakan anak pertama lebih dulu (urutan emisi).
+    // Node yang gagal masuk deque dikerjakan langsung di sini.
+    if (w->pool.workers > 0) {
+        for (int i = node->count - 1; i >= 0; i--) {
+            struct glob_node* child = node->items[i].child;
+            if (child != NULL && work_pool_push(&w->pool, owner, child) != 0) glob_run_node(w, child, owner);
+        }
+    }
+}
+
+// Fungsi untuk mengerjakan node lalu menandainya selesai bagi thread yang mengeluarkan hasil
+static void glob_run_node(struct glob_walk* w, struct glob_node* node, int owner) {
+    glob_visit(w, node, owner);
+    pthread_mutex_lock(&w->pool.lock);
+    node->done = 1;
+    pthread_cond_broadcast(&w->done_cond);
+    pthread_mutex_unlock(&w->pool.lock);
+}
+
+static void glob_pool_run(void* ctx, void* item, int self) {
+    glob_run_node(ctx, item, self);
+}
+
+// Fungsi untuk mengeluarkan hasil node secara berurutan (DFS). Tanpa worker, node dikerjakan di sini;
+// dengan worker, node yang sudah didorong ke deque ditunggu sampai selesai (node tidak boleh dibebaskan
+// selama masih ada di deque). Node dibebaskan setelah dikeluarkan.
+static void glob_emit_node(struct glob_walk* w, struct glob_node* node, glob_callback cb, void* ctx, int* matches) {
+    if (w->pool.workers == 0) {
+        glob_run_node(w, node, 0);
+    } else {
+        pthread_mutex_lock(&w->pool.lock);
+        while (!node->done) pthread_cond_wait(&w->done_cond, &w->pool.lock);
+        pthread_mutex_unlock(&w->pool.lock);
+    }
+    for (int i = 0; i < node->count; i++) {
+        struct glob_item* item = &node->items[i];
+        if (item->path != NULL) {
+            if (!w->stop) {
+                (*matches)++;
+                if (cb(item->path, ctx) != 0) w->stop = 1;
+            }
+            free(item->path);
+        }
+        if (item->child != NULL) glob_emit_node(w, item->child, cb, ctx, matches);
+    }
+    free(node->items);
+    free(node->prefix);
+    free(node);
+}
+
+// Fungsi untuk menelusuri satu pola (tanpa kurung kurawal) dan memanggil cb untuk setiap path
+// yang cocok, terurut per komponen path. Pola dengan "**" ditelusuri paralel oleh pool worker.
+// Mengembalikan jumlah path yang cocok, atau -1 jika pola tidak valid.
+static int glob_walk_pattern(const char* pattern, glob_callback cb, void* ctx) {
+    struct glob_walk w;
+    memset(&w, 0, sizeof(w));
+    w.pat = glob_compile(pattern);
+    if (w.pat == NULL) return -1;
+    if (w.pat->count == 0) {
+        free(w.pat);
+        return 0;
+    }
+    w.base_fd = open(w.pat->absolute ? "/" : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (w.base_fd < 0) {
+        free(w.pat);
+        return 0;
+    }
+
+    struct glob_node* root = calloc(1, sizeof(*root));
+    if (root == NULL) {
+        close(w.base_fd);
+        free(w.pat);
+        return -1;
+    }
+    root->dirfd = -1;
+    root->prefix = strdup(w.pat->absolute ? "/" : "");
+    root->states = 1;
+    if (root->prefix == NULL) {
+        free(root);
+        close(w.base_fd);
+        free(w.pat);
+        return -1;
+    }
+    // Prefix "/" sudah dibuka sebagai base_fd; path relatif node dihitung dari base_fd
+    if (w.pat->absolute) root->dirfd = dup(w.base_fd);
+    if (root->dirfd >= 0) w.open_fds = 1;
+
+    work_pool_init(&w.pool, w.pat->recursive ? work_pool_default_workers() : 0, glob_pool_run, &w);
+    work_pool_launch(&w.pool);
+    pthread_cond_init(&w.done_cond, NULL);
+
+    if (w.pool.started == 0) w.pool.workers = 0;
+
+    int matches = 0;
+    if (w.pool.workers > 0 && work_pool_push(&w.pool, w.pool.workers, root) != 0) glob_run_node(&w, root, 0);
+    glob_emit_node(&w, root, cb, ctx, &matches);
+
+    work_pool_stop(&w.pool);
+    pthread_cond_destroy(&w.done_cond);
+    close(w.base_fd);
+    free(w.pat);
+    return matches;
+}
+
+// Fungsi untuk mencari pasangan '}' dari '{' di s, sekaligus mendeteksi ',' tingkat atas.
+// Mengembalikan pointer ke '}' atau NULL jika tidak berpasangan.
+static const char* brace_close(const char* s, int* has_comma) {
+    int depth = 0;
+    *has_comma = 0;
+    for (const char* p = s; *p != '\0'; p++) {
+        if (*p == '\\' && p[1] != '\0') p++;
+        else if (*p == '{') depth++;
+        else if (*p == '}' && --depth == 0) return p;
+        else if (*p == ',' && depth == 1) *has_comma = 1;
+    }
+    return NULL;
+}
+
+// Fungsi untuk membaca rentang {a..b} (angka atau satu huruf); mengembalikan 1 jika valid
+static int brace_range(const char* s, size_t len, long* from, long* to, int* is_char) {
+    char body[64];
+    if (len >= sizeof(body)) return 0;
+    memcpy(body, s, len);
+    body[len] = '\0';
+    char* dots = strstr(body, "..");
+    if (dots == NULL) return 0;
+    *dots = '\0';
+    const char* a = body;
+    const char* b = dots + 2;
+    if (isalpha((unsigned char)a[0]) && a[1] == '\0' && isalpha((unsigned char)b[0]) && b[1] == '\0') {
+        *from = a[0];
+        *to = b[0];
+        *is_char = 1;
+        return 1;
+    }
+    char* end_a;
+    char* end_b;
+    *from = strtol(a, &end_a, 10);
+    *to = strtol(b, &end_b, 10);
+    *is_char = 0;
+    return a[0] != '\0' && *end_a == '\0' && b[0] != '\0' && *end_b == '\0' &&
+           labs(*to - *from) < GLOB_MAX_BRACE;
+}
+
+// Fungsi ekspansi kurung kurawal: {a,b} dan {1..5}, bersarang, kiri ke kanan seperti bash.
+// cb dipanggil untuk setiap kata hasil; mengembalikan jumlah kata atau -1 jika dihentikan.
+static int expand_braces(const char* word, glob_callback cb, void* ctx, int* budget) {
+    for (const char* open = word; (open = strchr(open, '{')) != NULL; open++) {
+        if (open > word && open[-1] == '\\') continue;
+        int has_comma;
+        const char* close = brace_close(open, &has_comma);
+        if (close == NULL) break;
+
+        size_t prefix_len = open - word;
+        size_t body_len = close - open - 1;
+        long from, to;
+        int is_char;
+        int is_range = !has_comma && brace_range(open + 1, body_len, &from, &to, &is_char);
+        if (!has_comma && !is_range) continue;
+
+        size_t cap = strlen(word) + 64;
+        char* out = malloc(cap);
+        if (out == NULL) return -1;
+        memcpy(out, word, prefix_len);
+        int total = 0;
+
+        if (is_range) {
+            long step = from <= to ? 1 : -1;
+            for (long v = from; ; v += step) {
+                int n = is_char ? snprintf(out + prefix_len, cap - prefix_len, "%c%s", (int)v, close + 1)
+                                : snprintf(out + prefix_len, cap - prefix_len, "%ld%s", v, close + 1);
+                if (n < 0 || (size_t)n >= cap - prefix_len || --*budget < 0) break;
+                int r = expand_braces(out, cb, ctx, budget);
+                if (r < 0) {
+                    free(out);
+                    return -1;
+                }
+                total += r;
+                if (v == to) break;
+            }
+        } else {
+            // Pecah isi kurung pada ',' tingkat atas
+            const char* alt = open + 1;
+            int depth = 0;
+            for (const char* p = alt; p <= close; p++) {
+                if (*p == '\\' && p < close) {
+                    p++;
+                    continue;
+                }
+                if (*p == '{') depth++;
+                else if (*p == '}' && p < close) depth--;
+                if ((*p == ',' && depth == 0) || p == close) {
+                    size_t alt_len = p - alt;
+                    snprintf(out + prefix_len, cap - prefix_len, "%.*s%s", (int)alt_len, alt, close + 1);
+                    if (--*budget < 0) break;
+                    int r = expand_braces(out, cb, ctx, budget);
+                    if (r < 0) {
+                        free(out);
+                        return -1;
+                    }
+                    total += r;
+                    alt = p + 1;
+                }
+            }
+        }
+        free(out);
+        return total;
+    }
+    return cb(word, ctx) != 0 ? -1 : 1;
+}
+
+// Konteks ekspansi satu kata: kata hasil brace dicocokkan ke filesystem
+struct glob_word_ctx {
+    glob_callback cb;
+    void* ctx;
+    int flags;
+    int stopped;
+};
+
+static int glob_stop_cb(const char* path, void* ctx) {
+    struct glob_word_ctx* c = ctx;
+    if (c->cb(path, c->ctx) != 0) c->stopped = 1;
+    return c->stopped;
+}
+
+static int glob_brace_word(const char* word, void* ctx) {
+    struct glob_word_ctx* c = ctx;
+    int meta = glob_has_meta(word);
+    if (meta && glob_walk_pattern(word, glob_stop_cb, c) > 0) return c->stopped;
+    if (c->stopped) return 1;
+
+    // Kata tanpa karakter glob, atau pola yang tidak cocok apa pun, dipakai apa adanya (seperti bash);
+    // dengan GLOB_NULL, pola kosong tidak menghasilkan apa pun dan kata biasa harus ada di disk
+    char* plain = malloc(strlen(word) + 1);
+    if (plain == NULL) return 0;
+    glob_unescape(word, plain);
+    struct stat st;
+    if (!(c->flags & GLOB_NULL) || (!meta && lstat(plain, &st) == 0)) {
+        if (c->cb(plain, c->ctx) != 0) c->stopped = 1;
+    }
+    free(plain);
+    return c->stopped;
+}
+
+// Fungsi untuk mengekspansi satu kata pola (escape dengan '\') menjadi path, dialirkan ke cb satu per
+// satu tanpa menampung seluruh hasil. Hasil tiap pola terurut per komponen path; cb mengembalikan
+// nonzero untuk berhenti (fungsi lalu mengembalikan -1).
+int glob_stream(const char* pattern, int flags, glob_callback cb, void* ctx) {
+    struct glob_word_ctx c = { cb, ctx, flags, 0 };
+    int budget = GLOB_MAX_BRACE;
+    expand_braces(pattern, glob_brace_word, &c, &budget);
+    return c.stopped ? -1 : 0;
+}
+
+// Pola dari token perintah terakhir yang berisi karakter glob tanpa kutip (diisi parse_input).
+// Kata yang dikutip tidak pernah diekspansi.
+static const char* glob_token[MAX_ARGS];
+static char* glob_token_pattern[MAX_ARGS];
+static char glob_pattern_buf[MAX_CMD_LEN * 2];
+
+// Fungsi untuk mendapatkan pola glob milik argumen (NULL jika argumen bukan pola)
+const char* glob_pattern_of(const char* arg) {
+    for (int i = 0; i < MAX_ARGS && glob_token[i] != NULL; i++) {
+        if (glob_token[i] == arg) return glob_token_pattern[i];
+    }
+    return NULL;
+}
+
+// Fungsi untuk memproses satu argumen builtin: pola dialirkan hasilnya, argumen biasa diteruskan
+int glob_for_each(const char* arg, glob_callback cb, void* ctx) {
+    const char* pattern = glob_pattern_of(arg);
+    if (pattern == NULL) return cb(arg, ctx) != 0 ? -1 : 0;
+    return glob_stream(pattern, 0, cb, ctx);
+}
+
+// Array argv hasil ekspansi (tumbuh sesuai kebutuhan, tidak dibatasi MAX_ARGS)
+struct glob_argv {
+    char** argv;
+    int count, capacity;
+    int overflow;
+};
+
+static int glob_argv_add(const char* path, void* ctx) {
+    struct glob_argv* a = ctx;
+    if (a->count + 1 >= GLOB_MAX_ARGV) {
+        a->overflow = 1;
+        return 1;
+    }
+    if (a->count + 1 >= a->capacity) {
+        int capacity = a->capacity * 2;
+        char** argv = realloc(a->argv, capacity * sizeof(char*));
+        if (argv == NULL) {
+            a->overflow = 1;
+            return 1;
+        }
+        a->argv = argv;
+        a->capacity = capacity;
+    }
+    if ((a->argv[a->count] = strdup(path)) == NULL) {
+        a->overflow = 1;
+        return 1;
+    }
+    a->count++;
+    return 0;
+}
+
+// Fungsi untuk membebaskan argv hasil expand_glob_args (args asli tidak dibebaskan)
+void free_glob_args(char** argv, char** original) {
+    if (argv == NULL || argv == original) return;
+    for (int i = 0; argv[i] != NULL; i++) free(argv[i]);
+    free(argv);
+}
+
+// Fungsi untuk mengekspansi glob di argumen perintah. Mengembalikan args apa adanya jika tidak ada
+// pola, argv baru (bebaskan dengan free_glob_args) jika ada, atau NULL jika hasilnya terlalu banyak.
+char** expand_glob_args(char** args) {
+    int has_pattern = 0;
+    for (int i = 0; args[i] != NULL; i++) {
+        if (glob_pattern_of(args[i]) != NULL) has_pattern = 1;
+    }
+    if (!has_pattern) return args;
+
+    struct glob_argv a = { malloc(64 * sizeof(char*)), 0, 64, 0 };
+    if (a.argv == NULL) return NULL;
+    for (int i = 0; args[i] != NULL && !a.overflow; i++) {
+        const char* pattern = glob_pattern_of(args[i]);
+        // Target redirection tidak diekspansi
+        int after_redirect = i > 0 && (strcmp(args[i - 1], "<") == 0 || strcmp(args[i - 1], ">") == 0);
+        if (pattern == NULL || after_redirect) glob_argv_add(args[i], &a);
+        else glob_stream(pattern, 0, glob_argv_add, &a);
+    }
+    a.argv[a.count] = NULL;
+
+    if (a.overflow) {
+        fprintf(stderr, "mishell: hasil glob terlalu banyak (batas %d argumen); gunakan 'pola', "
+                "mis. pola **/*.c | xargs ...\n", GLOB_MAX_ARGV - 1);
+        free_glob_args(a.argv, NULL);
+        return NULL;
+    }
+    return a.argv;
+}
+
+// Builtin yang menerima pola apa adanya dan mengalirkan hasilnya sendiri (tidak diekspansi ke argv)
+static const char* glob_stream_builtins[] = { "pola", "cari", NULL };
+
+int is_glob_stream_builtin(const char* name) {
+    for (int i = 0; glob_stream_builtins[i] != NULL; i++) {
+        if (strcmp(name, glob_stream_builtins[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+// Fungsi builtin "pola": mengalirkan hasil glob ke stdout tanpa menampungnya di argv
+static int pola_print(const char* path, void* ctx) {
+    int* opts = ctx;
+    opts[1]++;
+    if (opts[0] == 'c') return 0;
+    fputs(path, stdout);
+    putchar(opts[0] == '0' ? '\0' : '\n');
+    return ferror(stdout) ? 1 : 0;
+}
+
+void pola_command(char** args) {
+    int opts[2] = { 0, 0 };     // mode (0 = per baris, '0' = NUL, 'c' = hitung), jumlah
+    int i = 1;
+    for (; args[i] != NULL && args[i][0] == '-' && args[i][1] != '\0'; i++) {
+        if (strcmp(args[i], "-0") == 0) opts[0] = '0';
+        else if (strcmp(args[i], "-c") == 0) opts[0] = 'c';
+        else break;
+    }
+    if (args[i] == NULL) {
+        printf("Penggunaan: pola [-0 | -c] <pola>...   (mis. pola src/**/*.{c,h})\n");
+        last_exit_status = 2;
+        return;
+    }
+    for (; args[i] != NULL; i++) {
+        // Argumen yang dikutip tetap diperlakukan sebagai pola
+        const char* pattern = glob_pattern_of(args[i]);
+        if (glob_stream(pattern != NULL ? pattern : args[i], GLOB_NULL, pola_print, opts) != 0) break;
+    }
+    if (opts[0] == 'c') printf("%d\n", opts[1]);
+    fflush(stdout);
+    last_exit_status = opts[1] > 0 ? 0 : 1;
+}
+
+// ==================== cari: pencari file paralel ====================
+
+// Satu aturan dari .gitignore/.ignore
+struct ignore_rule {
+    char* pattern;
+    unsigned char negate;       // "!pola": batalkan pengabaian
+    unsigned char dir_only;     // "pola/": hanya direktori
+    unsigned char anchored;     // Mengandung '/': dicocokkan terhadap path relatif, bukan nama saja
+};
+
+// Aturan abaikan milik satu direktori; berantai ke aturan direktori induk (dibagi antar thread)
+struct ignore_set {
+    struct ignore_set* parent;
+    int refs;
+    size_t base_len;            // Panjang path direktori pemilik aturan (dengan '/'), untuk path relatif
+    int count;
+    struct ignore_rule* rules;
+    char* text;
+};
+
+// Direktori VCS yang selalu dilewati kecuali dengan -a
+static const char* cari_vcs_dirs[] = { ".git", ".hg", ".svn", NULL };
+
+static void ignore_set_put(struct ignore_set* s) {
+    while (s != NULL && __atomic_sub_fetch(&s->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        struct ignore_set* parent = s->parent;
+        free(s->rules);
+        free(s->text);
+        free(s);
+        s = parent;
+    }
+}
+
+static struct ignore_set* ignore_set_get(struct ignore_set* s) {
+    if (s != NULL) __atomic_add_fetch(&s->refs, 1, __ATOMIC_RELAXED);
+    return s;
+}
+
+// Fungsi untuk membaca .gitignore dan .ignore di direktori; mengembalikan set baru atau parent apa adanya
+static struct ignore_set* load_ignore_set(int dirfd, struct ignore_set* parent, size_t base_len) {
+    static const char* files[] = { ".gitignore", ".ignore" };
+    struct ignore_set* s = NULL;
+
+    for (int f = 0; f < 2; f++) {
+        int fd = openat(dirfd, files[f], O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size > CARI_MAX_IGNORE_FILE) {
+            close(fd);
+            continue;
+        }
+        if (s == NULL) {
+            s = calloc(1, sizeof(*s));
+            if (s == NULL) {
+                close(fd);
+                break;
+            }
+        }
+        // Gabungkan isi kedua file ke satu teks; aturan menunjuk ke dalamnya
+        size_t old_len = s->text != NULL ? strlen(s->text) : 0;
+        char* text = realloc(s->text, old_len + st.st_size + 2);
+        if (text == NULL) {
+            close(fd);
+            continue;
+        }
+        s->text = text;
+        ssize_t n = read(fd, text + old_len, st.st_size);
+        close(fd);
+        if (n < 0) n = 0;
+        text[old_len + n] = '\n';
+        text[old_len + n + 1] = '\0';
+    }
+    if (s == NULL) return ignore_set_get(parent);
+    if (s->text == NULL) {
+        free(s);
+        return ignore_set_get(parent);
+    }
+
+    int capacity = 0;
+    for (char* line = s->text; *line != '\0'; ) {
+        char* end = strchr(line, '\n');
+        *end = '\0';
+        char* next = end + 1;
+        if (end > line && end[-1] == '\r') *--end = '\0';
+        // Spasi di akhir diabaikan kecuali di-escape
+        while (end > line && end[-1] == ' ' && !(end - 1 > line && end[-2] == '\\')) *--end = '\0';
+        if (line[0] != '\0' && line[0] != '#') {
+            struct ignore_rule r = { line, 0, 0, 0 };
+            if (r.pattern[0] == '!') {
+                r.negate = 1;
+                r.pattern++;
+            } else if (r.pattern[0] == '\\' && (r.pattern[1] == '!' || r.pattern[1] == '#')) {
+                r.pattern++;
+            }
+            size_t len = strlen(r.pattern);
+            if (len > 0 && r.pattern[len - 1] == '/') {
+                r.dir_only = 1;
+                r.pattern[--len] = '\0';
+            }
+            if (strchr(r.pattern, '/') != NULL) {
+                r.anchored = 1;
+                if (r.pattern[0] == '/') r.pattern++;
+            }
+            // "**/x" sama dengan "x" di kedalaman mana pun
+            while (strncmp(r.pattern, "**/", 3) == 0) {
+                r.pattern += 3;
+                r.anchored = strchr(r.pattern, '/') != NULL;
+            }
+            if (r.pattern[0] != '\0') {
+                if (s->count == capacity) {
+                    capacity = capacity ? capacity * 2 : 16;
+                    struct ignore_rule* rules = realloc(s->rules, capacity * sizeof(*rules));
+                    if (rules == NULL) break;
+                    s->rules = rules;
+                }
+                s->rules[s->count++] = r;
+            }
+        }
+        line = next;
+    }
+
+    s->refs = 1;
+    s->base_len = base_len;
+    s->parent = ignore_set_get(parent);
+    return s;
+}
+
+// Fungsi untuk memeriksa apakah path diabaikan. Aturan terdekat dan terakhir yang cocok menang.
+static int is_ignored(const struct ignore_set* s, const char* path, const char* name, int is_dir) {
+    for (; s != NULL; s = s->parent) {
+        const char* rel = path + s->base_len;
+        for (int i = s->count - 1; i >= 0; i--) {
+            const struct ignore_rule* r = &s->rules[i];
+            if (r->dir_only && !is_dir) continue;
+            int matched = r->anchored ? fnmatch(r->pattern, rel, FNM_PATHNAME) == 0
+                                      : fnmatch(r->pattern, name, 0) == 0;
+            if (matched) return !r->negate;
+        }
+    }
+    return 0;
+}
+
+// Filter dan opsi "cari"
+struct cari_opts {
+    const char* names[CARI_MAX_NAMES];
+    int name_count;
+    int name_flags;             // FNM_CASEFOLD untuk -i
+    char type;                  // 'f', 'd', 'l', atau 0
+    int size_cmp;               // -1 lebih kecil, 0 sama, 1 lebih besar (dalam satuan size_unit)
+    long long size;
+    int mtime_cmp;              // -1 lebih baru dari, 1 lebih lama dari
+    time_t mtime_limit;
+    int max_depth;
+    int no_ignore;
+    char separator;
+};
+
+// Satu direktori yang menunggu ditelusuri
+struct cari_dir {
+    int dirfd;                  // Dibuka relatif ke induk; -1 = buka lewat path
+    int depth;
+    struct ignore_set* ignores;
+    size_t len;
+    char path[];                // Dengan '/' di akhir
+};
+
+// Buffer keluaran per thread, ditulis ke stdout per batch
+struct cari_out {
+    char buf[CARI_OUT_BATCH];
+    size_t len;
+    long long count;
+};
+
+// Status satu penelusuran "cari"
+struct cari_walk {
+    const struct cari_opts* o;
+    struct work_pool pool;
+    struct cari_out out[WORK_POOL_MAX_WORKERS + 1];
+    pthread_mutex_t out_lock;
+    int open_fds;
+    int stop;                   // Penulisan ke stdout gagal (mis. pipe ditutup)
+    int errors;
+};
+
+static void cari_flush(struct cari_walk* w, struct cari_out* out) {
+    if (out->len == 0) return;
+    pthread_mutex_lock(&w->out_lock);
+    for (size_t off = 0; off < out->len && !w->stop; ) {
+        ssize_t n = write(STDOUT_FILENO, out->buf + off, out->len - off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            w->stop = 1;
+            break;
+        }
+        off += n;
+    }
+    pthread_mutex_unlock(&w->out_lock);
+    out->len = 0;
+}
+
+static void cari_emit(struct cari_walk* w, struct cari_out* out, const char* path, size_t len) {
+    if (out->len + len + 1 > sizeof(out->buf)) cari_flush(w, out);
+    if (len + 1 > sizeof(out->buf)) return;
+    memcpy(out->buf + out->len, path, len);
+    out->buf[out->len + len] = w->o->separator;
+    out->len += len + 1;
+    out->count++;
+}
+
+// Fungsi untuk memeriksa filter nama/tipe/ukuran/waktu; stat (lewat dirfd + path) hanya dipanggil jika
+// filter ukuran atau waktu dipakai
+static int cari_matches(const struct cari_opts* o, int dirfd, const char* path, const char* name, unsigned char type) {
+    if (o->type == 'f' && type != DT_REG) return 0;
+    if (o->type == 'd' && type != DT_DIR) return 0;
+    if (o->type == 'l' && type != DT_LNK) return 0;
+    if (o->name_count > 0) {
+        int matched = 0;
+        for (int i = 0; i < o->name_count && !matched; i++) {
+            matched = fnmatch(o->names[i], name, o->name_flags) == 0;
+        }
+        if (!matched) return 0;
+    }
+    if (o->size_cmp == 2 && o->mtime_cmp == 0) return 1;
+
+    struct stat st;
+    if (fstatat(dirfd, path, &st, AT_SYMLINK_NOFOLLOW) != 0) return 0;
+    if (o->size_cmp != 2) {
+        if (o->size_cmp < 0 && !(st.st_size < o->size)) return 0;
+        if (o->size_cmp > 0 && !(st.st_size > o->size)) return 0;
+        if (o->size_cmp == 0 && st.st_size != o->size) return 0;
+    }
+    if (o->mtime_cmp < 0 && st.st_mtime < o->mtime_limit) return 0;
+    if (o->mtime_cmp > 0 && st.st_mtime >= o->mtime_limit) return 0;
+    return 1;
+}
+
+static struct cari_dir* cari_new_dir(const char* path, size_t len, int depth, struct ignore_set* ignores) {
+    struct cari_dir* d = malloc(sizeof(*d) + len + 2);
+    if (d == NULL) return NULL;
+    memcpy(d->path, path, len);
+    if (len == 0 || path[len - 1] != '/') d->path[len++] = '/';
+    d->path[len] = '\0';
+    d->len = len;
+    d->depth = depth;
+    d->dirfd = -1;
+    d->ignores = ignore_set_get(ignores);
+    return d;
+}
+
+static void cari_visit(struct cari_walk* w, struct cari_dir* d, int self);
+
+static void cari_pool_run(void* ctx, void* item, int self) {
+    cari_visit(ctx, item, self);
+}
+
+// Fungsi untuk menelusuri satu direktori: cocokkan setiap entri, dorong subdirektori ke deque sendiri
+static void cari_visit(struct cari_walk* w, struct cari_dir* d, int self) {
+    const struct cari_opts* o = w->o;
+    struct cari_out* out = &w->out[self];
+    int fd = d->dirfd;
+    if (fd >= 0) {
+        __atomic_fetch_sub(&w->open_fds, 1, __ATOMIC_RELAXED);
+    } else if (!w->stop) {
+        fd = open(d->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+    if (fd < 0 || w->stop) {
+        if (fd < 0 && !w->stop) {
+            fprintf(stderr, "cari: %.*s: %s\n", (int)(d->len > 1 ? d->len - 1 : d->len), d->path, strerror(errno));
+            __atomic_add_fetch(&w->errors, 1, __ATOMIC_RELAXED);
+        }
+        if (fd >= 0) close(fd);
+        ignore_set_put(d->ignores);
+        free(d);
+        return;
+    }
+
+    struct ignore_set* ignores = o->no_ignore ? NULL : load_ignore_set(fd, d->ignores, d->len);
+    char path[PATH_MAX];
+    memcpy(path, d->path, d->len);
+
+    char buf[32768];
+    long nread;
+    while (!w->stop && (nread = syscall(SYS_getdents64, fd, buf, sizeof(buf))) > 0) {
+        for (long off = 0; off < nread && !w->stop; ) {
+            struct linux_dirent64* e = (struct linux_dirent64*)(buf + off);
+            off += e->d_reclen;
+            const char* name = e->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+
+            unsigned char type = e->d_type;
+            if (type == DT_UNKNOWN) type = glob_entry_type(fd, name, type);
+            size_t name_len = strlen(name);
+            if (d->len + name_len + 2 > sizeof(path)) continue;
+            memcpy(path + d->len, name, name_len + 1);
+
+            if (!o->no_ignore) {
+                int vcs = 0;
+                for (int i = 0; cari_vcs_dirs[i] != NULL && !vcs; i++) vcs = strcmp(name, cari_vcs_dirs[i]) == 0;
+                if (vcs || is_ignored(ignores, path, name, type == DT_DIR)) continue;
+            }
+
+            if (cari_matches(o, fd, name, name, type)) cari_emit(w, out, path, d->len + name_len);
+
+            if (type == DT_DIR && (o->max_depth < 0 || d->depth < o->max_depth)) {
+                struct cari_dir* child = cari_new_dir(path, d->len + name_len, d->depth + 1, ignores);
+                if (child == NULL) continue;
+                // Buka relatif ke dirfd ini selama anggaran fd masih ada; sisanya dibuka lewat path
+                if (__atomic_add_fetch(&w->open_fds, 1, __ATOMIC_RELAXED) <= CARI_MAX_OPEN_FDS) {
+                    child->dirfd = openat(fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOFOLLOW);
+                }
+                if (child->dirfd < 0) __atomic_fetch_sub(&w->open_fds, 1, __ATOMIC_RELAXED);
+                if (work_pool_push(&w->pool, self, child) != 0) cari_visit(w, child, self);
+            }
+        }
+    }
+    close(fd);
+    ignore_set_put(ignores);
+    ignore_set_put(d->ignores);
+    free(d);
+}
+
+// Fungsi untuk menyiapkan satu titik awal (hasil glob argumen); titik awal sendiri ikut dicocokkan
+// seperti find, lalu direktorinya didorong ke deque pemanggil
+static int cari_add_root(const char* root, void* ctx) {
+    struct cari_walk* w = ctx;
+    int caller = w->pool.workers;
+    struct stat st;
+    if (lstat(root, &st) != 0) {
+        fprintf(stderr, "cari: %s: %s\n", root, strerror(errno));
+        w->errors++;
+        return 0;
+    }
+    const char* base = strrchr(root, '/');
+    base = base != NULL && base[1] != '\0' ? base + 1 : root;
+    unsigned char type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISLNK(st.st_mode) ? DT_LNK : S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+    if (cari_matches(w->o, AT_FDCWD, root, base, type)) cari_emit(w, &w->out[caller], root, strlen(root));
+
+    if (S_ISDIR(st.st_mode) && w->o->max_depth != 0) {
+        struct cari_dir* d = cari_new_dir(root, strlen(root), 1, NULL);
+        if (d != NULL && work_pool_push(&w->pool, caller, d) != 0) cari_visit(w, d, caller);
+    }
+    return w->stop;
+}
+
+// Fungsi untuk membaca angka dengan akhiran satuan ("10k", "2M", "7d", "3h") menjadi nilai dasar
+static int parse_cari_amount(const char* s, int* cmp, long long* value, const char* units, const long long* scales) {
+    *cmp = 0;
+    if (*s == '+') {
+        *cmp = 1;
+        s++;
+    } else if (*s == '-') {
+        *cmp = -1;
+        s++;
+    }
+    char* end;
+    double v = strtod(s, &end);
+    if (end == s || v < 0) return -1;
+    long long scale = scales[0];
+    if (*end != '\0') {
+        const char* u = strchr(units, *end);
+        if (u == NULL || end[1] != '\0') return -1;
+        scale = scales[u - units + 1];
+    }
+    *value = (long long)(v * scale);
+    return 0;
+}
+
+// Fungsi builtin "cari": pengganti find untuk kasus umum, paralel dengan work stealing
+void cari_command(char** args) {
+    static const long long size_scales[] = { 1, 1, 1024, 1024 * 1024, 1024LL * 1024 * 1024 };
+    static const long long time_scales[] = { 86400, 1, 60, 3600, 86400 };
+    struct cari_opts o;
+    memset(&o, 0, sizeof(o));
+    o.size_cmp = 2;
+    o.max_depth = -1;
+    o.separator = '\n';
+    int workers = work_pool_default_workers();
+    const char* roots[CARI_MAX_ROOTS];
+    int root_count = 0;
+
+    for (int i = 1; args[i] != NULL; i++) {
+        const char* a = args[i];
+        const char* v = args[i + 1];
+        if ((strcmp(a, "-n") == 0 || strcmp(a, "-name") == 0) && v != NULL && o.name_count < CARI_MAX_NAMES) {
+            // Pola nama tanpa kutip tidak diekspansi shell: "cari" ada di glob_stream_builtins
+            const char* pattern = glob_pattern_of(v);
+            o.names[o.name_count++] = pattern != NULL ? pattern : v;
+            i++;
+        } else if (strcmp(a, "-i") == 0) {
+            o.name_flags |= FNM_CASEFOLD;
+        } else if ((strcmp(a, "-t") == 0 || strcmp(a, "-type") == 0) && v != NULL && strchr("fdl", v[0]) && v[1] == '\0') {
+            o.type = v[0];
+            i++;
+        } else if ((strcmp(a, "-s") == 0 || strcmp(a, "-size") == 0) && v != NULL) {
+            long long size;
+            if (parse_cari_amount(v, &o.size_cmp, &size, "ckMG", size_scales) != 0) {
+                printf("cari: ukuran tidak valid: %s (contoh: +10M, -1k, 4096)\n", v);
+                last_exit_status = 2;
+                return;
+            }
+            o.size = size;
+            i++;
+        } else if ((strcmp(a, "-m") == 0 || strcmp(a, "-mtime") == 0) && v != NULL) {
+            long long age;
+            if (parse_cari_amount(v, &o.mtime_cmp, &age, "smhd", time_scales) != 0 || o.mtime_cmp == 0) {
+                printf("cari: umur tidak valid: %s (contoh: -7 = 7 hari terakhir, +2h = lebih dari 2 jam)\n", v);
+                last_exit_status = 2;
+                return;
+            }
+            o.mtime_limit = time(NULL) - age;
+            i++;
+        } else if ((strcmp(a, "-d") == 0 || strcmp(a, "-maxdepth") == 0) && v != NULL) {
+            o.max_depth = atoi(v);
+            i++;
+        } else if (strcmp(a, "-j") == 0 && v != NULL) {
+            workers = atoi(v) - 1;
+            if (workers < 0) workers = 0;
+            if (workers > WORK_POOL_MAX_WORKERS) workers = WORK_POOL_MAX_WORKERS;
+            i++;
+        } else if (strcmp(a, "-a") == 0) {
+            o.no_ignore = 1;
+        } else if (strcmp(a, "-0") == 0) {
+            o.separator = '\0';
+        } else if (a[0] != '-' && root_count < CARI_MAX_ROOTS) {
+            roots[root_count++] = a;
+        } else {
+            printf("Penggunaan: cari [direktori...] [-n pola] [-i] [-t f|d|l] [-s [+-]N[k|M|G]] [-m [+-]N[s|m|h|d]]\n");
+            printf("                 [-d kedalaman] [-a] [-0] [-j thread]\n");
+            last_exit_status = 2;
+            return;
+        }
+    }
+    if (root_count == 0) roots[root_count++] = ".";
+
+    struct cari_walk* w = calloc(1, sizeof(*w));
+    if (w == NULL) {
+        perror("cari");
+        last_exit_status = 1;
+        return;
+    }
+    w->o = &o;
+    pthread_mutex_init(&w->out_lock, NULL);
+    fflush(stdout);
+
+    // Semua titik awal didorong sebelum worker berjalan, karena pool berhenti begitu pekerjaannya habis
+    work_pool_init(&w->pool, workers, cari_pool_run, w);
+    for (int r = 0; r < root_count; r++) {
+        if (glob_for_each(roots[r], cari_add_root, w) != 0) break;
+    }
+    work_pool_launch(&w->pool);
+    work_pool_run(&w->pool);
+    work_pool_stop(&w->pool);
+
+    for (int i = 0; i <= WORK_POOL_MAX_WORKERS; i++) cari_flush(w, &w->out[i]);
+    pthread_mutex_destroy(&w->out_lock);
+    last_exit_status = w->errors > 0 ? 1 : 0;
+    free(w);
+}
+
+// Fungsi untuk mem-parsing input perintah (mendukung kutip tunggal, kutip ganda, dan backslash)
+// Token ditulis ulang di tempat tanpa tanda kutip, sehingga input ikut berubah. Token yang berisi
+// karakter glob tanpa kutip juga dicatat polanya (bagian yang dikutip di-escape) untuk ekspansi glob.
+void parse_input(char* input, char** args) {
+    char* src = input;
+    char* dst = input;
+    char* pat = glob_pattern_buf;
+    char* pat_end = glob_pattern_buf + sizeof(glob_pattern_buf) - 2;
+    int i = 0, globs = 0;
+
+    while (*src != '\0' && i < MAX_ARGS - 1) {
+        while (*src == ' ' || *src == '\t' || *src == '\n') src++;
+        if (*src == '\0') break;
+
+        args[i++] = dst;
+        char* token_pat = pat;
+        int has_meta = 0;
+        char quote = 0;
+        while (*src != '\0' && (quote || (*src != ' ' && *src != '\t' && *src != '\n'))) {
+            int literal = 1;
+            if (quote) {
+                if (*src == quote) {
+                    quote = 0;
+                    src++;
+                    continue;
+                } else if (quote == '"' && *src == '\\' && src[1] != '\0' && strchr("\"\\$`", src[1])) {
+                    src++;
+                }
+            } else if (*src == '\'' || *src == '"') {
+                quote = *src++;
+                continue;
+            } else if (*src == '\\' && src[1] != '\0') {
+                src++;
+            } else {
+                literal = 0;
+                if (strchr("*?[{", *src) != NULL) has_meta = 1;
+            }
+
+            // Karakter yang dikutip/di-escape ditulis dengan '\' di pola agar tidak dianggap glob
+            if (pat < pat_end) {
+                if (literal && strchr("*?[]{},\\", *src) != NULL) *pat++ = '\\';
+                *pat++ = *src;
+            }
+            *dst++ = *src++;
+        }
+
+        // Lewati pemisah lebih dulu agar penutup token tidak menimpa input yang belum dibaca
+        if (*src != '\0') src++;
+        *dst++ = '\0';
+
+        if (has_meta && pat < pat_end) {
+            *pat++ = '\0';
+            glob_token[globs] = args[i - 1];
+            glob_token_pattern[globs++] = token_pat;
+        } else {
+            pat = token_pat;
+        }
+    }
+    args[i] = NULL;
+    glob_token[globs] = NULL;
+}
+
+// Fungsi untuk memecah input berdasarkan pipe "|" dengan mengabaikan "|" di dalam tanda kutip
+int split_pipeline(char* input, char** commands, int max_commands) {
+    int count = 0;
+    char quote = 0;
+
+    commands[count++] = input;
+    for (char* p = input; *p != '\0'; p++) {
+        if (quote) {
+            if (*p == quote) quote = 0;
+            else if (*p == '\\' && quote == '"' && p[1] != '\0') p++;
+        } else if (*p == '\'' || *p == '"') {
+            quote = *p;
+        } else if (*p == '\\' && p[1] != '\0') {
+            p++;
+        } else if (*p == '|' && count < max_commands) {
+            *p = '\0';
+            commands[count++] = p + 1;
+        }
+    }
+    return count;
+}
+
+// Fungsi untuk memeriksa apakah perintah memakai sintaks yang belum didukung parser mishell (latar
+// belakang, subshell, backtick, redirection lanjutan, dll; glob, ; && || if/for/while, $VAR, $(...)
+// dan <(...) ditangani sendiri)
+int needs_bash_fallback(const char* command) {
+    char quote = 0;
+    int depth = 0;      // Kedalaman $( atau <( yang belum ditutup
+
+    for (const char* p = command; *p != '\0'; p++) {
+        if (quote == '\'') {
+            if (*p == '\'') quote = 0;
+            continue;
+        }
+        if (quote == '"') {
+            if (*p == '"') quote = 0;
+            else if (*p == '\\' && p[1] != '\0') p++;
+            else if (*p == '`' || (*p == '$' && p[1] == '(' && p[2] == '(')) return 1;
+            continue;
+        }
+
+        if (*p == '\'' || *p == '"') {
+            quote = *p;
+        } else if (*p == '\\' && p[1] != '\0') {
+            p++;
+        } else if (*p == '&' && p[1] == '&') {
+            p++;
+        } else if (*p == '$' && p[1] == '(' && p[2] == '(') {
+            return 1;
+        } else if ((*p == '$' || *p == '<') && p[1] == '(') {
+            depth++;
+            p++;
+        } else if (*p == ')' && depth > 0) {
+            depth--;
+        } else if (*p == '$') {
+            continue;
+        } else if (strchr("&`~()#", *p) != NULL) {
+            return 1;
+        } else if (*p == '>' && p[1] == '>') {
+            return 1;
+        } else if ((*p == '<' || *p == '>') && p > command && isdigit((unsigned char)p[-1])) {
+            // Redirection file descriptor seperti 2>
+            return 1;
+        } else if (*p == '<' && p[1] == '<') {
+            return 1;
+        }
+    }
+
+    // Tanda kutip yang tidak ditutup
+    return quote != 0;
+}
+
+// Fungsi untuk menjalankan perintah dengan bash secara langsung (tanpa sh perantara)
+void run_with_bash(const char* command) {
+    shell_env_sync();
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        execlp("bash", "bash", "-c", command, (char *)NULL);
+        perror("bash");
+        _exit(127);
+    } else if (pid < 0) {
+        perror("fork");
+        last_exit_status = 1;
+        return;
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+    last_exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+
+// Fungsi untuk menangani input/output redirection, mengembalikan -1 jika file gagal dibuka
+int handle_redirection(char** args) {
+    int i = 0;
+    int input_redirect = -1, output_redirect = -1;
+    char* input_file = NULL, *output_file = NULL;
+
+    // Menentukan posisi input/output redirection
+    while (args[i] != NULL) {
+        if (strcmp(args[i], "<") == 0) {
+            input_redirect = i;
+            input_file = args[i + 1];
+        } else if (strcmp(args[i], ">") == 0) {
+            output_redirect = i;
+            output_file = args[i + 1];
+        }
+        i++;
+    }
+
+    if (input_redirect != -1) {
+        // Input redirection
+        int fd = open(input_file, O_RDONLY);
+        if (fd == -1) {
+            perror("Error opening input file");
+            return -1;
+        }
+        dup2(fd, STDIN_FILENO);
+        close(fd);
+        args[input_redirect] = NULL;  // Hapus "<" dan file name
+    }
+
+    if (output_redirect != -1) {
+        // Output redirection
+        int fd = open(output_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1) {
+            perror("Error opening output file");
+            return -1;
+        }
+        dup2(fd, STDOUT_FILENO);
+        close(fd);
+        args[output_redirect] = NULL;  // Hapus ">" dan file name
+    }
+
+    return 0;
+}
+
+// Builtin yang bisa menjadi tahap pipeline di thread shell sendiri (tanpa fork/exec):
+// menerima fd input/output sendiri dan mengembalikan status keluar
+struct pipeline_builtin {
+    const char* name;
+    int (*run)(char** args, int in_fd, int out_fd);
+};
+
+static const struct pipeline_builtin pipeline_builtins[] = {
+    { "saring", saring_run },
+    { "hitung", hitung_run },
+    { "urut", urut_run },
+    { NULL, NULL }
+};
+
+static const struct pipeline_builtin* find_pipeline_builtin(const char* name) {
+    for (int i = 0; pipeline_builtins[i].name != NULL; i++) {
+        if (strcmp(name, pipeline_builtins[i].name) == 0) return &pipeline_builtins[i];
+    }
+    return NULL;
+}
+
+// Tahap pipeline yang berjalan sebagai thread; fd input/output menjadi milik thread
+struct builtin_stage {
+    const struct pipeline_builtin* builtin;
+    char** argv;                // Salinan argumen di heap (hasil glob atau salinan pointer)
+    int owns_strings;           // argv berasal dari expand_glob_args
+    int in_fd, out_fd;
+    int status;
+    pthread_t thread;
+};
+
+static void* run_builtin_stage(void* arg) {
+    struct builtin_stage* st = arg;
+    // Pembaca yang berhenti cukup membuat write() gagal dengan EPIPE, bukan mematikan shell
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    st->status = st->builtin->run(st->argv, st->in_fd, st->out_fd);
+    if (st->in_fd != STDIN_FILENO) close(st->in_fd);
+    if (st->out_fd != STDOUT_FILENO) close(st->out_fd);
+    return NULL;
+}
+
+static void free_builtin_stage(struct builtin_stage* st) {
+    if (st->owns_strings) {
+        for (int i = 0; st->argv[i] != NULL; i++) free(st->argv[i]);
+    }
+    free(st->argv);
+    free(st);
+}
+
+// Fungsi untuk menjalankan builtin sebagai tahap pipeline. Redirection "<" dan ">" dibuka di sini
+// dan menggantikan ujung pipe. Mengembalikan NULL jika gagal (fd tetap milik pemanggil).
+static struct builtin_stage* start_builtin_stage(const struct pipeline_builtin* builtin, char** args,
+                                                 int in_fd, int out_fd) {
+    struct builtin_stage* st = calloc(1, sizeof(*st));
+    if (st == NULL) return NULL;
+    st->builtin = builtin;
+    st->in_fd = -1;
+    st->out_fd = -1;
+
+    char** argv = expand_glob_args(args);
+    if (argv == NULL) {
+        free(st);
+        return NULL;
+    }
+    int count = 0;
+    while (argv[count] != NULL) count++;
+    if (argv == args) {
+        st->argv = malloc((count + 1) * sizeof(char*));
+        if (st->argv == NULL) {
+            free(st);
+            return NULL;
+        }
+        memcpy(st->argv, args, (count + 1) * sizeof(char*));
+    } else {
+        st->argv = argv;
+        st->owns_strings = 1;
+    }
+
+    int redirect_in = -1, redirect_out = -1, n = 0;
+    for (int i = 0; st->argv[i] != NULL; i++) {
+        int is_in = strcmp(st->argv[i], "<") == 0, is_out = strcmp(st->argv[i], ">") == 0;
+        if ((is_in || is_out) && st->argv[i + 1] != NULL) {
+            const char* file = st->argv[i + 1];
+            int* fd = is_in ? &redirect_in : &redirect_out;
+            if (*fd >= 0) close(*fd);
+            *fd = is_in ? open(file, O_RDONLY | O_CLOEXEC) : open(file, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (*fd < 0) {
+                perror(is_in ? "Error opening input file" : "Error opening output file");
+                if (redirect_in >= 0) close(redirect_in);
+                if (redirect_out >= 0) close(redirect_out);
+                free_builtin_stage(st);
+                return NULL;
+            }
+            if (st->owns_strings) {
+                free(st->argv[i]);
+                free(st->argv[i + 1]);
+            }
+            i++;
+            continue;
+        }
+        st->argv[n++] = st->argv[i];
+    }
+    st->argv[n] = NULL;
+
+    st->in_fd = redirect_in >= 0 ? redirect_in : in_fd;
+    st->out_fd = redirect_out >= 0 ? redirect_out : out_fd;
+    if (pthread_create(&st->thread, NULL, run_builtin_stage, st) != 0) {
+        perror("pthread_create");
+        if (redirect_in >= 0) close(redirect_in);
+        if (redirect_out >= 0) close(redirect_out);
+        free_builtin_stage(st);
+        return NULL;
+    }
+    // Ujung pipe yang digantikan redirection tidak dipakai thread
+    if (redirect_in >= 0 && in_fd != STDIN_FILENO) close(in_fd);
+    if (redirect_out >= 0 && out_fd != STDOUT_FILENO) close(out_fd);
+    return st;
+}
+
+// fd substitusi proses <(...) milik perintah yang sedang berjalan; harus tetap terbuka di child
+static int kept_fds[MAX_ARGS];
+static int kept_fd_count;
+
+static void close_fd_range(unsigned int first, unsigned int last) {
+#ifdef SYS_close_range
+    if (syscall(SYS_close_range, first, last, 0) == 0) return;
+#endif
+    long max = sysconf(_SC_OPEN_MAX);
+    if (max < 0 || max > 65536) max = 65536;
+    for (long fd = first; fd <= (long)last && fd < max; fd++) close(fd);
+}
+
+// Fungsi untuk menutup semua fd di atas stderr di child pipeline: ujung pipe milik tahap lain
+// (termasuk tahap thread) tidak boleh ikut terbuka agar pembacanya mendapat EOF. fd <(...) dilewati.
+static void close_inherited_fds(void) {
+    int keep[MAX_ARGS];
+    int count = kept_fd_count;
+    memcpy(keep, kept_fds, count * sizeof(int));
+    for (int i = 1; i < count; i++) {
+        for (int j = i; j > 0 && keep[j - 1] > keep[j]; j--) {
+            int t = keep[j];
+            keep[j] = keep[j - 1];
+            keep[j - 1] = t;
+        }
+    }
+    unsigned int from = 3;
+    for (int i = 0; i < count; i++) {
+        if (keep[i] < (int)from) continue;
+        if (keep[i] > (int)from) close_fd_range(from, keep[i] - 1);
+        from = keep[i] + 1;
+    }
+    close_fd_range(from, ~0U);
+}
+
+// Fungsi untuk menjalankan pipeline yang argumen tiap tahapnya disusun oleh source(ctx, i, args).
+// Tahap berupa builtin pipeline (mis. "saring") berjalan sebagai thread di shell, tahap lain di-fork.
+void run_pipeline(int num_commands, pipeline_stage_source source, void* ctx) {
+    pid_t pids[MAX_ARGS];
+    struct builtin_stage* stages[MAX_ARGS];    // NULL untuk tahap yang di-fork
+    int started = 0;
+    int prev_read = -1;
+
+    shell_env_sync();
+    fflush(stdout);
+
+    for (int i = 0; i < num_commands; i++) {
+        int pipefd[2] = { -1, -1 };
+        if (i < num_commands - 1 && pipe(pipefd) != 0) {
+            perror("pipe");
+            break;
+        }
+
+        // Argumen disusun di parent agar builtin pipeline bisa dikenali sebelum fork
+        char* args[MAX_ARGS];
+        if (source(ctx, i, args) != 0) args[0] = NULL;
+        const struct pipeline_builtin* builtin = args[0] != NULL ? find_pipeline_builtin(args[0]) : NULL;
+
+        if (builtin != NULL) {
+            int in_fd = prev_read != -1 ? prev_read : STDIN_FILENO;
+            int out_fd = pipefd[1] != -1 ? pipefd[1] : STDOUT_FILENO;
+            struct builtin_stage* st = start_builtin_stage(builtin, args, in_fd, out_fd);
+            if (st != NULL) {
+                // fd sudah diserahkan ke thread
+                prev_read = -1;
+                pipefd[1] = -1;
+                stages[started] = st;
+                pids[started++] = 0;
+            }
+        } else {
+            pid_t pid = fork();
+            if (pid == 0) {
+                // Child process
+                if (prev_read != -1) {
+                    dup2(prev_read, STDIN_FILENO);  // Dapatkan input dari pipe sebelumnya
+                }
+                if (pipefd[1] != -1) {
+                    dup2(pipefd[1], STDOUT_FILENO);  // Kirim output ke pipe berikutnya
+                }
+                close_inherited_fds();
+
+                if (args[0] == NULL || handle_redirection(args) != 0) {
+                    _exit(1);
+                }
+                // Builtin yang mengalirkan hasil (serta echo dan export) berjalan langsung di tahap pipeline, tanpa exec
+                if (is_glob_stream_builtin(args[0]) || strcmp(args[0], "echo") == 0 || strcmp(args[0], "export") == 0) {
+                    execute_command(args);
+                    fflush(stdout);
+                    _exit(last_exit_status);
+                }
+                char** argv = expand_glob_args(args);
+                if (argv == NULL) _exit(1);
+                execvp(argv[0], argv);
+                perror("execvp");  // Menambahkan error handling di sini
+                _exit(127);
+            } else if (pid < 0) {
+                perror("fork");
+            } else {
+                stages[started] = NULL;
+                pids[started++] = pid;
+            }
+        }
+
+        // Parent menutup ujung pipe yang sudah diwariskan agar pembaca mendapat EOF
+        if (prev_read != -1) close(prev_read);
+        if (pipefd[1] != -1) close(pipefd[1]);
+        prev_read = pipefd[0];
+    }
+    if (prev_read != -1) close(prev_read);
+
+    // Menunggu semua tahap, status pipeline mengikuti perintah terakhir
+    for (int i = 0; i < started; i++) {
+        int status;
+        if (stages[i] != NULL) {
+            pthread_join(stages[i]->thread, NULL);
+            status = stages[i]->status;
+            free_builtin_stage(stages[i]);
+        } else {
+            waitpid(pids[i], &status, 0);
+            status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+        }
+        if (i == started - 1) last_exit_status = status;
+    }
+}
+
+static int parse_pipeline_stage(void* ctx, int index, char** args) {
+    parse_input(((char**)ctx)[index], args);
+    return 0;
+}
+
+// Fungsi untuk mengeksekusi perintah dengan atau tanpa pipe
+void execute_pipeline(char* input) {
+    char* commands[MAX_ARGS];
+
+    // Memecah perintah berdasarkan pipe "|"
+    int num_commands = split_pipeline(input, commands, MAX_ARGS);
+    run_pipeline(num_commands, parse_pipeline_stage, commands);
+}
+
+// Fungsi untuk mengeksekusi perintah dengan atau tanpa pipe
+void execute_command(char** args) {
+    if (args[0] == NULL) return;  // Tidak ada perintah untuk dijalankan
+
+    last_exit_status = 0;
+
+    // Perintah internal "cd"
+    if (strcmp(args[0], "cd") == 0) {
+        if (args[1] == NULL) {
+            fprintf(stderr, "cd: expected argument\n");
+            last_exit_status = 1;
+        } else if (chdir(args[1]) != 0) {
+            perror("cd");
+            last_exit_status = 1;
+        }
+    }
+    // Perintah internal "exit"
+    else if (strcmp(args[0], "q") == 0) {
+        exit(0);
+    }
+    // Builtin sederhana yang sering dipakai di skrip, tanpa fork
+    else if (strcmp(args[0], "true") == 0 || strcmp(args[0], ":") == 0) {
+        last_exit_status = 0;
+    }
+    else if (strcmp(args[0], "false") == 0) {
+        last_exit_status = 1;
+    }
+    else if (strcmp(args[0], "export") == 0) {
+        export_command(args);
+    }
+    else if (strcmp(args[0], "unset") == 0) {
+        unset_command(args);
+    }
+    else if (strcmp(args[0], "echo") == 0) {
+        int newline = args[1] == NULL || strcmp(args[1], "-n") != 0;
+        for (int i = newline ? 1 : 2; args[i] != NULL; i++) {
+            printf(args[i + 1] != NULL ? "%s " : "%s", args[i]);
+        }
+        if (newline) putchar('\n');
+    }
+    // Menjalankan file skrip mishell (bytecode di-cache per file)
+    else if (strcmp(args[0], "jalankan") == 0) {
+        jalankan_command(args);
+    }
+    // Ekspansi glob yang dialirkan (untuk hasil yang terlalu besar bagi argv)
+    else if (strcmp(args[0], "pola") == 0) {
+        pola_command(args);
+    }
+    // Pencari file paralel (pengganti find untuk kasus umum)
+    else if (strcmp(args[0], "cari") == 0) {
+        cari_command(args);
+    }
+    // Pencarian teks (grep) dengan prefilter literal SIMD
+    else if (strcmp(args[0], "saring") == 0) {
+        fflush(stdout);
+        last_exit_status = saring_run(args, STDIN_FILENO, STDOUT_FILENO);
+    }
+    // Penghitung baris/kata/byte (wc) paralel dengan SIMD
+    else if (strcmp(args[0], "hitung") == 0) {
+        fflush(stdout);
+        last_exit_status = hitung_run(args, STDIN_FILENO, STDOUT_FILENO);
+    }
+    // Pengurutan eksternal (sort) untuk data yang lebih besar dari memori
+    else if (strcmp(args[0], "urut") == 0) {
+        fflush(stdout);
+        last_exit_status = urut_run(args, STDIN_FILENO, STDOUT_FILENO);
+    }
+    // Perintah internal "setup dns"
+    else if (strcmp(args[0], "setup") == 0 && args[1] != NULL && strcmp(args[1], "dns") == 0) {
+        setup_dns(args + 2);  // Memanggil fungsi setup_dns
+    }
+    // Perintah AI setup
+    else if (strcmp(args[0], "ai") == 0 && args[1] != NULL && strcmp(args[1], "setup") == 0) {
+        setup_ai_api();
+    }
+    // Perintah AI logout
+    else if (strcmp(args[0], "ai") == 0 && args[1] != NULL && 
+             (strcmp(args[1], "logout") == 0 || strcmp(args[1], "keluar") == 0)) {
+        logout_api_key();
+    }
+    // Perintah AI config: tampilkan atau ubah konfigurasi backend
+    else if (strcmp(args[0], "ai") == 0 && args[1] != NULL && strcmp(args[1], "config") == 0) {
+        if (args[2] == NULL) {
+            show_ai_config();
+        } else if (args[3] == NULL) {
+            printf("Gunakan: ai config <backend|url|model|timeout|auth_header|deadline|hedge|retries> <nilai>\n");
+        } else if (set_ai_config_value(args[2], args[3]) == 0) {
+            save_ai_config();
+            printf("Konfigurasi AI disimpan: %s = %s\n", args[2], args[3]);
+        }
+    }
+    // Perintah AI mock: mock server lokal untuk pengujian dan benchmark tanpa jaringan
+    else if (strcmp(args[0], "ai") == 0 && args[1] != NULL && strcmp(args[1], "mock") == 0) {
+        if (args[2] != NULL && strcmp(args[2], "stop") == 0) {
+            stop_ai_mock();
+            printf("Mock server AI dihentikan.\n");
+        } else {
+            start_ai_mock(args + 2);
+        }
+    }
+    // Perintah AI index: status atau hapus indeks saran lokal
+    else if (strcmp(args[0], "ai") == 0 && args[1] != NULL && strcmp(args[1], "index") == 0) {
+        ai_index_command(args[2]);
+    }
+    // Perintah AI bench: mengukur latensi backend AI
+    else if (strcmp(args[0], "ai") == 0 && args[1] != NULL && strcmp(args[1], "bench") == 0) {
+        ai_benchmark(args[2] != NULL ? atoi(args[2]) : 10);
+    }
+    // Perintah AI ask
+    else if (strcmp(args[0], "ai") == 0 && args[1] != NULL) {
+        // Menggabungkan semua argumen setelah "ai" menjadi satu prompt
+        char prompt[MAX_CMD_LEN] = "";
+        for (int i = 1; args[i] != NULL; i++) {
+            strcat(prompt, args[i]);
+            strcat(prompt, " ");
+        }
+        
+        ask_ai_terminal(prompt);
+    }
+    // Perintah internal "wifi add"
+    else if (strcmp(args[0], "wifi") == 0 && strcmp(args[1], "add") == 0) {
         wifi_add();  // Memanggil fungsi wifi_add
     }
-    // Perintah internal "list perintah"
-    else if (strcmp(args[0], "list") == 0 && strcmp(args[1], "perintah") == 0) {
-        list_commands();
+    // Perintah internal "list perintah"
+    else if (strcmp(args[0], "list") == 0 && strcmp(args[1], "perintah") == 0) {
+        list_commands();
+    }
+    // Perintah internal "cek battery"
+    else if (strcmp(args[0], "cek") == 0 && strcmp(args[1], "battery") == 0) {
+        FILE *fp = fopen("/sys/class/power_supply/BAT0/capacity", "r");
+        if (fp == NULL) {
+            perror("Gagal membuka file kapasitas baterai");
+            return;
+        }
+
+        int capacity;
+        if (fscanf(fp, "%d", &capacity) != 1) {
+            perror("Gagal membaca kapasitas baterai");
+            fclose(fp);
+            return;
+        }
+
+        printf("Kapasitas Baterai: %d%%\n", capacity);
+        fclose(fp);
+    }
+    // Test Speed: uji throughput/latensi bawaan (curl multi), tanpa speedtest-cli
+    else if (strcmp(args[0], "test") == 0 && args[1] != NULL && strcmp(args[1], "speed") == 0) {
+        if (args[2] != NULL && strcmp(args[2], "serve") == 0) {
+            start_speed_server(args + 3);
+        } else {
+            test_speed(args + 2);
+        }
+    }
+    // DNS: benchmark latensi resolver dan responder otoritatif bawaan
+    else if (strcmp(args[0], "dns") == 0 && args[1] != NULL && strcmp(args[1], "bench") == 0) {
+        dns_bench(args + 2);
+    }
+    else if (strcmp(args[0], "dns") == 0 && args[1] != NULL && strcmp(args[1], "serve") == 0) {
+        start_dns_server(args + 2);
+    }
+    // Perintah internal "history"
+    else if (strcmp(args[0], "history") == 0) {
+        show_history();
+    }
+    // Perintah internal "pwd"
+    else if (strcmp(args[0], "pwd") == 0) {
+        char cwd[MAX_CMD_LEN];
+        if (getcwd(cwd, sizeof(cwd)) != NULL) {
+            printf("%s\n", cwd);
+        } else {
+            perror("pwd");
+        }
+    }
+    // Perintah internal "clear" atau "cl" untuk membersihkan layar
+    else if (strcmp(args[0], "clear") == 0 || strcmp(args[0], "cl") == 0) {
+        // Clear layar terminal
+        printf("\033[H\033[J");  // ANSI escape sequence untuk membersihkan layar
+    }
+    // Perintah cek cpu, ram, dan disk
+    else if (strcmp(args[0], "cek") == 0 && args[1] != NULL) {
+        if (strcmp(args[1], "cpu") == 0) {
+            check_cpu(parse_interval_arg(args + 2, CPU_SAMPLE_DEFAULT_MS));
+        } else if (strcmp(args[1], "ram") == 0) {
+            int top_n = 0, sort_key = PROC_SORT_RSS;
+            for (int i = 2; args[i] != NULL; i++) {
+                if (strcmp(args[i], "--top") == 0) {
+                    top_n = RAM_TOP_DEFAULT;
+                    if (args[i + 1] != NULL && isdigit((unsigned char)args[i + 1][0])) {
+                        top_n = atoi(args[++i]);
+                    }
+                } else if (strcmp(args[i], "--sort") == 0 && args[i + 1] != NULL) {
+                    i++;
+                    if (strcmp(args[i], "pss") == 0) sort_key = PROC_SORT_PSS;
+                    else if (strcmp(args[i], "swap") == 0) sort_key = PROC_SORT_SWAP;
+                    else sort_key = PROC_SORT_RSS;
+                    if (top_n == 0) top_n = RAM_TOP_DEFAULT;
+                }
+            }
+            check_ram();
+            if (top_n > 0) {
+                check_ram_top(top_n, sort_key);
+            }
+        } else if (strcmp(args[1], "disk") == 0) {
+            check_disk(parse_interval_arg(args + 2, DISK_SAMPLE_DEFAULT_MS));
+        } else if (strcmp(args[1], "proc") == 0) {
+            if (args[2] != NULL && strcmp(args[2], "bench") == 0) {
+                proc_benchmark(args + 3);
+            } else {
+                check_proc(args + 2);
+            }
+        } else if (strcmp(args[1], "export") == 0) {
+            export_metrics(args + 2);
+        } else if (strcmp(args[1], "serve") == 0) {
+            start_metrics_server(args + 2);
+        } else if (strcmp(args[1], "record") == 0) {
+            record_metric_history(args + 2);
+        } else if (strcmp(args[1], "history") == 0) {
+            show_metric_history(args + 2);
+        } else if (strcmp(args[1], "pressure") == 0 || strcmp(args[1], "cgroup") == 0) {
+            check_cgroup(parse_interval_arg(args + 2, CGROUP_SAMPLE_DEFAULT_MS), strcmp(args[1], "cgroup") == 0);
+        } else if (strcmp(args[1], "net") == 0) {
+            check_net(args + 2);
+        } else if (strcmp(args[1], "top") == 0) {
+            int rate_hz = TOP_DEFAULT_RATE_HZ;
+            for (int i = 2; args[i] != NULL; i++) {
+                if ((strcmp(args[i], "-r") == 0 || strcmp(args[i], "--rate") == 0) && args[i + 1] != NULL) {
+                    rate_hz = atoi(args[i + 1]);
+                }
+            }
+            live_top(rate_hz);
+        } else if (strcmp(args[1], "battery") == 0) {
+            FILE *fp = fopen("/sys/class/power_supply/BAT0/capacity", "r");
+            if (fp == NULL) {
+                perror("Gagal membuka file kapasitas baterai");
+                return;
+            }
+
+            int capacity;
+            if (fscanf(fp, "%d", &capacity) != 1) {
+                perror("Gagal membaca kapasitas baterai");
+                fclose(fp);
+                return;
+            }
+
+            printf("Kapasitas Baterai: %d%%\n", capacity);
+            fclose(fp);
+        } else {
+            printf("Perintah cek tidak dikenal: %s\n", args[1]);
+            printf("Gunakan: cek cpu, cek ram, cek disk, cek proc, cek pressure, cek cgroup, cek net, cek top, cek export, cek serve, cek record, cek history, atau cek battery\n");
+        }
+    }
+    // Perintah internal "ls"
+    else if (strcmp(args[0], "ls") == 0) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            execvp(args[0], args);
+            perror("execvp");  // Jika execvp gagal, tampilkan pesan error
+            _exit(1);  // Pastikan anak keluar setelah error (tanpa handler atexit milik shell)
+        } else if (pid < 0) {
+            perror("fork");
+        } else {
+            waitpid(pid, NULL, 0);  // Tunggu proses anak selesai
+        }
+    }
+    // Perintah internal "edit"
+    else if (strcmp(args[0], "edit") == 0) {
+        if (args[1] == NULL) {
+            fprintf(stderr, "edit: expected file name\n");
+        } else {
+            // Mengecek apakah file ada
+            if (access(args[1], F_OK) != 0) {
+                perror("edit");
+                return;
+            }
+
+            // Memilih editor yang sesuai (misalnya nano atau vim)
+            pid_t pid = fork();
+            if (pid == 0) {
+                // Menjalankan editor
+                char *editor = "nano";  // Bisa ganti ke "vim" jika lebih suka vim
+                execlp(editor, editor, args[1], (char *)NULL);
+                perror("execvp");  // Jika execlp gagal, tampilkan pesan error
+                _exit(1);
+            } else if (pid < 0) {
+                perror("fork");
+            } else {
+                waitpid(pid, NULL, 0);  // Tunggu proses anak selesai
+            }
+        }
+    }
+    else {
+        pid_t pid = fork();
+        if (pid == 0) {
+            execvp(args[0], args);
+            perror("execvp");  // Jika execvp gagal, tampilkan pesan error
+            _exit(127);  // Pastikan anak keluar setelah error (tanpa handler atexit milik shell)
+        } else if (pid < 0) {
+            perror("fork");
+            last_exit_status = 1;
+        } else {
+            int status;
+            waitpid(pid, &status, 0);  // Tunggu proses selesai
+            last_exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+        }
+    }
+}
+
+// Fungsi untuk menjalankan satu baris perintah dengan parser dan executor mishell
+void run_command_line(char* line) {
+    char* args[MAX_ARGS];
+    char* commands[2];
+
+    // Periksa apakah perintah mengandung pipeline atau bukan
+    char pipe_probe[MAX_CMD_LEN];
+    snprintf(pipe_probe, sizeof(pipe_probe), "%s", line);
+    if (split_pipeline(pipe_probe, commands, 2) > 1) {
+        execute_pipeline(line);
+        return;
+    }
+
+    parse_input(line, args);
+    run_parsed_command(args);
+}
+
+// Fungsi untuk menjalankan satu perintah yang sudah di-parse: redirection, ekspansi glob, lalu eksekusi
+void run_parsed_command(char** args) {
+    // Simpan stdin/stdout agar redirection pada builtin tidak menetap di shell
+    shell_env_sync();
+    fflush(stdout);
+    int saved_stdin = dup(STDIN_FILENO);
+    int saved_stdout = dup(STDOUT_FILENO);
+
+    if (handle_redirection(args) == 0) {
+        // Builtin glob membaca pola langsung; perintah lain menerima argv hasil ekspansi
+        char** argv = args[0] != NULL && is_glob_stream_builtin(args[0]) ? args : expand_glob_args(args);
+        if (argv != NULL) {
+            execute_command(argv);
+            free_glob_args(argv, args);
+        } else {
+            last_exit_status = 1;
+        }
+    } else {
+        last_exit_status = 1;
+    }
+
+    fflush(stdout);
+    dup2(saved_stdin, STDIN_FILENO);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdin);
+    close(saved_stdout);
+}
+
+// Fungsi untuk menampilkan pesan selamat datang
+void welcome_message() {
+    printf("\n\n");
+    printf("               /$$           /$$                 /$$      /$$$$$$$$  /$$$$$$$   /$$   /$$\n");
+    printf("              |__/          | $$                | $$     |_____ $$/ | $$____  \\| $$  | $$\n");
+    printf(" /$$$$$$/$$$$  /$$  /$$$$$$$| $$$$$$$   /$$$$$$ | $$          /$$/ | $$    \\ \\| $$  | $$\n");
+    printf("| $$_  $$_  $$| $$ /$$_____/| $$__  $$ /$$__  $$| $$ /$$$$$$ /$$/ / | $$$$$$$$\\| $$  | $$\n");
+    printf("| $$ \\ $$ \\ $$| $$|  $$$$$$ | $$  \\ $$| $$$$$$$$| $$|______//$$/ / | $$____ / | $$  | $$\n");
+    printf("| $$ | $$ | $$| $$ \\____  $$| $$  | $$| $$_____/| $$       /$$/ /  | $$      | $$  | $$\n");
+    printf("| $$ | $$ | $$| $$ /$$$$$$$/| $$  | $$|  $$$$$$$| $$      /$$/ /   | $$      |  $$$$$$/\n");
+    printf("|__/ |__/ |__/|__/|_______/ |__/  |__/ \\_______/|__/     |__/ /    |__/       \\______/\n");
+    printf("                                      /$$$$$$$$  /$$$$$$$  /$$   /$$          \n");
+    printf("                                     | $$_____/ | $$__  $$| $$  | $$          \n");
+    printf("                                     | $$       | $$  \\ $$| $$  | $$          \n");
+    printf("                                     | $$$$$    | $$  | $$| $$  | $$          \n");
+    printf("                                     | $$__/    | $$  | $$| $$  | $$          \n");
+    printf("                                     | $$       | $$  | $$| $$  | $$          \n");
+    printf("                                     | $$$$$$$$| $$$$$$$/ |  $$$$$$/          \n");
+    printf("                                     |________/|_______/   \\______/           \n");
+    printf("                                                                                      \n");
+    printf("                                original by: azmi, zikri, dea, latief, rachel         \n");
+    printf("                                edit by    : friza, gita, dimas, tirangga, syahran    \n");
+    printf("*\n");
+    printf("Perintah dasar yang dapat digunakan:\n");
+    printf("1. cd <direktori>     : Pindah direktori\n");
+    printf("2. echo <pesan>       : Tampilkan pesan\n");
+    printf("3. touch <file>       : Membuat file baru\n");
+    printf("4. edit <file>        : Mengedit file\n");
+    printf("5. q                  : Keluar dari shell\n");
+    printf("6. history            : Menampilkan riwayat perintah\n");
+    printf("7. pwd                : Menampilkan direktori saat ini\n");
+    printf("8. ls                 : Menampilkan daftar file\n");
+    printf("9. cat <file>         : Menampilkan isi file\n");
+    printf("10. rm <file>         : Menghapus file\n");
+    printf("11. rmdir <dir>       : Menghapus direktori kosong\n");
+    printf("12. mkdir <dir>       : Membuat direktori baru\n");
+    printf("13. clear             : Menghapus layar terminal\n");
+    printf("14. cp <source> <dest>: Menyalin file\n");
+    printf("15. mv <source> <dest>: Memindahkan file\n");
+    printf("16. whoami            : Menampilkan nama pengguna\n");
+    printf("17. date              : Menampilkan tanggal dan waktu\n");
+    printf("18. man <command>     : Menampilkan manual perintah\n");
+    printf("19. head <file>       : Menampilkan beberapa baris pertama file\n");
+    printf("20. tail <file>       : Menampilkan beberapa baris terakhir file\n");
+    printf("21. setup dns [ip dom]: Meng-Setup DNS BIND (transaksional, --dir)\n");
+    printf("22. list perintah     : Menampilkan daftar perintah yang tersedia\n");
+    printf("23. cek battery       : Memeriksa kapasitas baterai\n");   
+    printf("24. test speed [local]: Uji throughput & latensi (curl multi, -n aliran)\n");
+    printf("25. cek cpu [-i ms]   : Menampilkan penggunaan CPU per core\n");
+    printf("26. cek ram [--top N]  : Menampilkan penggunaan RAM dan proses terbesar\n");
+    printf("27. cek disk [-i ms]  : Menampilkan penggunaan disk dan laju I/O\n");
+    printf("28. ai setup          : Menyiapkan Google Gemini API\n");
+    printf("29. ai <pertanyaan>   : Bertanya ke AI tentang perintah terminal\n");
+    printf("30. ai logout         : Menghapus API key Gemini yang tersimpan\n");
+    printf("31. ai config [k v]   : Mengatur backend AI (gemini/openai, url, model, timeout)\n");
+    printf("32. ai mock [port|stop]: Menjalankan mock server AI lokal\n");
+    printf("33. ai bench [n]      : Mengukur latensi backend AI\n");
+    printf("34. ai index [clear]  : Status/hapus indeks saran AI lokal\n");
+    printf("35. cek top [-r hz]   : Dashboard live CPU, RAM, disk, dan load\n");
+    printf("36. cek proc [opsi]   : Daftar proses (urut/filter CPU%%, RSS, user, dll.)\n");
+    printf("37. cek export        : Cetak metrik (--format=openmetrics|json)\n");
+    printf("38. cek serve [stop]  : Server metrik OpenMetrics/JSON di latar belakang\n");
+    printf("39. cek record [start|stop]: Perekam riwayat metrik di latar belakang\n");
+    printf("40. cek history cpu|ram|disk: Sparkline riwayat (--since 1h)\n");
+    printf("41. cek pressure / cek cgroup: PSI dan batas cgroup (-i ms)\n");
+    printf("42. cek net [--live]   : Trafik interface & state socket TCP (-i ms, -a)\n");
+    printf("43. setup dns --from f : Provisioning massal dari CSV/YAML (--dry-run)\n");
+    printf("44. dns bench [local]  : Latensi resolver p50/p99, timeout & SERVFAIL (dns serve)\n");
+    printf("45. pola [-c] <pola>   : Ekspansi glob * ? [..] {a,b} ** yang dialirkan ke stdout\n");
+    printf("46. cari [dir] [-n pola]: Cari file paralel (-t, -s, -m, -d; patuhi .gitignore)\n");
+    printf("47. saring [-i -c -n -l] <pola> [file]: Cari teks (regex ERE) di file/pipe, seperti grep\n");
+    printf("48. hitung [-l -w -c] [file...]: Hitung baris/kata/byte (seperti wc), paralel dengan SIMD\n");
+    printf("49. urut [-n -r -u] [-k N] [file]: Urutkan baris (seperti sort), muat file > RAM\n");
+    printf("50. jalankan <file>    : Jalankan skrip mishell (; && || if for while), bytecode di-cache\n");
+    printf("51. export NAMA=nilai  : Variabel environment ($NAMA, $(...), <(...)); unset NAMA\n");
+    printf("\nSilakan masukkan perintah!\n");
+}
+
+// Fungsi untuk menghilangkan karakter kutip yang mengelilingi string
+char* remove_surrounding_quotes(char* str) {
+    static char result[MAX_CMD_LEN];
+    
+    // Copy string asli
+    strncpy(result, str, MAX_CMD_LEN - 1);
+    result[MAX_CMD_LEN - 1] = '\0';
+    
+    int len = strlen(result);
+    
+    // Hapus tanda kutip di awal dan akhir jika ada
+    if (len >= 2 && ((result[0] == '"' && result[len-1] == '"') || 
+                     (result[0] == '\'' && result[len-1] == '\''))) {
+        memmove(result, result + 1, len - 2);
+        result[len - 2] = '\0';
+    }
+    
+    return result;
+}
+
+// Fungsi untuk meng-escape spasi dan karakter khusus dalam path
+char* escape_path(const char* path) {
+    static char escaped[MAX_CMD_LEN * 2];
+    int i, j = 0;
+    
+    for (i = 0; path[i] != '\0' && j < MAX_CMD_LEN * 2 - 2; i++) {
+        if (path[i] == ' ' || path[i] == '(' || path[i] == ')' || 
+            path[i] == '[' || path[i] == ']' || path[i] == '&' || 
+            path[i] == ';' || path[i] == '$' || path[i] == '|' || 
+            path[i] == '<' || path[i] == '>' || path[i] == '`' || 
+            path[i] == '\\' || path[i] == '"' || path[i] == '\'') {
+            escaped[j++] = '\\';
+        }
+        escaped[j++] = path[i];
+    }
+    
+    escaped[j] = '\0';
+    return escaped;
+}
+
+// Fungsi untuk mengganti escape HTML dengan karakter sebenarnya
+void replace_html_escapes(char* str) {
+    if (str == NULL) return;
+    
+    // Daftar penggantian karakter escape HTML umum
+    struct {
+        const char* escape;
+        const char* replacement;
+    } replacements[] = {
+        {"u003c", "<"},
+        {"u003e", ">"},
+        {"u0026", "&"},
+        {"u0022", "\""},
+        {"u0027", "'"},
+        {"u002F", "/"},
+        {"u005C", "\\"},
+        {"&lt;", "<"},
+        {"&gt;", ">"},
+        {"&amp;", "&"},
+        {"&quot;", "\""},
+        {"&apos;", "'"},
+        {NULL, NULL}  // Penanda akhir array
+    };
+    
+    char* found;
+    for (int i = 0; replacements[i].escape != NULL; i++) {
+        size_t escape_len = strlen(replacements[i].escape);
+        size_t repl_len = strlen(replacements[i].replacement);
+        
+        char* pos = str;
+        while ((found = strstr(pos, replacements[i].escape)) != NULL) {
+            // Simpan posisi setelah escape sequence
+            char* after = found + escape_len;
+            
+            // Ganti escape dengan karakter asli
+            memcpy(found, replacements[i].replacement, repl_len);
+            
+            // Geser sisa string
+            if (escape_len != repl_len) {
+                memmove(found + repl_len, after, strlen(after) + 1);
+            }
+            
+            // Update posisi pencarian berikutnya
+            pos = found + repl_len;
+        }
+    }
+}
+
+// File /proc yang dibuka sekali lalu dibaca ulang dengan pread (tanpa open/close setiap sampel)
+struct proc_file {
+    const char* path;
+    int fd;
+};
+
+struct proc_file proc_stat_file = { "/proc/stat", -1 };
+
+// Fungsi untuk membaca isi file /proc dari awal ke buffer, mengembalikan jumlah byte
+ssize_t read_proc_file(struct proc_file* f, char* buf, size_t size) {
+    if (f->fd < 0) {
+        f->fd = open(f->path, O_RDONLY | O_CLOEXEC);
+        if (f->fd < 0) return -1;
+    }
+
+    ssize_t n = pread(f->fd, buf, size - 1, 0);
+    if (n < 0) return -1;
+    buf[n] = '\0';
+    return n;
+}
+
+// Waktu CPU kumulatif dari satu baris cpu/cpuN di /proc/stat (satuan jiffies)
+// guest dan guest_nice tidak disimpan karena sudah termasuk dalam user dan nice
+struct cpu_times {
+    unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
+};
+
+// Satu sampel seluruh CPU: baris agregat "cpu" dan setiap "cpuN"
+struct cpu_sample {
+    struct cpu_times total;
+    struct cpu_times cores[MAX_CPUS];
+    int num_cores;
+};
+
+// Persentase penggunaan CPU di antara dua sampel
+struct cpu_usage {
+    double busy;    // Semua waktu non-idle, termasuk steal; iowait dihitung sebagai idle
+    double user;    // user + nice
+    double system;
+    double iowait;
+    double steal;
+    double irq;     // irq + softirq
+};
+
+// Fungsi untuk mengambil sampel /proc/stat dengan satu pread
+int sample_cpu(struct cpu_sample* s) {
+    static char buf[65536];
+    if (read_proc_file(&proc_stat_file, buf, sizeof(buf)) <= 0) return -1;
+
+    s->num_cores = 0;
+    char* p = buf;
+
+    // Baris cpu selalu berada di awal /proc/stat
+    while (strncmp(p, "cpu", 3) == 0) {
+        char* q = p + 3;
+        struct cpu_times* t = NULL;
+
+        if (*q == ' ') {
+            t = &s->total;
+        } else {
+            long idx = strtol(q, &q, 10);
+            if (idx >= 0 && idx < MAX_CPUS) {
+                t = &s->cores[idx];
+                // CPU offline tidak punya baris, biarkan bernilai nol
+                while (s->num_cores <= idx) {
+                    memset(&s->cores[s->num_cores], 0, sizeof(struct cpu_times));
+                    s->num_cores++;
+                }
+            }
+        }
+
+        unsigned long long v[8];
+        for (int i = 0; i < 8; i++) v[i] = strtoull(q, &q, 10);
+
+        if (t != NULL) {
+            t->user = v[0];
+            t->nice = v[1];
+            t->system = v[2];
+            t->idle = v[3];
+            t->iowait = v[4];
+            t->irq = v[5];
+            t->softirq = v[6];
+            t->steal = v[7];
+        }
+
+        p = strchr(p, '\n');
+        if (p == NULL) break;
+        p++;
+    }
+
+    return 0;
+}
+
+// Fungsi untuk mengurangi counter tanpa underflow (counter bisa mundur saat CPU hotplug)
+static unsigned long long counter_delta(unsigned long long before, unsigned long long after) {
+    return after > before ? after - before : 0;
+}
+
+// Fungsi untuk menghitung persentase penggunaan CPU di antara dua sampel
+void compute_cpu_usage(const struct cpu_times* a, const struct cpu_times* b, struct cpu_usage* u) {
+    unsigned long long user = counter_delta(a->user, b->user) + counter_delta(a->nice, b->nice);
+    unsigned long long system = counter_delta(a->system, b->system);
+    unsigned long long idle = counter_delta(a->idle, b->idle);
+    unsigned long long iowait = counter_delta(a->iowait, b->iowait);
+    unsigned long long irq = counter_delta(a->irq, b->irq) + counter_delta(a->softirq, b->softirq);
+    unsigned long long steal = counter_delta(a->steal, b->steal);
+    unsigned long long total = user + system + idle + iowait + irq + steal;
+
+    memset(u, 0, sizeof(*u));
+    if (total == 0) return;
+
+    u->busy = 100.0 * (total - idle - iowait) / total;
+    u->user = 100.0 * user / total;
+    u->system = 100.0 * system / total;
+    u->iowait = 100.0 * iowait / total;
+    u->steal = 100.0 * steal / total;
+    u->irq = 100.0 * irq / total;
+}
+
+// Fungsi untuk mendapatkan nama model CPU (dibaca sekali dari /proc/cpuinfo lalu disimpan)
+const char* cpu_model_name() {
+    static char model_name[256] = "";
+    if (model_name[0] != '\0') return model_name;
+
+    strcpy(model_name, "Unknown");
+    FILE *fp_info = fopen("/proc/cpuinfo", "r");
+    if (fp_info != NULL) {
+        char line[256];
+        while (fgets(line, sizeof(line), fp_info)) {
+            if (strncmp(line, "model name", 10) == 0) {
+                char* colon = strchr(line, ':');
+                if (colon != NULL) {
+                    snprintf(model_name, sizeof(model_name), "%s", colon + 2);
+                    model_name[strcspn(model_name, "\n")] = '\0';
+                }
+                break;
+            }
+        }
+        fclose(fp_info);
+    }
+    return model_name;
+}
+
+// Fungsi untuk memilih warna ANSI berdasarkan persentase penggunaan
+const char* usage_color(double percent) {
+    if (percent < 50) return "\033[1;32m";  // Hijau terang
+    if (percent < 80) return "\033[1;33m";  // Kuning terang
+    return "\033[1;31m";                     // Merah terang
+}
+
+// Fungsi untuk membaca opsi interval "-i <ms>" dari argumen perintah cek
+int parse_interval_arg(char** args, int default_ms) {
+    for (int i = 0; args[i] != NULL; i++) {
+        if ((strcmp(args[i], "-i") == 0 || strcmp(args[i], "--interval") == 0) && args[i + 1] != NULL) {
+            int ms = atoi(args[i + 1]);
+            return ms > 0 ? ms : default_ms;
+        }
+    }
+    return default_ms;
+}
+
+// Fungsi untuk menunggu selama sejumlah milidetik
+void sleep_ms(int ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+// Lokasi cgroup proses ini: direktori v2, dan controller v1 sebagai cadangan (sistem hybrid/lama)
+struct cgroup_paths {
+    char name[256];                 // Path cgroup dari /proc/self/cgroup
+    char v2[512];                   // "" jika tidak ada hierarki v2
+    char v1_memory[512];
+    char v1_cpu[512];
+    char v1_cpuacct[512];
+};
+
+// Sampel counter dan batas cgroup (v2, dilengkapi dari v1 bila file v2 tidak ada)
+struct cgroup_sample {
+    double time_ms;
+    int has_cpu, has_memory;
+    unsigned long long cpu_usage_usec, cpu_user_usec, cpu_system_usec;
+    unsigned long long nr_periods, nr_throttled, throttled_usec;
+    double cpu_limit;               // Jumlah CPU dari cpu.max/cpuset; 0 = tanpa batas
+    unsigned long long mem_current, mem_max, mem_high;  // Byte; batas 0 = tanpa batas
+    unsigned long long swap_current;
+    unsigned long long mem_anon, mem_file, mem_kernel, mem_shmem, mem_sock;
+    int io_count;
+    struct {
+        unsigned int major, minor;
+        unsigned long long rbytes, wbytes, rios, wios;
+    } io[MAX_DISKS];
+};
+
+// Satu baris PSI: "some avg10=.. avg60=.. avg300=.. total=.."
+struct psi_line {
+    double avg10, avg60, avg300;
+    unsigned long long total;       // Mikrodetik kumulatif tertahan
+};
+
+struct psi_sample {
+    struct psi_line some, full;
+    int valid, has_full;
+};
+
+// Fungsi untuk mencari titik mount hierarki cgroup (cgroup2, atau cgroup v1 dengan controller tertentu)
+static int find_cgroup_mount(const char* fstype, const char* controller, char* out, size_t size) {
+    FILE* fp = fopen("/proc/self/mountinfo", "r");
+    if (fp == NULL) return -1;
+
+    char line[1024];
+    int found = -1;
+    while (found != 0 && fgets(line, sizeof(line), fp) != NULL) {
+        char mount_point[256], type[32], options[256];
+        char* sep = strstr(line, " - ");
+        if (sep == NULL || sscanf(line, "%*d %*d %*s %*s %255s", mount_point) != 1 ||
+            sscanf(sep + 3, "%31s %*s %255s", type, options) != 2 || strcmp(type, fstype) != 0) {
+            continue;
+        }
+
+        if (controller == NULL) {
+            found = 0;
+        } else {
+            for (char* tok = strtok(options, ","); tok != NULL; tok = strtok(NULL, ",")) {
+                if (strcmp(tok, controller) == 0) {
+                    found = 0;
+                    break;
+                }
+            }
+        }
+        if (found == 0) snprintf(out, size, "%s", mount_point);
+    }
+    fclose(fp);
+    return found;
+}
+
+// Fungsi untuk menggabungkan mount dan path cgroup; di dalam cgroup namespace path
+// dari /proc/self/cgroup bisa tidak terlihat, sehingga akar mount yang dipakai
+static void cgroup_dir(const char* mount, const char* path, char* out, size_t size) {
+    snprintf(out, size, "%s%s", mount, strcmp(path, "/") == 0 ? "" : path);
+    if (access(out, F_OK) != 0) snprintf(out, size, "%s", mount);
+}
+
+// Fungsi untuk menemukan direktori cgroup proses ini (hasil disimpan)
+const struct cgroup_paths* cgroup_locate() {
+    static struct cgroup_paths paths;
+    static int located = 0;
+    if (located) return &paths;
+    located = 1;
+
+    FILE* fp = fopen("/proc/self/cgroup", "r");
+    if (fp == NULL) return &paths;
+
+    char line[512], mount[256];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        line[strcspn(line, "\n")] = '\0';
+        char* controllers = strchr(line, ':');
+        char* path = controllers ? strchr(controllers + 1, ':') : NULL;
+        if (path == NULL) continue;
+        *controllers++ = '\0';
+        *path++ = '\0';
+
+        if (strcmp(line, "0") == 0 && *controllers == '\0') {
+            snprintf(paths.name, sizeof(paths.name), "%s", path);
+            if (find_cgroup_mount("cgroup2", NULL, mount, sizeof(mount)) == 0) {
+                cgroup_dir(mount, path, paths.v2, sizeof(paths.v2));
+            }
+            continue;
+        }
+
+        const struct { const char* controller; char* dir; } v1[] = {
+            {"memory", paths.v1_memory}, {"cpu", paths.v1_cpu}, {"cpuacct", paths.v1_cpuacct},
+        };
+        for (size_t i = 0; i < sizeof(v1) / sizeof(v1[0]); i++) {
+            char list[128];
+            snprintf(list, sizeof(list), ",%s,", controllers);
+            char token[32];
+            snprintf(token, sizeof(token), ",%s,", v1[i].controller);
+            if (strstr(list, token) != NULL && find_cgroup_mount("cgroup", v1[i].controller, mount, sizeof(mount)) == 0) {
+                cgroup_dir(mount, path, v1[i].dir, sizeof(paths.v1_memory));
+                if (paths.name[0] == '\0' || strcmp(v1[i].controller, "memory") == 0) {
+                    snprintf(paths.name, sizeof(paths.name), "%s", path);
+                }
+            }
+        }
+    }
+    fclose(fp);
+    return &paths;
+}
+
+// Fungsi untuk membaca file kecil cgroup ke buffer milik pemanggil
+static ssize_t read_cgroup_file(const char* dir, const char* name, char* buf, size_t size) {
+    if (dir[0] == '\0') return -1;
+
+    char path[768];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    ssize_t n = read(fd, buf, size - 1);
+    close(fd);
+    if (n < 0) return -1;
+    buf[n] = '\0';
+    return n;
+}
+
+// Fungsi untuk membaca satu angka dari file cgroup; "max" atau nilai >= 2^62 berarti tanpa batas (0)
+static int read_cgroup_value(const char* dir, const char* name, unsigned long long* value) {
+    char buf[64];
+    if (read_cgroup_file(dir, name, buf, sizeof(buf)) <= 0) return -1;
+    if (strncmp(buf, "max", 3) == 0) {
+        *value = 0;
+        return 0;
+    }
+    *value = strtoull(buf, NULL, 10);
+    if (*value >= (1ULL << 62)) *value = 0;
+    return 0;
+}
+
+// Fungsi untuk mengambil nilai "kunci angka" dari file berformat flat keyed (cpu.stat, memory.stat)
+static unsigned long long keyed_value(const char* buf, const char* key) {
+    size_t len = strlen(key);
+    for (const char* line = buf; line != NULL && *line != '\0'; ) {
+        if (strncmp(line, key, len) == 0 && line[len] == ' ') return strtoull(line + len + 1, NULL, 10);
+        line = strchr(line, '\n');
+        if (line != NULL) line++;
+    }
+    return 0;
+}
+
+// Fungsi untuk menghitung jumlah CPU pada daftar seperti "0-3,8,10-11"
+static int count_cpu_list(const char* list) {
+    int count = 0;
+    while (*list != '\0' && *list != '\n') {
+        char* end;
+        long first = strtol(list, &end, 10);
+        long last = first;
+        if (end == list) break;
+        if (*end == '-') last = strtol(end + 1, &end, 10);
+        count += (int)(last - first + 1);
+        list = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+// Fungsi untuk mengambil sampel cgroup saat ini
+int sample_cgroup(struct cgroup_sample* s) {
+    static char buf[16384];
+    const struct cgroup_paths* p = cgroup_locate();
+
+    memset(s, 0, sizeof(*s));
+    s->time_ms = now_ms();
+
+    // CPU: cgroup v2
+    if (read_cgroup_file(p->v2, "cpu.stat", buf, sizeof(buf)) > 0) {
+        s->has_cpu = 1;
+        s->cpu_usage_usec = keyed_value(buf, "usage_usec");
+        s->cpu_user_usec = keyed_value(buf, "user_usec");
+        s->cpu_system_usec = keyed_value(buf, "system_usec");
+        s->nr_periods = keyed_value(buf, "nr_periods");
+        s->nr_throttled = keyed_value(buf, "nr_throttled");
+        s->throttled_usec = keyed_value(buf, "throttled_usec");
+    }
+    if (read_cgroup_file(p->v2, "cpu.max", buf, sizeof(buf)) > 0 && strncmp(buf, "max", 3) != 0) {
+        char* end;
+        double quota = strtod(buf, &end);
+        double period = strtod(end, NULL);
+        if (period > 0) s->cpu_limit = quota / period;
+    }
+    if (read_cgroup_file(p->v2, "cpuset.cpus.effective", buf, sizeof(buf)) > 0) {
+        int cpus = count_cpu_list(buf);
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        if (cpus > 0 && cpus < online && (s->cpu_limit == 0 || cpus < s->cpu_limit)) s->cpu_limit = cpus;
+    }
+
+    // CPU: cadangan cgroup v1 (cpuacct.usage dalam nanodetik, throttled_time dalam nanodetik)
+    unsigned long long value;
+    if (!s->has_cpu && read_cgroup_value(p->v1_cpuacct, "cpuacct.usage", &value) == 0) {
+        s->has_cpu = 1;
+        s->cpu_usage_usec = value / 1000;
+    }
+    if (s->nr_periods == 0 && read_cgroup_file(p->v1_cpu, "cpu.stat", buf, sizeof(buf)) > 0) {
+        s->nr_periods = keyed_value(buf, "nr_periods");
+        s->nr_throttled = keyed_value(buf, "nr_throttled");
+        s->throttled_usec = keyed_value(buf, "throttled_time") / 1000;
+    }
+    if (s->cpu_limit == 0 && read_cgroup_file(p->v1_cpu, "cpu.cfs_quota_us", buf, sizeof(buf)) > 0) {
+        long long quota = strtoll(buf, NULL, 10);
+        unsigned long long period;
+        if (quota > 0 && read_cgroup_value(p->v1_cpu, "cpu.cfs_period_us", &period) == 0 && period > 0) {
+            s->cpu_limit = (double)quota / period;
+        }
+    }
+
+    // Memori: cgroup v2
+    if (read_cgroup_value(p->v2, "memory.current", &s->mem_current) == 0) {
+        s->has_memory = 1;
+        read_cgroup_value(p->v2, "memory.max", &s->mem_max);
+        read_cgroup_value(p->v2, "memory.high", &s->mem_high);
+        read_cgroup_value(p->v2, "memory.swap.current", &s->swap_current);
+        if (read_cgroup_file(p->v2, "memory.stat", buf, sizeof(buf)) > 0) {
+            s->mem_anon = keyed_value(buf, "anon");
+            s->mem_file = keyed_value(buf, "file");
+            s->mem_kernel = keyed_value(buf, "kernel");
+            if (s->mem_kernel == 0) s->mem_kernel = keyed_value(buf, "kernel_stack") + keyed_value(buf, "slab");
+            s->mem_shmem = keyed_value(buf, "shmem");
+            s->mem_sock = keyed_value(buf, "sock");
+        }
+    } else if (read_cgroup_value(p->v1_memory, "memory.usage_in_bytes", &s->mem_current) == 0) {
+        // Memori: cadangan cgroup v1
+        s->has_memory = 1;
+        read_cgroup_value(p->v1_memory, "memory.limit_in_bytes", &s->mem_max);
+        read_cgroup_value(p->v1_memory, "memory.soft_limit_in_bytes", &s->mem_high);
+        if (read_cgroup_file(p->v1_memory, "memory.stat", buf, sizeof(buf)) > 0) {
+            s->mem_anon = keyed_value(buf, "rss");
+            s->mem_file = keyed_value(buf, "cache");
+            s->mem_shmem = keyed_value(buf, "shmem");
+            s->swap_current = keyed_value(buf, "swap");
+        }
+    }
+
+    // Batas di atas RAM fisik sama saja dengan tanpa batas
+    unsigned long long phys_bytes = (unsigned long long)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE);
+    if (s->mem_max >= phys_bytes) s->mem_max = 0;
+    if (s->mem_high >= phys_bytes) s->mem_high = 0;
+
+    // I/O per perangkat (hanya cgroup v2)
+    if (read_cgroup_file(p->v2, "io.stat", buf, sizeof(buf)) > 0) {
+        for (char* line = buf; line != NULL && *line != '\0' && s->io_count < MAX_DISKS; ) {
+            unsigned int major, minor;
+            if (sscanf(line, "%u:%u", &major, &minor) == 2) {
+                s->io[s->io_count].major = major;
+                s->io[s->io_count].minor = minor;
+                const struct { const char* key; unsigned long long* value; } fields[] = {
+                    {"rbytes=", &s->io[s->io_count].rbytes}, {"wbytes=", &s->io[s->io_count].wbytes},
+                    {"rios=", &s->io[s->io_count].rios}, {"wios=", &s->io[s->io_count].wios},
+                };
+                char* eol = strchr(line, '\n');
+                for (size_t f = 0; f < sizeof(fields) / sizeof(fields[0]); f++) {
+                    char* v = strstr(line, fields[f].key);
+                    if (v != NULL && (eol == NULL || v < eol)) *fields[f].value = strtoull(v + strlen(fields[f].key), NULL, 10);
+                }
+                s->io_count++;
+            }
+            line = strchr(line, '\n');
+            if (line != NULL) line++;
+        }
+    }
+
+    return s->has_cpu || s->has_memory ? 0 : -1;
+}
+
+// Fungsi untuk membaca file PSI (/proc/pressure/* atau <cgroup>/*.pressure)
+static int read_psi(const char* path, struct psi_sample* psi) {
+    char buf[256];
+    memset(psi, 0, sizeof(*psi));
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return -1;
+    buf[n] = '\0';
+
+    for (char* line = buf; line != NULL && *line != '\0'; ) {
+        struct psi_line* target = strncmp(line, "some", 4) == 0 ? &psi->some :
+                                  strncmp(line, "full", 4) == 0 ? &psi->full : NULL;
+        if (target != NULL &&
+            sscanf(line + 4, " avg10=%lf avg60=%lf avg300=%lf total=%llu",
+                   &target->avg10, &target->avg60, &target->avg300, &target->total) == 4) {
+            psi->valid = 1;
+            if (target == &psi->full) psi->has_full = 1;
+        }
+        line = strchr(line, '\n');
+        if (line != NULL) line++;
+    }
+    return psi->valid ? 0 : -1;
+}
+
+// Fungsi untuk menghitung pemakaian CPU cgroup (dalam jumlah CPU) di antara dua sampel
+double cgroup_cpu_used(const struct cgroup_sample* a, const struct cgroup_sample* b) {
+    double elapsed_us = (b->time_ms - a->time_ms) * 1000.0;
+    if (!a->has_cpu || !b->has_cpu || elapsed_us <= 0) return 0;
+    return (double)counter_delta(a->cpu_usage_usec, b->cpu_usage_usec) / elapsed_us;
+}
+
+// Fungsi untuk memeriksa penggunaan CPU (per core, tanpa fork)
+void check_cpu(int interval_ms) {
+    static struct cpu_sample first, second;
+    struct cgroup_sample cg_first, cg_second;
+
+    printf("Memeriksa penggunaan CPU...\n");
+
+    if (sample_cpu(&first) != 0) {
+        perror("Gagal membaca /proc/stat");
+        return;
+    }
+    int have_cgroup = sample_cgroup(&cg_first) == 0;
+
+    printf("Mengambil sampel penggunaan CPU selama %d ms...\n", interval_ms);
+    sleep_ms(interval_ms);
+
+    if (sample_cpu(&second) != 0) {
+        perror("Gagal membaca /proc/stat");
+        return;
+    }
+    have_cgroup = sample_cgroup(&cg_second) == 0 && have_cgroup;
+
+    struct cpu_usage total;
+    compute_cpu_usage(&first.total, &second.total, &total);
+
+    // Tampilkan hasil dengan format yang bagus
+    printf("\n");
+    printf("\033[1;36m"); // Cyan terang
+    printf("=================== PENGGUNAAN CPU ===================\n");
+    printf("\033[0m"); // Reset warna
+
+    printf("Penggunaan CPU Saat Ini: ");
+    printf("%s%.2f%%\n", usage_color(total.busy), total.busy);
+    printf("\033[0m"); // Reset warna
+
+    printf("user %.1f%%  system %.1f%%  iowait %.1f%%  steal %.1f%%  irq %.1f%%\n",
+           total.user, total.system, total.iowait, total.steal, total.irq);
+
+    // Di dalam container, angka di atas milik host; tampilkan juga relatif terhadap batas cgroup
+    if (have_cgroup && cg_second.cpu_limit > 0) {
+        double used = cgroup_cpu_used(&cg_first, &cg_second);
+        double percent = 100.0 * used / cg_second.cpu_limit;
+        printf("Batas cgroup: %.2f CPU, terpakai %s%.2f CPU (%.1f%% dari batas)\033[0m",
+               cg_second.cpu_limit, usage_color(percent), used, percent);
+        unsigned long long throttled = counter_delta(cg_first.nr_throttled, cg_second.nr_throttled);
+        if (throttled > 0) printf(", throttled %llu kali", throttled);
+        printf("\n");
+    }
+
+    // Tampilkan informasi tambahan
+    printf("\n");
+    printf("CPU Model: %s\n", cpu_model_name());
+    printf("Jumlah Core CPU: %d\n", second.num_cores);
+
+    printf("\n%-6s %8s %8s %8s %8s %8s %8s\n", "Core", "Sibuk", "User", "System", "IOWait", "Steal", "IRQ");
+    printf("------------------------------------------------------------\n");
+    for (int i = 0; i < second.num_cores && i < first.num_cores; i++) {
+        struct cpu_usage core;
+        compute_cpu_usage(&first.cores[i], &second.cores[i], &core);
+        printf("cpu%-3d %s%7.1f%%\033[0m %7.1f%% %7.1f%% %7.1f%% %7.1f%% %7.1f%%\n",
+               i, usage_color(core.busy), core.busy, core.user, core.system, core.iowait, core.steal, core.irq);
+    }
+
+    printf("\n");
+    printf("\033[1;36m"); // Cyan terang
+    printf("=====================================================\n");
+    printf("\033[0m"); // Reset warna
+}
+
+// Informasi memori dari /proc/meminfo (satuan kB)
+struct mem_info {
+    unsigned long long total, free, available, buffers, cached;
+    unsigned long long swap_total, swap_free;
+    unsigned long long shmem, slab, slab_reclaimable, slab_unreclaimable;
+    unsigned long long anon_huge;                   // Transparent hugepage (kB)
+    unsigned long long huge_total, huge_free;       // Jumlah halaman HugePages
+    unsigned long long huge_size;                   // Ukuran satu halaman HugePages (kB)
+};
+
+struct proc_file proc_meminfo_file = { "/proc/meminfo", -1 };
+
+// Fungsi untuk membaca /proc/meminfo dengan satu pread
+int sample_meminfo(struct mem_info* m) {
+    static char buf[8192];
+    if (read_proc_file(&proc_meminfo_file, buf, sizeof(buf)) <= 0) return -1;
+
+    const struct { const char* key; unsigned long long* value; } fields[] = {
+        {"MemTotal:", &m->total},
+        {"MemFree:", &m->free},
+        {"MemAvailable:", &m->available},
+        {"Buffers:", &m->buffers},
+        {"Cached:", &m->cached},
+        {"SwapTotal:", &m->swap_total},
+        {"SwapFree:", &m->swap_free},
+        {"Shmem:", &m->shmem},
+        {"Slab:", &m->slab},
+        {"SReclaimable:", &m->slab_reclaimable},
+        {"SUnreclaim:", &m->slab_unreclaimable},
+        {"AnonHugePages:", &m->anon_huge},
+        {"HugePages_Total:", &m->huge_total},
+        {"HugePages_Free:", &m->huge_free},
+        {"Hugepagesize:", &m->huge_size},
+    };
+    const int num_fields = sizeof(fields) / sizeof(fields[0]);
+
+    memset(m, 0, sizeof(*m));
+    for (char* line = buf; line != NULL && *line != '\0'; ) {
+        for (int i = 0; i < num_fields; i++) {
+            size_t len = strlen(fields[i].key);
+            if (strncmp(line, fields[i].key, len) == 0) {
+                *fields[i].value = strtoull(line + len, NULL, 10);
+                break;
+            }
+        }
+        line = strchr(line, '\n');
+        if (line != NULL) line++;
+    }
+    return 0;
+}
+
+struct proc_file proc_loadavg_file = { "/proc/loadavg", -1 };
+
+// Fungsi untuk membaca load average 1, 5, dan 15 menit
+int sample_loadavg(double load[3]) {
+    char buf[128];
+    if (read_proc_file(&proc_loadavg_file, buf, sizeof(buf)) <= 0) return -1;
+    return sscanf(buf, "%lf %lf %lf", &load[0], &load[1], &load[2]) == 3 ? 0 : -1;
+}
+
+// Counter kumulatif satu perangkat blok dari /proc/diskstats
+struct disk_stat {
+    char name[32];
+    unsigned long long reads, sectors_read;
+    unsigned long long writes, sectors_written;
+    unsigned long long io_ticks;    // Milidetik perangkat sibuk
+};
+
+// Satu sampel seluruh perangkat blok (hanya disk utuh, tanpa partisi/loop/ram)
+struct disk_sample {
+    double time_ms;
+    int count;
+    struct disk_stat disks[MAX_DISKS];
+};
+
+struct proc_file proc_diskstats_file = { "/proc/diskstats", -1 };
+
+// Fungsi untuk memeriksa apakah nama perangkat adalah disk utuh (ada di /sys/block)
+// Hasilnya disimpan agar /sys tidak dicek ulang setiap sampel
+static int is_whole_disk(const char* name) {
+    static struct { char name[32]; int whole; } cache[MAX_DISKS * 4];
+    static int cache_count = 0;
+
+    for (int i = 0; i < cache_count; i++) {
+        if (strcmp(cache[i].name, name) == 0) return cache[i].whole;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/block/%s", name);
+    int whole = access(path, F_OK) == 0 && strncmp(name, "loop", 4) != 0 &&
+                strncmp(name, "ram", 3) != 0 && strncmp(name, "zram", 4) != 0;
+
+    if (cache_count < (int)(sizeof(cache) / sizeof(cache[0]))) {
+        snprintf(cache[cache_count].name, sizeof(cache[cache_count].name), "%s", name);
+        cache[cache_count].whole = whole;
+        cache_count++;
+    }
+    return whole;
+}
+
+// Fungsi untuk membaca /proc/diskstats dengan satu pread
+int sample_diskstats(struct disk_sample* s) {
+    static char buf[65536];
+    if (read_proc_file(&proc_diskstats_file, buf, sizeof(buf)) <= 0) return -1;
+
+    s->time_ms = now_ms();
+    s->count = 0;
+
+    for (char* line = buf; line != NULL && *line != '\0' && s->count < MAX_DISKS; ) {
+        struct disk_stat* d = &s->disks[s->count];
+        unsigned long long v[10];
+        unsigned int major, minor;
+
+        if (sscanf(line, "%u %u %31s %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu",
+                   &major, &minor, d->name, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6],
+                   &v[7], &v[8], &v[9]) == 13 && is_whole_disk(d->name)) {
+            d->reads = v[0];
+            d->sectors_read = v[2];
+            d->writes = v[4];
+            d->sectors_written = v[6];
+            d->io_ticks = v[9];
+            s->count++;
+        }
+
+        line = strchr(line, '\n');
+        if (line != NULL) line++;
+    }
+    return 0;
+}
+
+// Laju I/O satu perangkat di antara dua sampel
+struct disk_rate {
+    double read_kbs, write_kbs;     // Throughput kB/s
+    double read_iops, write_iops;
+    double util;                    // Persentase waktu perangkat sibuk
+};
+
+// Fungsi untuk menghitung laju I/O perangkat di antara dua sampel
+// Mengembalikan 0 jika perangkat ditemukan di sampel sebelumnya
+int compute_disk_rate(const struct disk_sample* before, const struct disk_sample* after,
+                      const struct disk_stat* d, struct disk_rate* r) {
+    double seconds = (after->time_ms - before->time_ms) / 1000.0;
+    memset(r, 0, sizeof(*r));
+    if (seconds <= 0) return -1;
+
+    for (int i = 0; i < before->count; i++) {
+        const struct disk_stat* p = &before->disks[i];
+        if (strcmp(p->name, d->name) != 0) continue;
+
+        // Sektor di /proc/diskstats selalu berukuran 512 byte
+        r->read_kbs = counter_delta(p->sectors_read, d->sectors_read) / 2.0 / seconds;
+        r->write_kbs = counter_delta(p->sectors_written, d->sectors_written) / 2.0 / seconds;
+        r->read_iops = counter_delta(p->reads, d->reads) / seconds;
+        r->write_iops = counter_delta(p->writes, d->writes) / seconds;
+        r->util = counter_delta(p->io_ticks, d->io_ticks) / (seconds * 10.0);
+        if (r->util > 100.0) r->util = 100.0;
+        return 0;
+    }
+    return -1;
+}
+
+// Informasi satu proses dari /proc/[pid]
+struct proc_entry {
+    int pid;
+    int valid;                      // 0 jika proses sudah hilang saat dibaca
+    char name[32];
+    char state;
+    unsigned int uid;
+    int threads;
+    unsigned long long rss_kb, pss_kb, swap_kb;
+    int has_pss;                    // 0 jika smaps_rollup tidak bisa dibaca (mis. proses user lain)
+    int ppid, nice;
+    unsigned long long utime, stime;    // Waktu CPU kumulatif (clock tick)
+    unsigned long long start_time;      // Waktu mulai sejak boot (clock tick)
+    double cpu_percent;                 // Diisi oleh cek proc dari dua sampel
+};
+
+#define PROC_SCAN_STATUS 1          // Baca /proc/[pid]/status
+#define PROC_SCAN_SMAPS 2           // Baca /proc/[pid]/smaps_rollup (PSS)
+#define PROC_SCAN_STAT 4            // Baca /proc/[pid]/stat (waktu CPU, state, thread, RSS)
+
+// Tabel hasil scan. Kapasitas hanya tumbuh berlipat, tidak ada alokasi per proses
+struct proc_table {
+    struct proc_entry* entries;
+    int count;
+    int capacity;
+};
+
+// Status pekerjaan scan yang dibagi ke thread pool
+struct proc_scan_job {
+    struct proc_table* table;
+    int flags;
+    int next;                       // Indeks proses berikutnya (diambil secara atomik)
+    unsigned long long page_kb;     // Ukuran halaman dalam KB, dibaca sekali per pemindaian
+};
+
+static int proc_dirfd = -1;
+
+// Fungsi untuk membaca daftar PID dari /proc dengan getdents64 ke tabel
+static int list_proc_pids(struct proc_table* t) {
+    if (proc_dirfd < 0) {
+        proc_dirfd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (proc_dirfd < 0) return -1;
+    } else {
+        lseek(proc_dirfd, 0, SEEK_SET);
+    }
+
+    t->count = 0;
+    char buf[32768];
+    long nread;
+    while ((nread = syscall(SYS_getdents64, proc_dirfd, buf, sizeof(buf))) > 0) {
+        for (long off = 0; off < nread; ) {
+            struct linux_dirent64* d = (struct linux_dirent64*)(buf + off);
+            off += d->d_reclen;
+
+            // Hanya direktori yang namanya angka murni
+            int pid = 0;
+            const char* n = d->d_name;
+            if (*n < '1' || *n > '9') continue;
+            for (; *n >= '0' && *n <= '9'; n++) pid = pid * 10 + (*n - '0');
+            if (*n != '\0') continue;
+
+            if (t->count == t->capacity) {
+                int capacity = t->capacity ? t->capacity * 2 : 1024;
+                struct proc_entry* entries = realloc(t->entries, sizeof(struct proc_entry) * capacity);
+                if (entries == NULL) return -1;
+                t->entries = entries;
+                t->capacity = capacity;
+            }
+            struct proc_entry* e = &t->entries[t->count++];
+            memset(e, 0, sizeof(*e));
+            e->pid = pid;
+        }
+    }
+    return nread < 0 ? -1 : t->count;
+}
+
+// Fungsi untuk membaca /proc/[pid]/<file> relatif terhadap dirfd /proc ke buffer milik pemanggil
+static ssize_t read_pid_file(int pid, const char* file, char* buf, size_t size) {
+    char path[64];
+    snprintf(path, sizeof(path), "%d/%s", pid, file);
+
+    int fd = openat(proc_dirfd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    ssize_t total = 0, n;
+    while (total < (ssize_t)size - 1 && (n = read(fd, buf + total, size - 1 - total)) > 0) {
+        total += n;
+    }
+    close(fd);
+    buf[total] = '\0';
+    return total;
+}
+
+// Fungsi untuk membaca angka desimal (melewati spasi/tab di depannya) tanpa sscanf
+static unsigned long long scan_ull(const char** p) {
+    const char* s = *p;
+    while (*s == ' ' || *s == '\t') s++;
+    unsigned long long v = 0;
+    while (*s >= '0' && *s <= '9') v = v * 10 + (unsigned long long)(*s++ - '0');
+    *p = s;
+    return v;
+}
+
+// Fungsi untuk mencocokkan kunci "Nama:" di awal baris, mengembalikan posisi setelahnya
+static const char* match_key(const char* line, const char* key, size_t len) {
+    return strncmp(line, key, len) == 0 ? line + len : NULL;
+}
+
+#define MATCH_KEY(line, key) match_key(line, key, sizeof(key) - 1)
+
+// Fungsi untuk membaca angka desimal bertanda (mis. nilai nice)
+static long long scan_ll(const char** p) {
+    const char* s = *p;
+    while (*s == ' ') s++;
+    int negative = *s == '-';
+    if (negative) s++;
+    *p = s;
+    long long v = (long long)scan_ull(p);
+    return negative ? -v : v;
+}
+
+// Fungsi untuk mengurai /proc/[pid]/stat tanpa sscanf maupun alokasi
+// Nama perintah bisa berisi spasi dan ')', jadi batasnya adalah ')' terakhir
+static int parse_proc_stat(const char* buf, struct proc_entry* e, unsigned long long page_kb) {
+    const char* open_paren = strchr(buf, '(');
+    const char* close_paren = strrchr(buf, ')');
+    if (open_paren == NULL || close_paren == NULL || close_paren < open_paren || close_paren[1] == '\0') return -1;
+
+    size_t len = close_paren - open_paren - 1;
+    if (len > sizeof(e->name) - 1) len = sizeof(e->name) - 1;
+    memcpy(e->name, open_paren + 1, len);
+    e->name[len] = '\0';
+
+    const char* p = close_paren + 2;
+    e->state = *p++;
+
+    // Field ke-4 (ppid) sampai ke-24 (rss), penomoran sesuai proc(5)
+    for (int field = 4; field <= 24 && *p != '\0'; field++) {
+        long long v = scan_ll(&p);
+        switch (field) {
+            case 4:  e->ppid = (int)v; break;
+            case 14: e->utime = (unsigned long long)v; break;
+            case 15: e->stime = (unsigned long long)v; break;
+            case 19: e->nice = (int)v; break;
+            case 20: e->threads = (int)v; break;
+            case 22: e->start_time = (unsigned long long)v; break;
+            case 24: e->rss_kb = (unsigned long long)v * page_kb; break;
+        }
+    }
+    return 0;
+}
+
+// Fungsi untuk mengurai field penting dari /proc/[pid]/status
+static void parse_proc_status(const char* buf, struct proc_entry* e) {
+    for (const char* line = buf; line != NULL && *line != '\0'; ) {
+        const char* v;
+        if ((v = MATCH_KEY(line, "Name:")) != NULL) {
+            while (*v == '\t' || *v == ' ') v++;
+            size_t i = 0;
+            while (v[i] != '\n' && v[i] != '\0' && i < sizeof(e->name) - 1) {
+                e->name[i] = v[i];
+                i++;
+            }
+            e->name[i] = '\0';
+        } else if ((v = MATCH_KEY(line, "State:")) != NULL) {
+            while (*v == '\t' || *v == ' ') v++;
+            e->state = *v;
+        } else if ((v = MATCH_KEY(line, "Uid:")) != NULL) {
+            e->uid = (unsigned int)scan_ull(&v);
+        } else if ((v = MATCH_KEY(line, "Threads:")) != NULL) {
+            e->threads = (int)scan_ull(&v);
+        } else if ((v = MATCH_KEY(line, "VmRSS:")) != NULL) {
+            e->rss_kb = scan_ull(&v);
+        } else if ((v = MATCH_KEY(line, "VmSwap:")) != NULL) {
+            e->swap_kb = scan_ull(&v);
+        }
+        line = strchr(line, '\n');
+        if (line != NULL) line++;
+    }
+}
+
+// Fungsi untuk mengurai Pss dan Swap dari /proc/[pid]/smaps_rollup
+static void parse_smaps_rollup(const char* buf, struct proc_entry* e) {
+    for (const char* line = buf; line != NULL && *line != '\0'; ) {
+        const char* v;
+        if ((v = MATCH_KEY(line, "Pss:")) != NULL) {
+            e->pss_kb = scan_ull(&v);
+            e->has_pss = 1;
+        } else if ((v = MATCH_KEY(line, "Swap:")) != NULL) {
+            e->swap_kb = scan_ull(&v);
+        }
+        line = strchr(line, '\n');
+        if (line != NULL) line++;
+    }
+}
+
+// Thread pekerja: mengambil proses satu per satu dan membaca file-filenya dengan buffer tetap
+static void* proc_scan_worker(void* arg) {
+    struct proc_scan_job* job = arg;
+    char buf[PROC_READ_BUF];
+
+    for (;;) {
+        int i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+        if (i >= job->table->count) break;
+
+        struct proc_entry* e = &job->table->entries[i];
+        if ((job->flags & PROC_SCAN_STAT) && read_pid_file(e->pid, "stat", buf, sizeof(buf)) > 0 &&
+            parse_proc_stat(buf, e, job->page_kb) == 0) {
+            e->valid = 1;
+        }
+        if ((job->flags & PROC_SCAN_STATUS) && read_pid_file(e->pid, "status", buf, sizeof(buf)) > 0) {
+            parse_proc_status(buf, e);
+            e->valid = 1;
+        }
+        // Kernel thread tidak punya memori user, smaps_rollup-nya tidak perlu dibaca
+        if ((job->flags & PROC_SCAN_SMAPS) && e->valid && e->rss_kb > 0 &&
+            read_pid_file(e->pid, "smaps_rollup", buf, sizeof(buf)) > 0) {
+            parse_smaps_rollup(buf, e);
+        }
+    }
+    return NULL;
+}
+
+// Fungsi untuk memindai seluruh proses di /proc dengan thread pool kecil
+// flags: kombinasi PROC_SCAN_STAT, PROC_SCAN_STATUS, dan PROC_SCAN_SMAPS
+int scan_procs(struct proc_table* t, int flags) {
+    if (list_proc_pids(t) < 0) return -1;
+
+    struct proc_scan_job job = { t, flags, 0, (unsigned long long)sysconf(_SC_PAGESIZE) / 1024 };
+
+    // Thread tambahan hanya sepadan jika prosesnya banyak
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int num_threads = t->count / PROC_SCAN_PER_THREAD + 1;
+    if (num_threads > PROC_SCAN_MAX_THREADS) num_threads = PROC_SCAN_MAX_THREADS;
+    if (cpus > 0 && num_threads > cpus) num_threads = (int)cpus;
+
+    pthread_t threads[PROC_SCAN_MAX_THREADS];
+    int started = 0;
+    for (int i = 1; i < num_threads; i++) {
+        if (pthread_create(&threads[started], NULL, proc_scan_worker, &job) == 0) started++;
+    }
+    proc_scan_worker(&job);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    return t->count;
+}
+
+// Fungsi untuk memformat ukuran byte seperti df -h (mis. 12.3G)
+void format_size(unsigned long long bytes, char* out, size_t size) {
+    const char* units = "BKMGTP";
+    double value = bytes;
+    int unit = 0;
+    while (value >= 1024 && unit < 5) {
+        value /= 1024;
+        unit++;
+    }
+    if (unit == 0) {
+        snprintf(out, size, "%lluB", bytes);
+    } else {
+        snprintf(out, size, value < 10 ? "%.1f%c" : "%.0f%c", value, units[unit]);
+    }
+}
+
+// Fungsi untuk mengubah kB menjadi GB
+static double kb_to_gb(unsigned long long kb) {
+    return kb / 1024.0 / 1024.0;
+}
+
+// Fungsi untuk memeriksa penggunaan RAM
+void check_ram() {
+    struct mem_info mem;
+
+    printf("Memeriksa penggunaan RAM...\n");
+
+    if (sample_meminfo(&mem) != 0 || mem.total == 0) {
+        perror("Gagal membaca file /proc/meminfo");
+        return;
+    }
+
+    // "Terpakai" selalu MemTotal - MemAvailable, sama seperti di cek top
+    unsigned long long used = mem.total > mem.available ? mem.total - mem.available : 0;
+    double used_percent = 100.0 * used / mem.total;
+    unsigned long long swap_used = mem.swap_total > mem.swap_free ? mem.swap_total - mem.swap_free : 0;
+
+    // Tampilkan hasil dengan format yang bagus
+    printf("\n");
+    printf("\033[1;36m"); // Cyan terang
+    printf("=================== PENGGUNAAN RAM ===================\n");
+    printf("\033[0m"); // Reset warna
+
+    printf("Total RAM       : %.2f GB\n", kb_to_gb(mem.total));
+    printf("Terpakai        : %s%.2f GB (%.2f%%)\n", usage_color(used_percent), kb_to_gb(used), used_percent);
+    printf("\033[0m"); // Reset warna
+
+    printf("Tersedia        : %.2f GB\n", kb_to_gb(mem.available));
+    printf("Bebas           : %.2f GB\n", kb_to_gb(mem.free));
+    printf("Cache           : %.2f GB\n", kb_to_gb(mem.cached));
+    printf("Buffer          : %.2f GB\n", kb_to_gb(mem.buffers));
+    printf("Shared (shmem)  : %.2f GB\n", kb_to_gb(mem.shmem));
+    printf("Slab            : %.2f GB (reclaimable %.2f GB, unreclaimable %.2f GB)\n",
+           kb_to_gb(mem.slab), kb_to_gb(mem.slab_reclaimable), kb_to_gb(mem.slab_unreclaimable));
+    if (mem.huge_total > 0) {
+        printf("HugePages       : %llu x %llu kB = %.2f GB (bebas %llu)\n", mem.huge_total, mem.huge_size,
+               kb_to_gb(mem.huge_total * mem.huge_size), mem.huge_free);
+    }
+    printf("Transparent HP  : %.2f GB\n", kb_to_gb(mem.anon_huge));
+    if (mem.swap_total > 0) {
+        printf("Swap            : %.2f GB / %.2f GB\n", kb_to_gb(swap_used), kb_to_gb(mem.swap_total));
+    }
+
+    // Di dalam container, batas cgroup lebih relevan daripada total RAM host
+    struct cgroup_sample cg;
+    if (sample_cgroup(&cg) == 0 && cg.has_memory && cg.mem_max > 0) {
+        double percent = 100.0 * cg.mem_current / cg.mem_max;
+        printf("Batas cgroup    : %.2f GB, terpakai %s%.2f GB (%.2f%% dari batas)\033[0m\n",
+               cg.mem_max / 1073741824.0, usage_color(percent), cg.mem_current / 1073741824.0, percent);
+    }
+
+    printf("\n");
+    printf("\033[1;36m"); // Cyan terang
+    printf("=====================================================\n");
+    printf("\033[0m"); // Reset warna
+}
+
+static int proc_mem_sort = PROC_SORT_RSS;
+
+// Fungsi untuk mengambil nilai memori proses sesuai kolom urutan
+static unsigned long long proc_mem_value(const struct proc_entry* e) {
+    if (proc_mem_sort == PROC_SORT_PSS) return e->has_pss ? e->pss_kb : e->rss_kb;
+    if (proc_mem_sort == PROC_SORT_SWAP) return e->swap_kb;
+    return e->rss_kb;
+}
+
+// Fungsi pembanding untuk mengurutkan proses dari memori terbesar
+static int compare_proc_mem(const void* a, const void* b) {
+    unsigned long long va = proc_mem_value(a), vb = proc_mem_value(b);
+    return va < vb ? 1 : va > vb ? -1 : 0;
+}
+
+// Fungsi untuk mencari nama user dari UID (disimpan di cache kecil)
+const char* user_name(unsigned int uid) {
+    static struct { unsigned int uid; char name[32]; } cache[64];
+    static int cache_count = 0, cache_next = 0;
+
+    for (int i = 0; i < cache_count; i++) {
+        if (cache[i].uid == uid) return cache[i].name;
+    }
+
+    // Cache penuh: timpa entri tertua
+    int slot = cache_count < 64 ? cache_count++ : cache_next++ % 64;
+    struct passwd* pw = getpwuid(uid);
+    if (pw != NULL) {
+        snprintf(cache[slot].name, sizeof(cache[slot].name), "%s", pw->pw_name);
+    } else {
+        snprintf(cache[slot].name, sizeof(cache[slot].name), "%u", uid);
+    }
+    cache[slot].uid = uid;
+    return cache[slot].name;
+}
+
+// Fungsi untuk menampilkan proses dengan penggunaan memori terbesar
+void check_ram_top(int top_n, int sort_key) {
+    static struct proc_table table;
+    static const char* sort_names[] = { "RSS", "PSS", "Swap" };
+
+    double start = now_ms();
+    if (scan_procs(&table, PROC_SCAN_STATUS | PROC_SCAN_SMAPS) < 0) {
+        perror("Gagal memindai /proc");
+        return;
+    }
+    double elapsed = now_ms() - start;
+
+    proc_mem_sort = sort_key;
+    qsort(table.entries, table.count, sizeof(struct proc_entry), compare_proc_mem);
+
+    printf("\033[1;36m"); // Cyan terang
+    printf("============ PROSES TERBESAR (urut %s) ============\n", sort_names[sort_key]);
+    printf("\033[0m"); // Reset warna
+
+    printf("%-8s %-12s %-10s %-10s %-10s %s\n", "PID", "User", "RSS", "PSS", "Swap", "Perintah");
+    printf("-----------------------------------------------------------------------\n");
+
+    int shown = 0, no_pss = 0;
+    for (int i = 0; i < table.count; i++) {
+        struct proc_entry* e = &table.entries[i];
+        if (!e->valid) continue;
+        if (e->rss_kb > 0 && !e->has_pss) no_pss++;
+        if (shown >= top_n || proc_mem_value(e) == 0) continue;
+
+        char rss[16], pss[16], swap[16];
+        format_size(e->rss_kb * 1024, rss, sizeof(rss));
+        format_size(e->swap_kb * 1024, swap, sizeof(swap));
+        if (e->has_pss) {
+            format_size(e->pss_kb * 1024, pss, sizeof(pss));
+        } else {
+            snprintf(pss, sizeof(pss), "-");
+        }
+
+        printf("%-8d %-12.12s %-10s %-10s %-10s %s\n", e->pid, user_name(e->uid), rss, pss, swap, e->name);
+        shown++;
+    }
+
+    printf("\nDipindai %d proses dalam %.1f ms.\n", table.count, elapsed);
+    if (no_pss > 0) {
+        printf("PSS tidak terbaca untuk %d proses (butuh izin lebih, ditampilkan \"-\").\n", no_pss);
+    }
+}
+
+// Filter dan urutan untuk "cek proc"
+struct proc_filter {
+    int sort_key;
+    int limit;
+    int interval_ms;
+    const char* user;               // Nama user persis
+    const char* name;               // Potongan nama perintah
+    const char* states;             // Daftar state yang diterima, mis. "RD"
+    double min_cpu;
+    unsigned long long min_rss_kb;
+    int min_threads;
+};
+
+static int proc_list_sort = PROC_SORT_CPU;
+
+// Fungsi pembanding untuk tabel proses berdasarkan PID
+static int compare_proc_pid(const void* a, const void* b) {
+    return ((const struct proc_entry*)a)->pid - ((const struct proc_entry*)b)->pid;
+}
+
+// Fungsi pembanding untuk daftar "cek proc" sesuai kolom urutan
+static int compare_proc_list(const void* a, const void* b) {
+    const struct proc_entry* x = *(const struct proc_entry* const*)a;
+    const struct proc_entry* y = *(const struct proc_entry* const*)b;
+    int result = 0;
+
+    switch (proc_list_sort) {
+        case PROC_SORT_CPU:
+            result = x->cpu_percent < y->cpu_percent ? 1 : x->cpu_percent > y->cpu_percent ? -1 : 0;
+            break;
+        case PROC_SORT_RSS:
+            result = x->rss_kb < y->rss_kb ? 1 : x->rss_kb > y->rss_kb ? -1 : 0;
+            break;
+        case PROC_SORT_THREADS:
+            result = y->threads - x->threads;
+            break;
+        case PROC_SORT_STATE:
+            result = x->state - y->state;
+            break;
+        case PROC_SORT_USER:
+            result = strcmp(user_name(x->uid), user_name(y->uid));
+            break;
+        case PROC_SORT_NAME:
+            result = strcasecmp(x->name, y->name);
+            break;
+    }
+    return result != 0 ? result : x->pid - y->pid;
+}
+
+// Fungsi untuk memeriksa apakah proses lolos filter "cek proc"
+static int proc_matches(const struct proc_entry* e, const struct proc_filter* f) {
+    if (f->user != NULL && strcmp(user_name(e->uid), f->user) != 0) return 0;
+    if (f->name != NULL && strcasestr(e->name, f->name) == NULL) return 0;
+    if (f->states != NULL && strchr(f->states, e->state) == NULL) return 0;
+    if (e->cpu_percent < f->min_cpu) return 0;
+    if (e->rss_kb < f->min_rss_kb) return 0;
+    if (e->threads < f->min_threads) return 0;
+    return 1;
+}
+
+// Fungsi untuk membaca opsi "cek proc"
+static void parse_proc_filter(char** args, struct proc_filter* f) {
+    memset(f, 0, sizeof(*f));
+    f->sort_key = PROC_SORT_CPU;
+    f->limit = PROC_LIST_DEFAULT;
+    f->interval_ms = PROC_SAMPLE_DEFAULT_MS;
+
+    for (int i = 0; args[i] != NULL; i++) {
+        const char* next = args[i + 1];
+        if (next == NULL) break;
+
+        if (strcmp(args[i], "-s") == 0 || strcmp(args[i], "--sort") == 0) {
+            if (strcmp(next, "rss") == 0) f->sort_key = PROC_SORT_RSS;
+            else if (strcmp(next, "thread") == 0 || strcmp(next, "threads") == 0) f->sort_key = PROC_SORT_THREADS;
+            else if (strcmp(next, "state") == 0) f->sort_key = PROC_SORT_STATE;
+            else if (strcmp(next, "user") == 0) f->sort_key = PROC_SORT_USER;
+            else if (strcmp(next, "nama") == 0 || strcmp(next, "name") == 0) f->sort_key = PROC_SORT_NAME;
+            else f->sort_key = PROC_SORT_CPU;
+        } else if (strcmp(args[i], "-u") == 0 || strcmp(args[i], "--user") == 0) {
+            f->user = next;
+        } else if (strcmp(args[i], "-n") == 0 || strcmp(args[i], "--nama") == 0) {
+            f->name = next;
+        } else if (strcmp(args[i], "--state") == 0) {
+            f->states = next;
+        } else if (strcmp(args[i], "--min-cpu") == 0) {
+            f->min_cpu = atof(next);
+        } else if (strcmp(args[i], "--min-rss") == 0) {
+            f->min_rss_kb = strtoull(next, NULL, 10) * 1024;    // Dalam MB
+        } else if (strcmp(args[i], "--min-thread") == 0) {
+            f->min_threads = atoi(next);
+        } else if (strcmp(args[i], "-N") == 0) {
+            f->limit = atoi(next);
+        } else if (strcmp(args[i], "-i") == 0 || strcmp(args[i], "--interval") == 0) {
+            int ms = atoi(next);
+            if (ms > 0) f->interval_ms = ms;
+        } else {
+            continue;
+        }
+        i++;
+    }
+}
+
+// Fungsi untuk menampilkan daftar proses dengan CPU% dari dua sampel /proc/[pid]/stat
+void check_proc(char** args) {
+    static struct proc_table first, second;
+    static struct proc_entry** rows;
+    static int rows_capacity;
+
+    struct proc_filter f;
+    parse_proc_filter(args, &f);
+
+    printf("Mengambil sampel proses selama %d ms...\n", f.interval_ms);
+
+    // Sampel pertama cukup stat; status (UID) hanya dibaca di sampel kedua
+    if (scan_procs(&first, PROC_SCAN_STAT) < 0) {
+        perror("Gagal memindai /proc");
+        return;
+    }
+    double first_ms = now_ms();
+    sleep_ms(f.interval_ms);
+
+    double start = now_ms();
+    if (scan_procs(&second, PROC_SCAN_STAT | PROC_SCAN_STATUS) < 0) {
+        perror("Gagal memindai /proc");
+        return;
+    }
+    double scan_ms = now_ms() - start;
+    double seconds = (start - first_ms) / 1000.0;
+    long ticks = sysconf(_SC_CLK_TCK);
+
+    // Gabungkan kedua sampel berdasarkan PID
+    qsort(first.entries, first.count, sizeof(struct proc_entry), compare_proc_pid);
+    qsort(second.entries, second.count, sizeof(struct proc_entry), compare_proc_pid);
+
+    if (rows_capacity < second.count) {
+        struct proc_entry** grown = realloc(rows, sizeof(struct proc_entry*) * second.count);
+        if (grown == NULL) {
+            perror("Gagal mengalokasikan memori");
+            return;
+        }
+        rows = grown;
+        rows_capacity = second.count;
+    }
+
+    int num_rows = 0, total = 0, running = 0, sleeping = 0, zombie = 0;
+    for (int i = 0, j = 0; i < second.count; i++) {
+        struct proc_entry* e = &second.entries[i];
+        if (!e->valid) continue;
+
+        while (j < first.count && first.entries[j].pid < e->pid) j++;
+        e->cpu_percent = 0;
+        if (j < first.count && first.entries[j].pid == e->pid && first.entries[j].valid &&
+            first.entries[j].start_time == e->start_time && seconds > 0) {
+            unsigned long long used = counter_delta(first.entries[j].utime + first.entries[j].stime,
+                                                    e->utime + e->stime);
+            e->cpu_percent = 100.0 * used / ticks / seconds;
+        }
+
+        total++;
+        if (e->state == 'R') running++;
+        else if (e->state == 'S' || e->state == 'I') sleeping++;
+        else if (e->state == 'Z') zombie++;
+
+        if (proc_matches(e, &f)) rows[num_rows++] = e;
+    }
+
+    proc_list_sort = f.sort_key;
+    qsort(rows, num_rows, sizeof(struct proc_entry*), compare_proc_list);
+
+    printf("\n");
+    printf("\033[1;36m"); // Cyan terang
+    printf("======================= DAFTAR PROSES =======================\n");
+    printf("\033[0m"); // Reset warna
+    printf("Total %d proses: %d berjalan, %d tidur, %d zombie (scan %.1f ms)\n\n",
+           total, running, sleeping, zombie, scan_ms);
+
+    printf("%-8s %-12s %-2s %-5s %-8s %-10s %s\n", "PID", "User", "S", "THR", "CPU%", "RSS", "Perintah");
+    printf("-----------------------------------------------------------------\n");
+
+    for (int i = 0; i < num_rows && (f.limit <= 0 || i < f.limit); i++) {
+        struct proc_entry* e = rows[i];
+        char rss[16];
+        format_size(e->rss_kb * 1024, rss, sizeof(rss));
+
+        printf("%-8d %-12.12s %-2c %-5d %s%-8.1f\033[0m %-10s %s\n", e->pid, user_name(e->uid), e->state,
+               e->threads, usage_color(e->cpu_percent), e->cpu_percent, rss, e->name);
+    }
+
+    if (f.limit > 0 && num_rows > f.limit) {
+        printf("... %d proses lain cocok dengan filter (gunakan -N 0 untuk menampilkan semua)\n",
+               num_rows - f.limit);
+    }
+}
+
+// Fungsi benchmark pemindai /proc: waktu scan per 10 ribu proses
+// Dengan --spawn N, shell membuat N proses anak yang tidur agar jumlah proses realistis
+void proc_benchmark(char** args) {
+    static struct proc_table table;
+    int rounds = 5, spawn = 0;
+
+    for (int i = 0; args[i] != NULL; i++) {
+        if (strcmp(args[i], "-r") == 0 && args[i + 1] != NULL) rounds = atoi(args[++i]);
+        else if (strcmp(args[i], "--spawn") == 0 && args[i + 1] != NULL) spawn = atoi(args[++i]);
+    }
+    if (rounds < 1) rounds = 1;
+    if (spawn > PROC_BENCH_MAX_SPAWN) spawn = PROC_BENCH_MAX_SPAWN;
+
+    pid_t* children = NULL;
+    int spawned = 0;
+    if (spawn > 0) {
+        children = malloc(sizeof(pid_t) * spawn);
+        if (children == NULL) {
+            perror("Gagal mengalokasikan memori");
+            return;
+        }
+        fflush(stdout);
+        for (; spawned < spawn; spawned++) {
+            pid_t pid = fork();
+            if (pid < 0) {
+                perror("fork");
+                break;
+            }
+            if (pid == 0) {
+                for (;;) pause();
+            }
+            children[spawned] = pid;
+        }
+        printf("Membuat %d proses anak untuk benchmark.\n", spawned);
+    }
+
+    static const struct { const char* label; int flags; } modes[] = {
+        { "stat", PROC_SCAN_STAT },
+        { "stat + status", PROC_SCAN_STAT | PROC_SCAN_STATUS },
+        { "status + smaps_rollup", PROC_SCAN_STATUS | PROC_SCAN_SMAPS },
+    };
+
+    printf("\n%-24s %-10s %-12s %s\n", "Mode", "Proses", "ms/scan", "ms per 10k proses");
+    printf("-------------------------------------------------------------\n");
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        double total_ms = 0;
+        int count = 0;
+        for (int r = 0; r < rounds; r++) {
+            double start = now_ms();
+            count = scan_procs(&table, modes[m].flags);
+            total_ms += now_ms() - start;
+        }
+        double per_scan = total_ms / rounds;
+        printf("%-24s %-10d %-12.2f %.2f\n", modes[m].label, count, per_scan,
+               count > 0 ? per_scan * 10000.0 / count : 0);
+    }
+
+    for (int i = 0; i < spawned; i++) {
+        kill(children[i], SIGKILL);
+    }
+    for (int i = 0; i < spawned; i++) {
+        waitpid(children[i], NULL, 0);
+    }
+    free(children);
+}
+
+// Satu mount dari /proc/self/mountinfo beserta hasil statvfs-nya
+struct mount_entry {
+    char mount_point[256];
+    char fstype[32];
+    char source[128];
+    unsigned int major, minor;
+    int state;                      // 0 = belum selesai, 1 = sukses, -1 = gagal
+    unsigned long long size, used, avail;
+};
+
+struct statvfs_batch;
+
+// Argumen satu thread statvfs
+struct statvfs_job {
+    struct statvfs_batch* batch;
+    int index;
+};
+
+// Pekerjaan statvfs paralel. Dibebaskan oleh pemegang referensi terakhir, sehingga
+// thread yang tertahan di mount NFS yang macet tetap aman setelah shell berhenti menunggu.
+struct statvfs_batch {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int refs;
+    int pending;
+    struct mount_entry mounts[MAX_MOUNTS];
+    struct statvfs_job jobs[MAX_MOUNTS];
+};
+
+// Fungsi untuk menguraikan escape oktal di mountinfo (mis. "\040" untuk spasi)
+static void unescape_mount_path(char* s) {
+    char* dst = s;
+    for (char* src = s; *src != '\0'; ) {
+        if (src[0] == '\\' && src[1] >= '0' && src[1] <= '7' && src[2] >= '0' && src[2] <= '7' &&
+            src[3] >= '0' && src[3] <= '7') {
+            *dst++ = (char)(((src[1] - '0') << 6) | ((src[2] - '0') << 3) | (src[3] - '0'));
+            src += 4;
+        } else {
+            *dst++ = *src++;
+        }
+    }
+    *dst = '\0';
+}
+
+// Fungsi untuk memeriksa apakah filesystem termasuk pseudo filesystem yang tidak perlu ditampilkan
+static int is_pseudo_fs(const char* fstype) {
+    static const char* pseudo[] = {
+        "proc", "sysfs", "devtmpfs", "devpts", "tmpfs", "cgroup", "cgroup2", "securityfs",
+        "pstore", "bpf", "debugfs", "tracefs", "mqueue", "hugetlbfs", "configfs", "fusectl",
+        "autofs", "binfmt_misc", "rpc_pipefs", "nsfs", "squashfs", "efivarfs", "ramfs",
+        "selinuxfs", "fuse.gvfsd-fuse", "fuse.portal", NULL
+    };
+    for (int i = 0; pseudo[i] != NULL; i++) {
+        if (strcmp(fstype, pseudo[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+// Fungsi untuk membaca daftar mount nyata dari /proc/self/mountinfo (satu entri per perangkat)
+int read_mountinfo(struct mount_entry* mounts, int max_mounts) {
+    FILE* fp = fopen("/proc/self/mountinfo", "r");
+    if (fp == NULL) return -1;
+
+    int count = 0;
+    char line[1024];
+    while (fgets(line, sizeof(line), fp) != NULL && count < max_mounts) {
+        // Format: id parent major:minor root mount_point options [optional...] - fstype source super_options
+        unsigned int major, minor;
+        char mount_point[256];
+        if (sscanf(line, "%*d %*d %u:%u %*s %255s", &major, &minor, mount_point) != 3) continue;
+
+        char* sep = strstr(line, " - ");
+        if (sep == NULL) continue;
+
+        char fstype[32], source[128];
+        if (sscanf(sep + 3, "%31s %127s", fstype, source) != 2) continue;
+
+        if (is_pseudo_fs(fstype) || strncmp(source, "/dev/loop", 9) == 0) continue;
+
+        // Bind mount dari perangkat yang sama hanya ditampilkan sekali
+        int duplicate = 0;
+        for (int i = 0; i < count; i++) {
+            if (mounts[i].major == major && mounts[i].minor == minor) {
+                duplicate = 1;
+                break;
+            }
+        }
+        if (duplicate) continue;
+
+        struct mount_entry* m = &mounts[count++];
+        memset(m, 0, sizeof(*m));
+        unescape_mount_path(mount_point);
+        snprintf(m->mount_point, sizeof(m->mount_point), "%s", mount_point);
+        snprintf(m->fstype, sizeof(m->fstype), "%s", fstype);
+        snprintf(m->source, sizeof(m->source), "%s", source);
+        m->major = major;
+        m->minor = minor;
+    }
+
+    fclose(fp);
+    return count;
+}
+
+// Fungsi untuk melepas referensi batch statvfs, membebaskannya jika referensi terakhir
+static void release_statvfs_batch(struct statvfs_batch* b) {
+    pthread_mutex_lock(&b->lock);
+    int last = --b->refs == 0;
+    pthread_mutex_unlock(&b->lock);
+
+    if (last) {
+        pthread_mutex_destroy(&b->lock);
+        pthread_cond_destroy(&b->cond);
+        free(b);
+    }
+}
+
+// Thread pekerja: menjalankan statvfs untuk satu mount
+static void* statvfs_worker(void* arg) {
+    struct statvfs_job* job = arg;
+    struct statvfs_batch* b = job->batch;
+    struct mount_entry* m = &b->mounts[job->index];
+
+    struct statvfs st;
+    int ok = statvfs(m->mount_point, &st) == 0;
+
+    pthread_mutex_lock(&b->lock);
+    if (ok) {
+        m->size = (unsigned long long)st.f_blocks * st.f_frsize;
+        m->avail = (unsigned long long)st.f_bavail * st.f_frsize;
+        m->used = m->size - (unsigned long long)st.f_bfree * st.f_frsize;
+        m->state = 1;
+    } else {
+        m->state = -1;
+    }
+    b->pending--;
+    pthread_cond_signal(&b->cond);
+    pthread_mutex_unlock(&b->lock);
+
+    release_statvfs_batch(b);
+    return NULL;
+}
+
+// Fungsi untuk menjalankan statvfs semua mount secara paralel dengan batas waktu
+// Mount yang belum menjawab sebelum timeout ditandai state = 0
+void statvfs_parallel(struct mount_entry* mounts, int count, int timeout_ms) {
+    struct statvfs_batch* b = calloc(1, sizeof(*b));
+    if (b == NULL) return;
+
+    pthread_mutex_init(&b->lock, NULL);
+    pthread_cond_init(&b->cond, NULL);
+    memcpy(b->mounts, mounts, sizeof(struct mount_entry) * count);
+    b->refs = 1;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_attr_setstacksize(&attr, 64 * 1024);
+
+    for (int i = 0; i < count; i++) {
+        b->jobs[i].batch = b;
+        b->jobs[i].index = i;
+
+        pthread_mutex_lock(&b->lock);
+        b->refs++;
+        b->pending++;
+        pthread_mutex_unlock(&b->lock);
+
+        pthread_t tid;
+        if (pthread_create(&tid, &attr, statvfs_worker, &b->jobs[i]) != 0) {
+            pthread_mutex_lock(&b->lock);
+            b->refs--;
+            b->pending--;
+            b->mounts[i].state = -1;
+            pthread_mutex_unlock(&b->lock);
+        }
+    }
+    pthread_attr_destroy(&attr);
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&b->lock);
+    while (b->pending > 0) {
+        if (pthread_cond_timedwait(&b->cond, &b->lock, &deadline) == ETIMEDOUT) break;
+    }
+    memcpy(mounts, b->mounts, sizeof(struct mount_entry) * count);
+    pthread_mutex_unlock(&b->lock);
+
+    release_statvfs_batch(b);
+}
+
+// Fungsi untuk memeriksa penggunaan disk (tanpa df/iostat)
+void check_disk(int interval_ms) {
+    static struct mount_entry mounts[MAX_MOUNTS];
+    static struct disk_sample before, after;
+
+    printf("Memeriksa penggunaan disk...\n");
+
+    // Sampel I/O pertama diambil lebih dulu agar statvfs berjalan di dalam interval sampel
+    double start = now_ms();
+    int have_io = sample_diskstats(&before) == 0;
+
+    int count = read_mountinfo(mounts, MAX_MOUNTS);
+    if (count < 0) {
+        perror("Gagal membaca /proc/self/mountinfo");
+        return;
+    }
+    statvfs_parallel(mounts, count, DISK_STATVFS_TIMEOUT_MS);
+
+    // Tampilkan hasil dengan format yang bagus
+    printf("\n");
+    printf("\033[1;36m"); // Cyan terang
+    printf("=================== PENGGUNAAN DISK ===================\n");
+    printf("\033[0m"); // Reset warna
+
+    // Lebar kolom mount point mengikuti mount point terpanjang yang ditampilkan (minimal 20)
+    int width = 20;
+    for (int i = 0; i < count; i++) {
+        int len = (int)strlen(mounts[i].mount_point);
+        if ((mounts[i].state == 0 || (mounts[i].state > 0 && mounts[i].size != 0)) && len > width) width = len;
+    }
+
+    printf("%-*s %-10s %-10s %-10s %-10s %s\n",
+           width, "Mount Point", "Ukuran", "Terpakai", "Tersedia", "Persentase", "Tipe");
+    for (int i = 0; i < width + 51; i++) putchar('-');
+    putchar('\n');
+
+    for (int i = 0; i < count; i++) {
+        struct mount_entry* m = &mounts[i];
+
+        if (m->state == 0) {
+            printf("%-*s \033[1;31m%-43s\033[0m %s\n", width, m->mount_point, "(tidak merespons, dilewati)", m->fstype);
+            continue;
+        }
+        if (m->state < 0 || m->size == 0) continue;
+
+        char size[16], used[16], avail[16], percent[16];
+        format_size(m->size, size, sizeof(size));
+        format_size(m->used, used, sizeof(used));
+        format_size(m->avail, avail, sizeof(avail));
+
+        // Persentase seperti df: terpakai / (terpakai + tersedia untuk pengguna biasa)
+        unsigned long long denom = m->used + m->avail;
+        int used_percent = denom ? (int)((m->used * 100 + denom - 1) / denom) : 0;
+        snprintf(percent, sizeof(percent), "%d%%", used_percent);
+
+        printf("%-*s %-10s ", width, m->mount_point, size);
+        printf("%s%-10s ", usage_color(used_percent), used);
+        printf("\033[0m"); // Reset warna
+        printf("%-10s %-10s %s\n", avail, percent, m->fstype);
+    }
+
+    // Statistik I/O dihitung dari selisih dua sampel /proc/diskstats
+    if (have_io) {
+        int remaining = interval_ms - (int)(now_ms() - start);
+        if (remaining > 0) sleep_ms(remaining);
+
+        if (sample_diskstats(&after) == 0 && after.count > 0) {
+            printf("\n");
+            printf("Statistik I/O Disk (selama %.0f ms):\n", after.time_ms - before.time_ms);
+            printf("%-12s %-12s %-12s %-10s %-10s %s\n", "Device", "Baca kB/s", "Tulis kB/s", "Baca IOPS", "Tulis IOPS", "Util");
+            printf("--------------------------------------------------------------------\n");
+
+            for (int i = 0; i < after.count; i++) {
+                struct disk_rate rate;
+                if (compute_disk_rate(&before, &after, &after.disks[i], &rate) != 0) continue;
+                printf("%-12s %-12.1f %-12.1f %-10.1f %-10.1f %s%.1f%%\033[0m\n",
+                       after.disks[i].name, rate.read_kbs, rate.write_kbs, rate.read_iops, rate.write_iops,
+                       usage_color(rate.util), rate.util);
+            }
+        }
+    }
+
+    printf("\n");
+    printf("\033[1;36m"); // Cyan terang
+    printf("=======================================================\n");
+    printf("\033[0m"); // Reset warna
+}
+
+// Fungsi untuk mencari nama perangkat blok dari major:minor (mis. 8:0 -> sda)
+static void block_device_name(unsigned int major, unsigned int minor, char* out, size_t size) {
+    char path[64], target[256];
+    snprintf(path, sizeof(path), "/sys/dev/block/%u:%u", major, minor);
+    ssize_t n = readlink(path, target, sizeof(target) - 1);
+    if (n > 0) {
+        target[n] = '\0';
+        const char* base = strrchr(target, '/');
+        base = base != NULL ? base + 1 : target;
+        size_t len = strlen(base) < size - 1 ? strlen(base) : size - 1;
+        memcpy(out, base, len);
+        out[len] = '\0';
+    } else {
+        snprintf(out, size, "%u:%u", major, minor);
+    }
+}
+
+// Fungsi untuk menampilkan pressure stall information (PSI) dan laju terukurnya selama interval
+static void print_pressure(const char* dir, const struct psi_sample before[3], const struct psi_sample after[3],
+                           double seconds) {
+    static const char* resources[] = { "cpu", "memory", "io" };
+
+    printf("Sumber: %s\n\n", dir);
+    printf("%-8s %-6s %8s %8s %8s %10s\n", "Resource", "Jenis", "avg10", "avg60", "avg300", "Terukur");
+    printf("-----------------------------------------------------\n");
+
+    for (int r = 0; r < 3; r++) {
+        if (!after[r].valid) {
+            printf("%-8s %-6s %s\n", resources[r], "-", "(tidak tersedia)");
+            continue;
+        }
+        for (int full = 0; full <= 1; full++) {
+            if (full && !after[r].has_full) continue;
+            const struct psi_line* a = full ? &before[r].full : &before[r].some;
+            const struct psi_line* b = full ? &after[r].full : &after[r].some;
+
+            // Persentase waktu tertahan selama interval pengukuran
+            double measured = seconds > 0 ? counter_delta(a->total, b->total) / (seconds * 1e6) * 100.0 : 0;
+            if (measured > 100.0) measured = 100.0;
+            printf("%-8s %-6s %7.2f%% %7.2f%% %7.2f%% %s%9.2f%%\033[0m\n", resources[r], full ? "full" : "some",
+                   b->avg10, b->avg60, b->avg300, usage_color(measured * 2), measured);
+        }
+    }
+}
+
+// Fungsi untuk "cek pressure" (hanya PSI) dan "cek cgroup" (batas, throttling, memori, I/O, dan PSI)
+void check_cgroup(int interval_ms, int show_cgroup) {
+    static const char* psi_files[] = { "cpu", "memory", "io" };
+    struct psi_sample psi_before[3], psi_after[3];
+    struct cgroup_sample before, after;
+    const struct cgroup_paths* p = cgroup_locate();
+
+    // PSI cgroup dipakai jika proses berada di cgroup v2 selain akar; jika tidak, PSI sistem
+    const char* psi_dir = "/proc/pressure";
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/cpu.pressure", p->v2);
+    if (p->v2[0] != '\0' && strcmp(p->name, "/") != 0 && access(path, R_OK) == 0) {
+        psi_dir = p->v2;
+    }
+    int system_psi = psi_dir != p->v2;
+
+    printf("Mengambil sampel %s selama %d ms...\n", show_cgroup ? "cgroup" : "pressure", interval_ms);
+
+    for (int r = 0; r < 3; r++) {
+        snprintf(path, sizeof(path), system_psi ? "%s/%s" : "%s/%s.pressure", psi_dir, psi_files[r]);
+        read_psi(path, &psi_before[r]);
+    }
+    int have_cgroup = sample_cgroup(&before) == 0;
+    double start = now_ms();
+
+    sleep_ms(interval_ms);
+
+    for (int r = 0; r < 3; r++) {
+        snprintf(path, sizeof(path), system_psi ? "%s/%s" : "%s/%s.pressure", psi_dir, psi_files[r]);
+        read_psi(path, &psi_after[r]);
+    }
+    have_cgroup = sample_cgroup(&after) == 0 && have_cgroup;
+    double seconds = (now_ms() - start) / 1000.0;
+
+    if (show_cgroup) {
+        printf("\n");
+        printf("\033[1;36m"); // Cyan terang
+        printf("======================== CGROUP ========================\n");
+        printf("\033[0m"); // Reset warna
+
+        if (!have_cgroup) {
+            printf("Informasi cgroup tidak tersedia di sistem ini.\n");
+        } else {
+            printf("Cgroup      : %s (%s)\n", p->name[0] ? p->name : "/",
+                   p->v2[0] && (p->v1_memory[0] || p->v1_cpu[0]) ? "hybrid v1/v2" : p->v2[0] ? "v2" : "v1");
+
+            double used = cgroup_cpu_used(&before, &after);
+            if (after.cpu_limit > 0) {
+                double percent = 100.0 * used / after.cpu_limit;
+                printf("CPU         : %s%.2f CPU\033[0m (%.1f%% dari batas %.2f CPU)\n",
+                       usage_color(percent), used, percent, after.cpu_limit);
+            } else {
+                printf("CPU         : %.2f CPU (tanpa batas cgroup)\n", used);
+            }
+
+            unsigned long long periods = counter_delta(before.nr_periods, after.nr_periods);
+            unsigned long long throttled = counter_delta(before.nr_throttled, after.nr_throttled);
+            double throttled_ms = counter_delta(before.throttled_usec, after.throttled_usec) / 1000.0;
+            if (periods > 0) {
+                double percent = 100.0 * throttled / periods;
+                printf("Throttling  : %s%llu/%llu periode (%.1f%%)\033[0m, %.1f ms tertahan per detik\n",
+                       usage_color(percent * 2), throttled, periods, percent, seconds > 0 ? throttled_ms / seconds : 0);
+            } else {
+                printf("Throttling  : tidak ada periode kuota selama interval (total %llu kali tertahan)\n",
+                       after.nr_throttled);
+            }
+
+            if (after.has_memory) {
+                char current[16], limit[16];
+                format_size(after.mem_current, current, sizeof(current));
+                if (after.mem_max > 0) {
+                    double percent = 100.0 * after.mem_current / after.mem_max;
+                    format_size(after.mem_max, limit, sizeof(limit));
+                    printf("Memori      : %s%s\033[0m / %s (%.1f%% dari batas)\n", usage_color(percent), current, limit, percent);
+                } else {
+                    printf("Memori      : %s (tanpa batas cgroup)\n", current);
+                }
+                if (after.mem_high > 0) {
+                    format_size(after.mem_high, limit, sizeof(limit));
+                    printf("Batas lunak : %s\n", limit);
+                }
+
+                char anon[16], file[16], kernel[16], shmem[16], sock[16], swap[16];
+                format_size(after.mem_anon, anon, sizeof(anon));
+                format_size(after.mem_file, file, sizeof(file));
+                format_size(after.mem_kernel, kernel, sizeof(kernel));
+                format_size(after.mem_shmem, shmem, sizeof(shmem));
+                format_size(after.mem_sock, sock, sizeof(sock));
+                format_size(after.swap_current, swap, sizeof(swap));
+                printf("  anon %s, file %s, kernel %s, shmem %s, sock %s, swap %s\n",
+                       anon, file, kernel, shmem, sock, swap);
+            }
+
+            if (after.io_count > 0) {
+                printf("\n%-12s %-12s %-12s %-10s %s\n", "Device", "Baca kB/s", "Tulis kB/s", "Baca IOPS", "Tulis IOPS");
+                printf("------------------------------------------------------------\n");
+                for (int i = 0; i < after.io_count; i++) {
+                    for (int j = 0; j < before.io_count; j++) {
+                        if (before.io[j].major != after.io[i].major || before.io[j].minor != after.io[i].minor) continue;
+                        char name[32];
+                        block_device_name(after.io[i].major, after.io[i].minor, name, sizeof(name));
+                        printf("%-12s %-12.1f %-12.1f %-10.1f %.1f\n", name,
+                               counter_delta(before.io[j].rbytes, after.io[i].rbytes) / 1024.0 / seconds,
+                               counter_delta(before.io[j].wbytes, after.io[i].wbytes) / 1024.0 / seconds,
+                               counter_delta(before.io[j].rios, after.io[i].rios) / seconds,
+                               counter_delta(before.io[j].wios, after.io[i].wios) / seconds);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    printf("\n");
+    printf("\033[1;36m"); // Cyan terang
+    printf("================ PRESSURE STALL (PSI) =================\n");
+    printf("\033[0m"); // Reset warna
+    if (!psi_after[0].valid && !psi_after[1].valid && !psi_after[2].valid) {
+        printf("PSI tidak tersedia (butuh kernel 4.20+ dengan CONFIG_PSI).\n");
+    } else {
+        print_pressure(psi_dir, psi_before, psi_after, seconds);
+    }
+
+    printf("\n");
+    printf("\033[1;36m"); // Cyan terang
+    printf("=======================================================\n");
+    printf("\033[0m"); // Reset warna
+}
+
+// Buffer teks yang tumbuh otomatis untuk merender metrik
+struct text_buffer {
+    char* data;
+    size_t len;
+    size_t capacity;
+};
+
+// Fungsi untuk menambahkan teks berformat ke buffer
+static void buf_printf(struct text_buffer* b, const char* fmt, ...) {
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(b->data ? b->data + b->len : NULL, b->data ? b->capacity - b->len : 0, fmt, ap);
+        va_end(ap);
+        if (n < 0) return;
+
+        if (b->data != NULL && b->len + n < b->capacity) {
+            b->len += n;
+            return;
+        }
+
+        size_t capacity = b->capacity ? b->capacity * 2 : 4096;
+        while (capacity <= b->len + n) capacity *= 2;
+        char* data = realloc(b->data, capacity);
+        if (data == NULL) return;
+        b->data = data;
+        b->capacity = capacity;
+    }
+}
+
+// Fungsi untuk menulis string sebagai nilai label OpenMetrics atau string JSON (escape \ " dan newline)
+static void buf_escaped(struct text_buffer* b, const char* s) {
+    for (; *s != '\0'; s++) {
+        if (*s == '\\' || *s == '"') buf_printf(b, "\\%c", *s);
+        else if (*s == '\n') buf_printf(b, "\\n");
+        else if ((unsigned char)*s >= 0x20) buf_printf(b, "%c", *s);
+    }
+}
+
+// Seluruh data mentah untuk satu snapshot metrik, diambil dari sampler bersama
+struct metrics_state {
+    struct cpu_sample cpu[2];
+    struct disk_sample disk[2];
+    int cur;                        // Indeks sampel terbaru di cpu[] dan disk[]
+    int samples;                    // Jumlah sampel yang sudah diambil
+    struct mem_info mem;
+    double load[3];
+    struct mount_entry mounts[MAX_MOUNTS];
+    int mount_count;
+    double wall_time;               // Waktu sampel terbaru (detik sejak epoch)
+};
+
+// Fungsi untuk mengambil sampel baru; laju dihitung terhadap sampel sebelumnya
+void collect_metrics(struct metrics_state* st) {
+    st->cur = st->samples > 0 ? 1 - st->cur : 0;
+    sample_cpu(&st->cpu[st->cur]);
+    sample_diskstats(&st->disk[st->cur]);
+    sample_meminfo(&st->mem);
+    sample_loadavg(st->load);
+
+    st->mount_count = read_mountinfo(st->mounts, MAX_MOUNTS);
+    if (st->mount_count < 0) st->mount_count = 0;
+    statvfs_parallel(st->mounts, st->mount_count, DISK_STATVFS_TIMEOUT_MS);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    st->wall_time = ts.tv_sec + ts.tv_nsec / 1e9;
+    st->samples++;
+}
+
+// Fungsi untuk menulis baris HELP/TYPE satu keluarga metrik OpenMetrics
+static void metric_family(struct text_buffer* b, const char* name, const char* type, const char* help) {
+    buf_printf(b, "# TYPE %s %s\n# HELP %s %s\n", name, type, name, help);
+}
+
+// Fungsi untuk merender snapshot dalam format teks OpenMetrics
+void render_openmetrics(const struct metrics_state* st, struct text_buffer* b) {
+    const struct cpu_sample* cpu = &st->cpu[st->cur];
+    const struct cpu_sample* cpu_prev = &st->cpu[1 - st->cur];
+    const struct disk_sample* disk = &st->disk[st->cur];
+    const struct disk_sample* disk_prev = &st->disk[1 - st->cur];
+    double tick = (double)sysconf(_SC_CLK_TCK);
+
+    b->len = 0;
+
+    metric_family(b, "mishell_cpu_seconds", "counter", "Waktu CPU kumulatif per core dan mode.");
+    for (int i = 0; i < cpu->num_cores; i++) {
+        const struct cpu_times* t = &cpu->cores[i];
+        const struct { const char* mode; unsigned long long value; } modes[] = {
+            {"user", t->user}, {"nice", t->nice}, {"system", t->system}, {"idle", t->idle},
+            {"iowait", t->iowait}, {"irq", t->irq}, {"softirq", t->softirq}, {"steal", t->steal},
+        };
+        for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+            buf_printf(b, "mishell_cpu_seconds_total{cpu=\"%d\",mode=\"%s\"} %.2f\n", i, modes[m].mode,
+                       modes[m].value / tick);
+        }
+    }
+
+    if (st->samples > 1) {
+        struct cpu_usage usage;
+        metric_family(b, "mishell_cpu_busy_ratio", "gauge", "Porsi waktu CPU sibuk sejak snapshot sebelumnya.");
+        compute_cpu_usage(&cpu_prev->total, &cpu->total, &usage);
+        buf_printf(b, "mishell_cpu_busy_ratio{cpu=\"all\"} %.4f\n", usage.busy / 100.0);
+        for (int i = 0; i < cpu->num_cores && i < cpu_prev->num_cores; i++) {
+            compute_cpu_usage(&cpu_prev->cores[i], &cpu->cores[i], &usage);
+            buf_printf(b, "mishell_cpu_busy_ratio{cpu=\"%d\"} %.4f\n", i, usage.busy / 100.0);
+        }
+    }
+
+    const struct mem_info* mem = &st->mem;
+    unsigned long long used = mem->total > mem->available ? mem->total - mem->available : 0;
+    metric_family(b, "mishell_memory_bytes", "gauge", "Memori dari /proc/meminfo; used = total - available.");
+    const struct { const char* type; unsigned long long kb; } memory[] = {
+        {"total", mem->total}, {"used", used}, {"available", mem->available}, {"free", mem->free},
+        {"buffers", mem->buffers}, {"cached", mem->cached}, {"shmem", mem->shmem}, {"slab", mem->slab},
+        {"swap_total", mem->swap_total}, {"swap_free", mem->swap_free},
+    };
+    for (size_t i = 0; i < sizeof(memory) / sizeof(memory[0]); i++) {
+        buf_printf(b, "mishell_memory_bytes{type=\"%s\"} %llu\n", memory[i].type, memory[i].kb * 1024);
+    }
+
+    metric_family(b, "mishell_load", "gauge", "Load average.");
+    buf_printf(b, "mishell_load{period=\"1m\"} %.2f\nmishell_load{period=\"5m\"} %.2f\nmishell_load{period=\"15m\"} %.2f\n",
+               st->load[0], st->load[1], st->load[2]);
+
+    metric_family(b, "mishell_disk_read_bytes", "counter", "Byte dibaca per disk.");
+    for (int i = 0; i < disk->count; i++) {
+        buf_printf(b, "mishell_disk_read_bytes_total{device=\"%s\"} %llu\n", disk->disks[i].name,
+                   disk->disks[i].sectors_read * 512);
+    }
+    metric_family(b, "mishell_disk_written_bytes", "counter", "Byte ditulis per disk.");
+    for (int i = 0; i < disk->count; i++) {
+        buf_printf(b, "mishell_disk_written_bytes_total{device=\"%s\"} %llu\n", disk->disks[i].name,
+                   disk->disks[i].sectors_written * 512);
+    }
+    metric_family(b, "mishell_disk_io", "counter", "Operasi baca/tulis selesai per disk.");
+    for (int i = 0; i < disk->count; i++) {
+        buf_printf(b, "mishell_disk_io_total{device=\"%s\",op=\"read\"} %llu\n", disk->disks[i].name, disk->disks[i].reads);
+        buf_printf(b, "mishell_disk_io_total{device=\"%s\",op=\"write\"} %llu\n", disk->disks[i].name, disk->disks[i].writes);
+    }
+    if (st->samples > 1) {
+        metric_family(b, "mishell_disk_utilization_ratio", "gauge", "Porsi waktu disk sibuk sejak snapshot sebelumnya.");
+        for (int i = 0; i < disk->count; i++) {
+            struct disk_rate rate;
+            if (compute_disk_rate(disk_prev, disk, &disk->disks[i], &rate) != 0) continue;
+            buf_printf(b, "mishell_disk_utilization_ratio{device=\"%s\"} %.4f\n", disk->disks[i].name, rate.util / 100.0);
+        }
+    }
+
+    metric_family(b, "mishell_filesystem_size_bytes", "gauge", "Ukuran filesystem.");
+    for (int i = 0; i < st->mount_count; i++) {
+        const struct mount_entry* m = &st->mounts[i];
+        if (m->state != 1 || m->size == 0) continue;
+        buf_printf(b, "mishell_filesystem_size_bytes{mountpoint=\"");
+        buf_escaped(b, m->mount_point);
+        buf_printf(b, "\",fstype=\"%s\"} %llu\n", m->fstype, m->size);
+    }
+    metric_family(b, "mishell_filesystem_avail_bytes", "gauge", "Ruang tersedia untuk user biasa.");
+    for (int i = 0; i < st->mount_count; i++) {
+        const struct mount_entry* m = &st->mounts[i];
+        if (m->state != 1 || m->size == 0) continue;
+        buf_printf(b, "mishell_filesystem_avail_bytes{mountpoint=\"");
+        buf_escaped(b, m->mount_point);
+        buf_printf(b, "\",fstype=\"%s\"} %llu\n", m->fstype, m->avail);
+    }
+    metric_family(b, "mishell_filesystem_responsive", "gauge", "0 jika statvfs melewati batas waktu.");
+    for (int i = 0; i < st->mount_count; i++) {
+        buf_printf(b, "mishell_filesystem_responsive{mountpoint=\"");
+        buf_escaped(b, st->mounts[i].mount_point);
+        buf_printf(b, "\"} %d\n", st->mounts[i].state != 0);
+    }
+
+    metric_family(b, "mishell_snapshot_timestamp_seconds", "gauge", "Waktu snapshot diambil.");
+    buf_printf(b, "mishell_snapshot_timestamp_seconds %.3f\n", st->wall_time);
+    buf_printf(b, "# EOF\n");
+}
+
+// Fungsi untuk merender snapshot dalam format JSON
+void render_metrics_json(const struct metrics_state* st, struct text_buffer* b) {
+    const struct cpu_sample* cpu = &st->cpu[st->cur];
+    const struct cpu_sample* cpu_prev = &st->cpu[1 - st->cur];
+    const struct disk_sample* disk = &st->disk[st->cur];
+    const struct disk_sample* disk_prev = &st->disk[1 - st->cur];
+    struct cpu_usage usage;
+
+    b->len = 0;
+    buf_printf(b, "{\"timestamp\":%.3f,\"cpu\":{", st->wall_time);
+    if (st->samples > 1) {
+        compute_cpu_usage(&cpu_prev->total, &cpu->total, &usage);
+        buf_printf(b, "\"busy_percent\":%.2f,\"user_percent\":%.2f,\"system_percent\":%.2f,"
+                   "\"iowait_percent\":%.2f,\"steal_percent\":%.2f,",
+                   usage.busy, usage.user, usage.system, usage.iowait, usage.steal);
+    }
+    buf_printf(b, "\"cores\":[");
+    for (int i = 0; i < cpu->num_cores; i++) {
+        buf_printf(b, "%s{\"cpu\":%d", i ? "," : "", i);
+        if (st->samples > 1 && i < cpu_prev->num_cores) {
+            compute_cpu_usage(&cpu_prev->cores[i], &cpu->cores[i], &usage);
+            buf_printf(b, ",\"busy_percent\":%.2f", usage.busy);
+        }
+        buf_printf(b, "}");
+    }
+    buf_printf(b, "]},");
+
+    const struct mem_info* mem = &st->mem;
+    unsigned long long used = mem->total > mem->available ? mem->total - mem->available : 0;
+    buf_printf(b, "\"memory\":{\"total_bytes\":%llu,\"used_bytes\":%llu,\"available_bytes\":%llu,"
+               "\"free_bytes\":%llu,\"buffers_bytes\":%llu,\"cached_bytes\":%llu,\"shmem_bytes\":%llu,"
+               "\"slab_bytes\":%llu,\"swap_total_bytes\":%llu,\"swap_free_bytes\":%llu},",
+               mem->total * 1024, used * 1024, mem->available * 1024, mem->free * 1024, mem->buffers * 1024,
+               mem->cached * 1024, mem->shmem * 1024, mem->slab * 1024, mem->swap_total * 1024, mem->swap_free * 1024);
+    buf_printf(b, "\"load\":[%.2f,%.2f,%.2f],", st->load[0], st->load[1], st->load[2]);
+
+    buf_printf(b, "\"disks\":[");
+    for (int i = 0; i < disk->count; i++) {
+        const struct disk_stat* d = &disk->disks[i];
+        buf_printf(b, "%s{\"device\":\"%s\",\"read_bytes_total\":%llu,\"written_bytes_total\":%llu",
+                   i ? "," : "", d->name, d->sectors_read * 512, d->sectors_written * 512);
+        struct disk_rate rate;
+        if (st->samples > 1 && compute_disk_rate(disk_prev, disk, d, &rate) == 0) {
+            buf_printf(b, ",\"read_kbs\":%.1f,\"write_kbs\":%.1f,\"read_iops\":%.1f,\"write_iops\":%.1f,"
+                       "\"util_percent\":%.1f", rate.read_kbs, rate.write_kbs, rate.read_iops, rate.write_iops, rate.util);
+        }
+        buf_printf(b, "}");
+    }
+    buf_printf(b, "],");
+
+    buf_printf(b, "\"filesystems\":[");
+    for (int i = 0, first = 1; i < st->mount_count; i++) {
+        const struct mount_entry* m = &st->mounts[i];
+        if (m->state == 1 && m->size == 0) continue;
+        buf_printf(b, "%s{\"mountpoint\":\"", first ? "" : ",");
+        buf_escaped(b, m->mount_point);
+        buf_printf(b, "\",\"fstype\":\"%s\",\"responsive\":%s", m->fstype, m->state != 0 ? "true" : "false");
+        if (m->state == 1) {
+            buf_printf(b, ",\"size_bytes\":%llu,\"used_bytes\":%llu,\"avail_bytes\":%llu", m->size, m->used, m->avail);
+        }
+        buf_printf(b, "}");
+        first = 0;
+    }
+    buf_printf(b, "]}\n");
+}
+
+// Fungsi untuk membaca opsi --format=openmetrics|json (atau "--format json")
+static int parse_metrics_format(char** args) {
+    for (int i = 0; args[i] != NULL; i++) {
+        const char* value = NULL;
+        if (strncmp(args[i], "--format=", 9) == 0) value = args[i] + 9;
+        else if (strcmp(args[i], "--format") == 0 && args[i + 1] != NULL) value = args[i + 1];
+
+        if (value != NULL) return strcmp(value, "json") == 0 ? METRICS_FORMAT_JSON : METRICS_FORMAT_OPENMETRICS;
+    }
+    return METRICS_FORMAT_OPENMETRICS;
+}
+
+// Fungsi untuk mencetak metrik sekali ke stdout (cek export)
+void export_metrics(char** args) {
+    static struct metrics_state st;
+    struct text_buffer b = { NULL, 0, 0 };
+
+    st.samples = 0;
+    collect_metrics(&st);
+    sleep_ms(parse_interval_arg(args, CPU_SAMPLE_DEFAULT_MS));
+    collect_metrics(&st);
+
+    if (parse_metrics_format(args) == METRICS_FORMAT_JSON) {
+        render_metrics_json(&st, &b);
+    } else {
+        render_openmetrics(&st, &b);
+    }
+    if (b.data != NULL) {
+        fwrite(b.data, 1, b.len, stdout);
+        fflush(stdout);
+    }
+    free(b.data);
+}
+
+// Snapshot metrik yang sudah dirender; dilepas setelah scrape terakhir yang memakainya selesai
+struct metrics_snapshot {
+    int refs;
+    struct text_buffer openmetrics;
+    struct text_buffer json;
+};
+
+static pthread_mutex_t metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct metrics_snapshot* metrics_current = NULL;
+static int metrics_refresh_ms = METRICS_REFRESH_DEFAULT_MS;
+
+// Fungsi untuk melepas referensi snapshot
+static void release_metrics_snapshot(struct metrics_snapshot* s) {
+    pthread_mutex_lock(&metrics_lock);
+    int last = --s->refs == 0;
+    pthread_mutex_unlock(&metrics_lock);
+
+    if (last) {
+        free(s->openmetrics.data);
+        free(s->json.data);
+        free(s);
+    }
+}
+
+// Thread penyegar: mengambil sampel dan merender snapshot baru secara berkala
+static void* metrics_refresher(void* arg) {
+    static struct metrics_state st;
+    (void)arg;
+
+    collect_metrics(&st);
+    sleep_ms(CPU_SAMPLE_DEFAULT_MS);
+
+    for (;;) {
+        collect_metrics(&st);
+
+        struct metrics_snapshot* s = calloc(1, sizeof(*s));
+        if (s != NULL) {
+            s->refs = 1;
+            render_openmetrics(&st, &s->openmetrics);
+            render_metrics_json(&st, &s->json);
+
+            pthread_mutex_lock(&metrics_lock);
+            struct metrics_snapshot* old = metrics_current;
+            metrics_current = s;
+            pthread_mutex_unlock(&metrics_lock);
+            if (old != NULL) release_metrics_snapshot(old);
+        }
+        sleep_ms(metrics_refresh_ms);
+    }
+    return NULL;
+}
+
+// Fungsi untuk mengirim seluruh buffer ke socket
+static void send_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return;
+        }
+        data += n;
+        len -= n;
+    }
+}
+
+// Fungsi untuk menjawab satu scrape dari snapshot terbaru
+static void serve_metrics_request(int fd, const char* request) {
+    char header[256];
+    int json = strncmp(request, "GET /metrics.json", 17) == 0 || strncmp(request, "GET /json", 9) == 0 ||
+               strstr(request, "format=json") != NULL;
+    int metrics = json || strncmp(request, "GET /metrics", 12) == 0 || strncmp(request, "GET / ", 6) == 0;
+
+    if (!metrics) {
+        const char* not_found = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        send_all(fd, not_found, strlen(not_found));
+        return;
+    }
+
+    pthread_mutex_lock(&metrics_lock);
+    struct metrics_snapshot* s = metrics_current;
+    if (s != NULL) s->refs++;
+    pthread_mutex_unlock(&metrics_lock);
+
+    if (s == NULL) {
+        const char* warming = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nRetry-After: 1\r\nConnection: close\r\n\r\n";
+        send_all(fd, warming, strlen(warming));
+        return;
+    }
+
+    const struct text_buffer* body = json ? &s->json : &s->openmetrics;
+    int n = snprintf(header, sizeof(header),
+                     "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                     json ? "application/json" : "application/openmetrics-text; version=1.0.0; charset=utf-8",
+                     body->len);
+    send_all(fd, header, n);
+    send_all(fd, body->data, body->len);
+    release_metrics_snapshot(s);
+}
+
+// Satu koneksi scrape yang sedang membaca header permintaan
+struct metrics_client {
+    int fd;
+    size_t len;
+    double start_ms;
+    char request[1024];
+};
+
+// Fungsi loop server metrik: satu thread poll untuk semua koneksi, snapshot disegarkan thread lain
+void run_metrics_server(int listen_fd) {
+    static struct metrics_client clients[METRICS_MAX_CLIENTS];
+    struct pollfd fds[METRICS_MAX_CLIENTS + 1];
+    int num_clients = 0;
+
+    pthread_t refresher;
+    if (pthread_create(&refresher, NULL, metrics_refresher, NULL) != 0) {
+        perror("pthread_create");
+        return;
+    }
+
+    for (;;) {
+        fds[0].fd = num_clients < METRICS_MAX_CLIENTS ? listen_fd : -1;
+        fds[0].events = POLLIN;
+        for (int i = 0; i < num_clients; i++) {
+            fds[i + 1].fd = clients[i].fd;
+            fds[i + 1].events = POLLIN;
+        }
+
+        if (poll(fds, num_clients + 1, 1000) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        double now = now_ms();
+        for (int i = num_clients - 1; i >= 0; i--) {
+            struct metrics_client* c = &clients[i];
+            int done = 0;
+
+            if (fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)) {
+                ssize_t n = recv(c->fd, c->request + c->len, sizeof(c->request) - 1 - c->len, 0);
+                if (n <= 0) {
+                    done = 1;
+                } else {
+                    c->len += n;
+                    c->request[c->len] = '\0';
+                    if (strstr(c->request, "\r\n\r\n") != NULL || c->len == sizeof(c->request) - 1) {
+                        serve_metrics_request(c->fd, c->request);
+                        done = 1;
+                    }
+                }
+            } else if (now - c->start_ms > METRICS_CLIENT_TIMEOUT_MS) {
+                done = 1;
+            }
+
+            if (done) {
+                close(c->fd);
+                clients[i] = clients[--num_clients];
+            }
+        }
+
+        if (fds[0].fd >= 0 && (fds[0].revents & POLLIN)) {
+            int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+            if (fd >= 0) {
+                clients[num_clients].fd = fd;
+                clients[num_clients].len = 0;
+                clients[num_clients].start_ms = now;
+                num_clients++;
+            }
+        }
+    }
+}
+
+// Fungsi untuk membuat listener Unix socket
+int open_unix_listener(const char* path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        printf("Path socket terlalu panjang: %s\n", path);
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    unlink(path);
+
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 128) != 0) {
+        perror("bind/listen");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+pid_t metrics_server_pid = 0;
+pid_t metrics_server_owner = 0;     // Proses shell yang menjalankan server
+char metrics_server_addr[256] = "";
+
+// Fungsi untuk menghentikan server metrik yang berjalan di latar belakang. Proses anak hasil fork
+// (mis. "q" di dalam $(...)) mewarisi handler atexit ini, jadi hanya pemiliknya yang boleh menghentikan.
+void stop_metrics_server() {
+    if (metrics_server_pid > 0 && getpid() == metrics_server_owner) {
+        kill(metrics_server_pid, SIGTERM);
+        waitpid(metrics_server_pid, NULL, 0);
+        metrics_server_pid = 0;
+        if (strncmp(metrics_server_addr, "unix:", 5) == 0) unlink(metrics_server_addr + 5);
+        metrics_server_addr[0] = '\0';
+    }
+}
+
+// Fungsi untuk menjalankan "cek serve": server metrik di proses latar belakang
+void start_metrics_server(char** args) {
+    if (args[0] != NULL && strcmp(args[0], "stop") == 0) {
+        if (metrics_server_pid == 0) {
+            printf("Server metrik tidak berjalan.\n");
+            return;
+        }
+        stop_metrics_server();
+        printf("Server metrik dihentikan.\n");
+        return;
+    }
+    if (metrics_server_pid > 0) {
+        printf("Server metrik sudah berjalan di %s (pid %d). Gunakan 'cek serve stop' terlebih dahulu.\n",
+               metrics_server_addr, metrics_server_pid);
+        return;
+    }
+
+    int port = METRICS_DEFAULT_PORT;
+    const char* unix_path = NULL;
+    for (int i = 0; args[i] != NULL; i++) {
+        if (strcmp(args[i], "--port") == 0 && args[i + 1] != NULL) {
+            port = atoi(args[++i]);
+        } else if (strcmp(args[i], "--unix") == 0 && args[i + 1] != NULL) {
+            unix_path = args[++i];
+        } else if (strcmp(args[i], "--refresh") == 0 && args[i + 1] != NULL) {
+            int ms = atoi(args[++i]);
+            metrics_refresh_ms = ms >= 100 ? ms : METRICS_REFRESH_DEFAULT_MS;
+        }
+    }
+
+    int listen_fd = unix_path != NULL ? open_unix_listener(unix_path) : open_loopback_listener(port);
+    if (listen_fd < 0) return;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        run_metrics_server(listen_fd);
+        _exit(0);
+    } else if (pid < 0) {
+        perror("fork");
+        close(listen_fd);
+        return;
+    }
+
+    close(listen_fd);
+    metrics_server_pid = pid;
+    metrics_server_owner = getpid();
+    static int stop_registered = 0;
+    if (!stop_registered) {
+        atexit(stop_metrics_server);
+        stop_registered = 1;
+    }
+
+    if (unix_path != NULL) {
+        snprintf(metrics_server_addr, sizeof(metrics_server_addr), "unix:%s", unix_path);
+    } else {
+        snprintf(metrics_server_addr, sizeof(metrics_server_addr), "http://127.0.0.1:%d/metrics", port);
+    }
+    printf("Server metrik berjalan di %s (pid %d, snapshot tiap %d ms)\n",
+           metrics_server_addr, pid, metrics_refresh_ms);
+}
+
+// Buffer nol bersama untuk data yang dikirim server dan klien uji kecepatan
+static char speed_zeros[SPEED_CHUNK];
+
+// Fungsi untuk mengirim n byte nol ke socket; mengembalikan -1 jika koneksi putus
+static int speed_send_zeros(int fd, unsigned long long n) {
+    while (n > 0) {
+        size_t chunk = n < sizeof(speed_zeros) ? (size_t)n : sizeof(speed_zeros);
+        ssize_t sent = send(fd, speed_zeros, chunk, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            if (sent < 0 && errno == EINTR) continue;
+            return -1;
+        }
+        n -= sent;
+    }
+    return 0;
+}
+
+// Fungsi untuk melayani satu koneksi keep-alive server uji kecepatan
+static void* speed_connection(void* arg) {
+    int fd = (int)(intptr_t)arg;
+    char req[SPEED_HEADER_MAX + 1];
+    char sink[SPEED_CHUNK];
+    size_t len = 0;
+
+    struct timeval tv = { SPEED_IDLE_TIMEOUT_S, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    for (;;) {
+        // Baca header permintaan berikutnya
+        char* end;
+        req[len] = '\0';
+        while ((end = strstr(req, "\r\n\r\n")) == NULL) {
+            if (len == SPEED_HEADER_MAX) goto out;
+            ssize_t n = recv(fd, req + len, SPEED_HEADER_MAX - len, 0);
+            if (n <= 0) goto out;
+            len += n;
+            req[len] = '\0';
+        }
+        size_t header_len = end + 4 - req;
+        end[2] = '\0';
+
+        const char* response = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+        unsigned long long body_left = 0;
+
+        if (strncmp(req, "POST ", 5) == 0) {
+            // Upload: buang body sebanyak Content-Length lalu jawab 200
+            char* cl = strcasestr(req, "\r\nContent-Length:");
+            if (cl != NULL) body_left = strtoull(cl + 17, NULL, 10);
+            if (strcasestr(req, "\r\nExpect: 100-continue") != NULL) {
+                const char* cont = "HTTP/1.1 100 Continue\r\n\r\n";
+                send_all(fd, cont, strlen(cont));
+            }
+            size_t extra = len - header_len;
+            size_t used = extra < body_left ? extra : (size_t)body_left;
+            body_left -= used;
+            memmove(req, req + header_len + used, extra - used);
+            len = extra - used;
+            while (body_left > 0) {
+                ssize_t n = recv(fd, sink, body_left < sizeof(sink) ? (size_t)body_left : sizeof(sink), 0);
+                if (n <= 0) goto out;
+                body_left -= n;
+            }
+            send_all(fd, response, strlen(response));
+            continue;
+        }
+
+        int head = strncmp(req, "HEAD ", 5) == 0;
+        unsigned long long bytes = 0;
+        if (strncmp(req, "GET /down", 9) == 0 || strncmp(req, "HEAD /down", 10) == 0) {
+            char* q = strstr(req, "bytes=");
+            bytes = q != NULL ? strtoull(q + 6, NULL, 10) : SPEED_TRANSFER_BYTES;
+            if (bytes > SPEED_MAX_DOWN_BYTES) bytes = SPEED_MAX_DOWN_BYTES;
+        } else if (strncmp(req, "GET /ping", 9) != 0 && strncmp(req, "HEAD ", 5) != 0) {
+            response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+        }
+
+        len -= header_len;
+        memmove(req, req + header_len, len);
+
+        if (bytes > 0) {
+            char header[128];
+            int n = snprintf(header, sizeof(header),
+                             "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: %llu\r\n\r\n",
+                             bytes);
+            send_all(fd, header, n);
+            if (!head && speed_send_zeros(fd, bytes) != 0) goto out;
+        } else {
+            send_all(fd, response, strlen(response));
+        }
+    }
+
+out:
+    close(fd);
+    return NULL;
+}
+
+// Fungsi loop server uji kecepatan: satu thread per koneksi agar aliran paralel memakai banyak core
+void run_speed_server(int listen_fd) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    for (;;) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            perror("accept");
+            break;
+        }
+        pthread_t thread;
+        if (pthread_create(&thread, &attr, speed_connection, (void*)(intptr_t)fd) != 0) {
+            close(fd);
+        }
+    }
+    pthread_attr_destroy(&attr);
+}
+
+// Fungsi untuk menjalankan server uji kecepatan di proses anak
+static pid_t fork_speed_server(int listen_fd) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        run_speed_server(listen_fd);
+        _exit(0);
+    } else if (pid < 0) {
+        perror("fork");
+    }
+    close(listen_fd);
+    return pid;
+}
+
+pid_t speed_server_pid = 0;
+pid_t speed_server_owner = 0;       // Proses shell yang menjalankan server
+char speed_server_addr[128] = "";
+
+// Fungsi untuk menghentikan server uji kecepatan yang berjalan di latar belakang (hanya dari proses pemiliknya)
+void stop_speed_server() {
+    if (speed_server_pid > 0 && getpid() == speed_server_owner) {
+        kill(speed_server_pid, SIGTERM);
+        waitpid(speed_server_pid, NULL, 0);
+        speed_server_pid = 0;
+        speed_server_addr[0] = '\0';
+    }
+}
+
+// Fungsi untuk menjalankan "test speed serve": server uji kecepatan di latar belakang
+void start_speed_server(char** args) {
+    if (args[0] != NULL && strcmp(args[0], "stop") == 0) {
+        if (speed_server_pid == 0) {
+            printf("Server uji kecepatan tidak berjalan.\n");
+            return;
+        }
+        stop_speed_server();
+        printf("Server uji kecepatan dihentikan.\n");
+        return;
+    }
+    if (speed_server_pid > 0) {
+        printf("Server uji kecepatan sudah berjalan di %s (pid %d). Gunakan 'test speed serve stop' terlebih dahulu.\n",
+               speed_server_addr, speed_server_pid);
+        return;
+    }
+
+    int port = SPEED_DEFAULT_PORT;
+    const char* bind_addr = "127.0.0.1";
+    for (int i = 0; args[i] != NULL; i++) {
+        if (strcmp(args[i], "--port") == 0 && args[i + 1] != NULL) {
+            port = atoi(args[++i]);
+        } else if (strcmp(args[i], "--bind") == 0 && args[i + 1] != NULL) {
+            bind_addr = args[++i];
+        }
+    }
+
+    int listen_fd = open_tcp_listener(bind_addr, port);
+    if (listen_fd < 0) return;
+
+    pid_t pid = fork_speed_server(listen_fd);
+    if (pid < 0) return;
+    speed_server_pid = pid;
+    speed_server_owner = getpid();
+    static int stop_registered = 0;
+    if (!stop_registered) {
+        atexit(stop_speed_server);
+        stop_registered = 1;
+    }
+
+    snprintf(speed_server_addr, sizeof(speed_server_addr), "%s:%d", bind_addr, port);
+    printf("Server uji kecepatan berjalan di %s (pid %d)\n", speed_server_addr, pid);
+    printf("Dari mesin lain: test speed --server <alamat-host>:%d\n", port);
+}
+
+// Satu aliran transfer paralel "test speed"
+struct speed_stream {
+    CURL *curl;
+    unsigned long long *counter;
+    curl_off_t upload_left;
+};
+
+// Fungsi callback download: data hanya dihitung, tidak disimpan
+static size_t speed_write_cb(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    (void)ptr;
+    struct speed_stream* s = userdata;
+    *s->counter += size * nmemb;
+    return size * nmemb;
+}
+
+// Fungsi callback upload: mengisi buffer kirim dengan nol
+static size_t speed_read_cb(char* buffer, size_t size, size_t nmemb, void* userdata) {
+    struct speed_stream* s = userdata;
+    size_t n = size * nmemb;
+    if ((curl_off_t)n > s->upload_left) n = (size_t)s->upload_left;
+    if (n > sizeof(speed_zeros)) n = sizeof(speed_zeros);
+    memcpy(buffer, speed_zeros, n);
+    s->upload_left -= n;
+    *s->counter += n;
+    return n;
+}
+
+// Fungsi callback untuk membuang body jawaban yang tidak dibutuhkan
+static size_t speed_discard_cb(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    (void)ptr;
+    (void)userdata;
+    return size * nmemb;
+}
+
+// Fungsi untuk menyiapkan satu handle transfer uji kecepatan
+static int speed_stream_init(struct speed_stream* s, const char* url, int upload,
+                             unsigned long long* counter, struct curl_slist* headers) {
+    s->counter = counter;
+    s->upload_left = SPEED_TRANSFER_BYTES;
+    s->curl = curl_easy_init();
+    if (s->curl == NULL) return -1;
+
+    curl_easy_setopt(s->curl, CURLOPT_URL, url);
+    curl_easy_setopt(s->curl, CURLOPT_USERAGENT, "mishell-EDU");
+    curl_easy_setopt(s->curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(s->curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(s->curl, CURLOPT_CONNECTTIMEOUT_MS, 5000L);
+    curl_easy_setopt(s->curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(s->curl, CURLOPT_PRIVATE, s);
+    // Buffer besar agar klien tidak menjadi hambatan saat mengukur loopback
+    curl_easy_setopt(s->curl, CURLOPT_BUFFERSIZE, (long)CURL_MAX_READ_SIZE);
+
+    if (upload) {
+        curl_easy_setopt(s->curl, CURLOPT_POST, 1L);
+        curl_easy_setopt(s->curl, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)SPEED_TRANSFER_BYTES);
+        curl_easy_setopt(s->curl, CURLOPT_READFUNCTION, speed_read_cb);
+        curl_easy_setopt(s->curl, CURLOPT_READDATA, s);
+        curl_easy_setopt(s->curl, CURLOPT_UPLOAD_BUFFERSIZE, 2L * 1024 * 1024);
+        curl_easy_setopt(s->curl, CURLOPT_WRITEFUNCTION, speed_discard_cb);
+    } else {
+        curl_easy_setopt(s->curl, CURLOPT_WRITEFUNCTION, speed_write_cb);
+        curl_easy_setopt(s->curl, CURLOPT_WRITEDATA, s);
+    }
+    return 0;
+}
+
+// Fungsi untuk memformat laju bit/detik, mis. "942.10 Mbit/s (117.76 MB/s)"
+static void format_rate(double bits, char* out, size_t size) {
+    if (bits >= 1e9) {
+        snprintf(out, size, "%.2f Gbit/s (%.1f MB/s)", bits / 1e9, bits / 8e6);
+    } else if (bits >= 1e6) {
+        snprintf(out, size, "%.2f Mbit/s (%.2f MB/s)", bits / 1e6, bits / 8e6);
+    } else {
+        snprintf(out, size, "%.1f kbit/s (%.1f kB/s)", bits / 1e3, bits / 8e3);
+    }
+}
+
+// Fungsi untuk menjalankan satu arah uji (download/upload) dengan N aliran paralel di curl multi.
+// Mengembalikan laju rata-rata dalam bit/detik setelah masa pemanasan, atau -1 jika gagal.
+static double speed_phase(const char* label, const char* url, int upload, int streams, int seconds) {
+    struct speed_stream s[SPEED_MAX_STREAMS];
+    unsigned long long counter = 0;
+    CURLM *multi = curl_multi_init();
+    if (multi == NULL) return -1;
+
+    // Satu koneksi TCP per aliran, bukan multiplexing HTTP/2 dalam satu koneksi
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, (long)CURLPIPE_NOTHING);
+    struct curl_slist *headers = curl_slist_append(NULL, "Expect:");
+
+    int active = 0;
+    for (int i = 0; i < streams; i++) {
+        if (speed_stream_init(&s[active], url, upload, &counter, headers) != 0) break;
+        curl_multi_add_handle(multi, s[active].curl);
+        active++;
+    }
+
+    double start = now_ms();
+    double deadline = start + seconds * 1000.0;
+    double warmup_at = start + seconds * 1000.0 * SPEED_WARMUP_PERCENT / 100.0;
+    double warm_ms = start, last_tick = start;
+    unsigned long long warm_bytes = 0, last_bytes = 0;
+    int warm = 0, completed = 0, failed = 0;
+    CURLcode last_error = CURLE_OK;
+    long last_http = 0;
+    int live = isatty(STDOUT_FILENO);
+
+    for (;;) {
+        int running, queued;
+        CURLMsg *msg;
+        curl_multi_perform(multi, &running);
+
+        while ((msg = curl_multi_info_read(multi, &queued)) != NULL) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            struct speed_stream* st;
+            long code = 0;
+            CURLcode result = msg->data.result;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&st);
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &code);
+            curl_multi_remove_handle(multi, st->curl);
+
+            if (result != CURLE_OK || code >= 400) {
+                failed++;
+                last_error = result;
+                last_http = code;
+            } else {
+                completed++;
+            }
+            // Transfer selesai sebelum waktunya: ulangi di koneksi yang sama
+            if (failed <= active * 2) {
+                st->upload_left = SPEED_TRANSFER_BYTES;
+                curl_multi_add_handle(multi, st->curl);
+            }
+        }
+
+        double now = now_ms();
+        if (!warm && now >= warmup_at) {
+            warm = 1;
+            warm_ms = now;
+            warm_bytes = counter;
+        }
+        if (live && now - last_tick >= 250) {
+            char rate[64];
+            format_rate((counter - last_bytes) * 8.0 / ((now - last_tick) / 1000.0), rate, sizeof(rate));
+            printf("\r%-10s: %s\033[K", label, rate);
+            fflush(stdout);
+            last_tick = now;
+            last_bytes = counter;
+        }
+        if (now >= deadline || failed > active * 2) break;
+        curl_multi_poll(multi, NULL, 0, 50, NULL);
+    }
+    double end = now_ms();
+    if (live) printf("\r\033[K");
+
+    for (int i = 0; i < active; i++) {
+        curl_multi_remove_handle(multi, s[i].curl);
+        curl_easy_cleanup(s[i].curl);
+    }
+    curl_slist_free_all(headers);
+    curl_multi_cleanup(multi);
+
+    if (counter == 0 || (completed == 0 && failed > active * 2)) {
+        if (last_error != CURLE_OK) {
+            printf("%-10s: gagal (%s)\n", label, curl_easy_strerror(last_error));
+        } else {
+            printf("%-10s: gagal (HTTP %ld)\n", label, last_http);
+        }
+        return -1;
+    }
+
+    // Transfer yang terlalu singkat tidak punya masa pemanasan yang berarti
+    if (!warm || end - warm_ms < 100) {
+        warm_ms = start;
+        warm_bytes = 0;
+    }
+    double bits = (counter - warm_bytes) * 8.0 / ((end - warm_ms) / 1000.0);
+
+    char rate[64];
+    format_rate(bits, rate, sizeof(rate));
+    printf("%-10s: \033[1;32m%s\033[0m", label, rate);
+    if (failed > 0) printf(" (%d transfer gagal)", failed);
+    printf("\n");
+    return bits;
+}
+
+// Fungsi untuk mengukur sebaran RTT permintaan kecil di satu koneksi yang dipakai ulang
+static void speed_ping(const char* url, int head, int count) {
+    CURL *curl = curl_easy_init();
+    double* rtt = malloc(sizeof(double) * (count + 1));
+    if (curl == NULL || rtt == NULL) {
+        if (curl != NULL) curl_easy_cleanup(curl);
+        free(rtt);
+        return;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "mishell-EDU");
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, 5000L);
+    curl_easy_setopt(curl, CURLOPT_NOBODY, head ? 1L : 0L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, speed_discard_cb);
+
+    // Permintaan pertama membuka koneksi; waktunya dilaporkan terpisah dan tidak dihitung sebagai RTT
+    CURLcode result = curl_easy_perform(curl);
+    if (result != CURLE_OK) {
+        printf("Latensi   : gagal (%s)\n", curl_easy_strerror(result));
+        count = 0;
+    } else {
+        curl_off_t lookup, connect, tls;
+        curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &lookup);
+        curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+        curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &tls);
+        printf("Koneksi   : DNS %.2f ms, TCP %.2f ms", lookup / 1000.0, (connect - lookup) / 1000.0);
+        if (tls > 0) printf(", TLS %.2f ms", (tls - connect) / 1000.0);
+        printf("\n");
+    }
+
+    int ok = 0;
+    double jitter = 0;
+    for (int i = 0; i < count; i++) {
+        // Di koneksi yang dipakai ulang, satu permintaan kecil = satu RTT ditambah waktu server
+        double start = now_ms();
+        result = curl_easy_perform(curl);
+        if (result != CURLE_OK) {
+            printf("Latensi   : gagal (%s)\n", curl_easy_strerror(result));
+            break;
+        }
+        rtt[ok] = now_ms() - start;
+        if (ok > 0) jitter += rtt[ok] > rtt[ok - 1] ? rtt[ok] - rtt[ok - 1] : rtt[ok - 1] - rtt[ok];
+        ok++;
+    }
+    curl_easy_cleanup(curl);
+
+    if (ok > 0) {
+        double total = 0;
+        for (int i = 0; i < ok; i++) total += rtt[i];
+        qsort(rtt, ok, sizeof(double), compare_doubles);
+        printf("Latensi   : min %.3f  rata-rata %.3f  p50 %.3f  p90 %.3f  maks %.3f ms (%d sampel)\n",
+               rtt[0], total / ok, rtt[ok / 2], rtt[(ok * 9) / 10 < ok ? (ok * 9) / 10 : ok - 1], rtt[ok - 1], ok);
+        if (ok > 1) printf("Jitter    : %.3f ms\n", jitter / (ok - 1));
+    }
+    free(rtt);
+}
+
+// Fungsi untuk menjalankan "test speed": uji throughput dan latensi tanpa alat eksternal
+void test_speed(char** args) {
+    char down_url[512] = SPEED_DEFAULT_DOWN_URL;
+    char up_url[512] = SPEED_DEFAULT_UP_URL;
+    char ping_url[512] = SPEED_DEFAULT_PING_URL;
+    char target[512] = "speed.cloudflare.com";
+    int ping_head = 0;
+    int streams = SPEED_DEFAULT_STREAMS;
+    int seconds = SPEED_DEFAULT_SECONDS;
+    int pings = SPEED_DEFAULT_PINGS;
+    int download = 1, upload = 1;
+    const char* server = NULL;
+    int local = 0;
+
+    for (int i = 0; args[i] != NULL; i++) {
+        if (strcmp(args[i], "local") == 0) {
+            local = 1;
+        } else if (strcmp(args[i], "-n") == 0 && args[i + 1] != NULL) {
+            streams = atoi(args[++i]);
+        } else if (strcmp(args[i], "-t") == 0 && args[i + 1] != NULL) {
+            seconds = atoi(args[++i]);
+        } else if (strcmp(args[i], "--ping") == 0 && args[i + 1] != NULL) {
+            pings = atoi(args[++i]);
+        } else if (strcmp(args[i], "--server") == 0 && args[i + 1] != NULL) {
+            server = args[++i];
+        } else if (strcmp(args[i], "--up") == 0 && args[i + 1] != NULL) {
+            snprintf(up_url, sizeof(up_url), "%s", args[++i]);
+        } else if (strcmp(args[i], "--no-upload") == 0) {
+            upload = 0;
+        } else if (strcmp(args[i], "--no-download") == 0) {
+            download = 0;
+        } else if (strstr(args[i], "://") != NULL) {
+            // URL sendiri: download dari URL ini, upload hanya jika --up diberikan
+            snprintf(down_url, sizeof(down_url), "%s", args[i]);
+            snprintf(ping_url, sizeof(ping_url), "%s", args[i]);
+            snprintf(target, sizeof(target), "%s", args[i]);
+            ping_head = 1;
+            if (strcmp(up_url, SPEED_DEFAULT_UP_URL) == 0) up_url[0] = '\0';
+        } else {
+            printf("Penggunaan: test speed [local | --server host[:port] | URL] [-n aliran] [-t detik] [--ping N] [--up URL] [--no-upload] [--no-download]\n");
+            printf("            test speed serve [--port P] [--bind alamat] | serve stop\n");
+            return;
+        }
+    }
+    if (streams < 1) streams = 1;
+    if (streams > SPEED_MAX_STREAMS) streams = SPEED_MAX_STREAMS;
+    if (seconds < 1) seconds = SPEED_DEFAULT_SECONDS;
+    if (pings < 0) pings = 0;
+
+    // Mode lokal: server bawaan di port acak, cocok untuk mengukur kapasitas loopback tanpa internet
+    pid_t local_pid = 0;
+    if (local) {
+        int listen_fd = open_tcp_listener("127.0.0.1", 0);
+        if (listen_fd < 0) return;
+        struct sockaddr_in addr;
+        socklen_t addr_len = sizeof(addr);
+        getsockname(listen_fd, (struct sockaddr*)&addr, &addr_len);
+        local_pid = fork_speed_server(listen_fd);
+        if (local_pid < 0) return;
+        snprintf(target, sizeof(target), "127.0.0.1:%d", ntohs(addr.sin_port));
+        server = target;
+    }
+
+    if (server != NULL) {
+        const char* port = strchr(server, ':') != NULL ? "" : ":" SPEED_DEFAULT_PORT_STR;
+        // URL yang terpotong akan menguji alamat lain, jadi alamat server yang terlalu panjang ditolak
+        if ((size_t)snprintf(down_url, sizeof(down_url), "http://%s%s/down?bytes=%d",
+                             server, port, SPEED_TRANSFER_BYTES) >= sizeof(down_url) ||
+            (size_t)snprintf(up_url, sizeof(up_url), "http://%s%s/up", server, port) >= sizeof(up_url) ||
+            (size_t)snprintf(ping_url, sizeof(ping_url), "http://%s%s/ping", server, port) >= sizeof(ping_url) ||
+            (target != server && (size_t)snprintf(target, sizeof(target), "%s%s", server, port) >= sizeof(target))) {
+            printf("test speed: alamat server terlalu panjang\n");
+            if (local_pid > 0) {
+                kill(local_pid, SIGTERM);
+                waitpid(local_pid, NULL, 0);
+            }
+            return;
+        }
+        ping_head = 0;
+    }
+
+    printf("\033[1;36m=================== UJI KECEPATAN ===================\033[0m\n");
+    printf("Target    : %s%s\n", target, local ? " (server lokal)" : "");
+    printf("Aliran    : %d paralel, %d detik per arah\n", streams, seconds);
+    fflush(stdout);
+
+    if (pings > 0) speed_ping(ping_url, ping_head, pings);
+    if (download) speed_phase("Download", down_url, 0, streams, seconds);
+    if (upload && up_url[0] != '\0') speed_phase("Upload", up_url, 1, streams, seconds);
+    printf("\033[1;36m=====================================================\033[0m\n");
+
+    if (local_pid > 0) {
+        kill(local_pid, SIGTERM);
+        waitpid(local_pid, NULL, 0);
+    }
+}
+
+// Counter satu interface dari /proc/net/dev
+struct net_iface {
+    char name[32];
+    unsigned long long rx_bytes, rx_packets, rx_errs, rx_drop;
+    unsigned long long tx_bytes, tx_packets, tx_errs, tx_drop;
+};
+
+// Nama state socket TCP sesuai kolom "st" di /proc/net/tcp (1..11)
+#define TCP_STATES 12
+static const char* tcp_state_names[TCP_STATES] = {
+    "?", "ESTABLISHED", "SYN_SENT", "SYN_RECV", "FIN_WAIT1", "FIN_WAIT2", "TIME_WAIT",
+    "CLOSE", "CLOSE_WAIT", "LAST_ACK", "LISTEN", "CLOSING"
+};
+#define TCP_STATE_LISTEN 10
+
+// Counter TCP kumulatif dari /proc/net/snmp (Tcp:) dan /proc/net/netstat (TcpExt:)
+enum {
+    NET_ACTIVE_OPENS, NET_PASSIVE_OPENS, NET_ATTEMPT_FAILS, NET_ESTAB_RESETS, NET_IN_SEGS,
+    NET_OUT_SEGS, NET_RETRANS_SEGS, NET_IN_ERRS, NET_OUT_RSTS, NET_LISTEN_OVERFLOWS,
+    NET_LISTEN_DROPS, NET_TCP_TIMEOUTS, NET_COUNTERS
+};
+static const struct { const char* table; const char* key; } net_counter_keys[NET_COUNTERS] = {
+    { "Tcp:", "ActiveOpens" }, { "Tcp:", "PassiveOpens" }, { "Tcp:", "AttemptFails" },
+    { "Tcp:", "EstabResets" }, { "Tcp:", "InSegs" }, { "Tcp:", "OutSegs" },
+    { "Tcp:", "RetransSegs" }, { "Tcp:", "InErrs" }, { "Tcp:", "OutRsts" },
+    { "TcpExt:", "ListenOverflows" }, { "TcpExt:", "ListenDrops" }, { "TcpExt:", "TCPTimeouts" },
+};
+
+// Satu sampel jaringan: counter interface, counter TCP, dan jumlah socket per state
+struct net_sample {
+    double time_ms;
+    int count;
+    struct net_iface ifaces[MAX_NET_IFACES];
+    unsigned long long counters[NET_COUNTERS];
+    int states[TCP_STATES];
+    int sockets;
+    int listen_backlogged;  // Socket LISTEN yang antrean accept-nya tidak kosong
+};
+
+struct proc_file proc_net_dev_file = { "/proc/net/dev", -1 };
+struct proc_file proc_net_snmp_file = { "/proc/net/snmp", -1 };
+struct proc_file proc_net_netstat_file = { "/proc/net/netstat", -1 };
+
+// Fungsi untuk mengambil satu nilai dari tabel berpasangan "Prefix: nama..." / "Prefix: nilai..."
+// (format /proc/net/snmp dan /proc/net/netstat)
+static int snmp_value(const char* buf, const char* table, const char* key, unsigned long long* value) {
+    size_t table_len = strlen(table), key_len = strlen(key);
+
+    for (const char* line = buf; line != NULL && *line != '\0'; ) {
+        const char* next = strchr(line, '\n');
+        if (strncmp(line, table, table_len) == 0 && next != NULL && strncmp(next + 1, table, table_len) == 0) {
+            // Telusuri baris nama dan baris nilai bersamaan
+            const char* names = line + table_len;
+            const char* values = next + 1 + table_len;
+            for (;;) {
+                while (*names == ' ') names++;
+                while (*values == ' ') values++;
+                if (*names == '\n' || *names == '\0' || *values == '\n' || *values == '\0') return -1;
+
+                const char* name_end = names;
+                while (*name_end != ' ' && *name_end != '\n' && *name_end != '\0') name_end++;
+                if ((size_t)(name_end - names) == key_len && strncmp(names, key, key_len) == 0) {
+                    *value = strtoull(values, NULL, 10);
+                    return 0;
+                }
+                names = name_end;
+                while (*values != ' ' && *values != '\n' && *values != '\0') values++;
+            }
+        }
+        line = next != NULL ? next + 1 : NULL;
+    }
+    return -1;
+}
+
+// Fungsi untuk menghitung socket per state dari /proc/net/tcp atau tcp6
+// File dibaca bertahap karena bisa berisi puluhan ribu baris
+static void count_tcp_sockets(const char* path, struct net_sample* s) {
+    static char buf[65536];
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+
+    size_t len = 0;
+    int header = 1;
+    for (;;) {
+        ssize_t n = read(fd, buf + len, sizeof(buf) - 1 - len);
+        if (n <= 0) break;
+        len += n;
+        buf[len] = '\0';
+
+        char* line = buf;
+        char* nl;
+        while ((nl = strchr(line, '\n')) != NULL) {
+            *nl = '\0';
+            unsigned int state, tx_queue, rx_queue;
+            if (header) {
+                header = 0;
+            } else if (sscanf(line, "%*s %*s %*s %x %x:%x", &state, &tx_queue, &rx_queue) == 3 &&
+                       state < TCP_STATES) {
+                s->states[state]++;
+                s->sockets++;
+                // Untuk socket LISTEN, rx_queue adalah jumlah koneksi yang menunggu accept()
+                if (state == TCP_STATE_LISTEN && rx_queue > 0) s->listen_backlogged++;
+            }
+            line = nl + 1;
+        }
+        len = buf + len - line;
+        memmove(buf, line, len);
+    }
+    close(fd);
+}
+
+// Fungsi untuk mengambil sampel jaringan tanpa fork: /proc/net/dev, snmp, netstat, tcp, tcp6
+int sample_net(struct net_sample* s) {
+    static char buf[65536];
+    memset(s, 0, sizeof(*s));
+    s->time_ms = now_ms();
+
+    if (read_proc_file(&proc_net_dev_file, buf, sizeof(buf)) <= 0) return -1;
+    char* line = strchr(buf, '\n');
+    if (line != NULL) line = strchr(line + 1, '\n');   // Lewati dua baris judul
+    while (line != NULL && *++line != '\0' && s->count < MAX_NET_IFACES) {
+        char* colon = strchr(line, ':');
+        char* nl = strchr(line, '\n');
+        if (colon == NULL || (nl != NULL && colon > nl)) break;
+
+        struct net_iface* iface = &s->ifaces[s->count];
+        char* name = line;
+        while (*name == ' ') name++;
+        size_t name_len = colon - name < (long)sizeof(iface->name) - 1 ? (size_t)(colon - name) : sizeof(iface->name) - 1;
+        memcpy(iface->name, name, name_len);
+        iface->name[name_len] = '\0';
+
+        unsigned long long v[16];
+        if (sscanf(colon + 1, "%llu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu",
+                   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7], &v[8], &v[9], &v[10],
+                   &v[11], &v[12], &v[13], &v[14], &v[15]) == 16) {
+            iface->rx_bytes = v[0];
+            iface->rx_packets = v[1];
+            iface->rx_errs = v[2];
+            iface->rx_drop = v[3];
+            iface->tx_bytes = v[8];
+            iface->tx_packets = v[9];
+            iface->tx_errs = v[10];
+            iface->tx_drop = v[11];
+            s->count++;
+        }
+        line = nl;
+    }
+
+    if (read_proc_file(&proc_net_snmp_file, buf, sizeof(buf)) > 0) {
+        for (int i = 0; i < NET_COUNTERS; i++) {
+            if (strcmp(net_counter_keys[i].table, "Tcp:") == 0) {
+                snmp_value(buf, "Tcp:", net_counter_keys[i].key, &s->counters[i]);
+            }
+        }
+    }
+    if (read_proc_file(&proc_net_netstat_file, buf, sizeof(buf)) > 0) {
+        for (int i = 0; i < NET_COUNTERS; i++) {
+            if (strcmp(net_counter_keys[i].table, "TcpExt:") == 0) {
+                snmp_value(buf, "TcpExt:", net_counter_keys[i].key, &s->counters[i]);
+            }
+        }
+    }
+
+    count_tcp_sockets("/proc/net/tcp", s);
+    count_tcp_sockets("/proc/net/tcp6", s);
+    return 0;
+}
+
+// Fungsi untuk menyusun laporan "cek net" dari dua sampel ke buffer teks
+static void render_net_report(struct text_buffer* b, const struct net_sample* before,
+                              const struct net_sample* after, int show_all) {
+    double seconds = (after->time_ms - before->time_ms) / 1000.0;
+    if (seconds <= 0) seconds = 1;
+
+    buf_printf(b, "\033[1;36m====================================== JARINGAN ======================================\033[0m\n");
+    buf_printf(b, "%-14s %10s %10s %9s %9s %6s %6s %9s %9s\n",
+               "Interface", "RX/s", "TX/s", "RX pkt/s", "TX pkt/s", "Drop", "Error", "Total RX", "Total TX");
+    buf_printf(b, "--------------------------------------------------------------------------------------\n");
+
+    int hidden = 0;
+    for (int i = 0; i < after->count; i++) {
+        const struct net_iface* cur = &after->ifaces[i];
+        const struct net_iface* prev = NULL;
+        for (int j = 0; j < before->count; j++) {
+            if (strcmp(before->ifaces[j].name, cur->name) == 0) {
+                prev = &before->ifaces[j];
+                break;
+            }
+        }
+        if (prev == NULL) continue;
+
+        // Interface yang belum pernah dipakai disembunyikan kecuali dengan -a
+        if (!show_all && cur->rx_packets == 0 && cur->tx_packets == 0) {
+            hidden++;
+            continue;
+        }
+
+        char rx[16], tx[16], rx_total[16], tx_total[16];
+        format_size((unsigned long long)(counter_delta(prev->rx_bytes, cur->rx_bytes) / seconds), rx, sizeof(rx));
+        format_size((unsigned long long)(counter_delta(prev->tx_bytes, cur->tx_bytes) / seconds), tx, sizeof(tx));
+        format_size(cur->rx_bytes, rx_total, sizeof(rx_total));
+        format_size(cur->tx_bytes, tx_total, sizeof(tx_total));
+        unsigned long long drops = counter_delta(prev->rx_drop, cur->rx_drop) + counter_delta(prev->tx_drop, cur->tx_drop);
+        unsigned long long errors = counter_delta(prev->rx_errs, cur->rx_errs) + counter_delta(prev->tx_errs, cur->tx_errs);
+
+        buf_printf(b, "%-14s %8s/s %8s/s %9.0f %9.0f %s%6llu\033[0m %s%6llu\033[0m %9s %9s\n",
+                   cur->name, rx, tx,
+                   counter_delta(prev->rx_packets, cur->rx_packets) / seconds,
+                   counter_delta(prev->tx_packets, cur->tx_packets) / seconds,
+                   drops > 0 ? "\033[1;31m" : "", drops, errors > 0 ? "\033[1;31m" : "", errors,
+                   rx_total, tx_total);
+    }
+    if (hidden > 0) buf_printf(b, "(%d interface tanpa trafik disembunyikan, gunakan -a)\n", hidden);
+
+    // Ringkasan socket TCP per state (hanya state yang ada)
+    buf_printf(b, "\nSocket TCP : %d", after->sockets);
+    const char* sep = " (";
+    for (int i = 1; i < TCP_STATES; i++) {
+        if (after->states[i] == 0) continue;
+        buf_printf(b, "%s%s %d", sep, tcp_state_names[i], after->states[i]);
+        sep = ", ";
+    }
+    buf_printf(b, "%s\n", after->sockets > 0 ? ")" : "");
+    buf_printf(b, "Listen     : %d socket, %s%d\033[0m dengan antrean accept tidak kosong\n",
+               after->states[TCP_STATE_LISTEN], after->listen_backlogged > 0 ? "\033[1;33m" : "",
+               after->listen_backlogged);
+
+    unsigned long long d[NET_COUNTERS];
+    for (int i = 0; i < NET_COUNTERS; i++) d[i] = counter_delta(before->counters[i], after->counters[i]);
+
+    double retrans_pct = d[NET_OUT_SEGS] > 0 ? 100.0 * d[NET_RETRANS_SEGS] / d[NET_OUT_SEGS] : 0;
+    double retrans_total_pct = after->counters[NET_OUT_SEGS] > 0 ?
+                               100.0 * after->counters[NET_RETRANS_SEGS] / after->counters[NET_OUT_SEGS] : 0;
+    const char* retrans_color = retrans_pct >= 5 ? "\033[1;31m" : retrans_pct >= 1 ? "\033[1;33m" : "\033[1;32m";
+
+    buf_printf(b, "Segmen     : masuk %.0f/s, keluar %.0f/s, retransmisi %s%.0f/s (%.2f%%)\033[0m, error masuk %llu, RST keluar %llu\n",
+               d[NET_IN_SEGS] / seconds, d[NET_OUT_SEGS] / seconds, retrans_color,
+               d[NET_RETRANS_SEGS] / seconds, retrans_pct, d[NET_IN_ERRS], d[NET_OUT_RSTS]);
+    buf_printf(b, "Retransmisi: %llu sejak boot (%.2f%% dari segmen keluar), timeout RTO +%llu (total %llu)\n",
+               after->counters[NET_RETRANS_SEGS], retrans_total_pct, d[NET_TCP_TIMEOUTS],
+               after->counters[NET_TCP_TIMEOUTS]);
+    buf_printf(b, "Koneksi    : aktif +%llu, pasif +%llu, gagal +%llu, reset +%llu\n",
+               d[NET_ACTIVE_OPENS], d[NET_PASSIVE_OPENS], d[NET_ATTEMPT_FAILS], d[NET_ESTAB_RESETS]);
+    buf_printf(b, "Antrean    : listen overflow %s+%llu\033[0m, listen drop %s+%llu\033[0m (total %llu / %llu sejak boot)\n",
+               d[NET_LISTEN_OVERFLOWS] > 0 ? "\033[1;31m" : "", d[NET_LISTEN_OVERFLOWS],
+               d[NET_LISTEN_DROPS] > 0 ? "\033[1;31m" : "", d[NET_LISTEN_DROPS],
+               after->counters[NET_LISTEN_OVERFLOWS], after->counters[NET_LISTEN_DROPS]);
+    buf_printf(b, "\033[1;36m======================================================================================\033[0m\n");
+}
+
+// Fungsi untuk menjalankan "cek net [-i ms] [-a] [--live] [-n jumlah]"
+void check_net(char** args) {
+    static struct net_sample samples[2];
+    int interval_ms = parse_interval_arg(args, NET_SAMPLE_DEFAULT_MS);
+    int show_all = 0, live = 0, frames = 0;
+
+    for (int i = 0; args[i] != NULL; i++) {
+        if (strcmp(args[i], "-a") == 0 || strcmp(args[i], "--all") == 0) {
+            show_all = 1;
+        } else if (strcmp(args[i], "--live") == 0 || strcmp(args[i], "-l") == 0) {
+            live = 1;
+        } else if (strcmp(args[i], "-n") == 0 && args[i + 1] != NULL) {
+            frames = atoi(args[++i]);
+        }
+    }
+
+    int cur = 0;
+    if (sample_net(&samples[cur]) != 0) {
+        perror("Gagal membaca /proc/net/dev");
+        return;
+    }
+
+    if (!live) {
+        printf("Mengambil sampel jaringan selama %d ms...\n", interval_ms);
+        sleep_ms(interval_ms);
+        sample_net(&samples[1]);
+
+        struct text_buffer b = { 0 };
+        render_net_report(&b, &samples[0], &samples[1], show_all);
+        if (b.data != NULL) fwrite(b.data, 1, b.len, stdout);
+        free(b.data);
+        return;
+    }
+
+    // Mode live: tampilan disegarkan di tempat sampai 'q'/Ctrl+C, atau sebanyak -n frame
+    int interactive = isatty(STDIN_FILENO) && isatty(STDOUT_FILENO);
+    if (!interactive && frames <= 0) {
+        printf("cek net --live membutuhkan terminal interaktif (atau gunakan -n jumlah).\n");
+        return;
+    }
+
+    struct termios old_term, raw_term;
+    if (interactive) {
+        tcgetattr(STDIN_FILENO, &old_term);
+        raw_term = old_term;
+        raw_term.c_lflag &= ~(ICANON | ECHO | ISIG);
+        raw_term.c_cc[VMIN] = 0;
+        raw_term.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw_term);
+        printf("\033[?1049h\033[?25l\033[2J");
+    }
+
+    struct text_buffer b = { 0 };
+    int running = 1;
+    for (int frame = 0; running && (frames <= 0 || frame < frames); frame++) {
+        double deadline = now_ms() + interval_ms;
+        if (interactive) {
+            // Tunggu interval sambil tetap responsif terhadap tombol
+            double remaining;
+            while (running && (remaining = deadline - now_ms()) > 0) {
+                struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+                if (poll(&pfd, 1, (int)remaining + 1) > 0) {
+                    char keys[32];
+                    ssize_t n = read(STDIN_FILENO, keys, sizeof(keys));
+                    for (ssize_t i = 0; i < n; i++) {
+                        if (keys[i] == 'q' || keys[i] == 'Q' || keys[i] == 3) running = 0;
+                    }
+                    if (n <= 0) running = 0;
+                }
+            }
+            if (!running) break;
+        } else {
+            sleep_ms(interval_ms);
+        }
+
+        int next = 1 - cur;
+        sample_net(&samples[next]);
+        b.len = 0;
+        render_net_report(&b, &samples[cur], &samples[next], show_all);
+        cur = next;
+
+        if (interactive) {
+            // Timpa frame sebelumnya dari pojok kiri atas, hapus sisa setiap baris
+            printf("\033[H");
+            for (size_t i = 0; i < b.len; i++) {
+                if (b.data[i] == '\n') fputs("\033[K", stdout);
+                putchar(b.data[i]);
+            }
+            printf("\033[J(q: keluar, interval %d ms)", interval_ms);
+        } else {
+            fwrite(b.data, 1, b.len, stdout);
+        }
+        fflush(stdout);
+    }
+    free(b.data);
+
+    if (interactive) {
+        printf("\033[0m\033[?25h\033[?1049l");
+        fflush(stdout);
+        tcsetattr(STDIN_FILENO, TCSANOW, &old_term);
+    }
+}
+
+// Satu record DNS di dalam zona, mis. { "86", "PTR", "contoh.com." }
+struct dns_record {
+    char name[64];
+    char type[8];
+    char value[256];
+};
+
+// Satu zona yang dibuat "setup dns": forward (domain) atau reverse (c.b.a.in-addr.arpa)
+struct dns_zone {
+    char name[256];
+    char ns[256];               // Nameserver utama (FQDN dengan titik) untuk SOA dan NS
+    int ns_fixed;               // ns ditentukan eksplisit; jika 0, NS file yang sudah ada dipertahankan
+    char file[PATH_MAX];
+    struct dns_record* records;
+    int count, capacity;
+
+    // Hasil persiapan transaksi
+    struct text_buffer text;
+    unsigned long serial;
+    int changed;
+    char temp[PATH_MAX];        // File sementara yang menunggu rename
+};
+
+// Seluruh perubahan satu kali "setup dns": diterapkan bersama atau tidak sama sekali
+struct dns_plan {
+    char dir[1024];
+    struct dns_zone* zones;
+    int count, capacity;
+    int tools_run;              // Jumlah proses eksternal yang dijalankan
+    int dry_run;                // Hanya tampilkan diff, tidak menulis apa pun
+};
+
+// Fungsi untuk mencari zona di rencana, atau menambahkannya jika belum ada
+static struct dns_zone* dns_plan_zone(struct dns_plan* p, const char* name, const char* ns) {
+    for (int i = 0; i < p->count; i++) {
+        if (strcasecmp(p->zones[i].name, name) == 0) return &p->zones[i];
+    }
+    if (p->count == p->capacity) {
+        int capacity = p->capacity ? p->capacity * 2 : 8;
+        struct dns_zone* zones = realloc(p->zones, capacity * sizeof(*zones));
+        if (zones == NULL) return NULL;
+        p->zones = zones;
+        p->capacity = capacity;
+    }
+
+    struct dns_zone* z = &p->zones[p->count++];
+    memset(z, 0, sizeof(*z));
+    snprintf(z->name, sizeof(z->name), "%s", name);
+    snprintf(z->ns, sizeof(z->ns), "%s", ns);
+    snprintf(z->file, sizeof(z->file), "%s/db.%s", p->dir, name);
+    return z;
+}
+
+// Fungsi untuk menambahkan record ke zona (record yang persis sama tidak digandakan)
+static int dns_add_record(struct dns_zone* z, const char* name, const char* type, const char* value) {
+    for (int i = 0; i < z->count; i++) {
+        struct dns_record* r = &z->records[i];
+        if (strcasecmp(r->name, name) == 0 && strcmp(r->type, type) == 0 && strcasecmp(r->value, value) == 0) {
+            return 0;
+        }
+    }
+    if (z->count == z->capacity) {
+        int capacity = z->capacity ? z->capacity * 2 : 8;
+        struct dns_record* records = realloc(z->records, capacity * sizeof(*records));
+        if (records == NULL) return -1;
+        z->records = records;
+        z->capacity = capacity;
+    }
+
+    struct dns_record* r = &z->records[z->count++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    snprintf(r->type, sizeof(r->type), "%s", type);
+    snprintf(r->value, sizeof(r->value), "%s", value);
+    return 0;
+}
+
+// Fungsi untuk membandingkan record agar urutan di file zona selalu sama (tipe, lalu nama; nama angka secara numerik)
+static int compare_dns_records(const void* a, const void* b) {
+    const struct dns_record* ra = a;
+    const struct dns_record* rb = b;
+    int type = strcmp(ra->type, rb->type);
+    if (type != 0) return type;
+    if (isdigit((unsigned char)ra->name[0]) && isdigit((unsigned char)rb->name[0])) {
+        long na = atol(ra->name), nb = atol(rb->name);
+        if (na != nb) return na < nb ? -1 : 1;
+    }
+    int name = strcasecmp(ra->name, rb->name);
+    return name != 0 ? name : strcasecmp(ra->value, rb->value);
+}
+
+// Fungsi untuk menggabungkan record dari file zona yang sudah ada:
+// record dengan nama dan tipe yang sama di rencana menggantikan yang lama, begitu juga PTR lama
+// yang menunjuk host yang kini punya PTR baru (host pindah IP); sisanya dipertahankan
+static void dns_merge_existing(struct dns_zone* z, const char* old) {
+    int planned = z->count;
+    for (const char* line = old; line != NULL && *line != '\0'; ) {
+        char name[64], type[8], value[256];
+        if (*line != ';' && *line != '$' && !isspace((unsigned char)*line) &&
+            sscanf(line, "%63s IN %7s %255s", name, type, value) == 3 && strcmp(type, "SOA") != 0) {
+            if (strcmp(name, "@") == 0 && strcmp(type, "NS") == 0) {
+                if (!z->ns_fixed) snprintf(z->ns, sizeof(z->ns), "%s", value);
+            } else {
+                int replaced = 0;
+                for (int i = 0; i < planned && !replaced; i++) {
+                    const struct dns_record* r = &z->records[i];
+                    replaced = strcmp(r->type, type) == 0 &&
+                               (strcasecmp(r->name, name) == 0 || (strcmp(type, "PTR") == 0 && strcasecmp(r->value, value) == 0));
+                }
+                if (!replaced) dns_add_record(z, name, type, value);
+            }
+        }
+        line = strchr(line, '\n');
+        if (line != NULL) line++;
+    }
+}
+
+// Fungsi untuk membebaskan seluruh isi rencana
+static void dns_free_plan(struct dns_plan* p) {
+    for (int i = 0; i < p->count; i++) {
+        free(p->zones[i].records);
+        free(p->zones[i].text.data);
+    }
+    free(p->zones);
+    p->zones = NULL;
+    p->count = p->capacity = 0;
+}
+
+// Fungsi untuk memecah IPv4 menjadi nama zona reverse /24 dan nama host di dalamnya
+// mis. 192.168.100.86 -> "100.168.192.in-addr.arpa" dan "86"
+static int dns_reverse_name(const char* ip, char* zone, size_t zone_size, char* host, size_t host_size) {
+    struct in_addr addr;
+    if (inet_pton(AF_INET, ip, &addr) != 1) return -1;
+    const unsigned char* o = (const unsigned char*)&addr.s_addr;
+    snprintf(zone, zone_size, "%u.%u.%u.in-addr.arpa", o[2], o[1], o[0]);
+    snprintf(host, host_size, "%u", o[3]);
+    return 0;
+}
+
+// Fungsi untuk memeriksa nama domain: hanya huruf, angka, '-' dan '.'
+static int dns_valid_name(const char* name) {
+    if (name[0] == '\0' || name[0] == '.' || name[0] == '-' || strlen(name) > 253) return 0;
+    for (const char* c = name; *c != '\0'; c++) {
+        if (!isalnum((unsigned char)*c) && *c != '-' && *c != '.') return 0;
+    }
+    return 1;
+}
+
+// Fungsi untuk membaca seluruh file ke memori (NULL jika tidak ada)
+static char* read_whole_file(const char* path, size_t* len) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+    char* data = malloc(st.st_size + 1);
+    size_t total = 0;
+    while (data != NULL && total < (size_t)st.st_size) {
+        ssize_t n = read(fd, data + total, st.st_size - total);
+        if (n <= 0) break;
+        total += n;
+    }
+    close(fd);
+    if (data != NULL) data[total] = '\0';
+    if (len != NULL) *len = total;
+    return data;
+}
+
+// Fungsi untuk mengambil serial SOA dari isi file zona (0 jika tidak ditemukan)
+static unsigned long dns_zone_serial(const char* text) {
+    const char* soa = text != NULL ? strstr(text, "SOA") : NULL;
+    const char* paren = soa != NULL ? strchr(soa, '(') : NULL;
+    if (paren == NULL) return 0;
+
+    // Lewati komentar ";" sampai angka pertama setelah "("
+    for (const char* c = paren + 1; *c != '\0'; c++) {
+        if (*c == ';') {
+            c = strchr(c, '\n');
+            if (c == NULL) return 0;
+        } else if (isdigit((unsigned char)*c)) {
+            return strtoul(c, NULL, 10);
+        }
+    }
+    return 0;
+}
+
+// Fungsi untuk menghitung serial berikutnya berformat YYYYMMDDnn
+static unsigned long dns_next_serial(unsigned long old) {
+    time_t now = time(NULL);
+    struct tm tm;
+    localtime_r(&now, &tm);
+    unsigned long today = ((tm.tm_year + 1900) * 10000UL + (tm.tm_mon + 1) * 100UL + tm.tm_mday) * 100UL + 1;
+    return old >= today ? old + 1 : today;
+}
+
+// Fungsi untuk menyusun isi file zona dari template
+static void dns_render_zone(const struct dns_zone* z, unsigned long serial, struct text_buffer* b) {
+    b->len = 0;
+    buf_printf(b, "; Zona %s - dibuat oleh mishell setup dns, perubahan manual akan ditimpa\n", z->name);
+    buf_printf(b, "$TTL\t%d\n", DNS_DEFAULT_TTL);
+    // Kontak admin: root.<zona> untuk zona forward, root.<nameserver> untuk zona reverse
+    int reverse = strlen(z->name) > 13 && strcasecmp(z->name + strlen(z->name) - 13, ".in-addr.arpa") == 0;
+    buf_printf(b, "@\tIN\tSOA\t%s root.%s%s (\n", z->ns, reverse ? z->ns : z->name, reverse ? "" : ".");
+    buf_printf(b, "\t\t\t%lu\t\t; Serial\n", serial);
+    buf_printf(b, "\t\t\t604800\t\t; Refresh\n");
+    buf_printf(b, "\t\t\t86400\t\t; Retry\n");
+    buf_printf(b, "\t\t\t2419200\t\t; Expire\n");
+    buf_printf(b, "\t\t\t604800 )\t; Negative Cache TTL\n;\n");
+    buf_printf(b, "@\tIN\tNS\t%s\n", z->ns);
+    for (int i = 0; i < z->count; i++) {
+        const struct dns_record* r = &z->records[i];
+        if (strcmp(r->name, "@") == 0 && strcmp(r->type, "NS") == 0 && strcasecmp(r->value, z->ns) == 0) continue;
+        buf_printf(b, "%s\tIN\t%s\t%s\n", r->name, r->type, r->value);
+    }
+}
+
+// Fungsi untuk menulis data ke file sementara di direktori tujuan (siap di-rename secara atomik)
+static int stage_file(const char* path, const char* data, size_t len, char* temp, size_t temp_size) {
+    snprintf(temp, temp_size, "%s.mishell-XXXXXX", path);
+    int fd = mkstemp(temp);
+    if (fd < 0) {
+        fprintf(stderr, "Gagal membuat file sementara untuk %s: %s\n", path, strerror(errno));
+        temp[0] = '\0';
+        return -1;
+    }
+
+    size_t written = 0;
+    while (written < len) {
+        ssize_t n = write(fd, data + written, len - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        written += n;
+    }
+    int ok = written == len && fchmod(fd, 0644) == 0 && fsync(fd) == 0;
+    close(fd);
+    if (!ok) {
+        fprintf(stderr, "Gagal menulis %s: %s\n", temp, strerror(errno));
+        unlink(temp);
+        temp[0] = '\0';
+        return -1;
+    }
+    return 0;
+}
+
+// Fungsi untuk menjalankan program eksternal tanpa shell dan menangkap outputnya
+// Mengembalikan status keluar, atau 127 jika program tidak ditemukan
+static int run_tool(char* const argv[], char* out, size_t size) {
+    int fds[2];
+    if (pipe(fds) != 0) return -1;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        dup2(fds[1], STDERR_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+    close(fds[1]);
+    if (pid < 0) {
+        close(fds[0]);
+        return -1;
+    }
+
+    size_t len = 0;
+    char discard[1024];
+    for (;;) {
+        ssize_t n = len + 1 < size ? read(fds[0], out + len, size - 1 - len) : read(fds[0], discard, sizeof(discard));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        if (len + 1 < size) len += n;
+    }
+    if (size > 0) out[len] = '\0';
+    close(fds[0]);
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// Fungsi untuk mengambil nama zona dari baris 'zone "nama" ...' (0 jika bukan baris zona)
+static int dns_conf_zone_name(const char* line, char* name, size_t size) {
+    while (*line == ' ' || *line == '\t') line++;
+    if (strncmp(line, "zone", 4) != 0) return 0;
+    const char* open_quote = strchr(line + 4, '"');
+    const char* close_quote = open_quote != NULL ? strchr(open_quote + 1, '"') : NULL;
+    if (close_quote == NULL || (size_t)(close_quote - open_quote - 1) >= size) return 0;
+    memcpy(name, open_quote + 1, close_quote - open_quote - 1);
+    name[close_quote - open_quote - 1] = '\0';
+    return 1;
+}
+
+// Fungsi untuk mencari indeks zona di rencana (-1 jika tidak ada)
+static int dns_plan_index(const struct dns_plan* p, const char* name) {
+    for (int i = 0; i < p->count; i++) {
+        if (strcasecmp(p->zones[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+// Fungsi untuk menulis stanza zona named.conf.local
+static void dns_conf_stanza(struct text_buffer* b, const struct dns_zone* z) {
+    buf_printf(b, "zone \"%s\" { type master; file \"%s\"; allow-update { none; }; };\n", z->name, z->file);
+}
+
+// Fungsi untuk menyusun named.conf.local baru: semua zona mishell berada dalam satu blok bertanda
+// yang ditulis ulang utuh, sehingga menjalankan ulang tidak pernah menggandakan stanza zona
+static void dns_render_conf(const struct dns_plan* p, const char* old, struct text_buffer* b) {
+    struct text_buffer managed = { 0 };
+    int in_block = 0, index;
+    char name[256];
+    char* emitted = calloc(p->count > 0 ? p->count : 1, 1);
+
+    for (const char* line = old; line != NULL && *line != '\0'; ) {
+        const char* next = strchr(line, '\n');
+        size_t len = next != NULL ? (size_t)(next - line) : strlen(line);
+        char text[1024];
+        snprintf(text, sizeof(text), "%.*s", (int)(len < sizeof(text) - 1 ? len : sizeof(text) - 1), line);
+        line = next != NULL ? next + 1 : NULL;
+
+        if (strcmp(text, DNS_CONF_BEGIN) == 0) {
+            in_block = 1;
+        } else if (strcmp(text, DNS_CONF_END) == 0) {
+            in_block = 0;
+        } else if (in_block) {
+            // Zona lama di blok mishell dipertahankan; zona dalam rencana diganti di posisinya
+            if (!dns_conf_zone_name(text, name, sizeof(name))) continue;
+            index = dns_plan_index(p, name);
+            if (index < 0) {
+                buf_printf(&managed, "%s\n", text);
+            } else if (emitted != NULL && !emitted[index]) {
+                dns_conf_stanza(&managed, &p->zones[index]);
+                emitted[index] = 1;
+            }
+        } else if (dns_conf_zone_name(text, name, sizeof(name)) && dns_plan_index(p, name) >= 0 &&
+                   strstr(text, "};") != NULL) {
+            // Stanza satu baris yang ditambahkan versi lama dengan "tee -a": diganti oleh blok mishell
+        } else {
+            buf_printf(b, "%s\n", text);
+        }
+    }
+
+    buf_printf(b, "%s\n", DNS_CONF_BEGIN);
+    if (managed.data != NULL) buf_printf(b, "%s", managed.data);
+    for (int i = 0; i < p->count; i++) {
+        if (emitted == NULL || !emitted[i]) dns_conf_stanza(b, &p->zones[i]);
+    }
+    buf_printf(b, "%s\n", DNS_CONF_END);
+    free(managed.data);
+    free(emitted);
+}
+
+// Fungsi untuk memecah teks (diubah di tempat) menjadi array baris
+static char** split_lines(char* text, int* count) {
+    int capacity = 64;
+    char** lines = malloc(capacity * sizeof(char*));
+    *count = 0;
+    while (lines != NULL && text != NULL && *text != '\0') {
+        if (*count == capacity) {
+            capacity *= 2;
+            char** grown = realloc(lines, capacity * sizeof(char*));
+            if (grown == NULL) break;
+            lines = grown;
+        }
+        lines[(*count)++] = text;
+        text = strchr(text, '\n');
+        if (text != NULL) *text++ = '\0';
+    }
+    return lines;
+}
+
+// Fungsi untuk menampilkan perbedaan baris antara isi lama dan baru (mirip unified diff tanpa konteks)
+// Bagian awal/akhir yang sama dilewati; bagian tengah dibandingkan dengan LCS selama ukurannya wajar
+static void print_line_diff(const char* label, const char* old_text, const char* new_text) {
+    char* a_text = strdup(old_text != NULL ? old_text : "");
+    char* b_text = strdup(new_text != NULL ? new_text : "");
+    int n = 0, m = 0;
+    char** a = split_lines(a_text, &n);
+    char** b = split_lines(b_text, &m);
+    if (a == NULL || b == NULL) goto out;
+
+    printf("\033[1m--- %s%s\n+++ %s\033[0m\n", label, old_text == NULL ? " (belum ada)" : "", label);
+
+    int prefix = 0, suffix = 0;
+    while (prefix < n && prefix < m && strcmp(a[prefix], b[prefix]) == 0) prefix++;
+    while (suffix < n - prefix && suffix < m - prefix && strcmp(a[n - 1 - suffix], b[m - 1 - suffix]) == 0) suffix++;
+
+    int rows = n - prefix - suffix, cols = m - prefix - suffix;
+    unsigned int* lcs = NULL;
+    if ((long long)(rows + 1) * (cols + 1) <= DIFF_MAX_CELLS) {
+        lcs = calloc((size_t)(rows + 1) * (cols + 1), sizeof(unsigned int));
+    }
+    // lcs[i][j] = panjang LCS dari a[prefix+i..] dan b[prefix+j..]
+    #define LCS(i, j) lcs[(size_t)(i) * (cols + 1) + (j)]
+    if (lcs != NULL) {
+        for (int i = rows - 1; i >= 0; i--) {
+            for (int j = cols - 1; j >= 0; j--) {
+                LCS(i, j) = strcmp(a[prefix + i], b[prefix + j]) == 0 ? LCS(i + 1, j + 1) + 1 :
+                            LCS(i + 1, j) > LCS(i, j + 1) ? LCS(i + 1, j) : LCS(i, j + 1);
+            }
+        }
+    }
+
+    int i = 0, j = 0, in_hunk = 0;
+    while (i < rows || j < cols) {
+        int same = lcs != NULL && i < rows && j < cols && strcmp(a[prefix + i], b[prefix + j]) == 0;
+        if (same) {
+            i++;
+            j++;
+            in_hunk = 0;
+            continue;
+        }
+        if (!in_hunk) {
+            printf("\033[1;36m@@ baris %d @@\033[0m\n", prefix + j + 1);
+            in_hunk = 1;
+        }
+        // Tanpa tabel LCS (terlalu besar), seluruh bagian tengah ditampilkan sebagai hapus lalu tambah
+        int take_old = i < rows && (j >= cols || lcs == NULL || LCS(i + 1, j) >= LCS(i, j + 1));
+        if (take_old) {
+            printf("\033[1;31m-%s\033[0m\n", a[prefix + i++]);
+        } else {
+            printf("\033[1;32m+%s\033[0m\n", b[prefix + j++]);
+        }
+    }
+    #undef LCS
+    free(lcs);
+
+out:
+    free(a);
+    free(b);
+    free(a_text);
+    free(b_text);
+}
+
+// Fungsi untuk menghapus semua file sementara transaksi yang belum di-rename
+static void dns_abort(struct dns_plan* p, char* conf_temp) {
+    for (int i = 0; i < p->count; i++) {
+        if (p->zones[i].temp[0] != '\0') unlink(p->zones[i].temp);
+        p->zones[i].temp[0] = '\0';
+    }
+    if (conf_temp[0] != '\0') unlink(conf_temp);
+    conf_temp[0] = '\0';
+}
+
+// Fungsi untuk memeriksa apakah nameserver zona yang berada di dalam zona itu sendiri punya record
+// A/AAAA. Tanpa alamat, NS tidak bisa di-resolve (named-checkzone juga menolaknya).
+static int dns_zone_ns_has_address(const struct dns_zone* z) {
+    char owner[256];
+    size_t ns_len = strlen(z->ns), zone_len = strlen(z->name);
+    if (ns_len == 0 || z->ns[ns_len - 1] != '.') {
+        snprintf(owner, sizeof(owner), "%s", z->ns);            // Nama relatif terhadap zona
+    } else if (ns_len == zone_len + 1 && strncasecmp(z->ns, z->name, zone_len) == 0) {
+        strcpy(owner, "@");
+    } else if (ns_len > zone_len + 2 && z->ns[ns_len - zone_len - 2] == '.' &&
+               strncasecmp(z->ns + ns_len - zone_len - 1, z->name, zone_len) == 0) {
+        snprintf(owner, sizeof(owner), "%.*s", (int)(ns_len - zone_len - 2), z->ns);
+    } else {
+        return 1;                                               // Di luar zona: alamatnya diatur di tempat lain
+    }
+
+    for (int i = 0; i < z->count; i++) {
+        const struct dns_record* r = &z->records[i];
+        if ((strcmp(r->type, "A") == 0 || strcmp(r->type, "AAAA") == 0) &&
+            (strcasecmp(r->name, owner) == 0 || strcasecmp(r->name, z->ns) == 0)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Fungsi untuk menerapkan rencana secara transaksional:
+// tulis semua file ke temp, validasi, rename semuanya, lalu satu kali rndc reload.
+// Dengan dry_run, perubahan hanya ditampilkan sebagai diff.
+int apply_dns_plan(struct dns_plan* p) {
+    char output[4096];
+    char conf_path[PATH_MAX], conf_temp[PATH_MAX] = "";
+    int changed = 0, validate = 1;
+    double start = now_ms();
+
+    if (!p->dry_run && access(p->dir, W_OK) != 0) {
+        printf("Tidak bisa menulis ke %s: %s\n", p->dir, strerror(errno));
+        printf("Jalankan mishell dengan sudo, atau gunakan --dir <direktori> untuk staging.\n");
+        return -1;
+    }
+
+    // 1. Render setiap zona; serial hanya dinaikkan jika isinya benar-benar berubah
+    for (int i = 0; i < p->count; i++) {
+        struct dns_zone* z = &p->zones[i];
+        size_t old_len = 0;
+        char* old = read_whole_file(z->file, &old_len);
+        unsigned long old_serial = dns_zone_serial(old);
+        if (old != NULL) dns_merge_existing(z, old);
+        if (!dns_zone_ns_has_address(z)) {
+            printf("Zona %s: nameserver %s tidak punya record A/AAAA di zona ini.\n", z->name, z->ns);
+            printf("Tambahkan host '@' (atau host nameserver) untuk zona ini, atau tentukan ns di luar zona.\n");
+            free(old);
+            dns_abort(p, conf_temp);
+            return -1;
+        }
+        qsort(z->records, z->count, sizeof(struct dns_record), compare_dns_records);
+
+        dns_render_zone(z, old_serial, &z->text);
+        z->changed = old == NULL || z->text.len != old_len || memcmp(z->text.data, old, old_len) != 0;
+        z->serial = old_serial;
+        if (z->changed) {
+            z->serial = dns_next_serial(old_serial);
+            dns_render_zone(z, z->serial, &z->text);
+            if (p->dry_run) {
+                print_line_diff(z->file, old, z->text.data);
+            } else if (stage_file(z->file, z->text.data, z->text.len, z->temp, sizeof(z->temp)) != 0) {
+                free(old);
+                dns_abort(p, conf_temp);
+                return -1;
+            }
+            changed++;
+        }
+        free(old);
+    }
+
+    // 2. named.conf.local ditulis ulang hanya jika blok mishell berubah
+    snprintf(conf_path, sizeof(conf_path), "%s/named.conf.local", p->dir);
+    size_t old_len = 0;
+    char* old_conf = read_whole_file(conf_path, &old_len);
+    struct text_buffer conf = { 0 };
+    dns_render_conf(p, old_conf != NULL ? old_conf : "", &conf);
+    int conf_changed = old_conf == NULL || conf.len != old_len || memcmp(conf.data, old_conf, old_len) != 0;
+    if (conf_changed && p->dry_run) print_line_diff(conf_path, old_conf, conf.data);
+    free(old_conf);
+    if (conf_changed && !p->dry_run && stage_file(conf_path, conf.data, conf.len, conf_temp, sizeof(conf_temp)) != 0) {
+        free(conf.data);
+        dns_abort(p, conf_temp);
+        return -1;
+    }
+    free(conf.data);
+
+    if (changed == 0 && !conf_changed) {
+        printf("Konfigurasi DNS sudah sesuai, tidak ada yang berubah (%.0f ms).\n", now_ms() - start);
+        return 0;
+    }
+    if (p->dry_run) {
+        printf("Dry run: %d dari %d zona%s akan berubah, tidak ada file yang ditulis.\n",
+               changed, p->count, conf_changed ? " dan named.conf.local" : "");
+        return 0;
+    }
+
+    // 3. Validasi file sementara sebelum ada yang menggantikan file aktif
+    for (int i = 0; i < p->count && validate; i++) {
+        struct dns_zone* z = &p->zones[i];
+        if (!z->changed) continue;
+        char* argv[] = { "named-checkzone", "-q", z->name, z->temp, NULL };
+        int status = run_tool(argv, output, sizeof(output));
+        p->tools_run++;
+        if (status == 127) {
+            printf("named-checkzone tidak ditemukan, validasi zona dilewati.\n");
+            validate = 0;
+        } else if (status != 0) {
+            printf("\033[1;31mZona %s tidak valid, tidak ada file yang diubah:\033[0m\n%s", z->name, output);
+            dns_abort(p, conf_temp);
+            return -1;
+        }
+    }
+    if (conf_changed && validate) {
+        char* argv[] = { "named-checkconf", conf_temp, NULL };
+        int status = run_tool(argv, output, sizeof(output));
+        p->tools_run++;
+        if (status != 0 && status != 127) {
+            printf("\033[1;31mnamed.conf.local tidak valid, tidak ada file yang diubah:\033[0m\n%s", output);
+            dns_abort(p, conf_temp);
+            return -1;
+        }
+    }
+
+    // 4. Commit: rename atomik, zona lebih dulu agar konfigurasi tidak menunjuk file yang belum ada
+    for (int i = 0; i < p->count; i++) {
+        struct dns_zone* z = &p->zones[i];
+        if (!z->changed) {
+            printf("  %-40s tidak berubah (serial %lu)\n", z->name, z->serial);
+            continue;
+        }
+        if (rename(z->temp, z->file) != 0) {
+            fprintf(stderr, "Gagal mengganti %s: %s\n", z->file, strerror(errno));
+            dns_abort(p, conf_temp);
+            return -1;
+        }
+        z->temp[0] = '\0';
+        printf("  %-40s \033[1;32mditulis\033[0m (serial %lu) -> %s\n", z->name, z->serial, z->file);
+    }
+    if (conf_changed) {
+        if (rename(conf_temp, conf_path) != 0) {
+            fprintf(stderr, "Gagal mengganti %s: %s\n", conf_path, strerror(errno));
+            dns_abort(p, conf_temp);
+            return -1;
+        }
+        conf_temp[0] = '\0';
+        printf("  %-40s \033[1;32mdiperbarui\033[0m\n", conf_path);
+    }
+    int dir_fd = open(p->dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+
+    // 5. Satu kali reload untuk semua zona (hanya untuk direktori BIND yang aktif)
+    if (strcmp(p->dir, DNS_DEFAULT_DIR) == 0) {
+        char* argv[] = { "rndc", "reload", NULL };
+        int status = run_tool(argv, output, sizeof(output));
+        p->tools_run++;
+        if (status == 0) {
+            printf("BIND dimuat ulang dengan rndc reload.\n");
+        } else {
+            printf("\033[1;33mrndc reload gagal\033[0m%s%s", output[0] ? ": " : ".\n", output);
+            printf("Pastikan bind9 berjalan: sudo systemctl restart bind9\n");
+        }
+    } else {
+        printf("Direktori staging %s: reload dilewati.\n", p->dir);
+    }
+
+    printf("Selesai dalam %.0f ms: %d zona ditulis, %d proses eksternal.\n",
+           now_ms() - start, changed, p->tools_run);
+    return 0;
+}
+
+// Fungsi untuk memangkas spasi di awal/akhir string (di tempat)
+static char* trim_spaces(char* s) {
+    while (isspace((unsigned char)*s)) s++;
+    char* end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) *--end = '\0';
+    return s;
+}
+
+// Fungsi untuk membuang tanda kutip pembungkus nilai YAML/CSV
+static char* unquote_value(char* s) {
+    size_t len = strlen(s);
+    if (len >= 2 && (s[0] == '"' || s[0] == '\'') && s[len - 1] == s[0]) {
+        s[len - 1] = '\0';
+        return s + 1;
+    }
+    return s;
+}
+
+// Fungsi untuk menambahkan satu host ke rencana: A di zona forward dan PTR di zona reverse /24
+static int dns_plan_host(struct dns_plan* p, const char* zone_name, const char* ns, int ns_fixed,
+                         const char* name, const char* ip, int ptr, int line) {
+    char zone_fqdn[256], host_fqdn[330], default_ns[256];
+    char reverse_zone[64], host[8];
+
+    if (!dns_valid_name(zone_name)) {
+        printf("baris %d: nama zona tidak valid: %s\n", line, zone_name);
+        return -1;
+    }
+    if (strcmp(name, "@") != 0 && !dns_valid_name(name)) {
+        printf("baris %d: nama host tidak valid: %s\n", line, name);
+        return -1;
+    }
+    if (ns != NULL && ns[0] != '\0' && !dns_valid_name(ns)) {
+        printf("baris %d: nama nameserver tidak valid: %s\n", line, ns);
+        return -1;
+    }
+    if (dns_reverse_name(ip, reverse_zone, sizeof(reverse_zone), host, sizeof(host)) != 0) {
+        printf("baris %d: IP tidak valid: %s\n", line, ip);
+        return -1;
+    }
+
+    snprintf(zone_fqdn, sizeof(zone_fqdn), "%s.", zone_name);
+    snprintf(default_ns, sizeof(default_ns), "%s", ns != NULL && ns[0] != '\0' ? ns : zone_fqdn);
+    if (default_ns[strlen(default_ns) - 1] != '.') strncat(default_ns, ".", sizeof(default_ns) - strlen(default_ns) - 1);
+
+    struct dns_zone* forward = dns_plan_zone(p, zone_name, default_ns);
+    if (forward == NULL) return -1;
+    if (ns_fixed) {
+        snprintf(forward->ns, sizeof(forward->ns), "%s", default_ns);
+        forward->ns_fixed = 1;
+    }
+    dns_add_record(forward, name, "A", ip);
+
+    if (ptr) {
+        struct dns_zone* reverse = dns_plan_zone(p, reverse_zone, default_ns);
+        if (reverse == NULL) return -1;
+        if (strcmp(name, "@") == 0) {
+            snprintf(host_fqdn, sizeof(host_fqdn), "%s", zone_fqdn);
+        } else {
+            snprintf(host_fqdn, sizeof(host_fqdn), "%s.%s", name, zone_fqdn);
+        }
+        dns_add_record(reverse, host, "PTR", host_fqdn);
+    }
+    return 0;
+}
+
+// Fungsi untuk membaca nilai ya/tidak dari manifest
+static int parse_bool_value(const char* s) {
+    return !(strcasecmp(s, "no") == 0 || strcasecmp(s, "false") == 0 || strcasecmp(s, "tidak") == 0 ||
+             strcmp(s, "0") == 0);
+}
+
+// Fungsi untuk memuat manifest CSV: zona,nama,ip[,ptr] per baris (baris judul dan # komentar dilewati)
+static int load_dns_csv(struct dns_plan* p, char* text) {
+    int line_no = 0;
+    for (char* line = strtok(text, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+        line_no++;
+        char* row = trim_spaces(line);
+        if (row[0] == '\0' || row[0] == '#') continue;
+
+        char* fields[4] = { NULL, NULL, NULL, NULL };
+        int count = 0;
+        for (char* f = row; f != NULL && count < 4; count++) {
+            char* comma = strchr(f, ',');
+            if (comma != NULL) *comma = '\0';
+            fields[count] = unquote_value(trim_spaces(f));
+            f = comma != NULL ? comma + 1 : NULL;
+        }
+        if (line_no == 1 && strcasecmp(fields[0], "zone") == 0) continue;   // Baris judul
+        if (count < 3) {
+            printf("baris %d: format harus zona,nama,ip[,ptr]\n", line_no);
+            return -1;
+        }
+        int ptr = count < 4 || fields[3][0] == '\0' || parse_bool_value(fields[3]);
+        if (dns_plan_host(p, fields[0], NULL, 0, fields[1], fields[2], ptr, line_no) != 0) return -1;
+    }
+    return 0;
+}
+
+// Fungsi untuk memuat manifest YAML (subset): zona sebagai kunci tingkat atas, berisi ns, ptr, dan records
+//   contoh.com:
+//     ns: ns1.contoh.com
+//     records:
+//       "@": 10.0.0.1
+//       www: 10.0.0.5
+static int load_dns_yaml(struct dns_plan* p, char* text) {
+    char zone[256] = "", ns[256] = "";
+    int ptr = 1, in_records = 0, line_no = 0;
+
+    for (char* line = text; line != NULL; ) {
+        char* next = strchr(line, '\n');
+        if (next != NULL) *next++ = '\0';
+        line_no++;
+
+        char* hash = strstr(line, " #");
+        if (hash != NULL) *hash = '\0';
+        int indent = strspn(line, " ");
+        char* row = trim_spaces(line);
+        line = next;
+        if (row[0] == '\0' || row[0] == '#' || strcmp(row, "---") == 0) continue;
+
+        char* colon;
+        // Kunci boleh berisi titik dua hanya jika dikutip, mis. "@": ip
+        if (row[0] == '"' || row[0] == '\'') {
+            char* close = strchr(row + 1, row[0]);
+            colon = close != NULL ? strchr(close, ':') : NULL;
+        } else {
+            colon = strchr(row, ':');
+        }
+        if (colon == NULL) {
+            printf("baris %d: format YAML tidak dikenali: %s\n", line_no, row);
+            return -1;
+        }
+        *colon = '\0';
+        char* key = unquote_value(trim_spaces(row));
+        char* value = unquote_value(trim_spaces(colon + 1));
+
+        if (indent == 0) {
+            if (value[0] != '\0') {
+                printf("baris %d: zona '%s' harus berisi blok (ns, records)\n", line_no, key);
+                return -1;
+            }
+            snprintf(zone, sizeof(zone), "%s", key);
+            ns[0] = '\0';
+            ptr = 1;
+            in_records = 0;
+        } else if (zone[0] == '\0') {
+            printf("baris %d: record di luar zona\n", line_no);
+            return -1;
+        } else if (in_records > 0 && indent > in_records) {
+            if (dns_plan_host(p, zone, ns, ns[0] != '\0', key, value, ptr, line_no) != 0) return -1;
+        } else if (strcmp(key, "records") == 0) {
+            in_records = indent;
+        } else if (strcmp(key, "ns") == 0 || strcmp(key, "nameserver") == 0) {
+            snprintf(ns, sizeof(ns), "%s", value);
+            in_records = 0;
+        } else if (strcmp(key, "ptr") == 0) {
+            ptr = parse_bool_value(value);
+            in_records = 0;
+        } else {
+            printf("baris %d: kunci tidak dikenal: %s\n", line_no, key);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Fungsi untuk membangun rencana dari file manifest CSV atau YAML
+static int load_dns_manifest(struct dns_plan* p, const char* path) {
+    char* text = read_whole_file(path, NULL);
+    if (text == NULL) {
+        printf("Gagal membaca manifest %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    const char* ext = strrchr(path, '.');
+    int yaml = ext != NULL && (strcasecmp(ext, ".yaml") == 0 || strcasecmp(ext, ".yml") == 0);
+    int result = yaml ? load_dns_yaml(p, text) : load_dns_csv(p, text);
+    free(text);
+
+    if (result == 0 && p->count == 0) {
+        printf("Manifest %s tidak berisi record.\n", path);
+        return -1;
+    }
+    return result;
+}
+
+// Fungsi untuk memeriksa apakah program ada di PATH
+static int program_in_path(const char* name) {
+    const char* path = shell_var_get("PATH");
+    char candidate[PATH_MAX];
+    while (path != NULL && *path != '\0') {
+        const char* end = strchr(path, ':');
+        size_t len = end != NULL ? (size_t)(end - path) : strlen(path);
+        snprintf(candidate, sizeof(candidate), "%.*s/%s", (int)len, path, name);
+        if (access(candidate, X_OK) == 0) return 1;
+        path = end != NULL ? end + 1 : NULL;
+    }
+    return 0;
+}
+
+// Fungsi untuk menambahkan nameserver ke /etc/resolv.conf jika belum ada
+static void dns_add_resolver(const char* ip) {
+    char* resolv = read_whole_file("/etc/resolv.conf", NULL);
+    char line[96];
+    snprintf(line, sizeof(line), "nameserver %s\n", ip);
+    int present = resolv != NULL && (strncmp(resolv, line, strlen(line)) == 0 ||
+                                     (strstr(resolv, line) != NULL && strstr(resolv, line)[-1] == '\n'));
+    free(resolv);
+    if (present) return;
+
+    int fd = open("/etc/resolv.conf", O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (fd < 0 || write(fd, line, strlen(line)) < 0) {
+        perror("Gagal menambahkan nameserver ke /etc/resolv.conf");
+    } else {
+        printf("nameserver %s ditambahkan ke /etc/resolv.conf\n", ip);
+    }
+    if (fd >= 0) close(fd);
+}
+
+// Fungsi untuk menjalankan "setup dns [ip domain] [--dir direktori]"
+void setup_dns(char** args) {
+    char ip[64] = "", domain[256] = "";
+    struct dns_plan plan = { 0 };
+    snprintf(plan.dir, sizeof(plan.dir), "%s", DNS_DEFAULT_DIR);
+
+    const char* manifest = NULL;
+    int positional = 0;
+    for (int i = 0; args[i] != NULL; i++) {
+        if (strcmp(args[i], "--dir") == 0 && args[i + 1] != NULL) {
+            snprintf(plan.dir, sizeof(plan.dir), "%s", args[++i]);
+            size_t len = strlen(plan.dir);
+            if (len > 1 && plan.dir[len - 1] == '/') plan.dir[len - 1] = '\0';
+        } else if (strcmp(args[i], "--from") == 0 && args[i + 1] != NULL) {
+            manifest = args[++i];
+        } else if (strcmp(args[i], "--dry-run") == 0 || strcmp(args[i], "-n") == 0) {
+            plan.dry_run = 1;
+        } else if (positional == 0) {
+            snprintf(ip, sizeof(ip), "%s", args[i]);
+            positional++;
+        } else if (positional == 1) {
+            snprintf(domain, sizeof(domain), "%s", args[i]);
+            positional++;
+        }
+    }
+
+    int live = strcmp(plan.dir, DNS_DEFAULT_DIR) == 0;
+
+    // Provisioning massal: semua zona dari manifest diterapkan dalam satu transaksi dan satu reload
+    if (manifest != NULL) {
+        if (load_dns_manifest(&plan, manifest) == 0) {
+            printf("Manifest %s: %d zona di %s%s\n", manifest, plan.count, plan.dir,
+                   plan.dry_run ? " (dry run)" : "");
+            apply_dns_plan(&plan);
+        }
+        dns_free_plan(&plan);
+        return;
+    }
+
+    // Meminta input dari user jika tidak diberikan sebagai argumen
+    if (ip[0] == '\0') {
+        printf("Masukkan IP untuk DNS server (contoh 192.168.100.86): ");
+        if (fgets(ip, sizeof(ip), stdin) == NULL) return;
+        ip[strcspn(ip, "\n")] = 0;
+    }
+    if (domain[0] == '\0') {
+        printf("Masukkan domain untuk DNS (contoh: sugax1-server.com): ");
+        if (fgets(domain, sizeof(domain), stdin) == NULL) return;
+        domain[strcspn(domain, "\n")] = 0;
+    }
+    size_t domain_len = strlen(domain);
+    if (domain_len > 0 && domain[domain_len - 1] == '.') domain[domain_len - 1] = '\0';
+
+    char reverse_zone[64], host[8];
+    if (dns_reverse_name(ip, reverse_zone, sizeof(reverse_zone), host, sizeof(host)) != 0) {
+        printf("IP tidak valid: %s\n", ip);
+        return;
+    }
+    if (!dns_valid_name(domain)) {
+        printf("Domain tidak valid: %s\n", domain);
+        return;
+    }
+
+    if (live && !plan.dry_run && !program_in_path("named") && access("/usr/sbin/named", X_OK) != 0) {
+        printf("bind9 belum terinstal. Menginstal bind9...\n");
+        system("sudo apt-get update && sudo apt-get install -y bind9");
+    }
+
+    // Zona forward dan reverse dari template, seperti db.local dan db.127 bawaan BIND
+    char fqdn[260];
+    snprintf(fqdn, sizeof(fqdn), "%s.", domain);
+    struct dns_zone* forward = dns_plan_zone(&plan, domain, fqdn);
+    struct dns_zone* reverse = dns_plan_zone(&plan, reverse_zone, fqdn);
+    if (forward == NULL || reverse == NULL) {
+        dns_free_plan(&plan);
+        return;
+    }
+    dns_add_record(forward, "@", "A", ip);
+    dns_add_record(reverse, host, "PTR", fqdn);
+
+    printf("Menyiapkan DNS %s -> %s di %s...\n", domain, ip, plan.dir);
+    if (apply_dns_plan(&plan) == 0 && !plan.dry_run) {
+        if (live) dns_add_resolver(ip);
+        printf("\nKonfigurasi DNS selesai! DNS telah disiapkan dengan IP %s dan domain %s.\n", ip, domain);
+    }
+    dns_free_plan(&plan);
+}
+
+// Fungsi untuk menulis nama domain dalam format label DNS; mengembalikan panjang atau -1
+static int dns_encode_name(const char* name, unsigned char* out, size_t size) {
+    size_t pos = 0;
+    while (*name != '\0') {
+        const char* dot = strchr(name, '.');
+        size_t len = dot != NULL ? (size_t)(dot - name) : strlen(name);
+        if (len == 0 || len > 63 || pos + len + 2 > size) return -1;
+        out[pos++] = (unsigned char)len;
+        memcpy(out + pos, name, len);
+        pos += len;
+        name += len;
+        if (*name == '.') name++;
+    }
+    if (pos + 1 > size) return -1;
+    out[pos++] = 0;
+    return (int)pos;
+}
+
+// Fungsi untuk menyusun paket query standar (RD=1, satu pertanyaan kelas IN)
+static int dns_build_query(unsigned char* buf, size_t size, uint16_t id, const char* name, int qtype) {
+    if (size < 12) return -1;
+    memset(buf, 0, 12);
+    buf[0] = id >> 8;
+    buf[1] = id & 0xff;
+    buf[2] = 0x01;      // RD
+    buf[5] = 1;         // QDCOUNT
+    int n = dns_encode_name(name, buf + 12, size - 12 - 4);
+    if (n < 0) return -1;
+    unsigned char* q = buf + 12 + n;
+    q[0] = qtype >> 8;
+    q[1] = qtype & 0xff;
+    q[2] = 0;
+    q[3] = 1;           // IN
+    return 12 + n + 4;
+}
+
+// Fungsi untuk membaca pertanyaan pertama dari paket (nama huruf kecil tanpa titik akhir)
+// Mengembalikan offset setelah pertanyaan, atau -1 jika paket rusak
+static int dns_parse_question(const unsigned char* msg, size_t len, char* name, size_t size, int* qtype) {
+    size_t pos = 12, out = 0;
+    if (len < 12) return -1;
+    for (;;) {
+        if (pos >= len) return -1;
+        unsigned int label = msg[pos++];
+        if (label == 0) break;
+        if (label > 63 || pos + label > len || out + label + 2 > size) return -1;
+        if (out > 0) name[out++] = '.';
+        for (unsigned int i = 0; i < label; i++) name[out++] = tolower(msg[pos + i]);
+        pos += label;
+    }
+    name[out] = '\0';
+    if (pos + 4 > len) return -1;
+    *qtype = msg[pos] << 8 | msg[pos + 1];
+    return (int)(pos + 4);
+}
+
+// Database jawaban responder bawaan: entri per (nama, tipe), dirantai per bucket hash
+struct dns_db_entry {
+    char name[256];
+    int type;
+    unsigned char rdata[256];
+    int rdlen;
+    int next;
+};
+
+struct dns_db {
+    struct dns_db_entry* entries;
+    int count, capacity;
+    int buckets[DNS_DB_BUCKETS];
+    char (*zones)[256];
+    int zone_count;
+};
+
+// Fungsi hash FNV-1a untuk nama domain (sudah huruf kecil)
+static unsigned int dns_name_hash(const char* name) {
+    unsigned int h = 2166136261u;
+    for (; *name != '\0'; name++) h = (h ^ (unsigned char)*name) * 16777619u;
+    return h;
+}
+
+// Fungsi untuk menambahkan satu jawaban ke database responder
+static void dns_db_add(struct dns_db* db, const char* name, int type, const unsigned char* rdata, int rdlen) {
+    if (db->count == db->capacity) {
+        int capacity = db->capacity ? db->capacity * 2 : 256;
+        struct dns_db_entry* entries = realloc(db->entries, capacity * sizeof(*entries));
+        if (entries == NULL) return;
+        db->entries = entries;
+        db->capacity = capacity;
+    }
+    struct dns_db_entry* e = &db->entries[db->count];
+    size_t i;
+    for (i = 0; name[i] != '\0' && i < sizeof(e->name) - 1; i++) e->name[i] = tolower((unsigned char)name[i]);
+    e->name[i] = '\0';
+    if (i > 0 && e->name[i - 1] == '.') e->name[i - 1] = '\0';
+    e->type = type;
+    e->rdlen = rdlen;
+    memcpy(e->rdata, rdata, rdlen);
+
+    unsigned int b = dns_name_hash(e->name) % DNS_DB_BUCKETS;
+    e->next = db->buckets[b];
+    db->buckets[b] = db->count++;
+}
+
+// Fungsi untuk membangun database responder dari zona-zona dalam rencana
+static void dns_db_from_plan(struct dns_db* db, const struct dns_plan* p) {
+    memset(db, 0, sizeof(*db));
+    for (int i = 0; i < DNS_DB_BUCKETS; i++) db->buckets[i] = -1;
+    db->zones = calloc(p->count > 0 ? p->count : 1, sizeof(*db->zones));
+
+    for (int i = 0; i < p->count && db->zones != NULL; i++) {
+        const struct dns_zone* z = &p->zones[i];
+        snprintf(db->zones[db->zone_count++], sizeof(db->zones[0]), "%s", z->name);
+        for (char* c = db->zones[db->zone_count - 1]; *c != '\0'; c++) *c = tolower((unsigned char)*c);
+
+        for (int j = 0; j < z->count; j++) {
+            const struct dns_record* r = &z->records[j];
+            char fqdn[520];
+            if (strcmp(r->name, "@") == 0) snprintf(fqdn, sizeof(fqdn), "%s", z->name);
+            else snprintf(fqdn, sizeof(fqdn), "%s.%s", r->name, z->name);
+
+            unsigned char rdata[256];
+            if (strcmp(r->type, "A") == 0 && inet_pton(AF_INET, r->value, rdata) == 1) {
+                dns_db_add(db, fqdn, DNS_TYPE_A, rdata, 4);
+            } else if (strcmp(r->type, "PTR") == 0) {
+                int n = dns_encode_name(r->value, rdata, sizeof(rdata));
+                if (n > 0) dns_db_add(db, fqdn, DNS_TYPE_PTR, rdata, n);
+            }
+        }
+    }
+}
+
+// Fungsi untuk memeriksa apakah nama berada di salah satu zona responder
+static int dns_db_in_zone(const struct dns_db* db, const char* name) {
+    size_t len = strlen(name);
+    for (int i = 0; i < db->zone_count; i++) {
+        size_t zlen = strlen(db->zones[i]);
+        if (len == zlen && strcmp(name, db->zones[i]) == 0) return 1;
+        if (len > zlen && name[len - zlen - 1] == '.' && strcmp(name + len - zlen, db->zones[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+// Fungsi untuk menjawab satu query: A/PTR dari database, NXDOMAIN di dalam zona, REFUSED di luar zona
+// Mengembalikan panjang jawaban, atau -1 jika paket harus diabaikan
+static int dns_answer_query(const struct dns_db* db, const unsigned char* q, size_t qlen,
+                            unsigned char* out, size_t size) {
+    char name[256];
+    int qtype;
+    int qend = dns_parse_question(q, qlen, name, sizeof(name), &qtype);
+    if (qend < 0 || (q[2] & 0x80) || (size_t)qend > size) return -1;
+
+    memcpy(out, q, qend);
+    out[2] = 0x84 | (q[2] & 0x01);      // QR, AA, salin RD
+    out[3] = 0;
+    memset(out + 6, 0, 6);              // ANCOUNT, NSCOUNT, ARCOUNT
+    out[4] = 0;
+    out[5] = 1;
+
+    if (!dns_db_in_zone(db, name)) {
+        out[2] &= ~0x04;
+        out[3] = DNS_RCODE_REFUSED;
+        return qend;
+    }
+
+    int pos = qend, answers = 0, name_exists = 0;
+    for (int i = db->buckets[dns_name_hash(name) % DNS_DB_BUCKETS]; i >= 0; i = db->entries[i].next) {
+        const struct dns_db_entry* e = &db->entries[i];
+        if (strcmp(e->name, name) != 0) continue;
+        name_exists = 1;
+        if (e->type != qtype && qtype != DNS_TYPE_ANY) continue;
+        if ((size_t)pos + 12 + e->rdlen > size) break;
+
+        unsigned char* a = out + pos;
+        a[0] = 0xc0;                    // Pointer ke nama di pertanyaan
+        a[1] = 12;
+        a[2] = e->type >> 8;
+        a[3] = e->type & 0xff;
+        a[4] = 0;
+        a[5] = 1;
+        a[6] = (DNS_DEFAULT_TTL >> 24) & 0xff;
+        a[7] = (DNS_DEFAULT_TTL >> 16) & 0xff;
+        a[8] = (DNS_DEFAULT_TTL >> 8) & 0xff;
+        a[9] = DNS_DEFAULT_TTL & 0xff;
+        a[10] = e->rdlen >> 8;
+        a[11] = e->rdlen & 0xff;
+        memcpy(a + 12, e->rdata, e->rdlen);
+        pos += 12 + e->rdlen;
+        answers++;
+    }
+    out[6] = answers >> 8;
+    out[7] = answers & 0xff;
+    if (!name_exists) out[3] = DNS_RCODE_NXDOMAIN;     // Tanpa jawaban tapi nama ada = NODATA (NOERROR)
+    return pos;
+}
+
+// Satu koneksi TCP ke responder: query berbingkai panjang 2 byte (RFC 1035 4.2.2)
+struct dns_tcp_client {
+    int fd;
+    size_t len;
+    double last_ms;
+    unsigned char buf[DNS_MAX_MESSAGE + 2];
+};
+
+// Fungsi loop responder DNS bawaan: UDP dan TCP dalam satu poll
+void run_dns_responder(int udp_fd, int tcp_fd, const struct dns_db* db) {
+    static struct dns_tcp_client clients[DNS_MAX_TCP_CLIENTS];
+    struct pollfd fds[DNS_MAX_TCP_CLIENTS + 2];
+    unsigned char query[DNS_MAX_MESSAGE], answer[DNS_MAX_MESSAGE + 2];
+    int num_clients = 0;
+
+    for (;;) {
+        fds[0].fd = udp_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = num_clients < DNS_MAX_TCP_CLIENTS ? tcp_fd : -1;
+        fds[1].events = POLLIN;
+        for (int i = 0; i < num_clients; i++) {
+            fds[i + 2].fd = clients[i].fd;
+            fds[i + 2].events = POLLIN;
+        }
+        if (poll(fds, num_clients + 2, 1000) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        // UDP: kuras semua datagram yang menunggu
+        if (fds[0].revents & POLLIN) {
+            for (;;) {
+                struct sockaddr_storage from;
+                socklen_t from_len = sizeof(from);
+                ssize_t n = recvfrom(udp_fd, query, sizeof(query), MSG_DONTWAIT, (struct sockaddr*)&from, &from_len);
+                if (n < 0) break;
+                int len = dns_answer_query(db, query, n, answer, DNS_UDP_MAX);
+                if (len > 0) sendto(udp_fd, answer, len, MSG_DONTWAIT, (struct sockaddr*)&from, from_len);
+            }
+        }
+
+        double now = now_ms();
+        for (int i = num_clients - 1; i >= 0; i--) {
+            struct dns_tcp_client* c = &clients[i];
+            int done = 0;
+            if (fds[i + 2].revents & (POLLIN | POLLHUP | POLLERR)) {
+                ssize_t n = recv(c->fd, c->buf + c->len, sizeof(c->buf) - c->len, MSG_DONTWAIT);
+                if (n <= 0) {
+                    done = 1;
+                } else {
+                    c->len += n;
+                    c->last_ms = now;
+                    // Jawab semua pesan utuh di buffer (query boleh dikirim berurutan tanpa menunggu)
+                    size_t off = 0;
+                    while (c->len - off >= 2) {
+                        size_t msg_len = c->buf[off] << 8 | c->buf[off + 1];
+                        if (c->len - off - 2 < msg_len) break;
+                        int len = dns_answer_query(db, c->buf + off + 2, msg_len, answer + 2, DNS_MAX_MESSAGE);
+                        if (len > 0) {
+                            answer[0] = len >> 8;
+                            answer[1] = len & 0xff;
+                            send_all(c->fd, (const char*)answer, len + 2);
+                        }
+                        off += 2 + msg_len;
+                    }
+                    memmove(c->buf, c->buf + off, c->len - off);
+                    c->len -= off;
+                }
+            } else if (now - c->last_ms > DNS_TCP_IDLE_MS) {
+                done = 1;
+            }
+            if (done) {
+                close(c->fd);
+                clients[i] = clients[--num_clients];
+            }
+        }
+
+        if (fds[1].fd >= 0 && (fds[1].revents & POLLIN)) {
+            int fd = accept4(tcp_fd, NULL, NULL, SOCK_CLOEXEC);
+            if (fd >= 0) {
+                int one = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));   // Jawaban beruntun jangan ditahan Nagle
+                clients[num_clients].fd = fd;
+                clients[num_clients].len = 0;
+                clients[num_clients].last_ms = now;
+                num_clients++;
+            }
+        }
+    }
+}
+
+// Fungsi untuk memuat zona yang dikelola "setup dns" dari named.conf.local di direktori BIND
+static int load_dns_zones(struct dns_plan* p, const char* dir) {
+    char conf_path[PATH_MAX];
+    snprintf(conf_path, sizeof(conf_path), "%s/named.conf.local", dir);
+    char* conf = read_whole_file(conf_path, NULL);
+    if (conf == NULL) return -1;
+
+    int in_block = 0;
+    for (char* line = strtok(conf, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+        char name[256];
+        if (strcmp(line, DNS_CONF_BEGIN) == 0) in_block = 1;
+        else if (strcmp(line, DNS_CONF_END) == 0) in_block = 0;
+        if (!in_block || !dns_conf_zone_name(line, name, sizeof(name))) continue;
+
+        // Ambil path dari 'file "..."'
+        char* file = strstr(line, "file \"");
+        char* end = file != NULL ? strchr(file + 6, '"') : NULL;
+        struct dns_zone* z = dns_plan_zone(p, name, "");
+        if (z == NULL || end == NULL) continue;
+        snprintf(z->file, sizeof(z->file), "%.*s", (int)(end - file - 6), file + 6);
+
+        char* text = read_whole_file(z->file, NULL);
+        if (text != NULL) dns_merge_existing(z, text);
+        free(text);
+    }
+    free(conf);
+    return 0;
+}
+
+// Fungsi untuk membuat zona sintetis bench.test (beserta reverse-nya) saat tidak ada zona yang diprovisi
+static void dns_synthetic_zones(struct dns_plan* p) {
+    for (int i = 0; i < DNS_BENCH_SYNTH_HOSTS; i++) {
+        char host[16], ip[32];
+        snprintf(host, sizeof(host), "h%d", i);
+        snprintf(ip, sizeof(ip), "10.99.%d.%d", i / 256, i % 256);
+        dns_plan_host(p, "bench.test", NULL, 0, host, ip, 1, 0);
+    }
+}
+
+// Satu nama yang di-query oleh "dns bench"
+struct dns_query_name {
+    char name[256];
+    int qtype;
+};
+
+// Fungsi untuk mengubah tipe record teks menjadi nomor QTYPE
+static int dns_qtype_value(const char* type) {
+    static const struct { const char* name; int value; } types[] = {
+        { "A", 1 }, { "NS", 2 }, { "CNAME", 5 }, { "SOA", 6 }, { "PTR", 12 }, { "MX", 15 },
+        { "TXT", 16 }, { "AAAA", 28 }, { "SRV", 33 }, { "ANY", 255 },
+    };
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        if (strcasecmp(type, types[i].name) == 0) return types[i].value;
+    }
+    return -1;
+}
+
+// Fungsi untuk menambahkan nama ke daftar query (array tumbuh)
+static void add_query_name(struct dns_query_name** names, int* count, int* capacity, const char* name, int qtype) {
+    if (*count == *capacity) {
+        int grown = *capacity ? *capacity * 2 : 64;
+        struct dns_query_name* n = realloc(*names, grown * sizeof(*n));
+        if (n == NULL) return;
+        *names = n;
+        *capacity = grown;
+    }
+    snprintf((*names)[*count].name, sizeof((*names)[*count].name), "%s", name);
+    (*names)[*count].qtype = qtype;
+    (*count)++;
+}
+
+// Fungsi untuk membaca daftar nama dari file: "nama [TIPE]" per baris; alamat IPv4 di-query sebagai PTR
+static int load_query_names(const char* path, struct dns_query_name** names, int* count, int* capacity) {
+    char* text = read_whole_file(path, NULL);
+    if (text == NULL) {
+        printf("Gagal membaca %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    int line_no = 0;
+    for (char* line = strtok(text, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+        char name[256], type[16] = "A";
+        line_no++;
+        if (sscanf(line, "%255s %15s", name, type) < 1 || name[0] == '#') continue;
+
+        char zone[64], host[8], ptr_name[80];
+        int qtype = dns_qtype_value(type);
+        if (qtype < 0) {
+            printf("baris %d: tipe tidak dikenal: %s\n", line_no, type);
+            continue;
+        }
+        if (dns_reverse_name(name, zone, sizeof(zone), host, sizeof(host)) == 0) {
+            snprintf(ptr_name, sizeof(ptr_name), "%s.%s", host, zone);
+            add_query_name(names, count, capacity, ptr_name, DNS_TYPE_PTR);
+        } else {
+            add_query_name(names, count, capacity, name, qtype);
+        }
+    }
+    free(text);
+    return 0;
+}
+
+// Fungsi untuk mengambil daftar nama query dari zona dalam rencana (A untuk host, PTR untuk reverse)
+static void query_names_from_plan(const struct dns_plan* p, struct dns_query_name** names, int* count, int* capacity) {
+    for (int i = 0; i < p->count; i++) {
+        const struct dns_zone* z = &p->zones[i];
+        for (int j = 0; j < z->count; j++) {
+            const struct dns_record* r = &z->records[j];
+            int qtype = dns_qtype_value(r->type);
+            if (qtype < 0) continue;
+            char fqdn[520];
+            if (strcmp(r->name, "@") == 0) snprintf(fqdn, sizeof(fqdn), "%s", z->name);
+            else snprintf(fqdn, sizeof(fqdn), "%s.%s", r->name, z->name);
+            add_query_name(names, count, capacity, fqdn, qtype);
+        }
+    }
+}
+
+// Fungsi untuk membaca "ip", "ip:port", "ipv6", atau "[ipv6]:port" menjadi alamat socket
+static int parse_server_addr(const char* spec, struct sockaddr_storage* addr, socklen_t* len) {
+    char host[INET6_ADDRSTRLEN + 8];
+    int port = DNS_PORT;
+    memset(addr, 0, sizeof(*addr));
+
+    if (spec[0] == '[') {
+        const char* close = strchr(spec, ']');
+        if (close == NULL || (size_t)(close - spec - 1) >= sizeof(host)) return -1;
+        snprintf(host, sizeof(host), "%.*s", (int)(close - spec - 1), spec + 1);
+        if (close[1] == ':') port = atoi(close + 2);
+    } else if (strchr(spec, ':') != NULL && strchr(spec, ':') == strrchr(spec, ':')) {
+        const char* colon = strchr(spec, ':');
+        if ((size_t)(colon - spec) >= sizeof(host)) return -1;
+        snprintf(host, sizeof(host), "%.*s", (int)(colon - spec), spec);
+        port = atoi(colon + 1);
+    } else {
+        snprintf(host, sizeof(host), "%s", spec);
+    }
+
+    struct sockaddr_in* in4 = (struct sockaddr_in*)addr;
+    struct sockaddr_in6* in6 = (struct sockaddr_in6*)addr;
+    if (inet_pton(AF_INET, host, &in4->sin_addr) == 1) {
+        in4->sin_family = AF_INET;
+        in4->sin_port = htons(port);
+        *len = sizeof(*in4);
+    } else if (inet_pton(AF_INET6, host, &in6->sin6_addr) == 1) {
+        in6->sin6_family = AF_INET6;
+        in6->sin6_port = htons(port);
+        *len = sizeof(*in6);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+// Opsi satu kali "dns bench"
+struct dns_bench_opts {
+    int qps;
+    int seconds;
+    int tcp;
+    int timeout_ms;
+    int conns;
+};
+
+// Status satu query yang sudah dikirim
+struct dns_bench_query {
+    double sent_ms;
+    uint16_t id;
+    unsigned char conn;
+    unsigned char state;    // 0 menunggu, 1 dijawab, 2 timeout, 3 gagal kirim
+};
+
+// Fungsi untuk membuka koneksi (UDP: connect agar kernel menyaring sumber jawaban; TCP: dengan batas waktu)
+static int dns_bench_connect(const struct sockaddr_storage* addr, socklen_t len, int tcp, int timeout_ms) {
+    int fd = socket(addr->ss_family, (tcp ? SOCK_STREAM : SOCK_DGRAM) | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (tcp) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    if (connect(fd, (const struct sockaddr*)addr, len) != 0) {
+        if (errno != EINPROGRESS) {
+            close(fd);
+            return -1;
+        }
+        struct pollfd pfd = { fd, POLLOUT, 0 };
+        int err = 0;
+        socklen_t err_len = sizeof(err);
+        if (poll(&pfd, 1, timeout_ms) <= 0 || getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &err_len) != 0 || err != 0) {
+            errno = err != 0 ? err : ETIMEDOUT;
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+// Fungsi untuk menampilkan histogram latensi berskala log
+static void print_latency_histogram(const double* latencies, int count) {
+    static const double bounds[] = { 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 25, 50, 100, 250, 500, 1000 };
+    int num_bounds = sizeof(bounds) / sizeof(bounds[0]);
+    int buckets[sizeof(bounds) / sizeof(bounds[0]) + 1] = { 0 };
+
+    for (int i = 0; i < count; i++) {
+        int b = 0;
+        while (b < num_bounds && latencies[i] >= bounds[b]) b++;
+        buckets[b]++;
+    }
+    int first = 0, last = num_bounds, peak = 1;
+    while (first < last && buckets[first] == 0) first++;
+    while (last > first && buckets[last] == 0) last--;
+    for (int b = first; b <= last; b++) if (buckets[b] > peak) peak = buckets[b];
+
+    for (int b = first; b <= last; b++) {
+        char label[32];
+        if (b < num_bounds) snprintf(label, sizeof(label), "< %g ms", bounds[b]);
+        else snprintf(label, sizeof(label), ">= %g ms", bounds[num_bounds - 1]);
+        int width = (int)((double)buckets[b] / peak * DNS_HISTOGRAM_WIDTH + 0.5);
+        printf("  %-11s |\033[1;32m", label);
+        for (int i = 0; i < width; i++) putchar('#');
+        printf("\033[0m%*s %7d (%5.1f%%)\n", DNS_HISTOGRAM_WIDTH - width, "", buckets[b], 100.0 * buckets[b] / count);
+    }
+}
+
+// Fungsi untuk menjalankan benchmark terhadap satu nameserver dengan laju tetap (open loop):
+// query dikirim sesuai jadwal QPS tanpa menunggu jawaban sebelumnya
+static void dns_bench_server(const char* label, const struct sockaddr_storage* addr, socklen_t addr_len,
+                             const struct dns_query_name* names, int name_count, const struct dns_bench_opts* o) {
+    int total = o->qps * o->seconds;
+    struct dns_bench_query* queries = calloc(total, sizeof(*queries));
+    int* id_owner = malloc(65536 * sizeof(int));
+    double* latencies = malloc(total * sizeof(double));
+    int fds[DNS_BENCH_MAX_CONNS];
+    struct { unsigned char buf[DNS_MAX_MESSAGE + 2]; size_t len; } *rx = calloc(o->conns, sizeof(*rx));
+    int conns = 0;
+
+    printf("\033[1;36m=================== DNS BENCH %s (%s) ===================\033[0m\n", label, o->tcp ? "TCP" : "UDP");
+    if (queries == NULL || id_owner == NULL || latencies == NULL || rx == NULL) goto out;
+    for (int i = 0; i < 65536; i++) id_owner[i] = -1;
+
+    for (; conns < o->conns; conns++) {
+        fds[conns] = dns_bench_connect(addr, addr_len, o->tcp, o->timeout_ms);
+        if (fds[conns] < 0) {
+            printf("Gagal terhubung ke %s: %s\n", label, strerror(errno));
+            goto out;
+        }
+    }
+
+    int sent = 0, answered = 0, timeouts = 0, send_errors = 0, truncated = 0, mismatched = 0;
+    int rcodes[16] = { 0 };
+    int next = 0, oldest = 0, latency_count = 0;
+    uint16_t next_id = (uint16_t)(getpid() ^ (unsigned int)now_ms());
+    double start = now_ms(), send_end = start;
+
+    while (oldest < total) {
+        double now = now_ms();
+
+        // Kirim semua query yang sudah jatuh tempo menurut jadwal QPS
+        int due = (int)((now - start) * o->qps / 1000.0) + 1;
+        if (due > total) due = total;
+        while (next < due) {
+            int tries = 0;
+            while (id_owner[next_id] >= 0 && tries++ < 65536) next_id++;
+            if (id_owner[next_id] >= 0) break;   // Semua ID sedang dipakai: tunggu jawaban/timeout
+
+            struct dns_bench_query* q = &queries[next];
+            const struct dns_query_name* qn = &names[next % name_count];
+            unsigned char packet[DNS_MAX_MESSAGE + 2];
+            int len = dns_build_query(packet + 2, DNS_MAX_MESSAGE, next_id, qn->name, qn->qtype);
+            q->conn = next % conns;
+            q->id = next_id;
+            q->sent_ms = now_ms();
+
+            ssize_t n = -1;
+            if (len > 0 && o->tcp) {
+                packet[0] = len >> 8;
+                packet[1] = len & 0xff;
+                n = send(fds[q->conn], packet, len + 2, MSG_NOSIGNAL | MSG_DONTWAIT);
+                if (n != len + 2) n = -1;
+            } else if (len > 0) {
+                n = send(fds[q->conn], packet + 2, len, MSG_DONTWAIT);
+            }
+            if (n < 0) {
+                q->state = 3;
+                send_errors++;
+            } else {
+                id_owner[next_id] = next;
+                sent++;
+            }
+            next_id++;
+            next++;
+        }
+        if (next == total && send_end == start) send_end = now_ms();
+
+        struct pollfd pfds[DNS_BENCH_MAX_CONNS];
+        for (int i = 0; i < conns; i++) {
+            pfds[i].fd = fds[i];
+            pfds[i].events = POLLIN;
+        }
+        poll(pfds, conns, next < total ? 1 : 5);
+
+        now = now_ms();
+        for (int c = 0; c < conns; c++) {
+            if (!(pfds[c].revents & POLLIN)) continue;
+            for (;;) {
+                unsigned char* msg;
+                size_t msg_len;
+                if (o->tcp) {
+                    // TCP: kumpulkan byte lalu pecah per bingkai panjang 2 byte
+                    ssize_t n = recv(fds[c], rx[c].buf + rx[c].len, sizeof(rx[c].buf) - rx[c].len, MSG_DONTWAIT);
+                    if (n <= 0) break;
+                    rx[c].len += n;
+                } else {
+                    ssize_t n = recv(fds[c], rx[c].buf, sizeof(rx[c].buf), MSG_DONTWAIT);
+                    if (n <= 0) break;
+                    rx[c].len = n;
+                }
+
+                size_t off = 0;
+                for (;;) {
+                    if (o->tcp) {
+                        if (rx[c].len - off < 2) break;
+                        msg_len = rx[c].buf[off] << 8 | rx[c].buf[off + 1];
+                        if (rx[c].len - off - 2 < msg_len) break;
+                        msg = rx[c].buf + off + 2;
+                        off += 2 + msg_len;
+                    } else {
+                        if (off > 0) break;
+                        msg = rx[c].buf;
+                        msg_len = rx[c].len;
+                        off = rx[c].len;
+                    }
+                    if (msg_len < 12) continue;
+
+                    int id = msg[0] << 8 | msg[1];
+                    int qi = id_owner[id];
+                    if (qi < 0 || queries[qi].conn != c || !(msg[2] & 0x80)) {
+                        mismatched++;
+                        continue;
+                    }
+                    id_owner[id] = -1;
+                    queries[qi].state = 1;
+                    answered++;
+                    rcodes[msg[3] & 0x0f]++;
+                    if (msg[2] & 0x02) truncated++;
+                    latencies[latency_count++] = now - queries[qi].sent_ms;
+                }
+                memmove(rx[c].buf, rx[c].buf + off, rx[c].len - off);
+                rx[c].len -= off;
+            }
+        }
+
+        // Query tertua yang melewati batas waktu dihitung timeout dan ID-nya dibebaskan
+        while (oldest < next && (queries[oldest].state != 0 || now - queries[oldest].sent_ms >= o->timeout_ms)) {
+            if (queries[oldest].state == 0) {
+                queries[oldest].state = 2;
+                id_owner[queries[oldest].id] = -1;
+                timeouts++;
+            }
+            oldest++;
+        }
+    }
+
+    double send_seconds = (send_end - start) / 1000.0;
+    printf("Target      : %d qps selama %d detik, %d nama, %d koneksi\n", o->qps, o->seconds, name_count, conns);
+    printf("Terkirim    : %d (%.1f qps tercapai), dijawab %d", sent, send_seconds > 0 ? sent / send_seconds : 0.0, answered);
+    if (send_errors > 0) printf(", \033[1;31mgagal kirim %d\033[0m", send_errors);
+    if (mismatched > 0) printf(", jawaban tak dikenal %d", mismatched);
+    printf("\n");
+
+    int others = answered - rcodes[DNS_RCODE_NOERROR] - rcodes[DNS_RCODE_SERVFAIL] - rcodes[DNS_RCODE_NXDOMAIN] -
+                 rcodes[DNS_RCODE_REFUSED];
+    double servfail_pct = sent > 0 ? 100.0 * rcodes[DNS_RCODE_SERVFAIL] / sent : 0;
+    double timeout_pct = sent > 0 ? 100.0 * timeouts / sent : 0;
+    printf("Rcode       : NOERROR %d, NXDOMAIN %d, REFUSED %d, lainnya %d\n",
+           rcodes[DNS_RCODE_NOERROR], rcodes[DNS_RCODE_NXDOMAIN], rcodes[DNS_RCODE_REFUSED], others);
+    printf("SERVFAIL    : %s%d (%.2f%%)\033[0m\n", servfail_pct > 0 ? "\033[1;31m" : "\033[1;32m",
+           rcodes[DNS_RCODE_SERVFAIL], servfail_pct);
+    printf("Timeout     : %s%d (%.2f%%)\033[0m (batas %d ms)", timeout_pct > 0 ? "\033[1;31m" : "\033[1;32m",
+           timeouts, timeout_pct, o->timeout_ms);
+    if (truncated > 0) printf(", truncated %d", truncated);
+    printf("\n");
+
+    if (latency_count > 0) {
+        qsort(latencies, latency_count, sizeof(double), compare_doubles);
+        printf("Latensi     : min %.3f  p50 %.3f  p90 %.3f  p99 %.3f  maks %.3f ms\n", latencies[0],
+               latencies[latency_count / 2], latencies[(int)(latency_count * 0.9)],
+               latencies[(int)(latency_count * 0.99)], latencies[latency_count - 1]);
+        print_latency_histogram(latencies, latency_count);
+    }
+
+out:
+    for (int i = 0; i < conns; i++) close(fds[i]);
+    free(rx);
+    free(queries);
+    free(id_owner);
+    free(latencies);
+}
+
+// Fungsi untuk membuka socket UDP dan TCP responder di port yang sama (port 0 = pilih acak)
+static int open_dns_listeners(const char* bind_addr, int* port, int* udp_fd, int* tcp_fd) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    if (inet_pton(AF_INET, bind_addr, &addr.sin_addr) != 1) {
+        printf("Alamat tidak valid: %s\n", bind_addr);
+        return -1;
+    }
+
+    // Port acak UDP bisa saja sudah dipakai di TCP; coba beberapa kali
+    for (int attempt = 0; attempt < 8; attempt++) {
+        addr.sin_port = htons(*port);
+        *udp_fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (*udp_fd < 0 || bind(*udp_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            perror("bind UDP");
+            if (*udp_fd >= 0) close(*udp_fd);
+            return -1;
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(*udp_fd, (struct sockaddr*)&addr, &len);
+        int bound_port = ntohs(addr.sin_port);
+
+        *tcp_fd = open_tcp_listener(bind_addr, bound_port);
+        if (*tcp_fd >= 0) {
+            *port = bound_port;
+            return 0;
+        }
+        close(*udp_fd);
+        if (*port != 0) return -1;
+        addr.sin_port = 0;
+    }
+    return -1;
+}
+
+// Fungsi untuk menjalankan responder DNS di proses anak
+static pid_t fork_dns_responder(int udp_fd, int tcp_fd, const struct dns_db* db) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        run_dns_responder(udp_fd, tcp_fd, db);
+        _exit(0);
+    } else if (pid < 0) {
+        perror("fork");
+    }
+    close(udp_fd);
+    close(tcp_fd);
+    return pid;
+}
+
+// Fungsi untuk membebaskan database responder
+static void dns_free_db(struct dns_db* db) {
+    free(db->entries);
+    free(db->zones);
+    db->entries = NULL;
+    db->zones = NULL;
+}
+
+pid_t dns_server_pid = 0;
+pid_t dns_server_owner = 0;         // Proses shell yang menjalankan responder
+char dns_server_addr[128] = "";
+
+// Fungsi untuk menghentikan responder DNS yang berjalan di latar belakang (hanya dari proses pemiliknya)
+void stop_dns_server() {
+    if (dns_server_pid > 0 && getpid() == dns_server_owner) {
+        kill(dns_server_pid, SIGTERM);
+        waitpid(dns_server_pid, NULL, 0);
+        dns_server_pid = 0;
+        dns_server_addr[0] = '\0';
+    }
+}
+
+// Fungsi untuk memuat zona responder: zona "setup dns" di direktori, atau zona sintetis bench.test
+static void load_responder_zones(struct dns_plan* zones, const char* dir) {
+    snprintf(zones->dir, sizeof(zones->dir), "%s", dir);
+    if (load_dns_zones(zones, dir) != 0 || zones->count == 0) {
+        dns_free_plan(zones);
+        dns_synthetic_zones(zones);
+    }
+}
+
+// Fungsi untuk menjalankan "dns serve": responder otoritatif bawaan di latar belakang
+void start_dns_server(char** args) {
+    if (args[0] != NULL && strcmp(args[0], "stop") == 0) {
+        if (dns_server_pid == 0) {
+            printf("Responder DNS tidak berjalan.\n");
+            return;
+        }
+        stop_dns_server();
+        printf("Responder DNS dihentikan.\n");
+        return;
+    }
+    if (dns_server_pid > 0) {
+        printf("Responder DNS sudah berjalan di %s (pid %d). Gunakan 'dns serve stop' terlebih dahulu.\n",
+               dns_server_addr, dns_server_pid);
+        return;
+    }
+
+    int port = DNS_SERVE_DEFAULT_PORT;
+    const char* bind_addr = "127.0.0.1";
+    const char* dir = DNS_DEFAULT_DIR;
+    for (int i = 0; args[i] != NULL; i++) {
+        if (strcmp(args[i], "--port") == 0 && args[i + 1] != NULL) port = atoi(args[++i]);
+        else if (strcmp(args[i], "--bind") == 0 && args[i + 1] != NULL) bind_addr = args[++i];
+        else if (strcmp(args[i], "--dir") == 0 && args[i + 1] != NULL) dir = args[++i];
+    }
+
+    struct dns_plan zones = { 0 };
+    struct dns_db db;
+    load_responder_zones(&zones, dir);
+    dns_db_from_plan(&db, &zones);
+
+    int udp_fd, tcp_fd;
+    if (open_dns_listeners(bind_addr, &port, &udp_fd, &tcp_fd) == 0) {
+        pid_t pid = fork_dns_responder(udp_fd, tcp_fd, &db);
+        if (pid > 0) {
+            dns_server_pid = pid;
+            dns_server_owner = getpid();
+            static int stop_registered = 0;
+            if (!stop_registered) {
+                atexit(stop_dns_server);
+                stop_registered = 1;
+            }
+            snprintf(dns_server_addr, sizeof(dns_server_addr), "%s:%d", bind_addr, port);
+            printf("Responder DNS berjalan di %s UDP/TCP (pid %d): %d zona, %d record\n",
+                   dns_server_addr, pid, zones.count, db.count);
+        }
+    }
+    dns_free_db(&db);
+    dns_free_plan(&zones);
+}
+
+// Fungsi untuk menjalankan "dns bench": benchmark latensi resolver dengan laju tetap
+void dns_bench(char** args) {
+    struct dns_bench_opts o = { DNS_BENCH_DEFAULT_QPS, DNS_BENCH_DEFAULT_SECONDS, 0, DNS_BENCH_DEFAULT_TIMEOUT_MS, 0 };
+    const char* names_file = NULL;
+    const char* dir = DNS_DEFAULT_DIR;
+    const char* servers[DNS_BENCH_MAX_SERVERS];
+    int server_count = 0, local = 0;
+
+    for (int i = 0; args[i] != NULL; i++) {
+        if (strcmp(args[i], "local") == 0) local = 1;
+        else if (strcmp(args[i], "--qps") == 0 && args[i + 1] != NULL) o.qps = atoi(args[++i]);
+        else if (strcmp(args[i], "-t") == 0 && args[i + 1] != NULL) o.seconds = atoi(args[++i]);
+        else if (strcmp(args[i], "-c") == 0 && args[i + 1] != NULL) o.conns = atoi(args[++i]);
+        else if (strcmp(args[i], "--timeout") == 0 && args[i + 1] != NULL) o.timeout_ms = atoi(args[++i]);
+        else if (strcmp(args[i], "--tcp") == 0) o.tcp = 1;
+        else if (strcmp(args[i], "--names") == 0 && args[i + 1] != NULL) names_file = args[++i];
+        else if (strcmp(args[i], "--dir") == 0 && args[i + 1] != NULL) dir = args[++i];
+        else if (args[i][0] != '-' && server_count < DNS_BENCH_MAX_SERVERS) servers[server_count++] = args[i];
+        else {
+            printf("Penggunaan: dns bench [local | server[:port]...] [--qps N] [-t detik] [--tcp] [-c koneksi]\n");
+            printf("                      [--timeout ms] [--names file] [--dir direktori-bind]\n");
+            return;
+        }
+    }
+    if (local && server_count >= DNS_BENCH_MAX_SERVERS) {
+        printf("dns bench: paling banyak %d server, termasuk 'local'.\n", DNS_BENCH_MAX_SERVERS);
+        return;
+    }
+    if (o.qps < 1) o.qps = DNS_BENCH_DEFAULT_QPS;
+    if (o.qps > DNS_BENCH_MAX_QPS) o.qps = DNS_BENCH_MAX_QPS;
+    if (o.seconds < 1) o.seconds = DNS_BENCH_DEFAULT_SECONDS;
+    if (o.timeout_ms < 1) o.timeout_ms = DNS_BENCH_DEFAULT_TIMEOUT_MS;
+    if (o.conns < 1) o.conns = o.tcp ? DNS_BENCH_DEFAULT_TCP_CONNS : 1;
+    if (o.conns > DNS_BENCH_MAX_CONNS) o.conns = DNS_BENCH_MAX_CONNS;
+
+    // Sumber nama: file, zona hasil "setup dns", atau zona responder lokal
+    struct dns_plan zones = { 0 };
+    struct dns_query_name* names = NULL;
+    int name_count = 0, name_capacity = 0;
+    if (local) {
+        load_responder_zones(&zones, dir);
+    } else {
+        snprintf(zones.dir, sizeof(zones.dir), "%s", dir);
+        load_dns_zones(&zones, dir);
+    }
+    if (names_file != NULL) {
+        if (load_query_names(names_file, &names, &name_count, &name_capacity) != 0) {
+            dns_free_plan(&zones);
+            return;
+        }
+    } else {
+        query_names_from_plan(&zones, &names, &name_count, &name_capacity);
+    }
+    if (name_count == 0) {
+        printf("Tidak ada nama untuk di-query: gunakan --names <file> atau jalankan 'setup dns' terlebih dahulu.\n");
+        free(names);
+        dns_free_plan(&zones);
+        return;
+    }
+
+    // Mode lokal: responder bawaan di port acak loopback, tanpa bind9 maupun jaringan
+    pid_t local_pid = 0;
+    char local_addr[64];
+    if (local) {
+        struct dns_db db;
+        int port = 0, udp_fd, tcp_fd;
+        dns_db_from_plan(&db, &zones);
+        if (open_dns_listeners("127.0.0.1", &port, &udp_fd, &tcp_fd) == 0) {
+            local_pid = fork_dns_responder(udp_fd, tcp_fd, &db);
+        }
+        dns_free_db(&db);
+        if (local_pid <= 0) {
+            free(names);
+            dns_free_plan(&zones);
+            return;
+        }
+        snprintf(local_addr, sizeof(local_addr), "127.0.0.1:%d", port);
+        servers[server_count++] = local_addr;
+        printf("Responder lokal di %s: %d zona\n", local_addr, zones.count);
+    }
+
+    // Tanpa server eksplisit: semua nameserver di /etc/resolv.conf
+    char resolv_servers[DNS_BENCH_MAX_SERVERS][INET6_ADDRSTRLEN + 8];
+    if (server_count == 0) {
+        char* resolv = read_whole_file("/etc/resolv.conf", NULL);
+        for (char* line = resolv != NULL ? strtok(resolv, "\n") : NULL; line != NULL && server_count < DNS_BENCH_MAX_SERVERS;
+             line = strtok(NULL, "\n")) {
+            if (sscanf(line, "nameserver %45s", resolv_servers[server_count]) == 1) {
+                servers[server_count] = resolv_servers[server_count];
+                server_count++;
+            }
+        }
+        free(resolv);
+        if (server_count == 0) printf("Tidak ada nameserver di /etc/resolv.conf.\n");
+    }
+
+    for (int i = 0; i < server_count; i++) {
+        struct sockaddr_storage addr;
+        socklen_t addr_len;
+        if (parse_server_addr(servers[i], &addr, &addr_len) != 0) {
+            printf("Alamat nameserver tidak valid: %s\n", servers[i]);
+            continue;
+        }
+        dns_bench_server(servers[i], &addr, addr_len, names, name_count, &o);
+    }
+
+    if (local_pid > 0) {
+        kill(local_pid, SIGTERM);
+        waitpid(local_pid, NULL, 0);
+    }
+    free(names);
+    dns_free_plan(&zones);
+}
+
+// ==================== saring: pencarian teks (grep) bawaan ====================
+
+// Pencari literal: byte pertama dan terakhir needle dibandingkan di 16 posisi sekaligus (SSE2),
+// perbandingan penuh hanya untuk kandidat. Dengan icase, needle disimpan huruf kecil.
+struct literal_finder {
+    char needle[SARING_MAX_LITERAL];
+    size_t len;
+    int icase;
+};
+
+static void literal_finder_init(struct literal_finder* f, const char* s, size_t len, int icase) {
+    if (len >= sizeof(f->needle)) len = sizeof(f->needle) - 1;
+    for (size_t i = 0; i < len; i++) f->needle[i] = icase ? tolower((unsigned char)s[i]) : s[i];
+    f->needle[len] = '\0';
+    f->len = len;
+    f->icase = icase;
+}
+
+static int literal_equal(const struct literal_finder* f, const char* p) {
+    if (!f->icase) return memcmp(p, f->needle, f->len) == 0;
+    for (size_t i = 0; i < f->len; i++) {
+        if (tolower((unsigned char)p[i]) != (unsigned char)f->needle[i]) return 0;
+    }
+    return 1;
+}
+
+// Fungsi untuk mencari kemunculan pertama needle di [hay, end); NULL jika tidak ada
+static const char* find_literal(const struct literal_finder* f, const char* hay, const char* end) {
+    size_t n = f->len;
+    if ((size_t)(end - hay) < n) return NULL;
+    if (n == 0) return hay;
+    const char* last = end - n;     // Posisi awal terakhir yang mungkin
+    const char* p = hay;
+    unsigned char first = f->needle[0], tail = f->needle[n - 1];
+#if defined(__SSE2__)
+    __m128i first_lo = _mm_set1_epi8((char)first), first_up = _mm_set1_epi8((char)toupper(first));
+    __m128i tail_lo = _mm_set1_epi8((char)tail), tail_up = _mm_set1_epi8((char)toupper(tail));
+    if (!f->icase) {
+        first_up = first_lo;
+        tail_up = tail_lo;
+    }
+    for (; p + 15 <= last; p += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)p);
+        __m128i b = _mm_loadu_si128((const __m128i*)(p + n - 1));
+        __m128i ma = _mm_or_si128(_mm_cmpeq_epi8(a, first_lo), _mm_cmpeq_epi8(a, first_up));
+        __m128i mb = _mm_or_si128(_mm_cmpeq_epi8(b, tail_lo), _mm_cmpeq_epi8(b, tail_up));
+        unsigned int mask = _mm_movemask_epi8(_mm_and_si128(ma, mb));
+        while (mask != 0) {
+            int bit = __builtin_ctz(mask);
+            if (literal_equal(f, p + bit)) return p + bit;
+            mask &= mask - 1;
+        }
+    }
+#else
+    if (!f->icase) return memmem(hay, end - hay, f->needle, n);
+#endif
+    for (; p <= last; p++) {
+        if ((f->icase ? tolower((unsigned char)*p) : (unsigned char)*p) == first && literal_equal(f, p)) return p;
+    }
+    return NULL;
+}
+
+// Fungsi untuk mengambil literal terpanjang yang wajib ada di setiap kecocokan regex ERE.
+// Konservatif: tidak ada literal untuk pola dengan '|', isi kurung () juga dilewati.
+static size_t required_literal(const char* re, char* out, size_t size) {
+    char run[SARING_MAX_LITERAL];
+    size_t run_len = 0, best = 0;
+    int depth = 0;
+
+    for (const char* p = re; *p != '\0'; p++) {
+        char c = *p;
+        int literal = 0;
+        if (c == '\\' && p[1] != '\0') {
+            p++;
+            c = *p;
+            literal = strchr("wWsSbB<>`'0123456789", c) == NULL;
+        } else if (c == '|') {
+            return 0;
+        } else if (c == '[') {
+            // Lewati kelas karakter, termasuk ']' pertama yang literal
+            p++;
+            if (*p == '^') p++;
+            if (*p == ']') p++;
+            while (*p != '\0' && *p != ']') p++;
+            if (*p == '\0') return 0;
+        } else if (c == '(') {
+            depth++;
+        } else if (c == ')') {
+            depth--;
+        } else if (c == '{') {
+            while (p[1] != '\0' && *p != '}') p++;
+        } else {
+            literal = strchr(".^$*+?", c) == NULL;
+        }
+
+        // Karakter yang diikuti ?, * atau {..} boleh tidak muncul; '+' tetap wajib tetapi mengakhiri run
+        char next = p[1];
+        int optional = next == '?' || next == '*' || next == '{';
+        if (literal && depth == 0 && !optional && run_len < sizeof(run) - 1) run[run_len++] = c;
+        if (!literal || depth != 0 || optional || next == '+') {
+            if (run_len > best && run_len < size) {
+                memcpy(out, run, run_len);
+                best = run_len;
+            }
+            run_len = 0;
+        }
+    }
+    if (run_len > best && run_len < size) {
+        memcpy(out, run, run_len);
+        best = run_len;
+    }
+    out[best] = '\0';
+    return best;
+}
+
+// Pola dan opsi "saring" yang sudah dikompilasi (dibagi antar thread, hanya dibaca)
+struct saring_spec {
+    int icase, count_only, line_numbers, list_files, fixed;
+    int show_names;
+    int use_regex;
+    regex_t re;
+    struct literal_finder lit;  // Prefilter; len 0 = tidak ada literal wajib
+};
+
+// Hasil satu input
+struct saring_result {
+    struct text_buffer out;
+    long long matches;
+    int error;
+    int closed;                 // Pembaca output sudah berhenti (EPIPE)
+};
+
+// Fungsi untuk menambahkan data mentah ke text_buffer
+static void buf_append(struct text_buffer* b, const char* data, size_t len) {
+    if (b->len + len + 1 > b->capacity) {
+        size_t capacity = b->capacity ? b->capacity : 4096;
+        while (capacity < b->len + len + 1) capacity *= 2;
+        char* grown = realloc(b->data, capacity);
+        if (grown == NULL) return;
+        b->data = grown;
+        b->capacity = capacity;
+    }
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+    b->data[b->len] = '\0';
+}
+
+// Fungsi untuk menghitung newline di [p, end)
+static long long count_newlines(const char* p, const char* end) {
+    long long n = 0;
+    while (p < end && (p = memchr(p, '\n', end - p)) != NULL) {
+        n++;
+        p++;
+    }
+    return n;
+}
+
+// Fungsi untuk mencari di satu blok baris utuh. line_base = nomor baris sebelum blok.
+// Mengembalikan 1 jika pencarian boleh berhenti (-l sudah cocok).
+static int saring_block(const struct saring_spec* s, const char* data, size_t len, const char* label,
+                        long long line_base, struct saring_result* r) {
+    const char* p = data;
+    const char* end = data + len;
+    const char* counted = data;
+    long long line = line_base;
+
+    while (p < end) {
+        const char* line_start;
+        const char* line_end;
+        if (s->lit.len > 0) {
+            const char* hit = find_literal(&s->lit, p, end);
+            if (hit == NULL) break;
+            line_start = memrchr(p, '\n', hit - p);
+            line_start = line_start != NULL ? line_start + 1 : p;
+            line_end = memchr(hit, '\n', end - hit);
+        } else {
+            line_start = p;
+            line_end = memchr(p, '\n', end - p);
+        }
+        if (line_end == NULL) line_end = end;
+        p = line_end + 1;
+
+        if (s->use_regex) {
+            regmatch_t m[1];
+            m[0].rm_so = 0;
+            m[0].rm_eo = line_end - line_start;
+            if (regexec(&s->re, line_start, 1, m, REG_STARTEND) != 0) continue;
+        }
+
+        r->matches++;
+        if (s->list_files) return 1;
+        if (s->count_only) continue;
+        if (s->show_names) {
+            buf_append(&r->out, label, strlen(label));
+            buf_append(&r->out, ":", 1);
+        }
+        if (s->line_numbers) {
+            line += count_newlines(counted, line_start);
+            counted = line_start;
+            buf_printf(&r->out, "%lld:", line + 1);
+        }
+        buf_append(&r->out, line_start, line_end - line_start);
+        buf_append(&r->out, "\n", 1);
+    }
+    return 0;
+}
+
+// Fungsi untuk menulis seluruh buffer ke fd; -1 jika gagal (mis. pipe ditutup pembaca)
+static int write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        data += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// Fungsi untuk mencari di input yang tidak bisa di-mmap (pipe/stdin): dibaca per chunk besar,
+// hanya baris utuh yang diproses; sisa baris terakhir dibawa ke chunk berikutnya.
+// Jika out_fd >= 0, hasil ditulis langsung per chunk (tidak ditampung).
+static void saring_stream(const struct saring_spec* s, int fd, const char* label, struct saring_result* r, int out_fd) {
+    size_t capacity = SARING_CHUNK, len = 0;
+    char* buf = malloc(capacity);
+    long long line_base = 0;
+    int eof = 0;
+    if (buf == NULL) {
+        r->error = 1;
+        return;
+    }
+    while (!eof) {
+        if (len == capacity) {
+            char* grown = realloc(buf, capacity * 2);
+            if (grown == NULL) break;
+            buf = grown;
+            capacity *= 2;
+        }
+        ssize_t n = read(fd, buf + len, capacity - len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            fprintf(stderr, "saring: %s: %s\n", label, strerror(errno));
+            r->error = 1;
+            break;
+        }
+        if (n == 0) eof = 1;
+        len += n;
+
+        char* last_nl = len > 0 ? memrchr(buf, '\n', len) : NULL;
+        size_t block = eof ? len : last_nl != NULL ? (size_t)(last_nl - buf) + 1 : 0;
+        if (block == 0) continue;
+        if (saring_block(s, buf, block, label, line_base, r)) break;
+        if (s->line_numbers) line_base += count_newlines(buf, buf + block);
+        memmove(buf, buf + block, len - block);
+        len -= block;
+
+        if (out_fd >= 0 && r->out.len > 0) {
+            if (write_all(out_fd, r->out.data, r->out.len) != 0) {
+                r->closed = 1;
+                break;
+            }
+            r->out.len = 0;
+        }
+    }
+    free(buf);
+}
+
+// Fungsi untuk mencari di file yang di-mmap per blok baris utuh, supaya hasil untuk satu
+// file besar bisa dialirkan ke out_fd (jika >= 0) tanpa ditampung seluruhnya
+static void saring_mapped(const struct saring_spec* s, const char* data, size_t len, const char* label,
+                          struct saring_result* r, int out_fd) {
+    size_t offset = 0;
+    long long line_base = 0;
+    while (offset < len) {
+        size_t block = len - offset;
+        if (block > SARING_CHUNK * 4) {
+            const char* nl = memchr(data + offset + SARING_CHUNK * 4, '\n', len - offset - SARING_CHUNK * 4);
+            block = nl != NULL ? (size_t)(nl - (data + offset)) + 1 : len - offset;
+        }
+        if (saring_block(s, data + offset, block, label, line_base, r)) return;
+        if (s->line_numbers) line_base += count_newlines(data + offset, data + offset + block);
+        offset += block;
+
+        if (out_fd >= 0 && r->out.len > 0) {
+            if (write_all(out_fd, r->out.data, r->out.len) != 0) {
+                r->closed = 1;
+                return;
+            }
+            r->out.len = 0;
+        }
+    }
+}
+
+// Fungsi untuk mencari di satu file: file biasa di-mmap, selain itu dibaca per chunk
+static void saring_file(const struct saring_spec* s, const char* path, struct saring_result* r, int out_fd) {
+    int fd = strcmp(path, "-") == 0 ? dup(STDIN_FILENO) : open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "saring: %s: %s\n", path, strerror(errno));
+        r->error = 1;
+        if (fd >= 0) close(fd);
+        return;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        fprintf(stderr, "saring: %s: Is a directory\n", path);
+        r->error = 1;
+    } else if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        char* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            saring_stream(s, fd, path, r, out_fd);
+        } else {
+            madvise(data, st.st_size, MADV_SEQUENTIAL);
+            saring_mapped(s, data, st.st_size, path, r, out_fd);
+            munmap(data, st.st_size);
+        }
+    } else if (!S_ISREG(st.st_mode)) {
+        saring_stream(s, fd, path, r, out_fd);
+    }
+    close(fd);
+
+    if (r->closed) return;
+    if (s->count_only) {
+        if (s->show_names) buf_printf(&r->out, "%s:", path);
+        buf_printf(&r->out, "%lld\n", r->matches);
+    } else if (s->list_files && r->matches > 0) {
+        buf_printf(&r->out, "%s\n", path);
+    }
+}
+
+// Pembagian file ke thread: indeks berikutnya diambil bergiliran, hasil ditulis sesuai urutan argumen
+struct saring_job {
+    const struct saring_spec* spec;
+    char** files;
+    int count;
+    int next;
+    struct saring_result* results;
+    int* done;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+static int saring_job_step(struct saring_job* j) {
+    int i = __atomic_fetch_add(&j->next, 1, __ATOMIC_RELAXED);
+    if (i >= j->count) return 0;
+    saring_file(j->spec, j->files[i], &j->results[i], -1);
+    pthread_mutex_lock(&j->lock);
+    j->done[i] = 1;
+    pthread_cond_broadcast(&j->cond);
+    pthread_mutex_unlock(&j->lock);
+    return 1;
+}
+
+static void* saring_worker(void* arg) {
+    while (saring_job_step(arg)) {}
+    return NULL;
+}
+
+// Fungsi builtin "saring" (grep): bisa dipanggil langsung atau sebagai tahap pipeline di thread
+// shell dengan fd input/output sendiri. Mengembalikan status keluar seperti grep (0/1/2).
+int saring_run(char** args, int in_fd, int out_fd) {
+    struct saring_spec s;
+    memset(&s, 0, sizeof(s));
+    int workers = work_pool_default_workers();
+    int i = 1;
+    int with_names = -1;
+    for (; args[i] != NULL && args[i][0] == '-' && args[i][1] != '\0'; i++) {
+        if (strcmp(args[i], "--") == 0) {
+            i++;
+            break;
+        }
+        if (strcmp(args[i], "-j") == 0 && args[i + 1] != NULL) {
+            workers = atoi(args[++i]) - 1;
+            continue;
+        }
+        for (const char* f = args[i] + 1; *f != '\0'; f++) {
+            if (*f == 'i') s.icase = 1;
+            else if (*f == 'c') s.count_only = 1;
+            else if (*f == 'n') s.line_numbers = 1;
+            else if (*f == 'l') s.list_files = 1;
+            else if (*f == 'F') s.fixed = 1;
+            else if (*f == 'H') with_names = 1;
+            else if (*f == 'h') with_names = 0;
+            else {
+                fprintf(stderr, "Penggunaan: saring [-i] [-c] [-n] [-l] [-F] [-H|-h] [-j thread] <pola> [file...]\n");
+                return 2;
+            }
+        }
+    }
+    if (args[i] == NULL) {
+        fprintf(stderr, "Penggunaan: saring [-i] [-c] [-n] [-l] [-F] [-H|-h] [-j thread] <pola> [file...]\n");
+        return 2;
+    }
+    const char* pattern = args[i++];
+    char** files = args + i;
+    int file_count = 0;
+    while (files[file_count] != NULL) file_count++;
+    s.show_names = with_names >= 0 ? with_names : file_count > 1;
+
+    // Pola tanpa karakter regex dicari sebagai literal saja; selain itu literal wajibnya dipakai
+    // sebagai prefilter sebelum regexec per baris
+    char literal[SARING_MAX_LITERAL];
+    size_t literal_len;
+    if (s.fixed || strpbrk(pattern, "\\.[]()*+?{}|^$") == NULL) {
+        literal_len = strlen(pattern);
+        if (literal_len >= SARING_MAX_LITERAL) {
+            fprintf(stderr, "saring: pola literal terlalu panjang (maks %d)\n", SARING_MAX_LITERAL - 1);
+            return 2;
+        }
+        memcpy(literal, pattern, literal_len + 1);
+    } else {
+        literal_len = required_literal(pattern, literal, sizeof(literal));
+        int rc = regcomp(&s.re, pattern, REG_EXTENDED | REG_NOSUB | (s.icase ? REG_ICASE : 0));
+        if (rc != 0) {
+            char err[256];
+            regerror(rc, &s.re, err, sizeof(err));
+            fprintf(stderr, "saring: pola tidak valid: %s\n", err);
+            return 2;
+        }
+        s.use_regex = 1;
+    }
+    literal_finder_init(&s.lit, literal, literal_len, s.icase);
+
+    long long total = 0;
+    int errors = 0;
+    if (file_count <= 1) {
+        // Satu input: hasil dialirkan langsung tanpa ditampung
+        struct saring_result r;
+        memset(&r, 0, sizeof(r));
+        if (file_count == 0) {
+            saring_stream(&s, in_fd, "(standard input)", &r, out_fd);
+            if (s.count_only) buf_printf(&r.out, "%lld\n", r.matches);
+            else if (s.list_files && r.matches > 0) buf_printf(&r.out, "(standard input)\n");
+        } else {
+            saring_file(&s, files[0], &r, out_fd);
+        }
+        if (!r.closed && r.out.len > 0) write_all(out_fd, r.out.data, r.out.len);
+        free(r.out.data);
+        total = r.matches;
+        errors = r.error;
+    } else {
+        struct saring_job j;
+        memset(&j, 0, sizeof(j));
+        j.spec = &s;
+        j.files = files;
+        j.count = file_count;
+        j.results = calloc(file_count, sizeof(*j.results));
+        j.done = calloc(file_count, sizeof(int));
+        pthread_mutex_init(&j.lock, NULL);
+        pthread_cond_init(&j.cond, NULL);
+
+        if (workers > file_count - 1) workers = file_count - 1;
+        if (workers > WORK_POOL_MAX_WORKERS) workers = WORK_POOL_MAX_WORKERS;
+        pthread_t threads[WORK_POOL_MAX_WORKERS];
+        int started = 0;
+        if (j.results != NULL && j.done != NULL) {
+            for (; started < workers; started++) {
+                if (pthread_create(&threads[started], NULL, saring_worker, &j) != 0) break;
+            }
+            // Thread pemanggil ikut mengerjakan file dan menulis hasil sesuai urutan argumen
+            for (int w = 0; w < file_count; w++) {
+                pthread_mutex_lock(&j.lock);
+                while (!j.done[w]) {
+                    pthread_mutex_unlock(&j.lock);
+                    if (!saring_job_step(&j)) {
+                        pthread_mutex_lock(&j.lock);
+                        while (!j.done[w]) pthread_cond_wait(&j.cond, &j.lock);
+                        break;
+                    }
+                    pthread_mutex_lock(&j.lock);
+                }
+                pthread_mutex_unlock(&j.lock);
+
+                struct saring_result* r = &j.results[w];
+                total += r->matches;
+                errors |= r->error;
+                if (r->out.len > 0 && write_all(out_fd, r->out.data, r->out.len) != 0) {
+                    // Pembaca sudah berhenti: file yang belum diambil tidak perlu dicari
+                    __atomic_store_n(&j.next, file_count, __ATOMIC_RELAXED);
+                    break;
+                }
+            }
+            for (int t = 0; t < started; t++) pthread_join(threads[t], NULL);
+            for (int w = 0; w < file_count; w++) free(j.results[w].out.data);
+        }
+        pthread_mutex_destroy(&j.lock);
+        pthread_cond_destroy(&j.cond);
+        free(j.results);
+        free(j.done);
+    }
+
+    if (s.use_regex) regfree(&s.re);
+    if (errors && total == 0) return 2;
+    return total > 0 ? 0 : 1;
+}
+
+// ==================== hitung: penghitung baris/kata/byte (wc) bawaan ====================
+
+// Hasil hitungan satu input
+struct text_counts {
+    long long lines, words, bytes;
+};
+
+// Kernel penghitung: in_space = apakah byte sebelum blok adalah spasi (awal input dianggap spasi).
+// Kata dihitung dari awalnya, yaitu byte bukan spasi yang didahului spasi (spasi: ' ' dan \t..\r).
+typedef void (*count_kernel)(const unsigned char* p, size_t len, int words, int* in_space, struct text_counts* c);
+
+static void count_scalar(const unsigned char* p, size_t len, int words, int* in_space, struct text_counts* c) {
+    int space = *in_space;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char b = p[i];
+        c->lines += b == '\n';
+        int is_space = b == ' ' || (unsigned char)(b - '\t') <= '\r' - '\t';
+        c->words += words & space & !is_space;
+        space = is_space;
+    }
+    *in_space = space;
+}
+
+#if defined(__SSE2__)
+// 16 byte per langkah: newline dihitung dengan akumulator per byte (dijumlah tiap 255 langkah),
+// awal kata dari bitmask spasi yang digeser satu posisi
+static void count_sse2(const unsigned char* p, size_t len, int words, int* in_space, struct text_counts* c) {
+    const __m128i nl = _mm_set1_epi8('\n'), sp = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t'), range = _mm_set1_epi8('\r' - '\t');
+    unsigned int carry = *in_space;
+    size_t i = 0;
+
+    while (i + 16 <= len) {
+        __m128i acc = _mm_setzero_si128();
+        size_t end = i + 16 * 255 <= len ? i + 16 * 255 : len - (len - i) % 16;
+        for (; i < end; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(v, nl));
+            if (words) {
+                __m128i shifted = _mm_sub_epi8(v, tab);
+                __m128i ctrl = _mm_cmpeq_epi8(_mm_min_epu8(shifted, range), shifted);
+                unsigned int space = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, sp), ctrl));
+                unsigned int starts = ~space & ((space << 1) | carry) & 0xFFFF;
+                c->words += __builtin_popcount(starts);
+                carry = space >> 15;
+            }
+        }
+        __m128i sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+        c->lines += _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+    }
+    int space = carry;
+    count_scalar(p + i, len - i, words, &space, c);
+    *in_space = space;
+}
+#endif
+
+#if defined(__x86_64__)
+// Varian AVX2 (32 byte per langkah), dipilih saat runtime jika CPU mendukung
+__attribute__((target("avx2")))
+static void count_avx2(const unsigned char* p, size_t len, int words, int* in_space, struct text_counts* c) {
+    const __m256i nl = _mm256_set1_epi8('\n'), sp = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t'), range = _mm256_set1_epi8('\r' - '\t');
+    unsigned int carry = *in_space;
+    size_t i = 0;
+
+    while (i + 32 <= len) {
+        __m256i acc = _mm256_setzero_si256();
+        size_t end = i + 32 * 255 <= len ? i + 32 * 255 : len - (len - i) % 32;
+        for (; i < end; i += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+            acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(v, nl));
+            if (words) {
+                __m256i shifted = _mm256_sub_epi8(v, tab);
+                __m256i ctrl = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, range), shifted);
+                unsigned int space = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, sp), ctrl));
+                unsigned int starts = ~space & ((space << 1) | carry);
+                c->words += __builtin_popcount(starts);
+                carry = space >> 31;
+            }
+        }
+        __m256i sums = _mm256_sad_epu8(acc, _mm256_setzero_si256());
+        c->lines += _mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1)
+                  + _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3);
+    }
+    int space = carry;
+    count_scalar(p + i, len - i, words, &space, c);
+    *in_space = space;
+}
+#endif
+
+// Fungsi untuk memilih kernel terbaik yang didukung CPU (sekali saja)
+static count_kernel select_count_kernel(void) {
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2")) return count_avx2;
+#endif
+#if defined(__SSE2__)
+    return count_sse2;
+#else
+    return count_scalar;
+#endif
+}
+
+// Potongan file yang dihitung satu thread
+struct count_part {
+    count_kernel kernel;
+    const unsigned char* data;
+    size_t len;
+    int words;
+    int in_space;
+    struct text_counts counts;
+};
+
+static void* count_part_thread(void* arg) {
+    struct count_part* part = arg;
+    part->kernel(part->data, part->len, part->words, &part->in_space, &part->counts);
+    return NULL;
+}
+
+// Fungsi untuk menghitung blok di memori dengan beberapa thread. Status spasi di awal tiap
+// potongan diambil dari byte sebelumnya, sehingga kata yang terpotong tidak terhitung dua kali.
+static void count_parallel(count_kernel kernel, const unsigned char* data, size_t len, int words,
+                           int workers, struct text_counts* c) {
+    struct count_part parts[WORK_POOL_MAX_WORKERS + 1];
+    pthread_t threads[WORK_POOL_MAX_WORKERS];
+    int count = workers + 1;
+    if ((size_t)count > len / HITUNG_MIN_PART) count = len / HITUNG_MIN_PART;
+    if (count < 1) count = 1;
+    if (count > WORK_POOL_MAX_WORKERS + 1) count = WORK_POOL_MAX_WORKERS + 1;
+
+    size_t step = len / count;
+    for (int i = 0; i < count; i++) {
+        size_t start = i * step;
+        parts[i].kernel = kernel;
+        parts[i].data = data + start;
+        parts[i].len = i == count - 1 ? len - start : step;
+        parts[i].words = words;
+        parts[i].in_space = start == 0 ? 1 : data[start - 1] == ' ' || (unsigned char)(data[start - 1] - '\t') <= '\r' - '\t';
+        memset(&parts[i].counts, 0, sizeof(parts[i].counts));
+    }
+    // Potongan 0 dikerjakan thread pemanggil; jika thread gagal dibuat, potongannya juga
+    int started[WORK_POOL_MAX_WORKERS + 1] = { 0 };
+    for (int i = 1; i < count; i++) {
+        started[i] = pthread_create(&threads[i - 1], NULL, count_part_thread, &parts[i]) == 0;
+    }
+    for (int i = 0; i < count; i++) {
+        if (i == 0 || !started[i]) count_part_thread(&parts[i]);
+        else pthread_join(threads[i - 1], NULL);
+        c->lines += parts[i].counts.lines;
+        c->words += parts[i].counts.words;
+    }
+}
+
+// Fungsi untuk menghitung dari fd yang tidak bisa di-mmap (pipe/stdin) per chunk
+static int count_stream(count_kernel kernel, int fd, int words, struct text_counts* c) {
+    unsigned char* buf = malloc(HITUNG_CHUNK);
+    int in_space = 1;
+    if (buf == NULL) return -1;
+    for (;;) {
+        ssize_t n = read(fd, buf, HITUNG_CHUNK);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            free(buf);
+            return -1;
+        }
+        if (n == 0) break;
+        kernel(buf, n, words, &in_space, c);
+        c->bytes += n;
+    }
+    free(buf);
+    return 0;
+}
+
+// Fungsi untuk menghitung satu file; file biasa di-mmap (atau cukup fstat jika hanya -c)
+static int count_file(count_kernel kernel, int fd, int need_scan, int words, int workers,
+                      struct text_counts* c) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return -1;
+    if (S_ISDIR(st.st_mode)) {
+        errno = EISDIR;
+        return -1;
+    }
+    if (!S_ISREG(st.st_mode)) return count_stream(kernel, fd, words, c);
+
+    c->bytes = st.st_size;
+    if (!need_scan || st.st_size == 0) return 0;
+    unsigned char* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        c->bytes = 0;
+        return count_stream(kernel, fd, words, c);
+    }
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    count_parallel(kernel, data, st.st_size, words, workers, c);
+    munmap(data, st.st_size);
+    return 0;
+}
+
+// Fungsi untuk menulis satu baris hasil seperti wc
+static void print_counts(struct text_buffer* out, const struct text_counts* c, int show[3], int width, const char* name) {
+    long long values[3] = { c->lines, c->words, c->bytes };
+    const char* sep = "";
+    for (int i = 0; i < 3; i++) {
+        if (!show[i]) continue;
+        buf_printf(out, "%s%*lld", sep, width, values[i]);
+        sep = " ";
+    }
+    if (name != NULL) buf_printf(out, " %s", name);
+    buf_printf(out, "\n");
+}
+
+// Fungsi builtin "hitung" (wc): bisa dipanggil langsung atau sebagai tahap pipeline di thread shell
+int hitung_run(char** args, int in_fd, int out_fd) {
+    int show[3] = { 0, 0, 0 };      // baris, kata, byte
+    int workers = work_pool_default_workers();
+    int i = 1;
+    for (; args[i] != NULL && args[i][0] == '-' && args[i][1] != '\0'; i++) {
+        if (strcmp(args[i], "--") == 0) {
+            i++;
+            break;
+        }
+        if (strcmp(args[i], "-j") == 0 && args[i + 1] != NULL) {
+            workers = atoi(args[++i]) - 1;
+            if (workers < 0) workers = 0;
+            if (workers > WORK_POOL_MAX_WORKERS) workers = WORK_POOL_MAX_WORKERS;
+            continue;
+        }
+        for (const char* f = args[i] + 1; *f != '\0'; f++) {
+            if (*f == 'l') show[0] = 1;
+            else if (*f == 'w') show[1] = 1;
+            else if (*f == 'c') show[2] = 1;
+            else {
+                fprintf(stderr, "Penggunaan: hitung [-l] [-w] [-c] [-j thread] [file...]\n");
+                return 2;
+            }
+        }
+    }
+    if (!show[0] && !show[1] && !show[2]) show[0] = show[1] = show[2] = 1;
+
+    static count_kernel kernel = NULL;
+    if (kernel == NULL) kernel = select_count_kernel();
+
+    char** files = args + i;
+    int file_count = 0;
+    while (files[file_count] != NULL) file_count++;
+    int inputs = file_count > 0 ? file_count : 1;
+    struct text_counts* counts = calloc(inputs + 1, sizeof(*counts));
+    int* failed = calloc(inputs, sizeof(int));
+    if (counts == NULL || failed == NULL) {
+        free(counts);
+        free(failed);
+        return 1;
+    }
+
+    int status = 0;
+    for (int f = 0; f < inputs; f++) {
+        int fd = file_count == 0 ? in_fd : strcmp(files[f], "-") == 0 ? dup(in_fd) : open(files[f], O_RDONLY | O_CLOEXEC);
+        if (fd < 0 || count_file(kernel, fd, show[0] || show[1], show[1], workers, &counts[f]) != 0) {
+            fprintf(stderr, "hitung: %s: %s\n", file_count ? files[f] : "(stdin)", strerror(errno));
+            failed[f] = 1;
+            status = 1;
+        }
+        if (fd >= 0 && file_count > 0) close(fd);
+        counts[inputs].lines += counts[f].lines;
+        counts[inputs].words += counts[f].words;
+        counts[inputs].bytes += counts[f].bytes;
+    }
+
+    // Lebar kolom mengikuti angka terbesar; stdin dengan beberapa kolom minimal 7 seperti wc
+    int columns = show[0] + show[1] + show[2];
+    int width = 1;
+    if (columns > 1 || inputs > 1) {
+        struct text_counts* t = &counts[inputs];
+        long long max = t->bytes > t->words ? (t->bytes > t->lines ? t->bytes : t->lines) : (t->words > t->lines ? t->words : t->lines);
+        for (; max >= 10; max /= 10) width++;
+        if (file_count == 0 && width < 7) width = 7;
+    }
+
+    struct text_buffer out = { NULL, 0, 0 };
+    for (int f = 0; f < inputs; f++) {
+        if (!failed[f]) print_counts(&out, &counts[f], show, width, file_count ? files[f] : NULL);
+    }
+    if (file_count > 1) print_counts(&out, &counts[inputs], show, width, "total");
+    if (out.len > 0) write_all(out_fd, out.data, out.len);
+    free(out.data);
+    free(counts);
+    free(failed);
+    return status;
+}
+
+// ==================== urut: pengurutan (sort) eksternal bawaan ====================
+
+// Opsi "urut"
+struct urut_opts {
+    int numeric, reverse, unique;
+    int key_start, key_end;     // Field kunci (1-based); 0 = seluruh baris / sampai akhir baris
+    int separator;              // -t; -1 = dipisah deretan spasi/tab
+    size_t budget;              // Batas memori satu run
+    int workers;
+};
+
+// Satu baris beserta kunci yang sudah dihitung
+struct sort_line {
+    const char* text;
+    uint32_t len;
+    uint32_t key_off, key_len;
+    union {
+        double num;             // -n: nilai angka kunci
+        uint64_t prefix;        // 8 byte pertama kunci (big-endian) agar perbandingan jarang menyentuh teks
+    };
+};
+
+// Fungsi untuk mencari awal field ke-n (1-based) di baris; mengembalikan len jika tidak ada
+static size_t sort_field_start(const struct urut_opts* o, const char* s, size_t len, int n) {
+    size_t i = 0;
+    if (o->separator >= 0) {
+        for (int f = 1; f < n; f++) {
+            const char* sep = memchr(s + i, o->separator, len - i);
+            if (sep == NULL) return len;
+            i = sep - s + 1;
+        }
+        return i;
+    }
+    // Tanpa -t: field dipisah deretan spasi/tab, spasi di depan field dilewati (seperti sort -b)
+    for (int f = 1; ; f++) {
+        while (i < len && (s[i] == ' ' || s[i] == '\t')) i++;
+        if (f == n) return i;
+        while (i < len && s[i] != ' ' && s[i] != '\t') i++;
+        if (i == len) return len;
+    }
+}
+
+static size_t sort_field_end(const struct urut_opts* o, const char* s, size_t len, size_t start) {
+    if (o->separator >= 0) {
+        const char* sep = memchr(s + start, o->separator, len - start);
+        return sep != NULL ? (size_t)(sep - s) : len;
+    }
+    while (start < len && s[start] != ' ' && s[start] != '\t') start++;
+    return start;
+}
+
+// Fungsi untuk membaca angka di awal kunci seperti sort -n: [-]digit[.digit]; selain itu 0
+static double sort_number(const char* s, size_t len) {
+    size_t i = 0;
+    while (i < len && (s[i] == ' ' || s[i] == '\t')) i++;
+    int negative = i < len && s[i] == '-';
+    if (negative) i++;
+    double v = 0;
+    for (; i < len && s[i] >= '0' && s[i] <= '9'; i++) v = v * 10 + (s[i] - '0');
+    if (i < len && s[i] == '.') {
+        double scale = 0.1;
+        for (i++; i < len && s[i] >= '0' && s[i] <= '9'; i++, scale /= 10) v += (s[i] - '0') * scale;
+    }
+    return negative ? -v : v;
+}
+
+static void make_sort_line(const struct urut_opts* o, const char* text, size_t len, struct sort_line* r) {
+    r->text = text;
+    r->len = len;
+    size_t start = 0, end = len;
+    if (o->key_start > 0) {
+        start = sort_field_start(o, text, len, o->key_start);
+        if (o->key_end > 0) {
+            size_t last = o->key_end == o->key_start ? start : sort_field_start(o, text, len, o->key_end);
+            end = last < len ? sort_field_end(o, text, len, last) : len;
+            if (end < start) end = start;
+        }
+    }
+    r->key_off = start;
+    r->key_len = end - start;
+    if (o->numeric) {
+        r->num = sort_number(text + start, end - start);
+    } else {
+        r->prefix = 0;
+        for (size_t i = 0; i < 8; i++) {
+            r->prefix = (r->prefix << 8) | (i < end - start ? (unsigned char)text[start + i] : 0);
+        }
+    }
+}
+
+// Perbandingan dua baris: kunci dulu, lalu seluruh baris sebagai penentu terakhir (kecuali -u)
+static int compare_sort_lines(const struct sort_line* a, const struct sort_line* b, const struct urut_opts* o) {
+    int c;
+    if (o->numeric) {
+        c = (a->num > b->num) - (a->num < b->num);
+    } else if (a->prefix != b->prefix) {
+        c = a->prefix > b->prefix ? 1 : -1;
+    } else {
+        size_t n = a->key_len < b->key_len ? a->key_len : b->key_len;
+        c = memcmp(a->text + a->key_off, b->text + b->key_off, n);
+        if (c == 0) c = (a->key_len > b->key_len) - (a->key_len < b->key_len);
+    }
+    if (c == 0 && !o->unique && (o->numeric || o->key_start > 0)) {
+        size_t n = a->len < b->len ? a->len : b->len;
+        c = memcmp(a->text, b->text, n);
+        if (c == 0) c = (a->len > b->len) - (a->len < b->len);
+    }
+    return o->reverse ? -c : c;
+}
+
+static int compare_sort_lines_r(const void* a, const void* b, void* ctx) {
+    return compare_sort_lines(a, b, ctx);
+}
+
+// Sumber untuk merge k-arah: potongan run di memori atau run yang sudah ditulis ke file sementara
+struct merge_source {
+    struct sort_line cur;
+    int done;
+    // Potongan di memori
+    const struct sort_line* lines;
+    size_t pos, count;
+    // Run di file
+    int fd;
+    char* buf;
+    size_t buf_len, buf_pos, buf_cap;
+    int eof;
+};
+
+// Fungsi untuk maju ke baris berikutnya dari sumber
+static void merge_source_next(struct merge_source* s, const struct urut_opts* o) {
+    if (s->fd < 0) {
+        if (s->pos < s->count) s->cur = s->lines[s->pos++];
+        else s->done = 1;
+        return;
+    }
+    for (;;) {
+        char* nl = memchr(s->buf + s->buf_pos, '\n', s->buf_len - s->buf_pos);
+        if (nl != NULL) {
+            make_sort_line(o, s->buf + s->buf_pos, nl - (s->buf + s->buf_pos), &s->cur);
+            s->buf_pos = nl - s->buf + 1;
+            return;
+        }
+        if (s->eof) {
+            // Run selalu diakhiri newline; sisa tanpa newline hanya terjadi jika file rusak
+            s->done = 1;
+            return;
+        }
+        // Geser sisa baris ke depan buffer (perbesar jika satu baris melebihi buffer), lalu isi ulang
+        memmove(s->buf, s->buf + s->buf_pos, s->buf_len - s->buf_pos);
+        s->buf_len -= s->buf_pos;
+        s->buf_pos = 0;
+        if (s->buf_len == s->buf_cap) {
+            char* grown = realloc(s->buf, s->buf_cap * 2);
+            if (grown == NULL) {
+                s->done = 1;
+                return;
+            }
+            s->buf = grown;
+            s->buf_cap *= 2;
+        }
+        ssize_t n = read(s->fd, s->buf + s->buf_len, s->buf_cap - s->buf_len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) s->eof = 1;
+        else s->buf_len += n;
+    }
+}
+
+// Loser tree: node[0] menyimpan pemenang, node[1..k-1] pihak yang kalah di tiap pertandingan.
+// Setelah pemenang maju, hanya jalur dari daunnya ke akar yang dibandingkan ulang (log2 k).
+struct loser_tree {
+    int k;
+    int* node;
+    struct merge_source* src;
+    const struct urut_opts* o;
+};
+
+static int loser_tree_less(const struct loser_tree* t, int a, int b) {
+    if (t->src[a].done) return 0;
+    if (t->src[b].done) return 1;
+    int c = compare_sort_lines(&t->src[a].cur, &t->src[b].cur, t->o);
+    return c < 0 || (c == 0 && a < b);
+}
+
+static int loser_tree_build(struct loser_tree* t, int n) {
+    if (n >= t->k) return n - t->k;
+    int left = loser_tree_build(t, 2 * n), right = loser_tree_build(t, 2 * n + 1);
+    if (loser_tree_less(t, right, left)) {
+        t->node[n] = left;
+        return right;
+    }
+    t->node[n] = right;
+    return left;
+}
+
+static void loser_tree_replay(struct loser_tree* t, int winner) {
+    for (int n = (winner + t->k) / 2; n >= 1; n /= 2) {
+        if (loser_tree_less(t, t->node[n], winner)) {
+            int loser = winner;
+            winner = t->node[n];
+            t->node[n] = loser;
+        }
+    }
+    t->node[0] = winner;
+}
+
+// Penulis hasil dengan buffer; -u dibandingkan dengan baris terakhir yang ditulis
+struct sort_writer {
+    int fd;
+    struct text_buffer out;
+    struct text_buffer last;
+    int has_last;
+    int failed;
+};
+
+static void sort_writer_flush(struct sort_writer* w) {
+    if (!w->failed && w->out.len > 0 && write_all(w->fd, w->out.data, w->out.len) != 0) w->failed = 1;
+    w->out.len = 0;
+}
+
+static void sort_writer_emit(struct sort_writer* w, const struct sort_line* line, const struct urut_opts* o) {
+    if (o->unique) {
+        struct sort_line prev;
+        if (w->has_last) {
+            make_sort_line(o, w->last.data, w->last.len, &prev);
+            if (compare_sort_lines(&prev, line, o) == 0) return;
+        }
+        w->last.len = 0;
+        buf_append(&w->last, line->text, line->len);
+        w->has_last = 1;
+    }
+    buf_append(&w->out, line->text, line->len);
+    buf_append(&w->out, "\n", 1);
+    if (w->out.len >= URUT_WRITE_BATCH) sort_writer_flush(w);
+}
+
+// Fungsi untuk menggabungkan sumber-sumber yang sudah urut ke penulis
+static void merge_sources(struct merge_source* src, int k, const struct urut_opts* o, struct sort_writer* w) {
+    struct loser_tree t = { k, calloc(k > 1 ? k : 1, sizeof(int)), src, o };
+    if (t.node == NULL) {
+        w->failed = 1;
+        return;
+    }
+    for (int i = 0; i < k; i++) merge_source_next(&src[i], o);
+    t.node[0] = k > 1 ? loser_tree_build(&t, 1) : 0;
+    while (!w->failed && !src[t.node[0]].done) {
+        int winner = t.node[0];
+        sort_writer_emit(w, &src[winner].cur, o);
+        merge_source_next(&src[winner], o);
+        loser_tree_replay(&t, winner);
+    }
+    sort_writer_flush(w);
+    free(t.node);
+}
+
+// Potongan run yang diurutkan satu thread
+struct sort_part {
+    struct sort_line* lines;
+    size_t count;
+    const struct urut_opts* o;
+};
+
+static void* sort_part_thread(void* arg) {
+    struct sort_part* p = arg;
+    qsort_r(p->lines, p->count, sizeof(*p->lines), compare_sort_lines_r, (void*)p->o);
+    return NULL;
+}
+
+// Keadaan satu pemanggilan "urut"
+struct urut_state {
+    struct urut_opts o;
+    char* arena;                // Teks baris run yang sedang dikumpulkan
+    size_t arena_len, arena_cap;
+    struct sort_line* lines;
+    size_t count, capacity;
+    int* runs;                  // fd file sementara (sudah di-unlink) berisi run yang terurut
+    int run_count, run_cap;
+};
+
+// Fungsi untuk membuat file sementara yang langsung di-unlink (hilang sendiri saat ditutup)
+static int urut_temp_file(void) {
+    const char* dir = shell_var_get("TMPDIR");
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/urut-XXXXXX", dir != NULL && *dir != '\0' ? dir : "/tmp");
+    int fd = mkostemp(path, O_CLOEXEC);
+    if (fd >= 0) unlink(path);
+    return fd;
+}
+
+static int urut_add_run(struct urut_state* u, int fd) {
+    if (u->run_count == u->run_cap) {
+        int cap = u->run_cap ? u->run_cap * 2 : 16;
+        int* grown = realloc(u->runs, cap * sizeof(int));
+        if (grown == NULL) return -1;
+        u->runs = grown;
+        u->run_cap = cap;
+    }
+    u->runs[u->run_count++] = fd;
+    return 0;
+}
+
+// Fungsi untuk mengurutkan run di memori secara paralel lalu menggabungkan potongannya ke w
+static void urut_sort_run(struct urut_state* u, struct sort_writer* w) {
+    struct sort_part parts[WORK_POOL_MAX_WORKERS + 1];
+    pthread_t threads[WORK_POOL_MAX_WORKERS];
+    int count = u->o.workers + 1;
+    if ((size_t)count > u->count / URUT_MIN_PART) count = u->count / URUT_MIN_PART;
+    if (count < 1) count = 1;
+
+    size_t step = u->count / count;
+    int started[WORK_POOL_MAX_WORKERS + 1] = { 0 };
+    for (int i = 0; i < count; i++) {
+        parts[i].lines = u->lines + i * step;
+        parts[i].count = i == count - 1 ? u->count - i * step : step;
+        parts[i].o = &u->o;
+        if (i > 0) started[i] = pthread_create(&threads[i - 1], NULL, sort_part_thread, &parts[i]) == 0;
+    }
+    for (int i = 0; i < count; i++) {
+        if (i == 0 || !started[i]) sort_part_thread(&parts[i]);
+        else pthread_join(threads[i - 1], NULL);
+    }
+
+    struct merge_source src[WORK_POOL_MAX_WORKERS + 1];
+    memset(src, 0, sizeof(src));
+    for (int i = 0; i < count; i++) {
+        src[i].fd = -1;
+        src[i].lines = parts[i].lines;
+        src[i].count = parts[i].count;
+    }
+    merge_sources(src, count, &u->o, w);
+}
+
+// Fungsi untuk menulis run yang penuh ke file sementara dan mengosongkan memori run
+static int urut_spill(struct urut_state* u) {
+    int fd = urut_temp_file();
+    if (fd < 0) {
+        perror("urut: file sementara");
+        return -1;
+    }
+    struct sort_writer w;
+    memset(&w, 0, sizeof(w));
+    w.fd = fd;
+    urut_sort_run(u, &w);
+    free(w.out.data);
+    free(w.last.data);
+    if (w.failed || urut_add_run(u, fd) != 0 || lseek(fd, 0, SEEK_SET) != 0) {
+        fprintf(stderr, "urut: gagal menulis file sementara: %s\n", strerror(errno));
+        close(fd);
+        return -1;
+    }
+    u->count = 0;
+    return 0;
+}
+
+// Fungsi untuk menggabungkan beberapa run file ke w
+static void urut_merge_runs(struct urut_state* u, int first, int count, struct sort_writer* w) {
+    struct merge_source* src = calloc(count, sizeof(*src));
+    size_t buf_cap = u->o.budget / (count + 1);
+    if (buf_cap < URUT_MIN_READ_BUF) buf_cap = URUT_MIN_READ_BUF;
+    int ok = src != NULL;
+    for (int i = 0; ok && i < count; i++) {
+        src[i].fd = u->runs[first + i];
+        src[i].buf_cap = buf_cap;
+        ok = (src[i].buf = malloc(buf_cap)) != NULL;
+    }
+    if (ok) merge_sources(src, count, &u->o, w);
+    else w->failed = 1;
+    for (int i = 0; src != NULL && i < count; i++) free(src[i].buf);
+    free(src);
+}
+
+// Fungsi untuk menambahkan baris di arena[from, to) ke daftar baris run. Setiap '\n' mengakhiri satu
+// baris (termasuk baris kosong tepat sebelum '\n' terakhir); sisa tanpa '\n' di akhir menjadi satu baris.
+static int urut_index_lines(struct urut_state* u, size_t from, size_t to) {
+    const char* p = u->arena + from;
+    const char* end = u->arena + to;
+    while (p < end) {
+        const char* nl = memchr(p, '\n', end - p);
+        if (nl == NULL) nl = end;
+        if (u->count == u->capacity) {
+            size_t cap = u->capacity ? u->capacity * 2 : 4096;
+            struct sort_line* grown = realloc(u->lines, cap * sizeof(*grown));
+            if (grown == NULL) return -1;
+            u->lines = grown;
+            u->capacity = cap;
+        }
+        make_sort_line(&u->o, p, nl - p, &u->lines[u->count++]);
+        p = nl + 1;
+    }
+    return 0;
+}
+
+// Fungsi untuk membaca satu input ke arena. Jika arena atau daftar baris melewati anggaran,
+// run ditulis ke file sementara dan baris yang terpotong dipindah ke awal arena.
+static int urut_read_input(struct urut_state* u, int fd) {
+    size_t line_start = u->arena_len;  // Awal baris yang belum lengkap
+    for (;;) {
+        if (u->arena_len == u->arena_cap) {
+            size_t partial = u->arena_len - line_start;
+            if (u->count > 0) {
+                if (urut_spill(u) != 0) return -1;
+                memmove(u->arena, u->arena + line_start, partial);
+                u->arena_len = partial;
+                line_start = 0;
+            }
+            if (u->arena_len == u->arena_cap) {
+                // Satu baris lebih besar dari arena: arena diperbesar
+                char* grown = realloc(u->arena, u->arena_cap * 2);
+                if (grown == NULL) return -1;
+                u->arena = grown;
+                u->arena_cap *= 2;
+            }
+        }
+        ssize_t n = read(fd, u->arena + u->arena_len, u->arena_cap - u->arena_len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -1;
+        if (n == 0) break;
+        size_t old_len = u->arena_len;
+        u->arena_len += n;
+        char* last_nl = memrchr(u->arena + old_len, '\n', n);
+        if (last_nl == NULL) continue;
+        size_t complete = last_nl - u->arena + 1;
+        if (urut_index_lines(u, line_start, complete) != 0) return -1;
+        line_start = complete;
+        if (u->count * sizeof(struct sort_line) > u->o.budget / 3) {
+            size_t partial = u->arena_len - line_start;
+            if (urut_spill(u) != 0) return -1;
+            memmove(u->arena, u->arena + line_start, partial);
+            u->arena_len = partial;
+            line_start = 0;
+        }
+    }
+    // Baris terakhir tanpa newline tetap dihitung sebagai satu baris
+    if (line_start < u->arena_len) {
+        if (urut_index_lines(u, line_start, u->arena_len) != 0) return -1;
+    }
+    return 0;
+}
+
+static int urut_usage(void) {
+    fprintf(stderr, "Penggunaan: urut [-n] [-r] [-u] [-k field[,field]] [-t pemisah] [-S memori] [-j thread] [-o file] [file...]\n");
+    return 2;
+}
+
+// Fungsi builtin "urut" (sort): bisa dipanggil langsung atau sebagai tahap pipeline di thread shell
+int urut_run(char** args, int in_fd, int out_fd) {
+    static const long long size_scales[] = { 1, 1024, 1024, 1024 * 1024, 1024LL * 1024 * 1024 };
+    struct urut_state u;
+    memset(&u, 0, sizeof(u));
+    u.o.separator = -1;
+    u.o.budget = URUT_DEFAULT_BUDGET;
+    u.o.workers = work_pool_default_workers();
+    const char* output = NULL;
+    int i = 1;
+
+    for (; args[i] != NULL && args[i][0] == '-' && args[i][1] != '\0'; i++) {
+        const char* a = args[i];
+        const char* v = args[i + 1];
+        if (strcmp(a, "--") == 0) {
+            i++;
+            break;
+        } else if (strcmp(a, "-k") == 0 && v != NULL) {
+            char* end;
+            u.o.key_start = strtol(v, &end, 10);
+            u.o.key_end = *end == ',' ? atoi(end + 1) : 0;
+            if (u.o.key_start <= 0 || (u.o.key_end != 0 && u.o.key_end < u.o.key_start)) return urut_usage();
+            i++;
+        } else if (strcmp(a, "-t") == 0 && v != NULL) {
+            u.o.separator = strcmp(v, "\\t") == 0 ? '\t' : (unsigned char)v[0];
+            i++;
+        } else if (strcmp(a, "-S") == 0 && v != NULL) {
+            int cmp;
+            long long size;
+            if (parse_cari_amount(v, &cmp, &size, "kKMG", size_scales) != 0 || cmp != 0 || size < URUT_MIN_BUDGET) {
+                fprintf(stderr, "urut: ukuran memori tidak valid (minimal %dK): %s\n", URUT_MIN_BUDGET / 1024, v);
+                return 2;
+            }
+            u.o.budget = size;
+            i++;
+        } else if (strcmp(a, "-j") == 0 && v != NULL) {
+            u.o.workers = atoi(v) - 1;
+            if (u.o.workers < 0) u.o.workers = 0;
+            if (u.o.workers > WORK_POOL_MAX_WORKERS) u.o.workers = WORK_POOL_MAX_WORKERS;
+            i++;
+        } else if (strcmp(a, "-o") == 0 && v != NULL) {
+            output = v;
+            i++;
+        } else {
+            for (const char* f = a + 1; *f != '\0'; f++) {
+                if (*f == 'n') u.o.numeric = 1;
+                else if (*f == 'r') u.o.reverse = 1;
+                else if (*f == 'u') u.o.unique = 1;
+                else return urut_usage();
+            }
+        }
+    }
+
+    // Dua pertiga anggaran untuk teks baris, sisanya untuk daftar baris
+    u.arena_cap = u.o.budget / 3 * 2;
+    u.arena = malloc(u.arena_cap);
+    int status = 0;
+    if (u.arena == NULL) {
+        perror("urut");
+        return 2;
+    }
+    if (args[i] == NULL) {
+        if (urut_read_input(&u, in_fd) != 0) {
+            fprintf(stderr, "urut: gagal membaca input: %s\n", strerror(errno));
+            status = 2;
+        }
+    }
+    for (; args[i] != NULL && status == 0; i++) {
+        int fd = strcmp(args[i], "-") == 0 ? in_fd : open(args[i], O_RDONLY | O_CLOEXEC);
+        if (fd < 0 || urut_read_input(&u, fd) != 0) {
+            fprintf(stderr, "urut: %s: %s\n", args[i], strerror(errno));
+            status = 2;
+        }
+        if (fd >= 0 && fd != in_fd) close(fd);
+    }
+
+    // Run di file digabung bertahap jika jumlahnya melebihi batas fd yang dibuka bersamaan
+    if (status == 0 && u.run_count > 0 && u.count > 0 && urut_spill(&u) != 0) status = 2;
+    while (status == 0 && u.run_count > URUT_MAX_MERGE) {
+        int fd = urut_temp_file();
+        struct sort_writer w;
+        memset(&w, 0, sizeof(w));
+        w.fd = fd;
+        if (fd >= 0) urut_merge_runs(&u, 0, URUT_MAX_MERGE, &w);
+        free(w.out.data);
+        free(w.last.data);
+        if (fd < 0 || w.failed || lseek(fd, 0, SEEK_SET) != 0) {
+            fprintf(stderr, "urut: gagal menggabungkan run: %s\n", strerror(errno));
+            if (fd >= 0) close(fd);
+            status = 2;
+            break;
+        }
+        for (int r = 0; r < URUT_MAX_MERGE; r++) close(u.runs[r]);
+        memmove(u.runs, u.runs + URUT_MAX_MERGE, (u.run_count - URUT_MAX_MERGE) * sizeof(int));
+        u.run_count -= URUT_MAX_MERGE;
+        urut_add_run(&u, fd);
+    }
+
+    if (status == 0) {
+        // Output dibuka setelah semua input terbaca, sehingga -o boleh sama dengan file input
+        struct sort_writer w;
+        memset(&w, 0, sizeof(w));
+        w.fd = output != NULL ? open(output, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644) : out_fd;
+        if (w.fd < 0) {
+            fprintf(stderr, "urut: %s: %s\n", output, strerror(errno));
+            status = 2;
+        } else {
+            if (u.run_count > 0) urut_merge_runs(&u, 0, u.run_count, &w);
+            else urut_sort_run(&u, &w);
+            if (output != NULL) close(w.fd);
+        }
+        free(w.out.data);
+        free(w.last.data);
+    }
+
+    for (int r = 0; r < u.run_count; r++) close(u.runs[r]);
+    free(u.runs);
+    free(u.arena);
+    free(u.lines);
+    return status;
+}
+
+// ==================== Skrip: daftar perintah, if/for/while yang dikompilasi ke bytecode ====================
+
+// Variabel shell dan environment. Tabelnya copy-on-write: snapshot (mis. untuk "NAMA=nilai perintah")
+// hanya menambah refcount, salinan baru dibuat saat tabel yang dipakai bersama ditulis. Variabel yang
+// diekspor baru disusun menjadi envp saat akan ada proses dijalankan dan tabelnya berubah sejak itu.
+struct shell_var {
+    char* name;
+    char* value;
+    int exported;
+};
+
+struct shell_env {
+    int refs;
+    struct shell_var* vars;
+    int count, capacity;
+    char** envp;                // Satu blok: array pointer diikuti string "NAMA=nilai"
+    int dirty;                  // Variabel yang diekspor berubah sejak envp disusun
+};
+
+static struct shell_env* shell_env;
+static int shell_env_builds;
+
+static int shell_env_add(struct shell_env* env, const char* name, size_t name_len, const char* value, int exported) {
+    if (env->count == env->capacity) {
+        int capacity = env->capacity ? env->capacity * 2 : 64;
+        struct shell_var* grown = realloc(env->vars, capacity * sizeof(*grown));
+        if (grown == NULL) return -1;
+        env->vars = grown;
+        env->capacity = capacity;
+    }
+    struct shell_var* v = &env->vars[env->count];
+    v->name = strndup(name, name_len);
+    v->value = strdup(value);
+    v->exported = exported;
+    if (v->name == NULL || v->value == NULL) {
+        free(v->name);
+        free(v->value);
+        return -1;
+    }
+    env->count++;
+    return 0;
+}
+
+// Fungsi untuk mengambil tabel variabel aktif; saat pertama dipakai diisi dari environ
+static struct shell_env* shell_env_current(void) {
+    if (shell_env != NULL) return shell_env;
+    shell_env = calloc(1, sizeof(*shell_env));
+    if (shell_env == NULL) {
+        perror("calloc");
+        exit(1);
+    }
+    shell_env->refs = 1;
+    for (char** e = environ; e != NULL && *e != NULL; e++) {
+        const char* eq = strchr(*e, '=');
+        if (eq != NULL) shell_env_add(shell_env, *e, eq - *e, eq + 1, 1);
+    }
+    // environ awal tetap valid sampai ada variabel ekspor yang berubah
+    shell_env->dirty = 0;
+    return shell_env;
+}
+
+static void shell_env_release(struct shell_env* env) {
+    if (env == NULL || --env->refs > 0) return;
+    for (int i = 0; i < env->count; i++) {
+        free(env->vars[i].name);
+        free(env->vars[i].value);
+    }
+    free(env->vars);
+    free(env->envp);
+    free(env);
+}
+
+// Fungsi untuk mendapatkan tabel yang boleh ditulis: disalin dulu jika masih dipakai snapshot
+static struct shell_env* shell_env_writable(void) {
+    struct shell_env* env = shell_env_current();
+    if (env->refs == 1) return env;
+    struct shell_env* copy = calloc(1, sizeof(*copy));
+    if (copy == NULL) {
+        perror("calloc");
+        exit(1);
+    }
+    copy->refs = 1;
+    copy->dirty = 1;
+    for (int i = 0; i < env->count; i++) {
+        const struct shell_var* v = &env->vars[i];
+        if (shell_env_add(copy, v->name, strlen(v->name), v->value, v->exported) != 0) {
+            perror("malloc");
+            exit(1);
+        }
+    }
+    env->refs--;
+    shell_env = copy;
+    return copy;
+}
+
+// Fungsi untuk memasang environ sesuai tabel aktif sebelum menjalankan proses. envp hanya disusun
+// ulang jika ada variabel ekspor yang berubah; selain itu array yang sama dipakai lagi.
+void shell_env_sync(void) {
+    struct shell_env* env = shell_env_current();
+    if (!env->dirty) {
+        if (env->envp != NULL) environ = env->envp;
+        return;
+    }
+    size_t count = 0, bytes = 0;
+    for (int i = 0; i < env->count; i++) {
+        if (!env->vars[i].exported) continue;
+        count++;
+        bytes += strlen(env->vars[i].name) + strlen(env->vars[i].value) + 2;
+    }
+    char** envp = malloc((count + 1) * sizeof(char*) + bytes);
+    if (envp == NULL) {
+        perror("malloc");
+        return;
+    }
+    char* text = (char*)(envp + count + 1);
+    size_t n = 0;
+    for (int i = 0; i < env->count; i++) {
+        if (!env->vars[i].exported) continue;
+        envp[n++] = text;
+        text += sprintf(text, "%s=%s", env->vars[i].name, env->vars[i].value) + 1;
+    }
+    envp[n] = NULL;
+    // environ bisa masih menunjuk array lama, jadi diganti dulu sebelum array lama dibebaskan
+    char** old = env->envp;
+    environ = envp;
+    env->envp = envp;
+    env->dirty = 0;
+    free(old);
+    shell_env_builds++;
+}
+
+// Fungsi untuk menyimpan keadaan variabel saat ini (O(1)); dipulihkan dengan shell_env_restore
+static struct shell_env* shell_env_snapshot(void) {
+    struct shell_env* env = shell_env_current();
+    env->refs++;
+    return env;
+}
+
+static void shell_env_restore(struct shell_env* saved) {
+    struct shell_env* current = shell_env;
+    if (current == saved) {
+        saved->refs--;
+        return;
+    }
+    shell_env = saved;
+    // environ tidak boleh menunjuk envp milik tabel yang akan dibebaskan
+    if (current->envp != NULL && environ == current->envp) {
+        if (saved->envp == NULL) saved->dirty = 1;
+        shell_env_sync();
+    }
+    shell_env_release(current);
+}
+
+static struct shell_var* shell_var_find(struct shell_env* env, const char* name) {
+    for (int i = 0; i < env->count; i++) {
+        if (strcmp(env->vars[i].name, name) == 0) return &env->vars[i];
+    }
+    return NULL;
+}
+
+const char* shell_var_get(const char* name) {
+    struct shell_var* v = shell_var_find(shell_env_current(), name);
+    return v != NULL ? v->value : NULL;
+}
+
+// Fungsi untuk mengisi variabel; exported 1/0 mengubah status ekspor, -1 mempertahankannya
+int shell_var_set(const char* name, const char* value, int exported) {
+    struct shell_var* v = shell_var_find(shell_env_current(), name);
+    if (v != NULL && strcmp(v->value, value) == 0 && (exported < 0 || v->exported == exported)) return 0;
+
+    struct shell_env* env = shell_env_writable();
+    v = shell_var_find(env, name);
+    if (v == NULL) {
+        if (shell_env_add(env, name, strlen(name), value, exported > 0) != 0) return -1;
+        env->dirty |= exported > 0;
+        return 0;
+    }
+    char* copy = strdup(value);
+    if (copy == NULL) return -1;
+    free(v->value);
+    v->value = copy;
+    if (exported >= 0 && v->exported != exported) {
+        v->exported = exported;
+        env->dirty = 1;
+    }
+    env->dirty |= v->exported;
+    return 0;
+}
+
+void shell_var_unset(const char* name) {
+    if (shell_var_find(shell_env_current(), name) == NULL) return;
+    struct shell_env* env = shell_env_writable();
+    struct shell_var* v = shell_var_find(env, name);
+    env->dirty |= v->exported;
+    free(v->name);
+    free(v->value);
+    *v = env->vars[--env->count];
+}
+
+static int shell_var_name_valid(const char* name, size_t len) {
+    if (len == 0 || !(isalpha((unsigned char)name[0]) || name[0] == '_')) return 0;
+    for (size_t i = 1; i < len; i++) {
+        if (!isalnum((unsigned char)name[i]) && name[i] != '_') return 0;
+    }
+    return 1;
+}
+
+// Fungsi untuk perintah export: "export NAMA=nilai", "export NAMA", atau tanpa argumen untuk daftar
+void export_command(char** args) {
+    if (args[1] == NULL) {
+        struct shell_env* env = shell_env_current();
+        for (int i = 0; i < env->count; i++) {
+            if (env->vars[i].exported) printf("export %s=\"%s\"\n", env->vars[i].name, env->vars[i].value);
+        }
+        printf("(envp disusun %d kali)\n", shell_env_builds);
+        return;
+    }
+    for (int i = 1; args[i] != NULL; i++) {
+        const char* eq = strchr(args[i], '=');
+        size_t len = eq != NULL ? (size_t)(eq - args[i]) : strlen(args[i]);
+        if (!shell_var_name_valid(args[i], len)) {
+            fprintf(stderr, "export: '%s': nama variabel tidak valid\n", args[i]);
+            last_exit_status = 1;
+            continue;
+        }
+        char name[128];
+        snprintf(name, sizeof(name), "%.*s", (int)len, args[i]);
+        const char* value = eq != NULL ? eq + 1 : shell_var_get(name);
+        if (value != NULL) shell_var_set(name, value, 1);
+    }
+    // Pustaka (curl, readline, localtime) membaca environ langsung, jadi perubahan ekspor langsung dipasang
+    shell_env_sync();
+}
+
+// Fungsi untuk perintah unset: menghapus variabel shell/environment
+void unset_command(char** args) {
+    for (int i = 1; args[i] != NULL; i++) shell_var_unset(args[i]);
+    shell_env_sync();
+}
+
+// Bagian kata yang nilainya baru diketahui saat dijalankan
+enum { PART_TEXT, PART_VAR, PART_CMDSUB, PART_PROCSUB };
+
+struct script_part {
+    int kind;
+    char* text;                 // PART_TEXT: teks tanpa kutip; PART_VAR: nama variabel
+    char* pattern;              // PART_TEXT: teks dengan karakter yang dikutip di-escape (untuk glob)
+    int sub;                    // PART_CMDSUB/PART_PROCSUB: indeks di program->subs
+    int quoted;                 // Hasil ekspansi di dalam "..." (tidak dipecah per spasi)
+};
+
+// Satu kata hasil lexing. Kata statis disimpan final; kata berisi $VAR disimpan per bagian.
+struct script_word {
+    char* value;                // Kata statis: teks akhir (NULL untuk kata dinamis)
+    char* pattern;              // Kata statis dengan glob tanpa kutip: polanya
+    struct script_part* parts;  // Kata dinamis
+    int part_count;
+    int has_meta;               // Ada * ? [ { tanpa kutip
+    int bare;                   // Tanpa kutip/escape sama sekali (boleh menjadi kata kunci)
+    int assign_len;             // Diawali "NAMA=" tanpa kutip: panjang "NAMA=", selain itu 0
+};
+
+struct script_stage {
+    int first_word, word_count;
+    int assign_count;           // Kata awal berbentuk NAMA=nilai
+};
+
+// Satu perintah (pipeline) yang dijalankan oleh OP_RUN
+struct script_command {
+    int first_stage, stage_count;
+};
+
+struct script_for {
+    char* var;
+    int first_word, word_count;
+};
+
+// Instruksi bytecode: 8 bit opcode, 24 bit operand. OP_FOR_NEXT diikuti satu kata berisi alamat lompatan.
+enum {
+    OP_END,
+    OP_RUN,         // Jalankan perintah ke-n
+    OP_JUMP,
+    OP_JUMP_FAIL,   // Lompat jika status terakhir bukan 0
+    OP_JUMP_OK,     // Lompat jika status terakhir 0
+    OP_NOT,         // Balik status (!)
+    OP_STATUS,      // Set status
+    OP_FOR_INIT,    // Ekspansi daftar kata for ke-n
+    OP_FOR_NEXT     // Isi variabel for ke-n dengan kata berikutnya, atau lompat jika habis
+};
+
+#define SCRIPT_OP(op, arg) ((uint32_t)(op) | ((uint32_t)(arg) << 8))
+#define SCRIPT_NO_TARGET 0xFFFFFF
+
+struct script_program {
+    int refs;
+    uint32_t* code;
+    int code_len, code_cap;
+    struct script_word* words;
+    int word_count, word_cap;
+    struct script_stage* stages;
+    int stage_count, stage_cap;
+    struct script_command* commands;
+    int command_count, command_cap;
+    struct script_for* fors;
+    int for_count, for_cap;
+    struct script_program** subs;   // Program di dalam $(...) dan <(...)
+    int sub_count, sub_cap;
+};
+
+// Fungsi untuk memperbesar array item (kapasitas berlipat dua); -1 jika memori habis
+static int script_grow(void** items, int* capacity, int count, size_t size) {
+    if (count < *capacity) return 0;
+    int grown_capacity = *capacity ? *capacity * 2 : 16;
+    void* grown = realloc(*items, grown_capacity * size);
+    if (grown == NULL) return -1;
+    *items = grown;
+    *capacity = grown_capacity;
+    return 0;
+}
+
+static void script_release(struct script_program* p) {
+    if (p == NULL || --p->refs > 0) return;
+    for (int i = 0; i < p->word_count; i++) {
+        struct script_word* w = &p->words[i];
+        free(w->value);
+        free(w->pattern);
+        for (int j = 0; j < w->part_count; j++) {
+            free(w->parts[j].text);
+            free(w->parts[j].pattern);
+        }
+        free(w->parts);
+    }
+    for (int i = 0; i < p->for_count; i++) free(p->fors[i].var);
+    for (int i = 0; i < p->sub_count; i++) script_release(p->subs[i]);
+    free(p->subs);
+    free(p->words);
+    free(p->stages);
+    free(p->commands);
+    free(p->fors);
+    free(p->code);
+    free(p);
+}
+
+// ---------- Lexer ----------
+
+enum { TOK_WORD, TOK_SEMI, TOK_NEWLINE, TOK_AND, TOK_OR, TOK_PIPE, TOK_END };
+
+struct script_token {
+    int kind;
+    int word;                   // TOK_WORD: indeks di program->words
+    int line;
+};
+
+struct script_parser {
+    struct script_program* p;
+    struct script_token* tokens;
+    int count, capacity;
+    int pos;
+    char error[160];
+    int error_line;
+};
+
+static void script_error(struct script_parser* ps, int line, const char* fmt, ...) {
+    if (ps->error[0] != '\0') return;
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(ps->error, sizeof(ps->error), fmt, ap);
+    va_end(ap);
+    ps->error_line = line;
+}
+
+static int script_add_token(struct script_parser* ps, int kind, int word, int line) {
+    if (script_grow((void**)&ps->tokens, &ps->capacity, ps->count, sizeof(*ps->tokens)) != 0) return -1;
+    ps->tokens[ps->count].kind = kind;
+    ps->tokens[ps->count].word = word;
+    ps->tokens[ps->count].line = line;
+    ps->count++;
+    return 0;
+}
+
+// Segmen teks kata yang sedang dibangun: nilai tanpa kutip dan bentuk polanya
+struct script_segment {
+    struct text_buffer value, pattern;
+};
+
+static void segment_add(struct script_segment* seg, char c, int quoted) {
+    buf_append(&seg->value, &c, 1);
+    if (quoted && strchr("*?[]{},\\", c) != NULL) buf_append(&seg->pattern, "\\", 1);
+    buf_append(&seg->pattern, &c, 1);
+}
+
+static char* segment_take(struct text_buffer* b) {
+    char* s = b->data != NULL ? b->data : strdup("");
+    b->data = NULL;
+    b->len = b->capacity = 0;
+    return s;
+}
+
+static struct script_part* script_add_part(struct script_word* w, int kind) {
+    struct script_part* grown = realloc(w->parts, (w->part_count + 1) * sizeof(*grown));
+    if (grown == NULL) return NULL;
+    w->parts = grown;
+    struct script_part* part = &w->parts[w->part_count++];
+    memset(part, 0, sizeof(*part));
+    part->kind = kind;
+    return part;
+}
+
+static int script_flush_segment(struct script_word* w, struct script_segment* seg) {
+    if (seg->value.len == 0) return 0;
+    struct script_part* part = script_add_part(w, PART_TEXT);
+    if (part == NULL) return -1;
+    part->text = segment_take(&seg->value);
+    part->pattern = segment_take(&seg->pattern);
+    return 0;
+}
+
+static struct script_program* script_compile(const char* src, const char* name);
+
+// Fungsi untuk mencari ')' penutup; s menunjuk tepat setelah '('. Kurung di dalam kutip dilewati.
+static const char* script_match_paren(const char* s) {
+    int depth = 1;
+    char quote = 0;
+    for (; *s != '\0'; s++) {
+        if (quote == '\'') {
+            if (*s == '\'') quote = 0;
+        } else if (*s == '\\' && s[1] != '\0') {
+            s++;
+        } else if (quote == '"') {
+            if (*s == '"') quote = 0;
+        } else if (*s == '\'' || *s == '"') {
+            quote = *s;
+        } else if (*s == '(') {
+            depth++;
+        } else if (*s == ')' && --depth == 0) {
+            return s;
+        }
+    }
+    return NULL;
+}
+
+// Fungsi untuk mengompilasi isi $(...) atau <(...) (s menunjuk '(') menjadi sub-program. Mengembalikan
+// panjang yang dibaca termasuk kedua kurung, atau -1 jika sintaks salah.
+static int script_lex_sub(struct script_program* p, const char* s, int* sub, const char** error) {
+    const char* end = script_match_paren(s + 1);
+    if (end == NULL) {
+        *error = "substitusi tidak ditutup dengan ')'";
+        return -1;
+    }
+    char* text = strndup(s + 1, end - s - 1);
+    struct script_program* program = text != NULL ? script_compile(text, "substitusi") : NULL;
+    free(text);
+    if (program == NULL) {
+        *error = "isi substitusi tidak valid";
+        return -1;
+    }
+    if (script_grow((void**)&p->subs, &p->sub_cap, p->sub_count, sizeof(*p->subs)) != 0) {
+        script_release(program);
+        *error = "memori tidak cukup";
+        return -1;
+    }
+    p->subs[p->sub_count] = program;
+    *sub = p->sub_count++;
+    return end - s + 1;
+}
+
+// Fungsi untuk membaca $NAMA, ${NAMA} atau $? di s (menunjuk '$'). Mengembalikan panjang yang
+// dibaca dan menyalin nama ke name; 0 jika '$' harus dianggap literal; -1 jika sintaks salah.
+static int script_lex_var(const char* s, char* name, size_t size, const char** error) {
+    const char* start = s + 1;
+    size_t len = 0;
+    int braces = *start == '{';
+    if (braces) start++;
+    if (*start == '?') {
+        len = 1;
+    } else if (isalpha((unsigned char)*start) || *start == '_') {
+        while (isalnum((unsigned char)start[len]) || start[len] == '_') len++;
+    } else if (braces) {
+        *error = "nama variabel ${...} tidak valid";
+        return -1;
+    } else {
+        return 0;
+    }
+    if (braces && start[len] != '}') {
+        *error = "${ tidak ditutup";
+        return -1;
+    }
+    if (len >= size) {
+        *error = "nama variabel terlalu panjang";
+        return -1;
+    }
+    memcpy(name, start, len);
+    name[len] = '\0';
+    return (start - s) + len + braces;
+}
+
+// Fungsi untuk membaca satu kata mulai dari *sp; mengembalikan indeks kata atau -1
+static int script_lex_word(struct script_parser* ps, const char** sp, int line) {
+    struct script_program* p = ps->p;
+    if (script_grow((void**)&p->words, &p->word_cap, p->word_count, sizeof(*p->words)) != 0) return -1;
+    struct script_word* w = &p->words[p->word_count];
+    memset(w, 0, sizeof(*w));
+    w->bare = 1;
+
+    struct script_segment seg;
+    memset(&seg, 0, sizeof(seg));
+    const char* s = *sp;
+    const char* error = NULL;
+    int dynamic = 0;
+    char quote = 0;
+
+    while (*s != '\0' && error == NULL) {
+        char c = *s;
+        if (!quote && strchr(" \t\n;&|<>()", c) != NULL && !(c == '<' && s[1] == '(' && s == *sp)) break;
+        if (c == '`') {
+            error = "substitusi `...` belum didukung, gunakan $(...)";
+            break;
+        }
+        if (quote == '\'') {
+            if (c == '\'') quote = 0;
+            else segment_add(&seg, c, 1);
+            s++;
+            continue;
+        }
+        if (!quote && (c == '\'' || c == '"')) {
+            quote = c;
+            w->bare = 0;
+            s++;
+            continue;
+        }
+        if (quote == '"' && c == '"') {
+            quote = 0;
+            s++;
+            continue;
+        }
+        if (c == '\\' && s[1] != '\0' && (!quote || strchr("\"\\$`\n", s[1]) != NULL)) {
+            w->bare = 0;
+            if (s[1] != '\n') segment_add(&seg, s[1], 1);
+            s += 2;
+            continue;
+        }
+        // <(...) di awal kata: substitusi proses, diganti /dev/fd/N saat dijalankan
+        int procsub = !quote && c == '<' && s[1] == '(' && s == *sp;
+        if (procsub || (c == '$' && s[1] == '(')) {
+            if (!procsub && s[2] == '(') {
+                error = "aritmetika $((...)) belum didukung";
+                break;
+            }
+            int sub;
+            int n = script_lex_sub(p, s + 1, &sub, &error);
+            if (n < 0) break;
+            struct script_part* part = script_flush_segment(w, &seg) == 0 ?
+                script_add_part(w, procsub ? PART_PROCSUB : PART_CMDSUB) : NULL;
+            if (part == NULL) {
+                error = "memori tidak cukup";
+                break;
+            }
+            part->sub = sub;
+            part->quoted = quote != 0;
+            dynamic = 1;
+            w->bare = 0;
+            s += 1 + n;
+            continue;
+        }
+        if (c == '$') {
+            char name[128];
+            int n = script_lex_var(s, name, sizeof(name), &error);
+            if (n < 0) break;
+            if (n > 0) {
+                struct script_part* part = script_flush_segment(w, &seg) == 0 ? script_add_part(w, PART_VAR) : NULL;
+                if (part == NULL) {
+                    error = "memori tidak cukup";
+                    break;
+                }
+                part->text = strdup(name);
+                part->quoted = quote != 0;
+                dynamic = 1;
+                w->bare = 0;
+                s += n;
+                continue;
+            }
+        }
+        if (!quote && strchr("*?[{", c) != NULL) w->has_meta = 1;
+        // NAMA= tanpa kutip di awal kata: assignment variabel
+        if (c == '=' && !quote && w->bare && w->part_count == 0 && w->assign_len == 0 && seg.value.len < 128 &&
+            shell_var_name_valid(seg.value.data, seg.value.len)) {
+            w->assign_len = seg.value.len + 1;
+        }
+        segment_add(&seg, c, quote != 0);
+        s++;
+    }
+    if (error == NULL && quote) error = "tanda kutip tidak ditutup";
+
+    for (const char* q = *sp; q < s; q++) line += *q == '\n';
+    *sp = s;
+    if (error != NULL) {
+        script_error(ps, line, "%s", error);
+        free(seg.value.data);
+        free(seg.pattern.data);
+        p->word_count++;    // Tetap dicatat agar dibebaskan bersama program
+        return -1;
+    }
+    if (dynamic) {
+        script_flush_segment(w, &seg);
+    } else {
+        w->value = segment_take(&seg.value);
+        if (w->has_meta) w->pattern = segment_take(&seg.pattern);
+        else free(seg.pattern.data);
+    }
+    return p->word_count++;
+}
+
+static int script_static_word(struct script_program* p, const char* text) {
+    if (script_grow((void**)&p->words, &p->word_cap, p->word_count, sizeof(*p->words)) != 0) return -1;
+    struct script_word* w = &p->words[p->word_count];
+    memset(w, 0, sizeof(*w));
+    w->value = strdup(text);
+    return p->word_count++;
+}
+
+// Fungsi untuk memecah teks skrip menjadi token; -1 jika ada sintaks yang tidak didukung
+static int script_lex(struct script_parser* ps, const char* src) {
+    const char* s = src;
+    int line = 1;
+    while (*s != '\0') {
+        int kind = -1, len = 1;
+        if (*s == ' ' || *s == '\t' || *s == '\r') {
+            s++;
+            continue;
+        } else if (*s == '\\' && s[1] == '\n') {
+            s += 2;
+            line++;
+            continue;
+        } else if (*s == '#') {
+            while (*s != '\0' && *s != '\n') s++;
+            continue;
+        } else if (*s == '\n') {
+            kind = TOK_NEWLINE;
+        } else if (*s == ';') {
+            if (s[1] == ';') {
+                script_error(ps, line, "';;' (case) belum didukung");
+                return -1;
+            }
+            kind = TOK_SEMI;
+        } else if (*s == '&') {
+            if (s[1] != '&') {
+                script_error(ps, line, "menjalankan di latar belakang (&) belum didukung");
+                return -1;
+            }
+            kind = TOK_AND;
+            len = 2;
+        } else if (*s == '|') {
+            kind = s[1] == '|' ? TOK_OR : TOK_PIPE;
+            len = s[1] == '|' ? 2 : 1;
+        } else if (*s == '(' || *s == ')') {
+            script_error(ps, line, "subshell ( ) belum didukung");
+            return -1;
+        } else if ((*s == '<' && s[1] != '(') || *s == '>') {
+            if (s[1] == '<' || s[1] == '>' || s[1] == '&') {
+                script_error(ps, line, "redirection '%.2s' belum didukung", s);
+                return -1;
+            }
+            char op[2] = { *s, '\0' };
+            int word = script_static_word(ps->p, op);
+            if (word < 0 || script_add_token(ps, TOK_WORD, word, line) != 0) return -1;
+            s++;
+            continue;
+        }
+
+        if (kind >= 0) {
+            if (script_add_token(ps, kind, -1, line) != 0) return -1;
+            if (kind == TOK_NEWLINE) line++;
+            s += len;
+            continue;
+        }
+
+        int start_line = line;
+        const char* start = s;
+        int word = script_lex_word(ps, &s, line);
+        if (word < 0) return -1;
+        for (const char* q = start; q < s; q++) line += *q == '\n';
+        // "2>file" akan salah diartikan sebagai argumen "2"
+        const struct script_word* w = &ps->p->words[word];
+        if ((*s == '<' || *s == '>') && w->bare && w->value[0] != '\0' && strspn(w->value, "0123456789") == strlen(w->value)) {
+            script_error(ps, line, "redirection file descriptor (%s%c) belum didukung", w->value, *s);
+            return -1;
+        }
+        if (script_add_token(ps, TOK_WORD, word, start_line) != 0) return -1;
+    }
+    return script_add_token(ps, TOK_END, -1, line);
+}
+
+// ---------- Parser (AST) ----------
+
+enum { SN_NOP, SN_CMD, SN_SEQ, SN_AND, SN_OR, SN_NOT, SN_IF, SN_WHILE, SN_UNTIL, SN_FOR, SN_BREAK, SN_CONTINUE };
+
+struct script_node {
+    int kind;
+    int index;                  // SN_CMD: perintah, SN_FOR: for, SN_BREAK/SN_CONTINUE: level
+    int line;
+    struct script_node* a;      // Kiri / kondisi / badan loop for
+    struct script_node* b;      // Kanan / then / badan loop while
+    struct script_node* c;      // else
+};
+
+static struct script_node* script_node_new(int kind, int line, struct script_node* a, struct script_node* b) {
+    struct script_node* n = calloc(1, sizeof(*n));
+    if (n == NULL) return NULL;
+    n->kind = kind;
+    n->line = line;
+    n->a = a;
+    n->b = b;
+    return n;
+}
+
+static void script_node_free(struct script_node* n) {
+    if (n == NULL) return;
+    script_node_free(n->a);
+    script_node_free(n->b);
+    script_node_free(n->c);
+    free(n);
+}
+
+static const struct script_token* script_peek(struct script_parser* ps) {
+    return &ps->tokens[ps->pos];
+}
+
+// Apakah token saat ini kata kunci kw (kata tanpa kutip di posisi perintah)
+static int script_at_keyword(struct script_parser* ps, const char* kw) {
+    const struct script_token* t = script_peek(ps);
+    if (t->kind != TOK_WORD) return 0;
+    const struct script_word* w = &ps->p->words[t->word];
+    return w->bare && w->value != NULL && strcmp(w->value, kw) == 0;
+}
+
+static int script_at_stop_keyword(struct script_parser* ps) {
+    static const char* stops[] = { "then", "elif", "else", "fi", "do", "done", NULL };
+    for (int i = 0; stops[i] != NULL; i++) {
+        if (script_at_keyword(ps, stops[i])) return 1;
+    }
+    return 0;
+}
+
+static const char* script_token_text(struct script_parser* ps) {
+    const struct script_token* t = script_peek(ps);
+    switch (t->kind) {
+    case TOK_WORD: return ps->p->words[t->word].value != NULL ? ps->p->words[t->word].value : "$...";
+    case TOK_SEMI: return ";";
+    case TOK_NEWLINE: return "baris baru";
+    case TOK_AND: return "&&";
+    case TOK_OR: return "||";
+    case TOK_PIPE: return "|";
+    default: return "akhir skrip";
+    }
+}
+
+static int script_expect(struct script_parser* ps, const char* kw) {
+    if (script_at_keyword(ps, kw)) {
+        ps->pos++;
+        return 0;
+    }
+    script_error(ps, script_peek(ps)->line, "'%s' diharapkan, ditemukan '%s'", kw, script_token_text(ps));
+    return -1;
+}
+
+static struct script_node* script_parse_list(struct script_parser* ps);
+
+// Perintah sederhana: kata-kata sampai operator. Tahap pipeline ditambahkan ke perintah yang sama.
+static int script_parse_stage(struct script_parser* ps) {
+    struct script_program* p = ps->p;
+    const struct script_token* t = script_peek(ps);
+    if (t->kind != TOK_WORD) {
+        script_error(ps, t->line, "sintaks tak terduga dekat '%s'", script_token_text(ps));
+        return -1;
+    }
+    if (script_grow((void**)&p->stages, &p->stage_cap, p->stage_count, sizeof(*p->stages)) != 0) return -1;
+    struct script_stage* st = &p->stages[p->stage_count];
+    st->first_word = t->word;
+    st->word_count = 0;
+    st->assign_count = 0;
+    while (script_peek(ps)->kind == TOK_WORD) {
+        if (st->word_count == MAX_ARGS - 1) {
+            script_error(ps, t->line, "terlalu banyak argumen (maks %d)", MAX_ARGS - 1);
+            return -1;
+        }
+        if (st->assign_count == st->word_count && p->words[script_peek(ps)->word].assign_len > 0) st->assign_count++;
+        st->word_count++;
+        ps->pos++;
+    }
+    return p->stage_count++;
+}
+
+static struct script_node* script_parse_if(struct script_parser* ps, int line) {
+    struct script_node* n = script_node_new(SN_IF, line, NULL, NULL);
+    if (n == NULL) return NULL;
+    n->a = script_parse_list(ps);
+    if (n->a != NULL && n->a->kind == SN_NOP) script_error(ps, line, "kondisi if kosong");
+    if (ps->error[0] != '\0' || script_expect(ps, "then") != 0) return n;
+    n->b = script_parse_list(ps);
+    if (ps->error[0] != '\0') return n;
+    if (script_at_keyword(ps, "elif")) {
+        int elif_line = script_peek(ps)->line;
+        ps->pos++;
+        n->c = script_parse_if(ps, elif_line);     // Menghabiskan 'fi' milik if ini juga
+        return n;
+    }
+    if (script_at_keyword(ps, "else")) {
+        ps->pos++;
+        n->c = script_parse_list(ps);
+        if (ps->error[0] != '\0') return n;
+    }
+    script_expect(ps, "fi");
+    return n;
+}
+
+static struct script_node* script_parse_while(struct script_parser* ps, int kind, int line) {
+    struct script_node* n = script_node_new(kind, line, NULL, NULL);
+    if (n == NULL) return NULL;
+    n->a = script_parse_list(ps);
+    if (n->a != NULL && n->a->kind == SN_NOP) script_error(ps, line, "kondisi loop kosong");
+    if (ps->error[0] != '\0' || script_expect(ps, "do") != 0) return n;
+    n->b = script_parse_list(ps);
+    if (ps->error[0] == '\0') script_expect(ps, "done");
+    return n;
+}
+
+static struct script_node* script_parse_for(struct script_parser* ps, int line) {
+    struct script_program* p = ps->p;
+    const struct script_token* t = script_peek(ps);
+    const struct script_word* name = t->kind == TOK_WORD ? &p->words[t->word] : NULL;
+    if (name == NULL || !name->bare || !(isalpha((unsigned char)name->value[0]) || name->value[0] == '_') ||
+        strspn(name->value, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_") != strlen(name->value)) {
+        script_error(ps, line, "nama variabel for tidak valid");
+        return NULL;
+    }
+    ps->pos++;
+    if (!script_at_keyword(ps, "in")) {
+        script_error(ps, line, "for tanpa 'in' belum didukung");
+        return NULL;
+    }
+    ps->pos++;
+
+    if (script_grow((void**)&p->fors, &p->for_cap, p->for_count, sizeof(*p->fors)) != 0) return NULL;
+    struct script_for* f = &p->fors[p->for_count];
+    f->var = strdup(name->value);
+    f->first_word = script_peek(ps)->kind == TOK_WORD ? script_peek(ps)->word : 0;
+    f->word_count = 0;
+    int index = p->for_count++;
+    while (script_peek(ps)->kind == TOK_WORD) {
+        f->word_count++;
+        ps->pos++;
+    }
+    if (script_peek(ps)->kind != TOK_SEMI && script_peek(ps)->kind != TOK_NEWLINE) {
+        script_error(ps, script_peek(ps)->line, "';' atau baris baru diharapkan sebelum 'do'");
+        return NULL;
+    }
+    while (script_peek(ps)->kind == TOK_SEMI || script_peek(ps)->kind == TOK_NEWLINE) ps->pos++;
+
+    struct script_node* n = script_node_new(SN_FOR, line, NULL, NULL);
+    if (n == NULL) return NULL;
+    n->index = index;
+    if (script_expect(ps, "do") != 0) return n;
+    n->a = script_parse_list(ps);
+    if (ps->error[0] == '\0') script_expect(ps, "done");
+    return n;
+}
+
+static struct script_node* script_parse_command(struct script_parser* ps) {
+    int line = script_peek(ps)->line;
+    if (script_at_keyword(ps, "if")) {
+        ps->pos++;
+        return script_parse_if(ps, line);
+    }
+    if (script_at_keyword(ps, "while") || script_at_keyword(ps, "until")) {
+        int kind = script_at_keyword(ps, "while") ? SN_WHILE : SN_UNTIL;
+        ps->pos++;
+        return script_parse_while(ps, kind, line);
+    }
+    if (script_at_keyword(ps, "for")) {
+        ps->pos++;
+        return script_parse_for(ps, line);
+    }
+    if (script_at_keyword(ps, "break") || script_at_keyword(ps, "continue")) {
+        struct script_node* n = script_node_new(script_at_keyword(ps, "break") ? SN_BREAK : SN_CONTINUE, line, NULL, NULL);
+        if (n == NULL) return NULL;
+        ps->pos++;
+        n->index = 1;
+        const struct script_token* t = script_peek(ps);
+        if (t->kind == TOK_WORD) {
+            const char* level = ps->p->words[t->word].value;
+            n->index = level != NULL ? atoi(level) : 0;
+            if (n->index <= 0) script_error(ps, line, "level break/continue tidak valid");
+            ps->pos++;
+        }
+        return n;
+    }
+
+    struct script_program* p = ps->p;
+    int stage = script_parse_stage(ps);
+    if (stage < 0) return NULL;
+    if (script_grow((void**)&p->commands, &p->command_cap, p->command_count, sizeof(*p->commands)) != 0) return NULL;
+    p->commands[p->command_count].first_stage = stage;
+    p->commands[p->command_count].stage_count = 1;
+    struct script_node* n = script_node_new(SN_CMD, line, NULL, NULL);
+    if (n != NULL) n->index = p->command_count++;
+    return n;
+}
+
+static struct script_node* script_parse_pipeline(struct script_parser* ps) {
+    int line = script_peek(ps)->line;
+    int negate = 0;
+    if (script_at_keyword(ps, "!")) {
+        negate = 1;
+        ps->pos++;
+    }
+    struct script_node* n = script_parse_command(ps);
+    while (n != NULL && ps->error[0] == '\0' && script_peek(ps)->kind == TOK_PIPE) {
+        if (n->kind != SN_CMD) {
+            script_error(ps, line, "if/for/while di dalam pipeline belum didukung");
+            break;
+        }
+        ps->pos++;
+        while (script_peek(ps)->kind == TOK_NEWLINE) ps->pos++;
+        if (script_at_keyword(ps, "if") || script_at_keyword(ps, "while") || script_at_keyword(ps, "until") ||
+            script_at_keyword(ps, "for")) {
+            script_error(ps, line, "if/for/while di dalam pipeline belum didukung");
+            break;
+        }
+        // Tahap baru selalu tepat setelah tahap sebelumnya, sehingga tahap satu perintah tetap berurutan
+        if (script_parse_stage(ps) < 0) break;
+        ps->p->commands[n->index].stage_count++;
+    }
+    if (n != NULL && n->kind == SN_CMD && ps->error[0] == '\0') {
+        const struct script_command* c = &ps->p->commands[n->index];
+        for (int i = 0; c->stage_count > 1 && i < c->stage_count; i++) {
+            const struct script_stage* st = &ps->p->stages[c->first_stage + i];
+            if (st->assign_count == st->word_count) {
+                script_error(ps, line, "assignment tanpa perintah di dalam pipeline tidak didukung");
+                break;
+            }
+        }
     }
-    // Perintah internal "cek battery"
-    else if (strcmp(args[0], "cek") == 0 && strcmp(args[1], "battery") == 0) {
-        FILE *fp = fopen("/sys/class/power_supply/BAT0/capacity", "r");
-        if (fp == NULL) {
-            perror("Gagal membuka file kapasitas baterai");
+    if (negate && n != NULL) n = script_node_new(SN_NOT, line, n, NULL);
+    return n;
+}
+
+static struct script_node* script_parse_and_or(struct script_parser* ps) {
+    struct script_node* left = script_parse_pipeline(ps);
+    while (left != NULL && ps->error[0] == '\0' && (script_peek(ps)->kind == TOK_AND || script_peek(ps)->kind == TOK_OR)) {
+        int kind = script_peek(ps)->kind == TOK_AND ? SN_AND : SN_OR;
+        int line = script_peek(ps)->line;
+        ps->pos++;
+        while (script_peek(ps)->kind == TOK_NEWLINE) ps->pos++;
+        struct script_node* right = script_parse_pipeline(ps);
+        struct script_node* n = script_node_new(kind, line, left, right);
+        if (n == NULL) {
+            script_node_free(right);
+            break;
+        }
+        left = n;
+    }
+    return left;
+}
+
+// Daftar perintah dipisah ';' atau baris baru, berhenti di kata kunci penutup atau akhir skrip
+static struct script_node* script_parse_list(struct script_parser* ps) {
+    struct script_node* list = NULL;
+    while (ps->error[0] == '\0') {
+        while (script_peek(ps)->kind == TOK_SEMI || script_peek(ps)->kind == TOK_NEWLINE) ps->pos++;
+        if (script_peek(ps)->kind == TOK_END || script_at_stop_keyword(ps)) break;
+        struct script_node* n = script_parse_and_or(ps);
+        if (n == NULL) {
+            script_error(ps, script_peek(ps)->line, "memori tidak cukup");
+            break;
+        }
+        list = list != NULL ? script_node_new(SN_SEQ, n->line, list, n) : n;
+        int kind = script_peek(ps)->kind;
+        if (ps->error[0] == '\0' && kind != TOK_SEMI && kind != TOK_NEWLINE && kind != TOK_END && !script_at_stop_keyword(ps)) {
+            script_error(ps, script_peek(ps)->line, "sintaks tak terduga dekat '%s'", script_token_text(ps));
+        }
+    }
+    return list != NULL ? list : script_node_new(SN_NOP, script_peek(ps)->line, NULL, NULL);
+}
+
+// ---------- Kompilasi AST ke bytecode ----------
+
+struct script_codegen {
+    struct script_program* p;
+    int depth;
+    int continue_target[SCRIPT_MAX_DEPTH];
+    int break_chain[SCRIPT_MAX_DEPTH];  // Daftar OP_JUMP break yang belum diisi, berantai lewat operand
+    char error[160];
+    int error_line;
+};
+
+static int script_emit(struct script_program* p, int op, uint32_t arg) {
+    if (script_grow((void**)&p->code, &p->code_cap, p->code_len, sizeof(*p->code)) != 0) return -1;
+    p->code[p->code_len] = SCRIPT_OP(op, arg);
+    return p->code_len++;
+}
+
+static void script_patch(struct script_program* p, int at, int target) {
+    if (at >= 0) p->code[at] = SCRIPT_OP(p->code[at] & 0xFF, target);
+}
+
+static int script_gen(struct script_codegen* g, struct script_node* n) {
+    struct script_program* p = g->p;
+    int jump, end;
+    switch (n->kind) {
+    case SN_NOP:
+        return 0;
+    case SN_CMD:
+        return script_emit(p, OP_RUN, n->index) < 0 ? -1 : 0;
+    case SN_SEQ:
+        return script_gen(g, n->a) != 0 ? -1 : script_gen(g, n->b);
+    case SN_AND:
+    case SN_OR:
+        if (script_gen(g, n->a) != 0) return -1;
+        jump = script_emit(p, n->kind == SN_AND ? OP_JUMP_FAIL : OP_JUMP_OK, 0);
+        if (jump < 0 || script_gen(g, n->b) != 0) return -1;
+        script_patch(p, jump, p->code_len);
+        return 0;
+    case SN_NOT:
+        if (script_gen(g, n->a) != 0) return -1;
+        return script_emit(p, OP_NOT, 0) < 0 ? -1 : 0;
+    case SN_IF:
+        // cond; JUMP_FAIL else; then; JUMP end; else: (else | STATUS 0); end:
+        if (script_gen(g, n->a) != 0 || (jump = script_emit(p, OP_JUMP_FAIL, 0)) < 0) return -1;
+        if (script_gen(g, n->b) != 0 || (end = script_emit(p, OP_JUMP, 0)) < 0) return -1;
+        script_patch(p, jump, p->code_len);
+        if (n->c != NULL ? script_gen(g, n->c) != 0 : script_emit(p, OP_STATUS, 0) < 0) return -1;
+        script_patch(p, end, p->code_len);
+        return 0;
+    case SN_WHILE:
+    case SN_UNTIL:
+    case SN_FOR: {
+        if (g->depth == SCRIPT_MAX_DEPTH) {
+            snprintf(g->error, sizeof(g->error), "loop bersarang terlalu dalam (maks %d)", SCRIPT_MAX_DEPTH);
+            g->error_line = n->line;
+            return -1;
+        }
+        int start, exit_jump;
+        if (n->kind == SN_FOR) {
+            // FOR_INIT f; next: FOR_NEXT f, end; body; JUMP next; end:
+            if (script_emit(p, OP_FOR_INIT, n->index) < 0) return -1;
+            start = script_emit(p, OP_FOR_NEXT, n->index);
+            exit_jump = script_emit(p, OP_END, 0);     // Kata alamat lompatan, diisi setelah badan loop
+            if (start < 0 || exit_jump < 0) return -1;
+        } else {
+            // start: cond; JUMP_FAIL/JUMP_OK end; body; JUMP start; end: STATUS 0
+            start = p->code_len;
+            if (script_gen(g, n->a) != 0) return -1;
+            exit_jump = script_emit(p, n->kind == SN_WHILE ? OP_JUMP_FAIL : OP_JUMP_OK, 0);
+            if (exit_jump < 0) return -1;
+        }
+        g->continue_target[g->depth] = start;
+        g->break_chain[g->depth] = SCRIPT_NO_TARGET;
+        g->depth++;
+        int rc = script_gen(g, n->kind == SN_FOR ? n->a : n->b);
+        g->depth--;
+        if (rc != 0 || script_emit(p, OP_JUMP, start) < 0) return -1;
+
+        end = p->code_len;
+        if (n->kind == SN_FOR) {
+            p->code[exit_jump] = end;
+        } else {
+            script_patch(p, exit_jump, end);
+            if (script_emit(p, OP_STATUS, 0) < 0) return -1;
+        }
+        for (int at = g->break_chain[g->depth]; at != SCRIPT_NO_TARGET; ) {
+            int next = p->code[at] >> 8;
+            script_patch(p, at, end);
+            at = next;
+        }
+        return 0;
+    }
+    case SN_BREAK:
+    case SN_CONTINUE: {
+        if (n->index > g->depth) {
+            snprintf(g->error, sizeof(g->error), "%s di luar loop", n->kind == SN_BREAK ? "break" : "continue");
+            g->error_line = n->line;
+            return -1;
+        }
+        int loop = g->depth - n->index;
+        if (n->kind == SN_CONTINUE) return script_emit(p, OP_JUMP, g->continue_target[loop]) < 0 ? -1 : 0;
+        jump = script_emit(p, OP_JUMP, g->break_chain[loop]);
+        if (jump < 0) return -1;
+        g->break_chain[loop] = jump;
+        return 0;
+    }
+    }
+    return -1;
+}
+
+// Fungsi untuk mengompilasi teks skrip. name dipakai di pesan galat; NULL jika sintaks salah.
+static struct script_program* script_compile(const char* src, const char* name) {
+    struct script_parser ps;
+    memset(&ps, 0, sizeof(ps));
+    ps.p = calloc(1, sizeof(struct script_program));
+    if (ps.p == NULL) return NULL;
+    ps.p->refs = 1;
+
+    struct script_node* root = NULL;
+    if (script_lex(&ps, src) == 0) {
+        root = script_parse_list(&ps);
+        if (ps.error[0] == '\0' && script_peek(&ps)->kind != TOK_END) {
+            script_error(&ps, script_peek(&ps)->line, "'%s' tak terduga", script_token_text(&ps));
+        }
+    } else if (ps.error[0] == '\0') {
+        script_error(&ps, 0, "memori tidak cukup");
+    }
+
+    struct script_codegen g;
+    memset(&g, 0, sizeof(g));
+    g.p = ps.p;
+    if (ps.error[0] == '\0' && root != NULL && (script_gen(&g, root) != 0 || script_emit(ps.p, OP_END, 0) < 0)) {
+        snprintf(ps.error, sizeof(ps.error), "%s", g.error[0] != '\0' ? g.error : "memori tidak cukup");
+        ps.error_line = g.error_line;
+    }
+    script_node_free(root);
+    free(ps.tokens);
+
+    if (ps.error[0] != '\0') {
+        fprintf(stderr, "mishell: %s:%d: %s\n", name, ps.error_line, ps.error);
+        script_release(ps.p);
+        return NULL;
+    }
+    return ps.p;
+}
+
+// ---------- Interpreter ----------
+
+static void script_execute(const struct script_program* p);
+
+// Pid substitusi proses <(...) yang masih berjalan, sejajar dengan kept_fds
+static pid_t procsub_pids[MAX_ARGS];
+
+// Fungsi untuk menjalankan sub-program di proses anak dengan stdout ke pipe. fd baca pipe dikembalikan
+// lewat read_fd; untuk <(...) fd itu tidak close-on-exec agar bisa dibuka perintah lewat /dev/fd/N.
+static pid_t script_spawn_sub(const struct script_program* sub, int* read_fd, int inherit) {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        perror("pipe");
+        return -1;
+    }
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        close_inherited_fds();
+        script_execute(sub);
+        fflush(stdout);
+        _exit(last_exit_status);
+    }
+    close(fds[1]);
+    if (pid < 0) {
+        perror("fork");
+        close(fds[0]);
+        return -1;
+    }
+    if (inherit) fcntl(fds[0], F_SETFD, 0);
+    *read_fd = fds[0];
+    return pid;
+}
+
+static int script_wait(pid_t pid) {
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return 1;
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+
+// Fungsi untuk menangkap keluaran $(...) langsung dari pipe ke arena out (tanpa file sementara).
+// Baris baru di akhir dibuang seperti di bash; mengembalikan status keluar sub-program.
+static int script_capture(const struct script_program* sub, struct text_buffer* out) {
+    int fd;
+    pid_t pid = script_spawn_sub(sub, &fd, 0);
+    if (pid < 0) return 1;
+    size_t start = out->len;
+    for (;;) {
+        if (out->capacity - out->len < 4096) {
+            size_t capacity = out->capacity ? out->capacity * 2 : 16384;
+            while (capacity - out->len < 4096) capacity *= 2;
+            char* grown = realloc(out->data, capacity);
+            if (grown == NULL) break;
+            out->data = grown;
+            out->capacity = capacity;
+        }
+        ssize_t n = read(fd, out->data + out->len, out->capacity - out->len - 1);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        out->len += n;
+    }
+    close(fd);
+    while (out->len > start && out->data[out->len - 1] == '\n') out->len--;
+    if (out->data != NULL) out->data[out->len] = '\0';
+    return script_wait(pid);
+}
+
+// Fungsi untuk menutup fd <(...) yang dibuka setelah base dan menunggu prosesnya
+static void script_procsub_finish(int base) {
+    while (kept_fd_count > base) {
+        kept_fd_count--;
+        close(kept_fds[kept_fd_count]);
+        script_wait(procsub_pids[kept_fd_count]);
+    }
+}
+
+struct script_field {
+    size_t value_at;
+    size_t pattern_at;          // SIZE_MAX jika bukan pola glob
+};
+
+// Hasil ekspansi kata satu perintah. Nilai $VAR dan keluaran $(...) ditulis ke arena text, argv hasil
+// pemecahan kata ke arena fields; semuanya dipakai ulang dan hanya tumbuh.
+struct script_expansion {
+    struct text_buffer text;
+    struct text_buffer fields;
+    struct text_buffer pattern; // Pola glob field yang sedang disusun
+    struct script_field* items;
+    int count, capacity;
+    int sub_status;             // Status $(...) terakhir, -1 jika tidak ada
+};
+
+static void script_expansion_free(struct script_expansion* x) {
+    free(x->text.data);
+    free(x->fields.data);
+    free(x->pattern.data);
+    free(x->items);
+}
+
+// Fungsi untuk menutup field yang dimulai di value_at; field glob disimpan bersama polanya
+static void script_end_field(struct script_expansion* x, size_t value_at, int glob) {
+    buf_append(&x->fields, "", 1);
+    size_t pattern_at = SIZE_MAX;
+    if (glob) {
+        pattern_at = x->fields.len;
+        buf_append(&x->fields, x->pattern.data != NULL ? x->pattern.data : "", x->pattern.len);
+        buf_append(&x->fields, "", 1);
+    }
+    x->pattern.len = 0;
+    if (script_grow((void**)&x->items, &x->capacity, x->count, sizeof(*x->items)) != 0) return;
+    x->items[x->count].value_at = value_at;
+    x->items[x->count].pattern_at = pattern_at;
+    x->count++;
+}
+
+// Fungsi untuk menambahkan hasil ekspansi ke pola; karakter di special di-escape agar literal
+static void script_pattern_add(struct script_expansion* x, const char* text, size_t len, const char* special) {
+    size_t from = 0;
+    for (size_t k = 0; k < len; k++) {
+        if (strchr(special, text[k]) == NULL) continue;
+        buf_append(&x->pattern, text + from, k - from);
+        buf_append(&x->pattern, "\\", 1);
+        from = k;
+    }
+    buf_append(&x->pattern, text + from, len - from);
+}
+
+static int is_field_separator(char c) {
+    return c == ' ' || c == '\t' || c == '\n';
+}
+
+// Fungsi untuk mengekspansi satu kata menjadi nol atau lebih field. Hasil $VAR/$(...) tanpa kutip
+// dipecah per spasi, tab dan baris baru lalu boleh menjadi pola glob, seperti di bash. raw (untuk
+// nilai assignment, skip = panjang "NAMA=") selalu menghasilkan satu field tanpa pemecahan dan glob.
+static void script_expand_word(const struct script_program* p, const struct script_word* w,
+                               struct script_expansion* x, int raw, int skip) {
+    size_t value_at = x->fields.len;
+    x->pattern.len = 0;
+    if (w->parts == NULL) {
+        buf_append(&x->fields, w->value + skip, strlen(w->value + skip));
+        if (!raw && w->pattern != NULL) buf_append(&x->pattern, w->pattern, strlen(w->pattern));
+        script_end_field(x, value_at, !raw && w->pattern != NULL);
+        return;
+    }
+
+    // Tahap 1: setiap bagian dinamis dijalankan tepat sekali, hasilnya di arena text
+    size_t* at = malloc(w->part_count * 2 * sizeof(size_t));
+    if (at == NULL) return;
+    x->text.len = 0;
+    for (int i = 0; i < w->part_count; i++) {
+        const struct script_part* part = &w->parts[i];
+        at[2 * i] = x->text.len;
+        if (part->kind == PART_VAR) {
+            const char* value = shell_var_get(part->text);
+            if (strcmp(part->text, "?") == 0) buf_printf(&x->text, "%d", last_exit_status);
+            else if (value != NULL) buf_append(&x->text, value, strlen(value));
+        } else if (part->kind == PART_CMDSUB) {
+            x->sub_status = script_capture(p->subs[part->sub], &x->text);
+        } else if (part->kind == PART_PROCSUB) {
+            int fd;
+            pid_t pid = kept_fd_count < MAX_ARGS ? script_spawn_sub(p->subs[part->sub], &fd, 1) : -1;
+            if (pid > 0) {
+                kept_fds[kept_fd_count] = fd;
+                procsub_pids[kept_fd_count++] = pid;
+                buf_printf(&x->text, "/dev/fd/%d", fd);
+            }
+        }
+        at[2 * i + 1] = x->text.len - at[2 * i];
+    }
+
+    // Tahap 2: menyusun field (dan polanya) dari teks literal dan hasil tahap 1
+    int has = raw, glob = 0;
+    for (int i = 0; i < w->part_count; i++) {
+        const struct script_part* part = &w->parts[i];
+        if (part->kind == PART_TEXT) {
+            const char* text = part->text + (i == 0 ? skip : 0);
+            buf_append(&x->fields, text, strlen(text));
+            if (!raw) buf_append(&x->pattern, part->pattern, strlen(part->pattern));
+            has = 1;
+            glob |= w->has_meta;
+            continue;
+        }
+        const char* text = x->text.data + at[2 * i];
+        size_t len = at[2 * i + 1];
+        if (raw || part->quoted || part->kind == PART_PROCSUB) {
+            buf_append(&x->fields, text, len);
+            if (!raw) script_pattern_add(x, text, len, "*?[]{},\\");
+            has |= part->quoted || len > 0;
+            continue;
+        }
+        for (size_t k = 0; k < len; ) {
+            if (is_field_separator(text[k])) {
+                if (has) {
+                    script_end_field(x, value_at, glob);
+                    value_at = x->fields.len;
+                    has = glob = 0;
+                }
+                k++;
+                continue;
+            }
+            size_t run = k;
+            while (run < len && !is_field_separator(text[run])) run++;
+            buf_append(&x->fields, text + k, run - k);
+            script_pattern_add(x, text + k, run - k, "{},\\");
+            for (size_t j = k; j < run && !glob; j++) glob = strchr("*?[", text[j]) != NULL;
+            has = 1;
+            k = run;
+        }
+    }
+    if (has) script_end_field(x, value_at, glob && !raw);
+    free(at);
+}
+
+// Fungsi untuk menyusun argv satu tahap dari kata hasil kompilasi, tanpa lexing ulang. String ditulis
+// ke arena; kata berpola glob didaftarkan agar expand_glob_args dan glob_for_each mengenalinya.
+static int script_build_args(const struct script_program* p, const struct script_stage* st, int first, char** args,
+                             struct script_expansion* x) {
+    x->count = 0;
+    x->fields.len = 0;
+    for (int i = first; i < st->word_count; i++) script_expand_word(p, &p->words[st->first_word + i], x, 0, 0);
+    if (x->count > MAX_ARGS - 1) {
+        fprintf(stderr, "mishell: terlalu banyak argumen setelah ekspansi (maks %d)\n", MAX_ARGS - 1);
+        return -1;
+    }
+    int globs = 0;
+    for (int i = 0; i < x->count; i++) {
+        args[i] = x->fields.data + x->items[i].value_at;
+        if (x->items[i].pattern_at != SIZE_MAX) {
+            glob_token[globs] = args[i];
+            glob_token_pattern[globs++] = x->fields.data + x->items[i].pattern_at;
+        }
+    }
+    args[x->count] = NULL;
+    glob_token[globs] = NULL;
+    return 0;
+}
+
+// Fungsi untuk mengisi variabel dari kata NAMA=nilai di awal tahap (nilai tidak dipecah atau di-glob)
+static void script_assign(const struct script_program* p, const struct script_stage* st, struct script_expansion* x,
+                          int exported) {
+    for (int i = 0; i < st->assign_count; i++) {
+        const struct script_word* w = &p->words[st->first_word + i];
+        x->count = 0;
+        x->fields.len = 0;
+        script_expand_word(p, w, x, 1, w->assign_len);
+        char name[128];
+        snprintf(name, sizeof(name), "%.*s", w->assign_len - 1, w->parts != NULL ? w->parts[0].text : w->value);
+        if (x->count == 1) shell_var_set(name, x->fields.data + x->items[0].value_at, exported);
+    }
+}
+
+struct script_pipeline {
+    const struct script_program* p;
+    const struct script_command* c;
+    struct script_expansion stages[MAX_ARGS];   // Tetap hidup sampai semua tahap (termasuk thread) selesai
+    struct shell_env* saved;                    // Environment sebelum "NAMA=nilai" milik tahap terakhir
+};
+
+// Tahap disusun tepat sebelum di-fork, jadi assignment milik satu tahap cukup dipasang sampai tahap
+// berikutnya disusun
+static int script_pipeline_stage(void* ctx, int index, char** args) {
+    struct script_pipeline* sp = ctx;
+    const struct script_stage* st = &sp->p->stages[sp->c->first_stage + index];
+    if (sp->saved != NULL) {
+        shell_env_restore(sp->saved);
+        sp->saved = NULL;
+    }
+    if (st->assign_count > 0) {
+        sp->saved = shell_env_snapshot();
+        script_assign(sp->p, st, &sp->stages[index], 1);
+        shell_env_sync();
+    }
+    return script_build_args(sp->p, st, st->assign_count, args, &sp->stages[index]);
+}
+
+static void script_run_command(const struct script_program* p, const struct script_command* c) {
+    int procsub_base = kept_fd_count;
+    if (c->stage_count == 1) {
+        const struct script_stage* st = &p->stages[c->first_stage];
+        struct script_expansion x;
+        memset(&x, 0, sizeof(x));
+        x.sub_status = -1;
+        if (st->assign_count == st->word_count) {
+            // Hanya assignment: status mengikuti $(...) terakhir
+            script_assign(p, st, &x, -1);
+            last_exit_status = x.sub_status >= 0 ? x.sub_status : 0;
+        } else {
+            // NAMA=nilai perintah: variabel diekspor hanya untuk perintah ini
+            struct shell_env* saved = st->assign_count > 0 ? shell_env_snapshot() : NULL;
+            if (saved != NULL) script_assign(p, st, &x, 1);
+            char* args[MAX_ARGS];
+            if (script_build_args(p, st, st->assign_count, args, &x) == 0) run_parsed_command(args);
+            else last_exit_status = 1;
+            if (saved != NULL) shell_env_restore(saved);
+        }
+        script_expansion_free(&x);
+        script_procsub_finish(procsub_base);
+        return;
+    }
+    struct script_pipeline* sp = calloc(1, sizeof(*sp));
+    if (sp == NULL) {
+        last_exit_status = 1;
+        return;
+    }
+    sp->p = p;
+    sp->c = c;
+    run_pipeline(c->stage_count < MAX_ARGS ? c->stage_count : MAX_ARGS, script_pipeline_stage, sp);
+    if (sp->saved != NULL) shell_env_restore(sp->saved);
+    for (int i = 0; i < MAX_ARGS; i++) script_expansion_free(&sp->stages[i]);
+    free(sp);
+    script_procsub_finish(procsub_base);
+}
+
+// Daftar kata for yang sudah diekspansi (termasuk glob)
+struct script_iter {
+    char** values;
+    int count, capacity, next;
+};
+
+static int script_iter_add(const char* value, void* ctx) {
+    struct script_iter* it = ctx;
+    if (script_grow((void**)&it->values, &it->capacity, it->count, sizeof(char*)) != 0) return 1;
+    if ((it->values[it->count] = strdup(value)) == NULL) return 1;
+    it->count++;
+    return 0;
+}
+
+static void script_iter_clear(struct script_iter* it) {
+    for (int i = 0; i < it->count; i++) free(it->values[i]);
+    it->count = 0;
+    it->next = 0;
+}
+
+static void script_for_init(const struct script_program* p, const struct script_for* f, struct script_iter* it) {
+    struct script_expansion x;
+    memset(&x, 0, sizeof(x));
+    script_iter_clear(it);
+    for (int i = 0; i < f->word_count; i++) script_expand_word(p, &p->words[f->first_word + i], &x, 0, 0);
+    for (int i = 0; i < x.count; i++) {
+        if (x.items[i].pattern_at != SIZE_MAX) glob_stream(x.fields.data + x.items[i].pattern_at, 0, script_iter_add, it);
+        else script_iter_add(x.fields.data + x.items[i].value_at, it);
+    }
+    script_expansion_free(&x);
+}
+
+// Loop interpreter: setiap perintah sudah berupa kata hasil kompilasi, builtin dipanggil langsung
+static void script_execute(const struct script_program* p) {
+    struct script_iter* iters = p->for_count > 0 ? calloc(p->for_count, sizeof(*iters)) : NULL;
+    if (p->for_count > 0 && iters == NULL) {
+        last_exit_status = 1;
+        return;
+    }
+    uint32_t pc = 0;
+    int running = 1;
+    while (running) {
+        uint32_t ins = p->code[pc++];
+        uint32_t arg = ins >> 8;
+        switch (ins & 0xFF) {
+        case OP_END:
+            running = 0;
+            break;
+        case OP_RUN:
+            script_run_command(p, &p->commands[arg]);
+            break;
+        case OP_JUMP:
+            pc = arg;
+            break;
+        case OP_JUMP_FAIL:
+            if (last_exit_status != 0) pc = arg;
+            break;
+        case OP_JUMP_OK:
+            if (last_exit_status == 0) pc = arg;
+            break;
+        case OP_NOT:
+            last_exit_status = last_exit_status == 0;
+            break;
+        case OP_STATUS:
+            last_exit_status = arg;
+            break;
+        case OP_FOR_INIT:
+            script_for_init(p, &p->fors[arg], &iters[arg]);
+            last_exit_status = 0;
+            break;
+        case OP_FOR_NEXT: {
+            struct script_iter* it = &iters[arg];
+            uint32_t target = p->code[pc++];
+            if (it->next < it->count) shell_var_set(p->fors[arg].var, it->values[it->next++], -1);
+            else pc = target;
+            break;
+        }
+        }
+    }
+    for (int i = 0; i < p->for_count; i++) {
+        script_iter_clear(&iters[i]);
+        free(iters[i].values);
+    }
+    free(iters);
+}
+
+// Fungsi untuk menjalankan teks skrip sekali (mis. satu baris interaktif), tanpa cache
+void script_run_text(const char* text, const char* name) {
+    struct script_program* p = script_compile(text, name);
+    if (p == NULL) {
+        last_exit_status = 2;
+        return;
+    }
+    script_execute(p);
+    script_release(p);
+}
+
+// Cache program hasil kompilasi per file skrip, dikenali dari path dan mtime (serta ukuran)
+struct script_cache_entry {
+    char* path;
+    struct timespec mtime;
+    off_t size;
+    struct script_program* program;
+};
+
+static struct script_cache_entry script_cache[SCRIPT_CACHE_SIZE];
+static int script_cache_next;
+static int script_cache_hits, script_cache_misses;
+
+// Fungsi untuk menjalankan file skrip di shell ini; bytecode dipakai ulang selama file tidak berubah
+void script_run_file(const char* path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        fprintf(stderr, "jalankan: %s: %s\n", path, strerror(errno));
+        last_exit_status = 127;
+        return;
+    }
+
+    struct script_cache_entry* slot = NULL;
+    for (int i = 0; i < SCRIPT_CACHE_SIZE; i++) {
+        if (script_cache[i].path != NULL && strcmp(script_cache[i].path, path) == 0) {
+            slot = &script_cache[i];
+            break;
+        }
+    }
+    if (slot != NULL && slot->mtime.tv_sec == st.st_mtim.tv_sec && slot->mtime.tv_nsec == st.st_mtim.tv_nsec &&
+        slot->size == st.st_size) {
+        script_cache_hits++;
+    } else {
+        size_t len;
+        char* text = read_whole_file(path, &len);
+        if (text == NULL) {
+            fprintf(stderr, "jalankan: %s: %s\n", path, strerror(errno));
+            last_exit_status = 127;
+            return;
+        }
+        struct script_program* program = script_compile(text, path);
+        free(text);
+        if (program == NULL) {
+            last_exit_status = 2;
             return;
         }
+        script_cache_misses++;
+        if (slot == NULL) {
+            slot = &script_cache[script_cache_next];
+            script_cache_next = (script_cache_next + 1) % SCRIPT_CACHE_SIZE;
+            free(slot->path);
+            slot->path = strdup(path);
+        }
+        // Program lama tetap hidup selama masih dijalankan (mis. skrip yang menjalankan dirinya sendiri)
+        script_release(slot->program);
+        slot->program = program;
+        slot->mtime = st.st_mtim;
+        slot->size = st.st_size;
+    }
+
+    struct script_program* program = slot->program;
+    program->refs++;
+    script_execute(program);
+    script_release(program);
+}
+
+// Fungsi untuk memeriksa apakah baris memakai sintaks skrip (; && || baris baru, $VAR, $(...), <(...),
+// assignment NAMA=nilai, atau diawali if/for/while/until/!) sehingga perlu dikompilasi, bukan
+// dijalankan langsung sebagai satu perintah
+int is_script_line(const char* line) {
+    static const char* keywords[] = { "if", "for", "while", "until", "!", NULL };
+    const char* p = line;
+    while (*p == ' ' || *p == '\t') p++;
+    for (int i = 0; keywords[i] != NULL; i++) {
+        size_t n = strlen(keywords[i]);
+        if (strncmp(p, keywords[i], n) == 0 && (p[n] == ' ' || p[n] == '\t' || p[n] == '\0')) return 1;
+    }
+    size_t name_len = strspn(p, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_");
+    if (p[name_len] == '=' && shell_var_name_valid(p, name_len)) return 1;
+
+    char quote = 0;
+    for (; *p != '\0'; p++) {
+        if (quote) {
+            if (*p == quote) quote = 0;
+            else if (*p == '\\' && quote == '"' && p[1] != '\0') p++;
+            else if (*p == '$' && quote == '"') return 1;
+        } else if (*p == '\'' || *p == '"') {
+            quote = *p;
+        } else if (*p == '\\' && p[1] != '\0') {
+            p++;
+        } else if (*p == ';' || *p == '\n' || (*p == '&' && p[1] == '&') || (*p == '|' && p[1] == '|') ||
+                   *p == '$' || (*p == '<' && p[1] == '(')) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Fungsi untuk menjalankan satu baris input: sintaks skrip lewat kompiler, selain itu langsung
+void run_input_line(char* line) {
+    if (is_script_line(line)) script_run_text(line, "input");
+    else run_command_line(line);
+}
+
+// Fungsi builtin "jalankan": menjalankan file skrip mishell di shell ini
+void jalankan_command(char** args) {
+    if (args[1] == NULL) {
+        printf("Penggunaan: jalankan <file skrip> | jalankan cache\n");
+        last_exit_status = 2;
+        return;
+    }
+    if (strcmp(args[1], "cache") == 0) {
+        printf("Cache bytecode skrip: %d hit, %d kompilasi\n", script_cache_hits, script_cache_misses);
+        for (int i = 0; i < SCRIPT_CACHE_SIZE; i++) {
+            const struct script_cache_entry* e = &script_cache[i];
+            if (e->path == NULL) continue;
+            printf("  %-40s %d instruksi, %d perintah\n", e->path, e->program->code_len, e->program->command_count);
+        }
+        return;
+    }
+    script_run_file(args[1]);
+}
+
+// Satu sel layar untuk rendering berbasis diff
+struct screen_cell {
+    char ch;
+    unsigned char color;
+};
+
+// Warna sel layar "cek top"
+enum { SCREEN_DEFAULT, SCREEN_GREEN, SCREEN_YELLOW, SCREEN_RED, SCREEN_CYAN, SCREEN_BOLD };
+static const char* screen_colors[] = { "\033[0m", "\033[1;32m", "\033[1;33m", "\033[1;31m", "\033[1;36m", "\033[1m" };
+
+// Layar virtual: front = isi terminal saat ini, back = frame berikutnya
+struct screen {
+    int rows, cols;
+    struct screen_cell* front;
+    struct screen_cell* back;
+    char* out;
+    size_t out_size;
+};
+
+// Fungsi untuk (re)alokasi layar virtual sesuai ukuran terminal
+static int screen_resize(struct screen* s, int rows, int cols) {
+    free(s->front);
+    free(s->back);
+    free(s->out);
+
+    s->rows = rows;
+    s->cols = cols;
+    s->front = calloc((size_t)rows * cols, sizeof(struct screen_cell));
+    s->back = calloc((size_t)rows * cols, sizeof(struct screen_cell));
+    // Kasus terburuk: setiap sel butuh pindah kursor + ganti warna
+    s->out_size = (size_t)rows * cols * 24 + 64;
+    s->out = malloc(s->out_size);
+
+    return (s->front && s->back && s->out) ? 0 : -1;
+}
+
+// Fungsi untuk mengosongkan frame berikutnya
+static void screen_clear(struct screen* s) {
+    for (int i = 0; i < s->rows * s->cols; i++) {
+        s->back[i].ch = ' ';
+        s->back[i].color = SCREEN_DEFAULT;
+    }
+}
+
+// Fungsi untuk menulis teks terformat ke frame berikutnya (dipotong di tepi layar)
+static void screen_print(struct screen* s, int row, int col, unsigned char color, const char* fmt, ...) {
+    if (row < 0 || row >= s->rows) return;
+
+    char text[512];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+
+    for (int i = 0; text[i] != '\0' && col + i < s->cols; i++) {
+        struct screen_cell* c = &s->back[row * s->cols + col + i];
+        c->ch = text[i];
+        c->color = color;
+    }
+}
+
+// Fungsi untuk menggambar bar persentase berwarna, mis. [||||||    ]
+static void screen_bar(struct screen* s, int row, int col, int width, double percent) {
+    if (width < 3) return;
+    int inner = width - 2;
+    int filled = (int)(percent / 100.0 * inner + 0.5);
+    if (filled > inner) filled = inner;
+    if (filled < 0) filled = 0;
+
+    unsigned char color = percent < 50 ? SCREEN_GREEN : percent < 80 ? SCREEN_YELLOW : SCREEN_RED;
+    screen_print(s, row, col, SCREEN_DEFAULT, "[");
+    for (int i = 0; i < inner; i++) {
+        screen_print(s, row, col + 1 + i, color, "%c", i < filled ? '|' : ' ');
+    }
+    screen_print(s, row, col + width - 1, SCREEN_DEFAULT, "]");
+}
+
+// Fungsi untuk menulis hanya sel yang berubah ke terminal dengan satu write()
+static void screen_flush(struct screen* s) {
+    size_t len = 0;
+    int cur_row = -1, cur_col = -1;
+    int cur_color = -1;
+
+    for (int r = 0; r < s->rows; r++) {
+        for (int c = 0; c < s->cols; c++) {
+            // Sel pojok kanan bawah dilewati agar terminal tidak menggulung layar
+            if (r == s->rows - 1 && c == s->cols - 1) continue;
+
+            struct screen_cell* b = &s->back[r * s->cols + c];
+            struct screen_cell* f = &s->front[r * s->cols + c];
+            if (b->ch == f->ch && b->color == f->color) continue;
+
+            if (r != cur_row || c != cur_col) {
+                len += snprintf(s->out + len, s->out_size - len, "\033[%d;%dH", r + 1, c + 1);
+            }
+            if (b->color != cur_color) {
+                len += snprintf(s->out + len, s->out_size - len, "%s", screen_colors[b->color]);
+                cur_color = b->color;
+            }
+            s->out[len++] = b->ch;
+            *f = *b;
+            cur_row = r;
+            cur_col = c + 1;
+        }
+    }
+
+    if (len > 0) {
+        len += snprintf(s->out + len, s->out_size - len, "\033[0m");
+        if (write(STDOUT_FILENO, s->out, len) < 0) {
+            // Terminal tertutup, abaikan
+        }
+    }
+}
+
+// Fungsi untuk menyusun satu frame dashboard "cek top"
+static void compose_top_frame(struct screen* s, int rate_hz, const struct cpu_sample* cpu_prev,
+                              const struct cpu_sample* cpu_cur, const struct mem_info* mem,
+                              const double load[3], const struct disk_sample* disk_prev,
+                              const struct disk_sample* disk_cur) {
+    int row = 0;
+    int bar_width = s->cols - 60 > 12 ? s->cols - 60 : 12;
+    if (bar_width > 50) bar_width = 50;
+
+    screen_clear(s);
+    screen_print(s, row++, 0, SCREEN_CYAN, "mishell-EDU cek top | %d Hz | load %.2f %.2f %.2f | q: keluar",
+                 rate_hz, load[0], load[1], load[2]);
+    row++;
+
+    // Penggunaan CPU total
+    struct cpu_usage total;
+    compute_cpu_usage(&cpu_prev->total, &cpu_cur->total, &total);
+    screen_print(s, row, 0, SCREEN_BOLD, "CPU ");
+    screen_bar(s, row, 6, bar_width, total.busy);
+    screen_print(s, row++, 7 + bar_width, SCREEN_DEFAULT, "%5.1f%%  us %4.1f sy %4.1f io %4.1f st %4.1f irq %4.1f",
+                 total.busy, total.user, total.system, total.iowait, total.steal, total.irq);
+
+    // Disk yang akan ditampilkan menentukan sisa baris untuk core
+    int disk_rows = disk_cur->count > 0 ? disk_cur->count + 2 : 0;
+    int core_rows_avail = s->rows - row - 4 - disk_rows;
+
+    // Core CPU dalam beberapa kolom jika layar lebar
+    int cell_width = 26;
+    int per_row = s->cols / cell_width > 0 ? s->cols / cell_width : 1;
+    int num_cores = cpu_cur->num_cores < cpu_prev->num_cores ? cpu_cur->num_cores : cpu_prev->num_cores;
+    for (int i = 0; i < num_cores; i++) {
+        int r = i / per_row;
+        if (r >= core_rows_avail) break;
+        struct cpu_usage core;
+        compute_cpu_usage(&cpu_prev->cores[i], &cpu_cur->cores[i], &core);
+        int col = (i % per_row) * cell_width;
+        screen_print(s, row + r, col, SCREEN_DEFAULT, "%-5d", i);
+        screen_bar(s, row + r, col + 5, 12, core.busy);
+        screen_print(s, row + r, col + 18, SCREEN_DEFAULT, "%5.1f%%", core.busy);
+    }
+    int used_core_rows = (num_cores + per_row - 1) / per_row;
+    row += used_core_rows < core_rows_avail ? used_core_rows : (core_rows_avail > 0 ? core_rows_avail : 0);
+    row++;
+
+    // Memori dan swap
+    unsigned long long used = mem->total > mem->available ? mem->total - mem->available : 0;
+    double mem_percent = mem->total ? 100.0 * used / mem->total : 0;
+    screen_print(s, row, 0, SCREEN_BOLD, "MEM ");
+    screen_bar(s, row, 6, bar_width, mem_percent);
+    screen_print(s, row++, 7 + bar_width, SCREEN_DEFAULT, "%5.1f%%  %.2f/%.2f GB  cache %.2f GB",
+                 mem_percent, used / 1048576.0, mem->total / 1048576.0, (mem->cached + mem->buffers) / 1048576.0);
+
+    unsigned long long swap_used = mem->swap_total > mem->swap_free ? mem->swap_total - mem->swap_free : 0;
+    double swap_percent = mem->swap_total ? 100.0 * swap_used / mem->swap_total : 0;
+    screen_print(s, row, 0, SCREEN_BOLD, "SWAP");
+    screen_bar(s, row, 6, bar_width, swap_percent);
+    screen_print(s, row++, 7 + bar_width, SCREEN_DEFAULT, "%5.1f%%  %.2f/%.2f GB",
+                 swap_percent, swap_used / 1048576.0, mem->swap_total / 1048576.0);
+
+    // Laju I/O disk
+    if (disk_cur->count > 0) {
+        row++;
+        screen_print(s, row++, 0, SCREEN_BOLD, "%-12s %12s %12s %9s %9s %7s",
+                     "DISK", "Baca kB/s", "Tulis kB/s", "r/s", "w/s", "Util");
+        for (int i = 0; i < disk_cur->count && row < s->rows; i++) {
+            struct disk_rate rate;
+            compute_disk_rate(disk_prev, disk_cur, &disk_cur->disks[i], &rate);
+            screen_print(s, row, 0, SCREEN_DEFAULT, "%-12s %12.1f %12.1f %9.1f %9.1f ",
+                         disk_cur->disks[i].name, rate.read_kbs, rate.write_kbs, rate.read_iops, rate.write_iops);
+            screen_print(s, row++, 60, rate.util < 50 ? SCREEN_GREEN : rate.util < 80 ? SCREEN_YELLOW : SCREEN_RED,
+                         "%6.1f%%", rate.util);
+        }
+    }
+}
+
+// Fungsi untuk mendapatkan ukuran terminal
+static void terminal_size(int* rows, int* cols) {
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0 && ws.ws_col > 0) {
+        *rows = ws.ws_row;
+        *cols = ws.ws_col;
+    } else {
+        *rows = 24;
+        *cols = 80;
+    }
+}
+
+// Fungsi untuk menampilkan dashboard live CPU, memori, disk, dan load (cek top)
+// Di-refresh oleh timerfd dan poll; hanya sel layar yang berubah yang ditulis ulang.
+void live_top(int rate_hz) {
+    static struct cpu_sample cpu_samples[2];
+    static struct disk_sample disk_samples[2];
+    struct mem_info mem;
+    double load[3] = {0, 0, 0};
+
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) {
+        printf("cek top membutuhkan terminal interaktif.\n");
+        return;
+    }
+    if (rate_hz < 1) rate_hz = 1;
+    if (rate_hz > TOP_MAX_RATE_HZ) rate_hz = TOP_MAX_RATE_HZ;
+
+    // SIGWINCH diterima lewat signalfd agar bisa ditangani di loop poll yang sama
+    sigset_t winch_mask, old_mask;
+    sigemptyset(&winch_mask);
+    sigaddset(&winch_mask, SIGWINCH);
+    sigprocmask(SIG_BLOCK, &winch_mask, &old_mask);
+    int sig_fd = signalfd(-1, &winch_mask, SFD_CLOEXEC | SFD_NONBLOCK);
+
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (timer_fd < 0 || sig_fd < 0) {
+        perror("timerfd/signalfd");
+        if (timer_fd >= 0) close(timer_fd);
+        if (sig_fd >= 0) close(sig_fd);
+        sigprocmask(SIG_SETMASK, &old_mask, NULL);
+        return;
+    }
+
+    long interval_ns = 1000000000L / rate_hz;
+    struct itimerspec its;
+    its.it_interval.tv_sec = interval_ns / 1000000000L;
+    its.it_interval.tv_nsec = interval_ns % 1000000000L;
+    its.it_value = its.it_interval;
+    timerfd_settime(timer_fd, 0, &its, NULL);
+
+    // Mode terminal mentah: tanpa echo, tanpa buffer baris, Ctrl+C dibaca sebagai karakter
+    struct termios old_term, raw_term;
+    tcgetattr(STDIN_FILENO, &old_term);
+    raw_term = old_term;
+    raw_term.c_lflag &= ~(ICANON | ECHO | ISIG);
+    raw_term.c_cc[VMIN] = 0;
+    raw_term.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &raw_term);
+
+    // Layar alternatif dan kursor disembunyikan
+    const char* enter = "\033[?1049h\033[?25l\033[2J";
+    if (write(STDOUT_FILENO, enter, strlen(enter)) < 0) {
+        // Abaikan
+    }
+
+    struct screen scr = { 0 };
+    int rows, cols;
+    terminal_size(&rows, &cols);
+    screen_resize(&scr, rows, cols);
+
+    int cur = 0;
+    sample_cpu(&cpu_samples[cur]);
+    sample_diskstats(&disk_samples[cur]);
+    int resized = 0;
+    int running = 1;
+
+    while (running) {
+        struct pollfd fds[3] = {
+            { STDIN_FILENO, POLLIN, 0 },
+            { timer_fd, POLLIN, 0 },
+            { sig_fd, POLLIN, 0 },
+        };
+        if (poll(fds, 3, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
 
-        int capacity;
-        if (fscanf(fp, "%d", &capacity) != 1) {
-            perror("Gagal membaca kapasitas baterai");
-            fclose(fp);
-            return;
+        if (fds[0].revents & POLLIN) {
+            char keys[32];
+            ssize_t n = read(STDIN_FILENO, keys, sizeof(keys));
+            for (ssize_t i = 0; i < n; i++) {
+                if (keys[i] == 'q' || keys[i] == 'Q' || keys[i] == 3) running = 0;
+            }
         }
+        if (fds[0].revents & (POLLHUP | POLLERR)) running = 0;
 
-        printf("Kapasitas Baterai: %d%%\n", capacity);
-        fclose(fp);
+        if (fds[2].revents & POLLIN) {
+            struct signalfd_siginfo info;
+            while (read(sig_fd, &info, sizeof(info)) > 0) {
+            }
+            // Ukuran terminal berubah: alokasi ulang dan gambar ulang seluruh layar
+            terminal_size(&rows, &cols);
+            screen_resize(&scr, rows, cols);
+            const char* clear = "\033[2J";
+            if (write(STDOUT_FILENO, clear, strlen(clear)) < 0) {
+                // Abaikan
+            }
+            resized = 1;
+        }
+
+        if (running && (fds[1].revents & POLLIN)) {
+            uint64_t expirations;
+            if (read(timer_fd, &expirations, sizeof(expirations)) < 0) continue;
+
+            int next = 1 - cur;
+            sample_cpu(&cpu_samples[next]);
+            sample_diskstats(&disk_samples[next]);
+            sample_meminfo(&mem);
+            sample_loadavg(load);
+
+            compose_top_frame(&scr, rate_hz, &cpu_samples[cur], &cpu_samples[next], &mem, load,
+                              &disk_samples[cur], &disk_samples[next]);
+            screen_flush(&scr);
+            cur = next;
+        }
     }
-    // Test Speed
-    else if (strcmp(args[0], "test") == 0 && strcmp(args[1], "speed") == 0) {
-        // Memeriksa apakah speedtest-cli sudah terinstal
-        printf("Memeriksa apakah speedtest-cli sudah terinstal...\n");
 
-        // Cek dengan lebih akurat
-        int status = system("which speedtest-cli > /dev/null 2>&1");
-        
-        if (status != 0) {
-            printf("speedtest-cli tidak ditemukan. Menginstal...\n");
-            
-            // Menginstal speedtest-cli jika belum terinstal
-            system("sudo apt-get update && sudo apt-get install -y speedtest-cli");
-
-            // Periksa lagi setelah instalasi
-            status = system("which speedtest-cli > /dev/null 2>&1");
-            if (status != 0) {
-                printf("Gagal menginstal speedtest-cli. Silakan instal manual dengan:\n");
-                printf("sudo apt-get install speedtest-cli\n");
-                return;
-            }
-            
-        printf("speedtest-cli telah terinstal.\n");
+    // Kembalikan terminal seperti semula
+    const char* leave = "\033[0m\033[?25h\033[?1049l";
+    if (write(STDOUT_FILENO, leave, strlen(leave)) < 0) {
+        // Abaikan
+    }
+    tcsetattr(STDIN_FILENO, TCSANOW, &old_term);
+
+    close(timer_fd);
+    close(sig_fd);
+    sigprocmask(SIG_SETMASK, &old_mask, NULL);
+
+    free(scr.front);
+    free(scr.back);
+    free(scr.out);
+
+    if (resized) {
+        rl_resize_terminal();
+    }
+}
+
+// Deret metrik yang direkam oleh "cek record"
+enum {
+    HIST_CPU_BUSY, HIST_CPU_IOWAIT, HIST_LOAD1, HIST_MEM_USED, HIST_SWAP_USED,
+    HIST_DISK_READ, HIST_DISK_WRITE, HIST_DISK_UTIL, HISTORY_SERIES
+};
+
+static const struct {
+    const char* label;
+    const char* group;              // Grup untuk "cek history cpu|ram|disk"
+    const char* unit;
+    int percent;                    // 1 = skala sparkline tetap 0-100
+} history_series[HISTORY_SERIES] = {
+    {"CPU sibuk", "cpu", "%", 1},
+    {"iowait", "cpu", "%", 1},
+    {"load 1m", "cpu", "", 0},
+    {"RAM terpakai", "ram", "%", 1},
+    {"swap terpakai", "ram", "%", 1},
+    {"disk baca", "disk", "kB/s", 0},
+    {"disk tulis", "disk", "kB/s", 0},
+    {"disk util", "disk", "%", 1},
+};
+
+// Header file ring riwayat metrik (menempati blok pertama)
+struct history_header {
+    char magic[4];                  // "MSTS"
+    uint32_t version;
+    uint32_t block_size;
+    uint32_t num_blocks;            // Jumlah blok data setelah header
+    uint32_t head;                  // Blok yang sedang ditulis perekam
+    uint32_t interval_s;
+    int32_t recorder_pid;           // 0 jika perekam tidak berjalan
+    uint32_t reserved;
+};
+
+// Satu blok data: ringkasan untuk query cepat + bitstream sampel terkompresi ala Gorilla
+// Penulis memakai seqlock: seq ganjil selama blok sedang diubah
+struct history_block {
+    uint32_t seq;
+    uint32_t count;                 // Jumlah sampel di blok
+    uint32_t bits;                  // Panjang bitstream yang terpakai
+    uint32_t reserved;
+    int64_t start_time, end_time;   // Detik sejak epoch, sampel pertama dan terakhir
+    struct { double min, max, sum; } agg[HISTORY_SERIES];
+    uint8_t data[];
+};
+
+#define HISTORY_DATA_BITS ((HISTORY_BLOCK_SIZE - sizeof(struct history_block)) * 8)
+// Ukuran terburuk satu sampel: dod 4+32 bit, tiap nilai 2+5+6+64 bit
+#define HISTORY_MAX_SAMPLE_BITS (36 + HISTORY_SERIES * 77)
+
+// Fungsi untuk mendapatkan path file ring riwayat metrik
+void get_history_path(char *path, size_t size) {
+    const char *home_dir = shell_var_get("HOME");
+    if (home_dir != NULL) {
+        snprintf(path, size, "%s/%s", home_dir, HISTORY_FILE);
     } else {
-        printf("speedtest-cli sudah terinstal.\n");
+        snprintf(path, size, "./%s", HISTORY_FILE);
     }
-    
-    // Menampilkan pesan animasi sementara menunggu hasil tes
-    printf("Mengukur kecepatan");
-    
-    // Animasi titik bertahap
-    for (int i = 0; i < 3; i++) {
-        printf(".");
-        fflush(stdout);  // Mengeluarkan output ke terminal tanpa buffer
-        sleep(1);        // Menunggu 1 detik
+}
+
+// Fungsi untuk menulis n bit (MSB dulu) ke bitstream
+static void put_bits(uint8_t* data, uint32_t* pos, uint64_t value, int n) {
+    for (int i = n - 1; i >= 0; i--, (*pos)++) {
+        uint8_t mask = 0x80 >> (*pos & 7);
+        if ((value >> i) & 1) data[*pos >> 3] |= mask;
+        else data[*pos >> 3] &= ~mask;
     }
-    printf("\n");
+}
 
-        // Menggunakan path absolut sebagai tambahan keamanan
-    printf("\033[1;32m");  // Mengaktifkan warna hijau terang
-        
-        // Menggunakan execvp untuk menjalankan speedtest-cli dengan lebih aman
-        pid_t pid = fork();
-        if (pid == 0) {
-            // Proses anak
-            execlp("speedtest-cli", "speedtest-cli", "--simple", NULL);
-            
-            // Jika execlp gagal, berikan pesan error
-            perror("Gagal menjalankan speedtest-cli");
-            exit(1);
-        } else if (pid < 0) {
-            // Fork gagal
-            perror("Fork gagal");
-        } else {
-            // Proses parent
-            int status;
-            waitpid(pid, &status, 0);
-            
-            if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
-                printf("Gagal menjalankan speedtest-cli.\n");
-                printf("Coba instal ulang dengan: sudo apt-get install --reinstall speedtest-cli\n");
-            }
-        }
-        
-    printf("\033[0m");  // Reset warna ke default
+// Fungsi untuk membaca n bit dari bitstream; bit di luar panjang dibaca sebagai 0
+static uint64_t get_bits(const uint8_t* data, uint32_t len, uint32_t* pos, int n) {
+    uint64_t value = 0;
+    for (int i = 0; i < n; i++, (*pos)++) {
+        int bit = *pos < len && (data[*pos >> 3] & (0x80 >> (*pos & 7)));
+        value = (value << 1) | (bit ? 1 : 0);
+    }
+    return value;
+}
 
-    // Memberikan jeda singkat untuk efek
-    printf("\nTes kecepatan selesai!\n");
+// State encoder/decoder Gorilla untuk satu blok
+struct gorilla_state {
+    int64_t prev_time, prev_delta;
+    uint64_t prev_value[HISTORY_SERIES];
+    int prev_leading[HISTORY_SERIES], prev_trailing[HISTORY_SERIES];   // -1 = belum ada jendela
+};
+
+static void gorilla_reset(struct gorilla_state* g, int64_t start_time) {
+    memset(g, 0, sizeof(*g));
+    g->prev_time = start_time;
+    for (int s = 0; s < HISTORY_SERIES; s++) g->prev_leading[s] = -1;
+}
+
+// Fungsi untuk menyandikan timestamp sebagai delta-of-delta
+static void encode_time(uint8_t* data, uint32_t* pos, struct gorilla_state* g, int64_t t) {
+    int64_t delta = t - g->prev_time;
+    int64_t dod = delta - g->prev_delta;
+    g->prev_time = t;
+    g->prev_delta = delta;
+
+    if (dod == 0) {
+        put_bits(data, pos, 0, 1);
+    } else if (dod >= -63 && dod <= 64) {
+        put_bits(data, pos, 2, 2);
+        put_bits(data, pos, dod + 63, 7);
+    } else if (dod >= -255 && dod <= 256) {
+        put_bits(data, pos, 6, 3);
+        put_bits(data, pos, dod + 255, 9);
+    } else if (dod >= -2047 && dod <= 2048) {
+        put_bits(data, pos, 14, 4);
+        put_bits(data, pos, dod + 2047, 12);
+    } else {
+        put_bits(data, pos, 15, 4);
+        put_bits(data, pos, (uint32_t)(int32_t)dod, 32);
     }
-    // Perintah internal "history"
-    else if (strcmp(args[0], "history") == 0) {
-        show_history();
+}
+
+static int64_t decode_time(const uint8_t* data, uint32_t len, uint32_t* pos, struct gorilla_state* g) {
+    int64_t dod;
+    if (get_bits(data, len, pos, 1) == 0) dod = 0;
+    else if (get_bits(data, len, pos, 1) == 0) dod = (int64_t)get_bits(data, len, pos, 7) - 63;
+    else if (get_bits(data, len, pos, 1) == 0) dod = (int64_t)get_bits(data, len, pos, 9) - 255;
+    else if (get_bits(data, len, pos, 1) == 0) dod = (int64_t)get_bits(data, len, pos, 12) - 2047;
+    else dod = (int32_t)(uint32_t)get_bits(data, len, pos, 32);
+
+    g->prev_delta += dod;
+    g->prev_time += g->prev_delta;
+    return g->prev_time;
+}
+
+// Fungsi untuk menyandikan nilai double sebagai XOR terhadap nilai sebelumnya
+static void encode_value(uint8_t* data, uint32_t* pos, struct gorilla_state* g, int s, double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    uint64_t x = bits ^ g->prev_value[s];
+    g->prev_value[s] = bits;
+
+    if (x == 0) {
+        put_bits(data, pos, 0, 1);
+        return;
     }
-    // Perintah internal "pwd"
-    else if (strcmp(args[0], "pwd") == 0) {
-        char cwd[MAX_CMD_LEN];
-        if (getcwd(cwd, sizeof(cwd)) != NULL) {
-            printf("%s\n", cwd);
-        } else {
-            perror("pwd");
+
+    int leading = __builtin_clzll(x), trailing = __builtin_ctzll(x);
+    if (leading > 31) leading = 31;
+
+    if (g->prev_leading[s] >= 0 && leading >= g->prev_leading[s] && trailing >= g->prev_trailing[s]) {
+        // Bit bermakna muat di jendela sebelumnya
+        put_bits(data, pos, 2, 2);
+        put_bits(data, pos, x >> g->prev_trailing[s], 64 - g->prev_leading[s] - g->prev_trailing[s]);
+    } else {
+        int len = 64 - leading - trailing;
+        put_bits(data, pos, 3, 2);
+        put_bits(data, pos, leading, 5);
+        put_bits(data, pos, len - 1, 6);
+        put_bits(data, pos, x >> trailing, len);
+        g->prev_leading[s] = leading;
+        g->prev_trailing[s] = trailing;
+    }
+}
+
+static double decode_value(const uint8_t* data, uint32_t len, uint32_t* pos, struct gorilla_state* g, int s) {
+    if (get_bits(data, len, pos, 1) != 0) {
+        if (get_bits(data, len, pos, 1) != 0) {
+            g->prev_leading[s] = (int)get_bits(data, len, pos, 5);
+            int meaningful = (int)get_bits(data, len, pos, 6) + 1;
+            g->prev_trailing[s] = 64 - g->prev_leading[s] - meaningful;
         }
+        int meaningful = 64 - g->prev_leading[s] - g->prev_trailing[s];
+        g->prev_value[s] ^= get_bits(data, len, pos, meaningful) << g->prev_trailing[s];
     }
-    // Perintah internal "clear" atau "cl" untuk membersihkan layar
-    else if (strcmp(args[0], "clear") == 0 || strcmp(args[0], "cl") == 0) {
-        // Clear layar terminal
-        printf("\033[H\033[J");  // ANSI escape sequence untuk membersihkan layar
+
+    double v;
+    memcpy(&v, &g->prev_value[s], sizeof(v));
+    return v;
+}
+
+// Fungsi untuk memetakan file ring; membuat/menginisialisasi ulang jika create != 0 dan formatnya beda
+static struct history_header* history_map(int create, size_t size_bytes, size_t* mapped_size) {
+    char path[MAX_CMD_LEN];
+    get_history_path(path, sizeof(path));
+
+    int fd = open(path, (create ? O_RDWR | O_CREAT : O_RDWR) | O_CLOEXEC, 0600);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
     }
-    // Perintah cek cpu, ram, dan disk
-    else if (strcmp(args[0], "cek") == 0 && args[1] != NULL) {
-        if (strcmp(args[1], "cpu") == 0) {
-            check_cpu();
-        } else if (strcmp(args[1], "ram") == 0) {
-            check_ram();
-        } else if (strcmp(args[1], "disk") == 0) {
-            check_disk();
-        } else if (strcmp(args[1], "battery") == 0) {
-            FILE *fp = fopen("/sys/class/power_supply/BAT0/capacity", "r");
-            if (fp == NULL) {
-                perror("Gagal membuka file kapasitas baterai");
-                return;
-            }
 
-            int capacity;
-            if (fscanf(fp, "%d", &capacity) != 1) {
-                perror("Gagal membaca kapasitas baterai");
-                fclose(fp);
-                return;
+    size_t size = st.st_size;
+    int reinit = 0;
+    if (create) {
+        uint32_t num_blocks = size_bytes / HISTORY_BLOCK_SIZE;
+        if (num_blocks < 5) num_blocks = 5;
+        size_t wanted = (size_t)num_blocks * HISTORY_BLOCK_SIZE;
+        if (size != wanted) {
+            if (ftruncate(fd, 0) != 0 || ftruncate(fd, wanted) != 0) {
+                close(fd);
+                return NULL;
             }
-
-            printf("Kapasitas Baterai: %d%%\n", capacity);
-            fclose(fp);
-        } else {
-            printf("Perintah cek tidak dikenal: %s\n", args[1]);
-            printf("Gunakan: cek cpu, cek ram, cek disk, atau cek battery\n");
+            size = wanted;
+            reinit = 1;
         }
     }
-    // Perintah internal "ls"
-    else if (strcmp(args[0], "ls") == 0) {
-        pid_t pid = fork();
-        if (pid == 0) {
-            execvp(args[0], args);
-            perror("execvp");  // Jika execvp gagal, tampilkan pesan error
-            exit(1);  // Pastikan anak keluar setelah error
-        } else if (pid < 0) {
-            perror("fork");
-        } else {
-            waitpid(pid, NULL, 0);  // Tunggu proses anak selesai
-        }
+    if (size < 2 * HISTORY_BLOCK_SIZE) {
+        close(fd);
+        return NULL;
     }
-    // Perintah internal "edit"
-    else if (strcmp(args[0], "edit") == 0) {
-        if (args[1] == NULL) {
-            fprintf(stderr, "edit: expected file name\n");
-        } else {
-            // Mengecek apakah file ada
-            if (access(args[1], F_OK) != 0) {
-                perror("edit");
-                return;
-            }
 
-            // Memilih editor yang sesuai (misalnya nano atau vim)
-            pid_t pid = fork();
-            if (pid == 0) {
-                // Menjalankan editor
-                char *editor = "nano";  // Bisa ganti ke "vim" jika lebih suka vim
-                execlp(editor, editor, args[1], (char *)NULL);
-                perror("execvp");  // Jika execlp gagal, tampilkan pesan error
-                exit(1);
-            } else if (pid < 0) {
-                perror("fork");
-            } else {
-                waitpid(pid, NULL, 0);  // Tunggu proses anak selesai
-            }
+    struct history_header* h = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (h == MAP_FAILED) return NULL;
+
+    if (reinit || memcmp(h->magic, "MSTS", 4) != 0 || h->version != HISTORY_VERSION ||
+        h->block_size != HISTORY_BLOCK_SIZE || (size_t)(h->num_blocks + 1) * HISTORY_BLOCK_SIZE != size) {
+        if (!create) {
+            munmap(h, size);
+            return NULL;
         }
+        memset(h, 0, size);
+        memcpy(h->magic, "MSTS", 4);
+        h->version = HISTORY_VERSION;
+        h->block_size = HISTORY_BLOCK_SIZE;
+        h->num_blocks = size / HISTORY_BLOCK_SIZE - 1;
     }
-    else {
-        pid_t pid = fork();
-        if (pid == 0) {
-            execvp(args[0], args);
-            perror("execvp");  // Jika execvp gagal, tampilkan pesan error
-            exit(1);  // Pastikan anak keluar setelah error
-        } else if (pid < 0) {
-            perror("fork");
-        } else {
-            waitpid(pid, NULL, 0);  // Tunggu proses selesai
+
+    *mapped_size = size;
+    return h;
+}
+
+static struct history_block* history_block_at(struct history_header* h, uint32_t index) {
+    return (struct history_block*)((char*)h + (size_t)(index + 1) * HISTORY_BLOCK_SIZE);
+}
+
+// Fungsi untuk menyalin blok secara konsisten (seqlock); gagal jika penulis terus mengubahnya
+static int history_read_block(const struct history_block* b, struct history_block* out) {
+    for (int attempt = 0; attempt < 100; attempt++) {
+        uint32_t seq = __atomic_load_n(&b->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            sched_yield();
+            continue;
         }
+        memcpy(out, b, HISTORY_BLOCK_SIZE);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&b->seq, __ATOMIC_RELAXED) == seq) return 0;
     }
+    return -1;
 }
 
-// Fungsi untuk menampilkan pesan selamat datang
-void welcome_message() {
-    printf("\n\n");
-    printf("               /$$           /$$                 /$$      /$$$$$$$$  /$$$$$$$   /$$   /$$\n");
-    printf("              |__/          | $$                | $$     |_____ $$/ | $$____  \\| $$  | $$\n");
-    printf(" /$$$$$$/$$$$  /$$  /$$$$$$$| $$$$$$$   /$$$$$$ | $$          /$$/ | $$    \\ \\| $$  | $$\n");
-    printf("| $$_  $$_  $$| $$ /$$_____/| $$__  $$ /$$__  $$| $$ /$$$$$$ /$$/ / | $$$$$$$$\\| $$  | $$\n");
-    printf("| $$ \\ $$ \\ $$| $$|  $$$$$$ | $$  \\ $$| $$$$$$$$| $$|______//$$/ / | $$____ / | $$  | $$\n");
-    printf("| $$ | $$ | $$| $$ \\____  $$| $$  | $$| $$_____/| $$       /$$/ /  | $$      | $$  | $$\n");
-    printf("| $$ | $$ | $$| $$ /$$$$$$$/| $$  | $$|  $$$$$$$| $$      /$$/ /   | $$      |  $$$$$$/\n");
-    printf("|__/ |__/ |__/|__/|_______/ |__/  |__/ \\_______/|__/     |__/ /    |__/       \\______/\n");
-    printf("                                      /$$$$$$$$  /$$$$$$$  /$$   /$$          \n");
-    printf("                                     | $$_____/ | $$__  $$| $$  | $$          \n");
-    printf("                                     | $$       | $$  \\ $$| $$  | $$          \n");
-    printf("                                     | $$$$$    | $$  | $$| $$  | $$          \n");
-    printf("                                     | $$__/    | $$  | $$| $$  | $$          \n");
-    printf("                                     | $$       | $$  | $$| $$  | $$          \n");
-    printf("                                     | $$$$$$$$| $$$$$$$/ |  $$$$$$/          \n");
-    printf("                                     |________/|_______/   \\______/           \n");
-    printf("                                                                                      \n");
-    printf("                                original by: azmi, zikri, dea, latief, rachel         \n");
-    printf("                                edit by    : friza, gita, dimas, tirangga, syahran    \n");
-    printf("*\n");
-    printf("Perintah dasar yang dapat digunakan:\n");
-    printf("1. cd <direktori>     : Pindah direktori\n");
-    printf("2. echo <pesan>       : Tampilkan pesan\n");
-    printf("3. touch <file>       : Membuat file baru\n");
-    printf("4. edit <file>        : Mengedit file\n");
-    printf("5. q                  : Keluar dari shell\n");
-    printf("6. history            : Menampilkan riwayat perintah\n");
-    printf("7. pwd                : Menampilkan direktori saat ini\n");
-    printf("8. ls                 : Menampilkan daftar file\n");
-    printf("9. cat <file>         : Menampilkan isi file\n");
-    printf("10. rm <file>         : Menghapus file\n");
-    printf("11. rmdir <dir>       : Menghapus direktori kosong\n");
-    printf("12. mkdir <dir>       : Membuat direktori baru\n");
-    printf("13. clear             : Menghapus layar terminal\n");
-    printf("14. cp <source> <dest>: Menyalin file\n");
-    printf("15. mv <source> <dest>: Memindahkan file\n");
-    printf("16. whoami            : Menampilkan nama pengguna\n");
-    printf("17. date              : Menampilkan tanggal dan waktu\n");
-    printf("18. man <command>     : Menampilkan manual perintah\n");
-    printf("19. head <file>       : Menampilkan beberapa baris pertama file\n");
-    printf("20. tail <file>       : Menampilkan beberapa baris terakhir file\n");
-    printf("21. setup dns         : Meng-Setup DNS dengan cepat\n");
-    printf("22. list perintah     : Menampilkan daftar perintah yang tersedia\n");
-    printf("23. cek battery       : Memeriksa kapasitas baterai\n");   
-    printf("24. test speed        : Menguji kecepatan internet\n");
-    printf("25. cek cpu           : Menampilkan informasi penggunaan CPU\n");
-    printf("26. cek ram           : Menampilkan informasi penggunaan RAM\n");
-    printf("27. cek disk          : Menampilkan informasi penggunaan disk\n");
-    printf("28. ai setup          : Menyiapkan Google Gemini API\n");
-    printf("29. ai <pertanyaan>   : Bertanya ke AI tentang perintah terminal\n");
-    printf("30. ai logout         : Menghapus API key Gemini yang tersimpan\n");
-    printf("\nSilakan masukkan perintah!\n");
+// Penulis blok di proses perekam
+struct history_writer {
+    struct history_header* header;
+    struct history_block* block;
+    struct gorilla_state state;
+};
+
+// Fungsi untuk memulai blok baru di posisi berikutnya dalam ring (menimpa blok tertua)
+static void history_new_block(struct history_writer* w, int64_t t) {
+    struct history_header* h = w->header;
+    uint32_t next = w->block != NULL ? (h->head + 1) % h->num_blocks : h->head;
+    struct history_block* b = history_block_at(h, next);
+
+    __atomic_store_n(&b->seq, b->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memset((char*)b + sizeof(b->seq), 0, HISTORY_BLOCK_SIZE - sizeof(b->seq));
+    b->start_time = b->end_time = t;
+    __atomic_store_n(&b->seq, b->seq + 1, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&h->head, next, __ATOMIC_RELEASE);
+    w->block = b;
+    gorilla_reset(&w->state, t);
 }
 
-// Fungsi untuk menghilangkan karakter kutip yang mengelilingi string
-char* remove_surrounding_quotes(char* str) {
-    static char result[MAX_CMD_LEN];
-    
-    // Copy string asli
-    strncpy(result, str, MAX_CMD_LEN - 1);
-    result[MAX_CMD_LEN - 1] = '\0';
-    
-    int len = strlen(result);
-    
-    // Hapus tanda kutip di awal dan akhir jika ada
-    if (len >= 2 && ((result[0] == '"' && result[len-1] == '"') || 
-                     (result[0] == '\'' && result[len-1] == '\''))) {
-        memmove(result, result + 1, len - 2);
-        result[len - 2] = '\0';
+// Fungsi untuk menambahkan satu sampel (timestamp + semua deret) ke blok aktif
+static void history_append(struct history_writer* w, int64_t t, const double* values) {
+    if (w->block == NULL || w->block->bits + HISTORY_MAX_SAMPLE_BITS > HISTORY_DATA_BITS) {
+        history_new_block(w, t);
     }
-    
-    return result;
+    struct history_block* b = w->block;
+
+    __atomic_store_n(&b->seq, b->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    uint32_t pos = b->bits;
+    if (b->count > 0) encode_time(b->data, &pos, &w->state, t);
+    for (int s = 0; s < HISTORY_SERIES; s++) {
+        encode_value(b->data, &pos, &w->state, s, values[s]);
+        if (b->count == 0 || values[s] < b->agg[s].min) b->agg[s].min = values[s];
+        if (b->count == 0 || values[s] > b->agg[s].max) b->agg[s].max = values[s];
+        b->agg[s].sum += values[s];
+    }
+    b->bits = pos;
+    b->end_time = t;
+    b->count++;
+
+    __atomic_store_n(&b->seq, b->seq + 1, __ATOMIC_RELEASE);
+}
+
+// Fungsi untuk membulatkan nilai (tidak negatif) agar XOR antar sampel lebih sering nol
+static double round_to(double v, double step) {
+    return (double)(long long)(v / step + 0.5) * step;
 }
 
-// Fungsi untuk meng-escape spasi dan karakter khusus dalam path
-char* escape_path(const char* path) {
-    static char escaped[MAX_CMD_LEN * 2];
-    int i, j = 0;
-    
-    for (i = 0; path[i] != '\0' && j < MAX_CMD_LEN * 2 - 2; i++) {
-        if (path[i] == ' ' || path[i] == '(' || path[i] == ')' || 
-            path[i] == '[' || path[i] == ']' || path[i] == '&' || 
-            path[i] == ';' || path[i] == '$' || path[i] == '|' || 
-            path[i] == '<' || path[i] == '>' || path[i] == '`' || 
-            path[i] == '\\' || path[i] == '"' || path[i] == '\'') {
-            escaped[j++] = '\\';
+// Loop proses perekam: sampel setiap interval_s detik, selaras dengan jam dinding
+static void run_history_recorder(struct history_header* h, int interval_s) {
+    static struct cpu_sample cpu[2];
+    static struct disk_sample disk[2];
+    struct history_writer w = { h, NULL, {0} };
+    int cur = 0;
+
+    // Lanjutkan setelah blok terbaru agar riwayat lama tetap utuh
+    int64_t newest = -1;
+    for (uint32_t i = 0; i < h->num_blocks; i++) {
+        struct history_block* b = history_block_at(h, i);
+        if (b->count > 0 && b->end_time > newest) {
+            newest = b->end_time;
+            h->head = (i + 1) % h->num_blocks;
+        }
+    }
+
+    sample_cpu(&cpu[cur]);
+    sample_diskstats(&disk[cur]);
+
+    for (;;) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        struct timespec next = { (now.tv_sec / interval_s + 1) * interval_s, 0 };
+        while (clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &next, NULL) == EINTR) {
         }
-        escaped[j++] = path[i];
+
+        int prev = cur;
+        cur = 1 - cur;
+        struct mem_info mem;
+        double load[3] = {0, 0, 0};
+        if (sample_cpu(&cpu[cur]) != 0 || sample_diskstats(&disk[cur]) != 0 || sample_meminfo(&mem) != 0) continue;
+        sample_loadavg(load);
+
+        double values[HISTORY_SERIES] = {0};
+        struct cpu_usage usage;
+        compute_cpu_usage(&cpu[prev].total, &cpu[cur].total, &usage);
+        values[HIST_CPU_BUSY] = round_to(usage.busy, 0.1);
+        values[HIST_CPU_IOWAIT] = round_to(usage.iowait, 0.1);
+        values[HIST_LOAD1] = load[0];
+        if (mem.total > 0) {
+            values[HIST_MEM_USED] = round_to(100.0 * (mem.total - mem.available) / mem.total, 0.1);
+        }
+        if (mem.swap_total > 0) {
+            values[HIST_SWAP_USED] = round_to(100.0 * (mem.swap_total - mem.swap_free) / mem.swap_total, 0.1);
+        }
+        for (int i = 0; i < disk[cur].count; i++) {
+            struct disk_rate rate;
+            if (compute_disk_rate(&disk[prev], &disk[cur], &disk[cur].disks[i], &rate) != 0) continue;
+            values[HIST_DISK_READ] += rate.read_kbs;
+            values[HIST_DISK_WRITE] += rate.write_kbs;
+            if (rate.util > values[HIST_DISK_UTIL]) values[HIST_DISK_UTIL] = rate.util;
+        }
+        values[HIST_DISK_READ] = round_to(values[HIST_DISK_READ], 1);
+        values[HIST_DISK_WRITE] = round_to(values[HIST_DISK_WRITE], 1);
+        values[HIST_DISK_UTIL] = round_to(values[HIST_DISK_UTIL], 0.1);
+
+        history_append(&w, next.tv_sec, values);
     }
-    
-    escaped[j] = '\0';
-    return escaped;
 }
 
-// Fungsi untuk mengganti escape HTML dengan karakter sebenarnya
-void replace_html_escapes(char* str) {
-    if (str == NULL) return;
-    
-    // Daftar penggantian karakter escape HTML umum
-    struct {
-        const char* escape;
-        const char* replacement;
-    } replacements[] = {
-        {"u003c", "<"},
-        {"u003e", ">"},
-        {"u0026", "&"},
-        {"u0022", "\""},
-        {"u0027", "'"},
-        {"u002F", "/"},
-        {"u005C", "\\"},
-        {"&lt;", "<"},
-        {"&gt;", ">"},
-        {"&amp;", "&"},
-        {"&quot;", "\""},
-        {"&apos;", "'"},
-        {NULL, NULL}  // Penanda akhir array
-    };
-    
-    char* found;
-    for (int i = 0; replacements[i].escape != NULL; i++) {
-        size_t escape_len = strlen(replacements[i].escape);
-        size_t repl_len = strlen(replacements[i].replacement);
-        
-        char* pos = str;
-        while ((found = strstr(pos, replacements[i].escape)) != NULL) {
-            // Simpan posisi setelah escape sequence
-            char* after = found + escape_len;
-            
-            // Ganti escape dengan karakter asli
-            memcpy(found, replacements[i].replacement, repl_len);
-            
-            // Geser sisa string
-            if (escape_len != repl_len) {
-                memmove(found + repl_len, after, strlen(after) + 1);
+// Fungsi untuk memeriksa apakah perekam yang tercatat di header masih hidup
+static int history_recorder_alive(const struct history_header* h) {
+    return h->recorder_pid > 0 && kill(h->recorder_pid, 0) == 0;
+}
+
+// Fungsi untuk "cek record [start|stop]": perekam metrik di latar belakang
+void record_metric_history(char** args) {
+    size_t size;
+
+    if (args[0] != NULL && strcmp(args[0], "start") == 0) {
+        int interval_s = HISTORY_DEFAULT_INTERVAL_S;
+        size_t size_bytes = (size_t)HISTORY_DEFAULT_SIZE_MB * 1024 * 1024;
+        for (int i = 1; args[i] != NULL; i++) {
+            if (strcmp(args[i], "-i") == 0 && args[i + 1] != NULL) {
+                interval_s = atoi(args[++i]);
+            } else if (strcmp(args[i], "--size") == 0 && args[i + 1] != NULL) {
+                size_bytes = strtoull(args[++i], NULL, 10) * 1024 * 1024;
             }
-            
-            // Update posisi pencarian berikutnya
-            pos = found + repl_len;
         }
-    }
-}
+        if (interval_s < 1) interval_s = HISTORY_DEFAULT_INTERVAL_S;
 
-// Fungsi untuk memeriksa penggunaan CPU
-void check_cpu() {
-    printf("Memeriksa penggunaan CPU...\n");
-    
-    // Dapatkan jumlah core CPU terlebih dahulu
-    int cpu_count = 0;
-    char model_name[256] = "Unknown";
-    
-    FILE *fp_info = fopen("/proc/cpuinfo", "r");
-    if (fp_info != NULL) {
-        char line[256];
-        while (fgets(line, sizeof(line), fp_info)) {
-            if (strncmp(line, "model name", 10) == 0) {
-                // Ekstrak nama model
-                char* colon = strchr(line, ':');
-                if (colon != NULL) {
-                    strncpy(model_name, colon + 2, sizeof(model_name) - 1);
-                    model_name[sizeof(model_name) - 1] = '\0';
-                    // Hapus newline di akhir
-                    size_t len = strlen(model_name);
-                    if (len > 0 && model_name[len - 1] == '\n') {
-                        model_name[len - 1] = '\0';
-                    }
-                }
-                cpu_count++;
+        // Jangan mengubah ukuran file yang sedang ditulis perekam lain
+        struct history_header* h = history_map(0, 0, &size);
+        if (h != NULL) {
+            int alive = history_recorder_alive(h);
+            pid_t pid = h->recorder_pid;
+            munmap(h, size);
+            if (alive) {
+                printf("Perekam metrik sudah berjalan (pid %d). Gunakan 'cek record stop' terlebih dahulu.\n", pid);
+                return;
             }
         }
-        fclose(fp_info);
-    }
-    
-    // Buka file /proc/stat yang berisi informasi CPU
-    FILE *fp = fopen("/proc/stat", "r");
-    if (fp == NULL) {
-        perror("Gagal membuka file /proc/stat");
+
+        h = history_map(1, size_bytes, &size);
+        if (h == NULL) {
+            perror("Gagal membuat file riwayat metrik");
+            return;
+        }
+
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            // Perekam tetap berjalan setelah mishell ditutup
+            setsid();
+            int devnull = open("/dev/null", O_RDWR);
+            if (devnull >= 0) {
+                dup2(devnull, STDIN_FILENO);
+                dup2(devnull, STDOUT_FILENO);
+                dup2(devnull, STDERR_FILENO);
+            }
+
+            // Tutup fd warisan (mis. salinan stdout dari run_command_line) agar pipe pemanggil
+            // tidak tertahan terbuka; file /proc dibuka ulang saat sampel pertama
+            if (syscall(SYS_close_range, 3, ~0U, 0) != 0) {
+                for (int fd = 3; fd < 1024; fd++) close(fd);
+            }
+            proc_stat_file.fd = proc_meminfo_file.fd = proc_loadavg_file.fd = proc_diskstats_file.fd = -1;
+            proc_net_dev_file.fd = proc_net_snmp_file.fd = proc_net_netstat_file.fd = -1;
+            h->recorder_pid = getpid();
+            h->interval_s = interval_s;
+            run_history_recorder(h, interval_s);
+            _exit(0);
+        } else if (pid < 0) {
+            perror("fork");
+            munmap(h, size);
+            return;
+        }
+
+        printf("Perekam metrik berjalan (pid %d), sampel tiap %d detik, ring %zu kB (%u blok).\n",
+               pid, interval_s, size / 1024, h->num_blocks);
+        munmap(h, size);
         return;
     }
-    
-    // Array untuk menyimpan data CPU (user, nice, system, idle)
-    unsigned long long int cpu_times1[10] = {0};
-    unsigned long long int cpu_times2[10] = {0};
-    
-    // Baca nilai awal
-    char cpu_label[10];
-    fscanf(fp, "%s %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu", 
-           cpu_label, &cpu_times1[0], &cpu_times1[1], &cpu_times1[2], &cpu_times1[3], 
-           &cpu_times1[4], &cpu_times1[5], &cpu_times1[6], &cpu_times1[7], 
-           &cpu_times1[8], &cpu_times1[9]);
-    
-    fclose(fp);
-    
-    // Tunggu sebentar untuk melihat perubahan
-    printf("Mengambil sampel penggunaan CPU untuk 1 detik...\n");
-    
-    // Menggunakan sleep lebih lama untuk sampel yang lebih akurat
-    sleep(2);
-    
-    // Baca nilai kedua
-    fp = fopen("/proc/stat", "r");
-    if (fp == NULL) {
-        perror("Gagal membuka file /proc/stat");
+
+    struct history_header* h = history_map(0, 0, &size);
+    if (h == NULL) {
+        printf("Belum ada riwayat metrik. Jalankan 'cek record start' terlebih dahulu.\n");
         return;
     }
-    
-    fscanf(fp, "%s %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu", 
-           cpu_label, &cpu_times2[0], &cpu_times2[1], &cpu_times2[2], &cpu_times2[3], 
-           &cpu_times2[4], &cpu_times2[5], &cpu_times2[6], &cpu_times2[7], 
-           &cpu_times2[8], &cpu_times2[9]);
-    
-    fclose(fp);
-    
-    // Hitung total untuk kedua pengukuran
-    unsigned long long int total_time1 = 0;
-    unsigned long long int total_time2 = 0;
-    
-    for (int i = 0; i < 10; i++) {
-        total_time1 += cpu_times1[i];
-        total_time2 += cpu_times2[i];
-    }
-    
-    // Hitung idle time untuk kedua pengukuran (iowait tidak dihitung sebagai idle)
-    unsigned long long int idle_time1 = cpu_times1[3]; // idle saja
-    unsigned long long int idle_time2 = cpu_times2[3]; // idle saja
-    
-    // Hitung delta
-    unsigned long long int total_delta = total_time2 - total_time1;
-    unsigned long long int idle_delta = idle_time2 - idle_time1;
-    
-    // Hitung persentase penggunaan CPU: non-idle / total
-    double cpu_usage = 100.0 * (1.0 - ((double)idle_delta / total_delta));
-    
-    // Metode alternatif: Periksa penggunaan dengan top
-    double top_usage = 0.0;
-    FILE *fp_top = popen("top -bn1 | grep '%Cpu(s)' | awk '{print $2+$4+$6}'", "r");
-    if (fp_top != NULL) {
-        if (fscanf(fp_top, "%lf", &top_usage) != 1) {
-            top_usage = cpu_usage; // Fallback ke nilai yang dihitung
+
+    if (args[0] != NULL && strcmp(args[0], "stop") == 0) {
+        if (history_recorder_alive(h)) {
+            kill(h->recorder_pid, SIGTERM);
+            printf("Perekam metrik (pid %d) dihentikan.\n", h->recorder_pid);
+        } else {
+            printf("Perekam metrik tidak berjalan.\n");
         }
-        pclose(fp_top);
+        h->recorder_pid = 0;
+        munmap(h, size);
+        return;
     }
-    
-    // Gunakan nilai yang lebih masuk akal
-    double final_cpu_usage = (top_usage > 0.0) ? top_usage : cpu_usage;
-    
-    // Tampilkan hasil dengan format yang bagus
-    printf("\n");
-    printf("\033[1;36m"); // Cyan terang
-    printf("=================== PENGGUNAAN CPU ===================\n");
-    printf("\033[0m"); // Reset warna
-    
-    printf("Penggunaan CPU Saat Ini: ");
-    
-    // Warna berdasarkan penggunaan
-    if (final_cpu_usage < 50) {
-        printf("\033[1;32m"); // Hijau terang
-    } else if (final_cpu_usage < 80) {
-        printf("\033[1;33m"); // Kuning terang
+
+    // Status: rentang waktu dan rasio kompresi
+    int64_t oldest = 0, newest = 0;
+    unsigned long long samples = 0, bits = 0;
+    int used_blocks = 0;
+    for (uint32_t i = 0; i < h->num_blocks; i++) {
+        struct history_block* b = history_block_at(h, i);
+        if (b->count == 0) continue;
+        used_blocks++;
+        samples += b->count;
+        bits += b->bits;
+        if (oldest == 0 || b->start_time < oldest) oldest = b->start_time;
+        if (b->end_time > newest) newest = b->end_time;
+    }
+
+    char path[MAX_CMD_LEN];
+    get_history_path(path, sizeof(path));
+    printf("File riwayat : %s (%zu kB, %d/%u blok terpakai)\n", path, size / 1024, used_blocks, h->num_blocks);
+    if (history_recorder_alive(h)) {
+        printf("Perekam      : berjalan (pid %d, interval %u detik)\n", h->recorder_pid, h->interval_s);
     } else {
-        printf("\033[1;31m"); // Merah terang
+        printf("Perekam      : tidak berjalan\n");
     }
-    
-    printf("%.2f%%\n", final_cpu_usage);
-    printf("\033[0m"); // Reset warna
-    
-    // Tampilkan informasi tambahan
-    printf("\n");
-    printf("CPU Model: %s\n", model_name);
-    printf("Jumlah Core CPU: %d\n", cpu_count);
-    
-    printf("\n");
-    printf("\033[1;36m"); // Cyan terang
-    printf("=====================================================\n");
-    printf("\033[0m"); // Reset warna
+    if (samples > 0) {
+        char from[32], to[32];
+        time_t t_from = oldest, t_to = newest;
+        strftime(from, sizeof(from), "%Y-%m-%d %H:%M:%S", localtime(&t_from));
+        strftime(to, sizeof(to), "%Y-%m-%d %H:%M:%S", localtime(&t_to));
+        printf("Rentang      : %s s/d %s (%llu sampel)\n", from, to, samples);
+        printf("Kompresi     : %.1f byte/sampel (mentah %zu byte)\n", bits / 8.0 / samples,
+               sizeof(int64_t) + HISTORY_SERIES * sizeof(double));
+    }
+    munmap(h, size);
 }
 
-// Fungsi untuk memeriksa penggunaan RAM
-void check_ram() {
-    printf("Memeriksa penggunaan RAM...\n");
-    
-    // Buka file /proc/meminfo yang berisi informasi memori
-    FILE *fp = fopen("/proc/meminfo", "r");
-    if (fp == NULL) {
-        perror("Gagal membuka file /proc/meminfo");
+// Fungsi untuk mengurai durasi seperti 90s, 30m, 1h, 2d (tanpa satuan = detik)
+static long parse_duration(const char* s) {
+    char* end;
+    long value = strtol(s, &end, 10);
+    switch (*end) {
+        case 'm': return value * 60;
+        case 'h': return value * 3600;
+        case 'd': return value * 86400;
+        default: return value;
+    }
+}
+
+// Akumulator satu ember waktu pada sparkline
+struct history_bucket {
+    double sum;
+    unsigned int count;
+};
+
+// Fungsi untuk "cek history cpu|ram|disk [--since 1h]"
+// Blok di luar rentang dilewati lewat header; blok yang seluruhnya jatuh di satu ember
+// memakai ringkasan min/max/sum tanpa didekode.
+void show_metric_history(char** args) {
+    static struct history_bucket buckets[HISTORY_SERIES][HISTORY_MAX_WIDTH];
+    static uint64_t copy[HISTORY_BLOCK_SIZE / sizeof(uint64_t)];
+    static const char* spark[] = { "▁", "▂", "▃", "▄", "▅", "▆", "▇", "█" };
+
+    const char* group = args[0];
+    if (group == NULL || (strcmp(group, "cpu") != 0 && strcmp(group, "ram") != 0 && strcmp(group, "disk") != 0)) {
+        printf("Gunakan: cek history cpu|ram|disk [--since 1h]\n");
         return;
     }
-    
-    // Variabel untuk menyimpan informasi memori
-    unsigned long total_mem = 0;
-    unsigned long free_mem = 0;
-    unsigned long available_mem = 0;
-    unsigned long buffers = 0;
-    unsigned long cached = 0;
-    
-    char line[256];
-    
-    // Baca file baris per baris
-    while (fgets(line, sizeof(line), fp) != NULL) {
-        if (strncmp(line, "MemTotal:", 9) == 0) {
-            sscanf(line, "MemTotal: %lu kB", &total_mem);
-        } else if (strncmp(line, "MemFree:", 8) == 0) {
-            sscanf(line, "MemFree: %lu kB", &free_mem);
-        } else if (strncmp(line, "MemAvailable:", 13) == 0) {
-            sscanf(line, "MemAvailable: %lu kB", &available_mem);
-        } else if (strncmp(line, "Buffers:", 8) == 0) {
-            sscanf(line, "Buffers: %lu kB", &buffers);
-        } else if (strncmp(line, "Cached:", 7) == 0) {
-            sscanf(line, "Cached: %lu kB", &cached);
+
+    long since = HISTORY_DEFAULT_SINCE_S;
+    for (int i = 1; args[i] != NULL; i++) {
+        if (strcmp(args[i], "--since") == 0 && args[i + 1] != NULL) {
+            since = parse_duration(args[++i]);
         }
     }
-    
-    fclose(fp);
-    
-    // Hitung penggunaan memori
-    unsigned long used_mem = total_mem - free_mem;
-    double used_percent = 100.0 * ((double)used_mem / total_mem);
-    
-    // Konversi ke unit yang lebih mudah dibaca
-    double total_gb = total_mem / 1024.0 / 1024.0;
-    double used_gb = used_mem / 1024.0 / 1024.0;
-    double free_gb = free_mem / 1024.0 / 1024.0;
-    double available_gb = available_mem / 1024.0 / 1024.0;
-    double cached_gb = cached / 1024.0 / 1024.0;
-    double buffers_gb = buffers / 1024.0 / 1024.0;
-    
-    // Perbaikan: Gunakan "MemAvailable" untuk perhitungan yang lebih akurat
-    unsigned long actual_used_mem = total_mem - available_mem;
-    double actual_used_percent = 100.0 * ((double)actual_used_mem / total_mem);
-    double actual_used_gb = actual_used_mem / 1024.0 / 1024.0;
-    
-    // Tampilkan hasil dengan format yang bagus
-    printf("\n");
-    printf("\033[1;36m"); // Cyan terang
-    printf("=================== PENGGUNAAN RAM ===================\n");
-    printf("\033[0m"); // Reset warna
-    
-    printf("Total RAM       : %.2f GB\n", total_gb);
-    printf("Terpakai        : ");
-    
-    // Warna berdasarkan penggunaan
-    if (actual_used_percent < 50) {
-        printf("\033[1;32m"); // Hijau terang
-    } else if (actual_used_percent < 80) {
-        printf("\033[1;33m"); // Kuning terang
-    } else {
-        printf("\033[1;31m"); // Merah terang
-    }
-    
-    printf("%.2f GB (%.2f%%)\n", actual_used_gb, actual_used_percent);
-    printf("\033[0m"); // Reset warna
-    
-    printf("Tersedia        : %.2f GB\n", available_gb);
-    printf("Bebas           : %.2f GB\n", free_gb);
-    printf("Cache           : %.2f GB\n", cached_gb);
-    printf("Buffer          : %.2f GB\n", buffers_gb);
-    
-    printf("\n");
-    printf("\033[1;36m"); // Cyan terang
-    printf("=====================================================\n");
-    printf("\033[0m"); // Reset warna
-}
+    if (since <= 0) since = HISTORY_DEFAULT_SINCE_S;
 
-// Fungsi untuk memeriksa penggunaan disk
-void check_disk() {
-    printf("Memeriksa penggunaan disk...\n");
-    
-    // Jalankan perintah df untuk mendapatkan informasi disk
-    FILE *fp = popen("df -h --output=target,size,used,avail,pcent,fstype | grep -v tmpfs | grep -v loop", "r");
-    if (fp == NULL) {
-        perror("Gagal menjalankan perintah df");
+    size_t size;
+    struct history_header* h = history_map(0, 0, &size);
+    if (h == NULL) {
+        printf("Belum ada riwayat metrik. Jalankan 'cek record start' terlebih dahulu.\n");
         return;
     }
-    
-    char line[256];
-    int header_skipped = 0;
-    
-    // Tampilkan hasil dengan format yang bagus
-    printf("\n");
-    printf("\033[1;36m"); // Cyan terang
-    printf("=================== PENGGUNAAN DISK ===================\n");
-    printf("\033[0m"); // Reset warna
-    
-    printf("%-15s %-10s %-10s %-10s %-10s %s\n", 
-           "Mount Point", "Ukuran", "Terpakai", "Tersedia", "Persentase", "Tipe");
-    printf("-----------------------------------------------------------------------\n");
-    
-    // Baca output dari perintah df
-    while (fgets(line, sizeof(line), fp) != NULL) {
-        // Lewati header
-        if (!header_skipped) {
-            header_skipped = 1;
+
+    int rows, cols;
+    terminal_size(&rows, &cols);
+    int width = cols - 52;
+    if (width > HISTORY_MAX_WIDTH) width = HISTORY_MAX_WIDTH;
+    if (width < 10) width = 10;
+
+    int64_t now = time(NULL);
+    int64_t from = now - since;
+    double bucket_s = (double)since / width;
+
+    double min[HISTORY_SERIES], max[HISTORY_SERIES], sum[HISTORY_SERIES] = {0}, last[HISTORY_SERIES];
+    memset(buckets, 0, sizeof(buckets));
+    unsigned long long samples = 0;
+    int64_t last_time = 0;
+    int blocks_read = 0, blocks_decoded = 0;
+
+    // Blok terbaru selalu didekode untuk mendapatkan nilai terkini
+    uint32_t newest = 0;
+    for (uint32_t i = 1; i < h->num_blocks; i++) {
+        if (history_block_at(h, i)->end_time > history_block_at(h, newest)->end_time) newest = i;
+    }
+
+    for (uint32_t i = 0; i < h->num_blocks; i++) {
+        const struct history_block* src = history_block_at(h, i);
+        if (src->count == 0 || src->end_time < from || src->start_time > now) continue;
+
+        struct history_block* b = (struct history_block*)copy;
+        if (history_read_block(src, b) != 0 || b->count == 0) continue;
+        blocks_read++;
+
+        int first_bucket = b->start_time >= from ? (int)((b->start_time - from) / bucket_s) : -1;
+        int last_bucket = (int)((b->end_time - from) / bucket_s);
+        if (last_bucket >= width) last_bucket = width - 1;
+
+        if (first_bucket >= 0 && first_bucket == last_bucket && i != newest) {
+            for (int s = 0; s < HISTORY_SERIES; s++) {
+                if (samples == 0 || b->agg[s].min < min[s]) min[s] = b->agg[s].min;
+                if (samples == 0 || b->agg[s].max > max[s]) max[s] = b->agg[s].max;
+                sum[s] += b->agg[s].sum;
+                buckets[s][first_bucket].sum += b->agg[s].sum;
+                buckets[s][first_bucket].count += b->count;
+            }
+            samples += b->count;
             continue;
         }
-        
-        // Parse informasi disk
-        char mount_point[64];
-        char size[16];
-        char used[16];
-        char avail[16];
-        char percent[16];
-        char fstype[16];
-        
-        sscanf(line, "%s %s %s %s %s %s", mount_point, size, used, avail, percent, fstype);
-        
-        // Tampilkan dengan warna berdasarkan persentase penggunaan
-        printf("%-15s %-10s ", mount_point, size);
-        
-        // Ekstrak nilai numerik dari persentase
-        int used_percent = 0;
-        sscanf(percent, "%d%%", &used_percent);
-        
-        // Warna berdasarkan penggunaan
-        if (used_percent < 50) {
-            printf("\033[1;32m"); // Hijau terang
-        } else if (used_percent < 80) {
-            printf("\033[1;33m"); // Kuning terang
-        } else {
-            printf("\033[1;31m"); // Merah terang
-        }
-        
-        printf("%-10s ", used);
-        printf("\033[0m"); // Reset warna
-        
-        printf("%-10s %-10s %s\n", avail, percent, fstype);
-    }
-    
-    pclose(fp);
-    
-    // Tambahkan informasi I/O disk jika tersedia
-    fp = popen("iostat -d -k | grep -v loop | grep -v ram | grep -v tmpfs | tail -n +4", "r");
-    if (fp != NULL) {
-        printf("\n");
-        printf("Statistik I/O Disk (kB/s):\n");
-        printf("%-15s %-10s %-10s\n", "Device", "Baca", "Tulis");
-        printf("----------------------------------\n");
-        
-        while (fgets(line, sizeof(line), fp) != NULL) {
-            char dev[16];
-            float tps, kb_read, kb_wrtn;
-            
-            if (sscanf(line, "%s %f %f %f", dev, &tps, &kb_read, &kb_wrtn) == 4) {
-                printf("%-15s %-10.2f %-10.2f\n", dev, kb_read, kb_wrtn);
+
+        blocks_decoded++;
+        struct gorilla_state g;
+        gorilla_reset(&g, b->start_time);
+        uint32_t pos = 0;
+        for (uint32_t k = 0; k < b->count; k++) {
+            int64_t t = k == 0 ? b->start_time : decode_time(b->data, b->bits, &pos, &g);
+            double values[HISTORY_SERIES];
+            for (int s = 0; s < HISTORY_SERIES; s++) {
+                values[s] = decode_value(b->data, b->bits, &pos, &g, s);
+            }
+            if (t < from || t > now) continue;
+
+            int bucket = (int)((t - from) / bucket_s);
+            if (bucket >= width) bucket = width - 1;
+            for (int s = 0; s < HISTORY_SERIES; s++) {
+                if (samples == 0 || values[s] < min[s]) min[s] = values[s];
+                if (samples == 0 || values[s] > max[s]) max[s] = values[s];
+                sum[s] += values[s];
+                buckets[s][bucket].sum += values[s];
+                buckets[s][bucket].count++;
+            }
+            if (t >= last_time) {
+                last_time = t;
+                memcpy(last, values, sizeof(last));
             }
+            samples++;
         }
-        
-        pclose(fp);
     }
-    
-    printf("\n");
+
     printf("\033[1;36m"); // Cyan terang
-    printf("=======================================================\n");
+    printf("Riwayat %s, %ld detik terakhir", group, since);
     printf("\033[0m"); // Reset warna
+    printf(" (%llu sampel, %d blok dibaca, %d didekode)\n\n", samples, blocks_read, blocks_decoded);
+
+    if (samples == 0) {
+        printf("Tidak ada sampel pada rentang ini.\n");
+        munmap(h, size);
+        return;
+    }
+
+    for (int s = 0; s < HISTORY_SERIES; s++) {
+        if (strcmp(history_series[s].group, group) != 0) continue;
+
+        double scale = history_series[s].percent ? 100.0 : 0;
+        if (!history_series[s].percent) {
+            for (int k = 0; k < width; k++) {
+                if (buckets[s][k].count > 0 && buckets[s][k].sum / buckets[s][k].count > scale) {
+                    scale = buckets[s][k].sum / buckets[s][k].count;
+                }
+            }
+        }
+
+        printf("%-14s ", history_series[s].label);
+        for (int k = 0; k < width; k++) {
+            if (buckets[s][k].count == 0) {
+                printf(" ");
+                continue;
+            }
+            double avg = buckets[s][k].sum / buckets[s][k].count;
+            int level = scale > 0 ? (int)(avg / scale * 7.999) : 0;
+            if (level < 0) level = 0;
+            if (level > 7) level = 7;
+            printf("%s", spark[level]);
+        }
+        printf(" min %.1f rata2 %.1f maks %.1f", min[s], sum[s] / samples, max[s]);
+        if (last_time > 0) printf(" kini %.1f", last[s]);
+        printf(" %s\n", history_series[s].unit);
+    }
+
+    munmap(h, size);
 }
 
-int main() {
+int main(int argc, char** argv) {
     char* input;
-    char* args[MAX_ARGS];
     char input_copy[MAX_CMD_LEN];
 
+    // Mode mock server AI mandiri: mishell --ai-mock [port] [opsi gangguan]
+    if (argc >= 2 && strcmp(argv[1], "--ai-mock") == 0) {
+        int port;
+        if (parse_ai_mock_args(argv + 2, &port) != 0) return 1;
+        int listen_fd = open_loopback_listener(port);
+        if (listen_fd < 0) return 1;
+        printf("Mock server AI berjalan di http://127.0.0.1:%d\n", port);
+        fflush(stdout);
+        run_ai_mock_server(listen_fd);
+        return 0;
+    }
+
+    // Mode skrip: mishell <file>
+    if (argc >= 2 && argv[1][0] != '-') {
+        load_api_key();
+        load_ai_config();
+        script_run_file(argv[1]);
+        fflush(stdout);
+        return last_exit_status;
+    }
+
     // Inisialisasi readline
     rl_bind_key('\t', rl_complete);
     
-    // Load API key
+    // Load API key dan konfigurasi backend AI
     load_api_key();
+    load_ai_config();
     
     // Tampilkan halaman welcome untuk pertama kali
     welcome_message();
@@ -1617,14 +13825,7 @@ int main() {
             strncpy(input_copy, input, MAX_CMD_LEN - 1);
             input_copy[MAX_CMD_LEN - 1] = '\0';
             
-            // Periksa apakah perintah mengandung pipeline atau bukan
-            if (strchr(input_copy, '|') != NULL) {
-                execute_pipeline(input_copy);
-            } else {
-                parse_input(input_copy, args);
-                handle_redirection(args);
-                execute_command(args);
-            }
+            run_input_line(input_copy);
         }
         
         // Bebaskan memori dari readline
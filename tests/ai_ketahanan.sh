@@ -0,0 +1,109 @@
+#!/bin/sh
+# Uji ketahanan jalur AI terhadap "mishell --ai-mock" dengan gangguan: retry dengan backoff pada
+# 429/5xx, hedge yang menang saat ada ekor latensi, deadline total, serta circuit breaker yang
+# terbuka setelah kegagalan beruntun dan tertutup lagi setelah masa tunggu (~15 detik).
+# Penggunaan: tests/ai_ketahanan.sh [path/ke/mishell]   (bawaan ./mishell; port awal lewat PORT=...)
+MISHELL=$(cd "$(dirname "${1:-./mishell}")" && pwd)/$(basename "${1:-./mishell}")
+PORT=${PORT:-$((20000 + $$ % 10000))}
+DIR=$(mktemp -d)
+MOCKS=""
+trap 'kill $MOCKS 2>/dev/null; rm -rf "$DIR"' EXIT
+cd "$DIR" || exit 1
+
+# Menjalankan mock mandiri di port $1 dengan opsi gangguan sisanya, lalu menunggu sampai siap
+mock() {
+    port=$1
+    shift
+    "$MISHELL" --ai-mock "$port" "$@" > "mock$port.txt" 2>&1 &
+    MOCKS="$MOCKS $!"
+    for i in 1 2 3 4 5 6 7 8 9 10; do
+        grep -q "berjalan" "mock$port.txt" && return 0
+        sleep 0.2
+    done
+    echo "GAGAL: mock di port $port tidak siap"
+    cat "mock$port.txt"
+    exit 1
+}
+
+# Menjalankan satu skrip mishell (dari stdin) dengan HOME sementara, keluaran tanpa warna di $1.txt
+sesi() {
+    cat > "$1.msh"
+    HOME="$DIR" "$MISHELL" "$1.msh" 2>&1 | sed 's/\x1b\[[0-9;]*m//g' > "$1.txt"
+}
+
+# Nilai angka ke-$2 pada baris pertama di $1.txt yang diawali $3
+angka() {
+    sed -n "s/^$3//p" "$1.txt" | head -1 | tr -cs '0-9' ' ' | awk -v n="$2" '{ print $n + 0 }'
+}
+
+gagal=0
+salah() {
+    echo "GAGAL: $1"
+    sed 's/^/    /' "$2.txt"
+    gagal=1
+}
+
+SEHAT=$PORT
+LIMIT=$((PORT + 1))
+EKOR=$((PORT + 2))
+LAMBAT=$((PORT + 3))
+MATI=$((PORT + 4))
+mock $SEHAT
+mock $LIMIT --429 30
+mock $EKOR --tail 50 1000
+mock $LAMBAT --delay 2000
+mock $MATI --error 100
+
+# Retry dengan backoff: 30% jawaban 429, semua permintaan tetap berhasil lewat percobaan ulang
+sesi retry <<SKRIP
+ai config url http://127.0.0.1:$LIMIT
+ai config hedge off
+ai config retries 6
+ai config deadline 60000
+ai bench 20
+SKRIP
+grep -q "Mencoba ulang dalam" retry.txt || salah "retry tidak menunggu backoff" retry
+[ "$(angka retry 1 'Retry    :')" -gt 0 ] || salah "tidak ada retry tercatat" retry
+grep -q "^Berhasil : 20/20" retry.txt || salah "retry tidak memulihkan semua permintaan" retry
+
+# Hedge: separuh permintaan tertahan 1 detik, duplikat yang dikirim setelah 100 ms harus menang
+sesi hedge <<SKRIP
+ai config url http://127.0.0.1:$EKOR
+ai config hedge 100
+ai config retries 0
+ai config deadline 60000
+ai bench 20
+SKRIP
+[ "$(angka hedge 1 'Hedge    :')" -gt 0 ] || salah "hedge tidak pernah dikirim" hedge
+[ "$(angka hedge 2 'Hedge    :')" -gt 0 ] || salah "hedge tidak pernah menang" hedge
+
+# Deadline: backend menjawab setelah 2 detik, deadline total 300 ms
+sesi deadline <<SKRIP
+ai config url http://127.0.0.1:$LAMBAT
+ai config hedge off
+ai config retries 3
+ai config deadline 300
+ai bench 1
+SKRIP
+grep -q "Deadline 300 ms terlampaui" deadline.txt || salah "deadline tidak ditegakkan" deadline
+grep -q "Semua permintaan gagal" deadline.txt || salah "permintaan lewat deadline dianggap berhasil" deadline
+
+# Circuit breaker: terbuka setelah kegagalan beruntun, menahan permintaan ke backend yang sudah
+# sehat selama masa tunggu, lalu tertutup lagi setelah satu permintaan uji berhasil
+sesi breaker <<SKRIP
+ai config url http://127.0.0.1:$MATI
+ai config hedge off
+ai config retries 1
+ai config deadline 60000
+ai bench 6
+ai config url http://127.0.0.1:$SEHAT
+ai bench 1
+sleep 16
+ai bench 3
+SKRIP
+grep -q "ditahan selama" breaker.txt || salah "circuit breaker tidak terbuka" breaker
+grep -q "sedang tidak tersedia" breaker.txt || salah "circuit breaker tidak menahan permintaan" breaker
+grep -q "^Berhasil : 3/3" breaker.txt || salah "circuit breaker tidak tertutup setelah masa tunggu" breaker
+
+[ $gagal -eq 0 ] && echo "OK: retry, hedge, deadline, dan circuit breaker sesuai harapan"
+exit $gagal
@@ -0,0 +1,33 @@
+#!/bin/sh
+# Uji mode mock AI: "ai mock" harus tetap melayani setelah proses anak shell keluar
+# (exec gagal, "q" di dalam $(...)), dan berhenti sendiri saat shell selesai.
+# Penggunaan: tests/ai_mock.sh [path/ke/mishell]   (bawaan ./mishell; port lewat PORT=...)
+MISHELL=$(cd "$(dirname "${1:-./mishell}")" && pwd)/$(basename "${1:-./mishell}")
+PORT=${PORT:-$((20000 + $$ % 10000))}
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+cd "$DIR" || exit 1
+
+cat > uji.msh <<SKRIP
+ai mock $PORT --reply "ls -la"
+ai bench 3
+perintah_tidak_ada_zz
+echo \$(q)
+ls /tidak_ada_zz | cat
+ai bench 3
+SKRIP
+HOME="$DIR" "$MISHELL" uji.msh > keluaran.txt 2>&1
+sed 's/\x1b\[[0-9;]*m//g' keluaran.txt > bersih.txt
+
+gagal=0
+grep -q "Mock server AI berjalan di http://127.0.0.1:$PORT" bersih.txt || { echo "GAGAL: mock tidak berjalan"; gagal=1; }
+[ "$(grep -c '^Berhasil : 3/3' bersih.txt)" -eq 2 ] || { echo "GAGAL: bench tidak 3/3 sebelum dan sesudah anak keluar"; gagal=1; }
+pid=$(sed -n 's/^Mock server AI berjalan di .* (pid \([0-9]*\)).*/\1/p' bersih.txt)
+if [ -n "$pid" ] && kill -0 "$pid" 2>/dev/null; then
+    echo "GAGAL: mock (pid $pid) masih berjalan setelah shell selesai"
+    kill "$pid"
+    gagal=1
+fi
+[ $gagal -ne 0 ] && cat bersih.txt
+[ $gagal -eq 0 ] && echo "OK: mock AI bertahan selama sesi dan berhenti bersama shell"
+exit $gagal
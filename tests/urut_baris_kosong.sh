@@ -0,0 +1,31 @@
+#!/bin/sh
+# Uji regresi "urut": deretan baris kosong yang jatuh tepat di batas chunk baca dan batas spill
+# harus tetap terurut lengkap, sama dengan LC_ALL=C sort.
+# Penggunaan: tests/urut_baris_kosong.sh [path/ke/mishell]   (bawaan ./mishell)
+MISHELL=$(cd "$(dirname "${1:-./mishell}")" && pwd)/$(basename "${1:-./mishell}")
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+cd "$DIR" || exit 1
+
+# 200001 baris, ~30% kosong dan sering berurutan
+awk 'BEGIN { srand(1); for (i = 0; i < 200001; i++) print (rand() < 0.3 ? "" : "x" int(rand() * 100000)) }' > data.txt
+cat > uji.msh <<'SKRIP'
+urut data.txt > o1.txt
+urut -S 64K data.txt > o2.txt
+cat data.txt | urut > o3.txt
+cat data.txt | urut -S 64K > o4.txt
+urut -u -S 64K data.txt > o5.txt
+awk 'BEGIN { for (i = 0; i < 10; i++) { print (i % 2 ? "" : "z" i); fflush() } }' | urut > o6.txt
+SKRIP
+HOME="$DIR" "$MISHELL" uji.msh || exit 1
+
+LC_ALL=C sort data.txt > e.txt
+LC_ALL=C sort -u data.txt > eu.txt
+awk 'BEGIN { for (i = 0; i < 10; i++) print (i % 2 ? "" : "z" i) }' | LC_ALL=C sort > eg.txt
+
+gagal=0
+for f in o1 o2 o3 o4; do cmp -s $f.txt e.txt || { echo "GAGAL: $f ($(wc -l < $f.txt) baris)"; gagal=1; }; done
+cmp -s o5.txt eu.txt || { echo "GAGAL: o5 (-u)"; gagal=1; }
+cmp -s o6.txt eg.txt || { echo "GAGAL: o6 (generator)"; gagal=1; }
+[ $gagal -eq 0 ] && echo "OK: urut sama dengan sort"
+exit $gagal